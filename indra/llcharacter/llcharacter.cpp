@@ -33,6 +33,7 @@
 #include "llcharacter.h"
 #include "llstring.h"
 #include "llfasttimer.h"
+#include "workexecutor.h"
 
 #define SKEL_HEADER "Linden Skeleton 1.0"
 
@@ -182,22 +183,57 @@ void LLCharacter::requestStopMotion( LLMotion* motion)
 void LLCharacter::updateMotions(e_update_t update_type)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
+    if (beginUpdateMotions(update_type))
+    {
+        evaluateMotions();
+    }
+}
+
+//-----------------------------------------------------------------------------
+// beginUpdateMotions()
+//-----------------------------------------------------------------------------
+bool LLCharacter::beginUpdateMotions(e_update_t update_type)
+{
     if (update_type == HIDDEN_UPDATE)
     {
         mMotionController.updateMotionsMinimal();
+        return false;
     }
-    else
+
+    // unpause if the number of outstanding pause requests has dropped to the initial one
+    if (mMotionController.isPaused() && mPauseRequest->getNumRefs() == 1)
     {
-        // unpause if the number of outstanding pause requests has dropped to the initial one
-        if (mMotionController.isPaused() && mPauseRequest->getNumRefs() == 1)
-        {
-            mMotionController.unpauseAllMotions();
-        }
-        bool force_update = (update_type == FORCE_UPDATE);
-        {
-            mMotionController.updateMotions(force_update);
-        }
+        mMotionController.unpauseAllMotions();
+    }
+    bool force_update = (update_type == FORCE_UPDATE);
+    return mMotionController.beginUpdateMotions(force_update);
+}
+
+//-----------------------------------------------------------------------------
+// evaluateMotions()
+//-----------------------------------------------------------------------------
+void LLCharacter::evaluateMotions()
+{
+    mMotionController.evaluateMotions();
+}
+
+//-----------------------------------------------------------------------------
+// evaluateMotionsInParallel()
+//-----------------------------------------------------------------------------
+void LLCharacter::evaluateMotionsInParallel(const std::vector<LLCharacter*>& characters)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
+    const S32 count = (S32)characters.size();
+    if (count == 0)
+    {
+        return;
     }
+
+    // Characters are claimed one at a time, some cost far more than others.
+    // The main thread waits on this, so it goes ahead of other executor work.
+    LL::WorkExecutor::getShared().forEach(count,
+        [&characters](size_t i) { characters[i]->evaluateMotions(); },
+        LL::WorkExecutor::PRIORITY_HIGH);
 }
 
 
@@ -31,6 +31,7 @@
 // Header Files
 //-----------------------------------------------------------------------------
 #include <string>
+#include <vector>
 
 #include "lljoint.h"
 #include "llmotioncontroller.h"
@@ -161,6 +162,17 @@ public:
     enum e_update_t { NORMAL_UPDATE, HIDDEN_UPDATE, FORCE_UPDATE };
     void updateMotions(e_update_t update_type);
 
+    // updateMotions() split as LLMotionController::beginUpdateMotions() and
+    // evaluateMotions() are.  beginUpdateMotions() returns true if
+    // evaluateMotions() is still to run.
+    bool beginUpdateMotions(e_update_t update_type);
+    void evaluateMotions();
+
+    // Run evaluateMotions() on each of characters, spread over the shared
+    // WorkExecutor and the calling thread, and return when all are done.  A
+    // character must not appear twice.
+    static void evaluateMotionsInParallel(const std::vector<LLCharacter*>& characters);
+
     LLAnimPauseRequest requestPause();
     bool areAnimationsPaused() const { return mMotionController.isPaused(); }
     void setAnimTimeFactor(F32 factor) { mMotionController.setTimeFactor(factor); }
@@ -0,0 +1,121 @@
+/**
+ * @file llkeyframekeys.cpp
+ * @brief Sorted key storage and batched interpolation for keyframe curves
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llkeyframekeys.h"
+
+void LLKeyframeBatch::clear()
+{
+    mVectorBefore.clear();
+    mVectorAfter.clear();
+    mVectorU.clear();
+    mRotationBefore.clear();
+    mRotationAfter.clear();
+    mRotationU.clear();
+    mRotationDone.clear();
+}
+
+S32 LLKeyframeBatch::addLerp(const LLVector3& before, const LLVector3& after, F32 u)
+{
+    LLVector4a v;
+    v.load3(before.mV);
+    mVectorBefore.push_back(v);
+    v.load3(after.mV);
+    mVectorAfter.push_back(v);
+    mVectorU.push_back(u);
+    return (S32)mVectorU.size() - 1;
+}
+
+S32 LLKeyframeBatch::addNlerp(const LLQuaternion& before, const LLQuaternion& after, F32 u)
+{
+    LLVector4a v;
+    if (dot(before, after) < 0.f)
+    {
+        // nlerp() slerps these, leave it to do so
+        v.loadua(nlerp(u, before, after).mQ);
+        mRotationBefore.push_back(v);
+        mRotationAfter.push_back(v);
+        mRotationDone.push_back(1);
+    }
+    else
+    {
+        v.loadua(before.mQ);
+        mRotationBefore.push_back(v);
+        v.loadua(after.mQ);
+        mRotationAfter.push_back(v);
+        mRotationDone.push_back(0);
+    }
+    mRotationU.push_back(u);
+    return (S32)mRotationU.size() - 1;
+}
+
+// Same operations as lerp(const LLVector3&, ...) and
+// lerp(F32, const LLQuaternion&, ...) followed by LLQuaternion::normalize().
+void LLKeyframeBatch::interpolate()
+{
+    LL_PROFILE_ZONE_SCOPED;
+
+    const S32 vector_count = getNumVectors();
+    LLVector4a* __restrict beforep = mVectorBefore.data();
+    const LLVector4a* __restrict afterp = mVectorAfter.data();
+    for (S32 i = 0; i < vector_count; ++i)
+    {
+        beforep[i].setLerp(beforep[i], afterp[i], mVectorU[i]);
+    }
+
+    const S32 rotation_count = getNumRotations();
+    beforep = mRotationBefore.data();
+    afterp = mRotationAfter.data();
+    for (S32 i = 0; i < rotation_count; ++i)
+    {
+        if (mRotationDone[i])
+        {
+            continue;
+        }
+
+        const F32 t = mRotationU[i];
+        LLVector4a& r = beforep[i];
+        LLVector4a p;
+        p.setMul(r, 1.f - t);
+        r.setMul(afterp[i], t);
+        r.add(p);
+
+        const F32* q = r.getF32ptr();
+        F32 mag = sqrtf(q[VX]*q[VX] + q[VY]*q[VY] + q[VZ]*q[VZ] + q[VW]*q[VW]);
+        if (mag > FP_MAG_THRESHOLD)
+        {
+            if (fabs(1.f - mag) > ONE_PART_IN_A_MILLION)
+            {
+                r.mul(1.f/mag);
+            }
+        }
+        else
+        {
+            r.set(0.f, 0.f, 0.f, 1.f);
+        }
+    }
+}
@@ -0,0 +1,198 @@
+/**
+ * @file llkeyframekeys.h
+ * @brief Sorted key storage and batched interpolation for keyframe curves
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLKEYFRAMEKEYS_H
+#define LL_LLKEYFRAMEKEYS_H
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "llmath.h"
+#include "llquaternion.h"
+#include "llvector4a.h"
+#include "v3math.h"
+
+//-----------------------------------------------------------------------------
+// LLKeyframeKeys
+//-----------------------------------------------------------------------------
+// The keys of one curve, kept in a single array sorted by time.
+//
+// Looks enough like the std::map<F32, KEY> the curves used to keep that code
+// building or editing curves doesn't need to change, but lookups walk
+// contiguous memory, and seek() takes a cursor so a motion playing forward a
+// frame at a time finds its keys in a compare or two instead of a search.
+template <class KEY>
+class LLKeyframeKeys
+{
+public:
+    typedef std::pair<F32, KEY> value_type;
+    typedef std::vector<value_type> array_t;
+    typedef typename array_t::iterator iterator;
+    typedef typename array_t::const_iterator const_iterator;
+
+    // Keys walked past before seek() gives up and searches
+    static const S32 MAX_SEEK_STEPS = 4;
+
+    iterator begin()                { return mKeys.begin(); }
+    iterator end()                  { return mKeys.end(); }
+    const_iterator begin() const    { return mKeys.begin(); }
+    const_iterator end() const      { return mKeys.end(); }
+    bool empty() const              { return mKeys.empty(); }
+    size_t size() const             { return mKeys.size(); }
+    void clear()                    { mKeys.clear(); }
+    void reserve(size_t count)      { mKeys.reserve(count); }
+
+    const value_type& getKey(S32 index) const { return mKeys[index]; }
+
+    // First key at or after time
+    iterator lower_bound(F32 time)
+    {
+        return std::lower_bound(mKeys.begin(), mKeys.end(), time, &keyBefore);
+    }
+
+    const_iterator lower_bound(F32 time) const
+    {
+        return std::lower_bound(mKeys.begin(), mKeys.end(), time, &keyBefore);
+    }
+
+    // Key at time, added in order if there is none yet
+    KEY& operator[](F32 time)
+    {
+        if (mKeys.empty() || mKeys.back().first < time)
+        {
+            // Curves are almost always built in order
+            mKeys.emplace_back(time, KEY());
+            return mKeys.back().second;
+        }
+
+        iterator it = lower_bound(time);
+        if (it->first != time)
+        {
+            it = mKeys.insert(it, value_type(time, KEY()));
+        }
+        return it->second;
+    }
+
+    // Index of the first key at or after time, the same key lower_bound()
+    // finds.  cursor is where the last seek ended, and is updated; any value
+    // is safe, the keys may have changed since it was set.
+    S32 seek(F32 time, S32& cursor) const
+    {
+        const S32 count = (S32)mKeys.size();
+        S32 index = llclamp(cursor, 0, count);
+
+        if (index > 0 && !(mKeys[index - 1].first < time))
+        {
+            // Went back, most likely looped to the start
+            index = (S32)(std::lower_bound(mKeys.begin(), mKeys.begin() + index, time, &keyBefore) - mKeys.begin());
+        }
+        else
+        {
+            for (S32 steps = 0; index < count && mKeys[index].first < time; ++index)
+            {
+                if (++steps > MAX_SEEK_STEPS)
+                {
+                    index = (S32)(std::lower_bound(mKeys.begin() + index, mKeys.end(), time, &keyBefore) - mKeys.begin());
+                    break;
+                }
+            }
+        }
+
+        cursor = index;
+        return index;
+    }
+
+    // Find the keys to sample at time the way the curves always have: the
+    // last key past the end, the first key before the start or the key
+    // itself exactly on one.  Returns the index of that key and sets u to -1,
+    // or, between two keys, returns the index of the later one and sets u to
+    // how far time is from the earlier one, in (0, 1].  Keys must not be
+    // empty.
+    S32 findKeys(F32 time, S32& cursor, F32& u) const
+    {
+        S32 right = seek(time, cursor);
+        if (right == (S32)mKeys.size())
+        {
+            u = -1.f;
+            return right - 1;
+        }
+
+        if (right == 0 || mKeys[right].first == time)
+        {
+            u = -1.f;
+            return right;
+        }
+
+        F32 index_before = mKeys[right - 1].first;
+        F32 index_after = mKeys[right].first;
+        u = (time - index_before) / (index_after - index_before);
+        return right;
+    }
+
+private:
+    static bool keyBefore(const value_type& key, F32 time) { return key.first < time; }
+
+    array_t mKeys;
+};
+
+//-----------------------------------------------------------------------------
+// LLKeyframeBatch
+//-----------------------------------------------------------------------------
+// Interpolations gathered from many curves and run together over contiguous
+// LLVector4a arrays.  Results match lerp() on LLVector3 and nlerp() on
+// LLQuaternion to the bit, rotations on opposite hemispheres fall back to
+// nlerp() itself.
+class LLKeyframeBatch
+{
+public:
+    void clear();
+
+    // Queue an interpolation, returns the index of its result
+    S32 addLerp(const LLVector3& before, const LLVector3& after, F32 u);
+    S32 addNlerp(const LLQuaternion& before, const LLQuaternion& after, F32 u);
+
+    S32 getNumVectors() const       { return (S32)mVectorU.size(); }
+    S32 getNumRotations() const     { return (S32)mRotationU.size(); }
+
+    void interpolate();
+
+    // Results, valid after interpolate()
+    LLVector3 getVector(S32 index) const        { return LLVector3(mVectorBefore[index].getF32ptr()); }
+    LLQuaternion getRotation(S32 index) const   { return LLQuaternion(mRotationBefore[index].getF32ptr()); }
+
+private:
+    // Interpolated in place into the before arrays
+    std::vector<LLVector4a> mVectorBefore;
+    std::vector<LLVector4a> mVectorAfter;
+    std::vector<F32>        mVectorU;
+    std::vector<LLVector4a> mRotationBefore;
+    std::vector<LLVector4a> mRotationAfter;
+    std::vector<F32>        mRotationU;
+    std::vector<U8>         mRotationDone;  // Opposite hemispheres, already set
+};
+
+#endif // LL_LLKEYFRAMEKEYS_H
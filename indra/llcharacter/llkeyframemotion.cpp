@@ -161,34 +161,18 @@ LLVector3 LLKeyframeMotion::ScaleCurve::getValue(F32 time, F32 duration)
         return value;
     }
 
-    key_map_t::iterator right = mKeys.lower_bound(time);
-    if (right == mKeys.end())
+    S32 cursor = 0;
+    F32 u;
+    S32 right = mKeys.findKeys(time, cursor, u);
+    if (u < 0.f)
     {
-        // Past last key
-        --right;
-        value = right->second.mScale;
-    }
-    else if (right == mKeys.begin() || right->first == time)
-    {
-        // Before first key or exactly on a key
-        value = right->second.mScale;
+        // Past last key, before first key or exactly on a key
+        value = mKeys.getKey(right).second.mScale;
     }
     else
     {
         // Between two keys
-        key_map_t::iterator left = right; --left;
-        F32 index_before = left->first;
-        F32 index_after = right->first;
-        ScaleKey& scale_before = left->second;
-        ScaleKey& scale_after = right->second;
-        if (right == mKeys.end())
-        {
-            scale_after = mLoopInKey;
-            index_after = duration;
-        }
-
-        F32 u = (time - index_before) / (index_after - index_before);
-        value = interp(u, scale_before, scale_after);
+        value = interp(u, mKeys.getKey(right - 1).second, mKeys.getKey(right).second);
     }
     return value;
 }
@@ -196,7 +180,7 @@ LLVector3 LLKeyframeMotion::ScaleCurve::getValue(F32 time, F32 duration)
 //-----------------------------------------------------------------------------
 // interp()
 //-----------------------------------------------------------------------------
-LLVector3 LLKeyframeMotion::ScaleCurve::interp(F32 u, ScaleKey& before, ScaleKey& after)
+LLVector3 LLKeyframeMotion::ScaleCurve::interp(F32 u, const ScaleKey& before, const ScaleKey& after)
 {
     switch (mInterpolationType)
     {
@@ -210,6 +194,33 @@ LLVector3 LLKeyframeMotion::ScaleCurve::interp(F32 u, ScaleKey& before, ScaleKey
     }
 }
 
+//-----------------------------------------------------------------------------
+// ScaleCurve::sample()
+//-----------------------------------------------------------------------------
+void LLKeyframeMotion::ScaleCurve::sample(LLJointState* joint_state, F32 time, S32& cursor, JointSampler& sampler)
+{
+    if (mKeys.empty())
+    {
+        joint_state->setScale(LLVector3::zero);
+        return;
+    }
+
+    F32 u;
+    S32 right = mKeys.findKeys(time, cursor, u);
+    if (u < 0.f)
+    {
+        joint_state->setScale(mKeys.getKey(right).second.mScale);
+    }
+    else if (mInterpolationType == IT_STEP)
+    {
+        joint_state->setScale(mKeys.getKey(right - 1).second.mScale);
+    }
+    else
+    {
+        sampler.queueScale(joint_state, mKeys.getKey(right - 1).second.mScale, mKeys.getKey(right).second.mScale, u);
+    }
+}
+
 //-----------------------------------------------------------------------------
 // RotationCurve::RotationCurve()
 //-----------------------------------------------------------------------------
@@ -241,34 +252,18 @@ LLQuaternion LLKeyframeMotion::RotationCurve::getValue(F32 time, F32 duration)
         return value;
     }
 
-    key_map_t::iterator right = mKeys.lower_bound(time);
-    if (right == mKeys.end())
-    {
-        // Past last key
-        --right;
-        value = right->second.mRotation;
-    }
-    else if (right == mKeys.begin() || right->first == time)
+    S32 cursor = 0;
+    F32 u;
+    S32 right = mKeys.findKeys(time, cursor, u);
+    if (u < 0.f)
     {
-        // Before first key or exactly on a key
-        value = right->second.mRotation;
+        // Past last key, before first key or exactly on a key
+        value = mKeys.getKey(right).second.mRotation;
     }
     else
     {
         // Between two keys
-        key_map_t::iterator left = right; --left;
-        F32 index_before = left->first;
-        F32 index_after = right->first;
-        RotationKey& rot_before = left->second;
-        RotationKey& rot_after = right->second;
-        if (right == mKeys.end())
-        {
-            rot_after = mLoopInKey;
-            index_after = duration;
-        }
-
-        F32 u = (time - index_before) / (index_after - index_before);
-        value = interp(u, rot_before, rot_after);
+        value = interp(u, mKeys.getKey(right - 1).second, mKeys.getKey(right).second);
     }
     return value;
 }
@@ -276,7 +271,7 @@ LLQuaternion LLKeyframeMotion::RotationCurve::getValue(F32 time, F32 duration)
 //-----------------------------------------------------------------------------
 // interp()
 //-----------------------------------------------------------------------------
-LLQuaternion LLKeyframeMotion::RotationCurve::interp(F32 u, RotationKey& before, RotationKey& after)
+LLQuaternion LLKeyframeMotion::RotationCurve::interp(F32 u, const RotationKey& before, const RotationKey& after)
 {
     switch (mInterpolationType)
     {
@@ -290,6 +285,33 @@ LLQuaternion LLKeyframeMotion::RotationCurve::interp(F32 u, RotationKey& before,
     }
 }
 
+//-----------------------------------------------------------------------------
+// RotationCurve::sample()
+//-----------------------------------------------------------------------------
+void LLKeyframeMotion::RotationCurve::sample(LLJointState* joint_state, F32 time, S32& cursor, JointSampler& sampler)
+{
+    if (mKeys.empty())
+    {
+        joint_state->setRotation(LLQuaternion::DEFAULT);
+        return;
+    }
+
+    F32 u;
+    S32 right = mKeys.findKeys(time, cursor, u);
+    if (u < 0.f)
+    {
+        joint_state->setRotation(mKeys.getKey(right).second.mRotation);
+    }
+    else if (mInterpolationType == IT_STEP)
+    {
+        joint_state->setRotation(mKeys.getKey(right - 1).second.mRotation);
+    }
+    else
+    {
+        sampler.queueRotation(joint_state, mKeys.getKey(right - 1).second.mRotation, mKeys.getKey(right).second.mRotation, u);
+    }
+}
+
 
 //-----------------------------------------------------------------------------
 // PositionCurve::PositionCurve()
@@ -322,34 +344,18 @@ LLVector3 LLKeyframeMotion::PositionCurve::getValue(F32 time, F32 duration)
         return value;
     }
 
-    key_map_t::iterator right = mKeys.lower_bound(time);
-    if (right == mKeys.end())
+    S32 cursor = 0;
+    F32 u;
+    S32 right = mKeys.findKeys(time, cursor, u);
+    if (u < 0.f)
     {
-        // Past last key
-        --right;
-        value = right->second.mPosition;
-    }
-    else if (right == mKeys.begin() || right->first == time)
-    {
-        // Before first key or exactly on a key
-        value = right->second.mPosition;
+        // Past last key, before first key or exactly on a key
+        value = mKeys.getKey(right).second.mPosition;
     }
     else
     {
         // Between two keys
-        key_map_t::iterator left = right; --left;
-        F32 index_before = left->first;
-        F32 index_after = right->first;
-        PositionKey& pos_before = left->second;
-        PositionKey& pos_after = right->second;
-        if (right == mKeys.end())
-        {
-            pos_after = mLoopInKey;
-            index_after = duration;
-        }
-
-        F32 u = (time - index_before) / (index_after - index_before);
-        value = interp(u, pos_before, pos_after);
+        value = interp(u, mKeys.getKey(right - 1).second, mKeys.getKey(right).second);
     }
 
     llassert(value.isFinite());
@@ -360,7 +366,7 @@ LLVector3 LLKeyframeMotion::PositionCurve::getValue(F32 time, F32 duration)
 //-----------------------------------------------------------------------------
 // interp()
 //-----------------------------------------------------------------------------
-LLVector3 LLKeyframeMotion::PositionCurve::interp(F32 u, PositionKey& before, PositionKey& after)
+LLVector3 LLKeyframeMotion::PositionCurve::interp(F32 u, const PositionKey& before, const PositionKey& after)
 {
     switch (mInterpolationType)
     {
@@ -373,6 +379,33 @@ LLVector3 LLKeyframeMotion::PositionCurve::interp(F32 u, PositionKey& before, Po
     }
 }
 
+//-----------------------------------------------------------------------------
+// PositionCurve::sample()
+//-----------------------------------------------------------------------------
+void LLKeyframeMotion::PositionCurve::sample(LLJointState* joint_state, F32 time, S32& cursor, JointSampler& sampler)
+{
+    if (mKeys.empty())
+    {
+        joint_state->setPosition(LLVector3::zero);
+        return;
+    }
+
+    F32 u;
+    S32 right = mKeys.findKeys(time, cursor, u);
+    if (u < 0.f)
+    {
+        joint_state->setPosition(mKeys.getKey(right).second.mPosition);
+    }
+    else if (mInterpolationType == IT_STEP)
+    {
+        joint_state->setPosition(mKeys.getKey(right - 1).second.mPosition);
+    }
+    else
+    {
+        sampler.queuePosition(joint_state, mKeys.getKey(right - 1).second.mPosition, mKeys.getKey(right).second.mPosition, u);
+    }
+}
+
 
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
@@ -419,6 +452,93 @@ void LLKeyframeMotion::JointMotion::update(LLJointState* joint_state, F32 time,
     }
 }
 
+//-----------------------------------------------------------------------------
+// JointMotion::sample()
+//-----------------------------------------------------------------------------
+void LLKeyframeMotion::JointMotion::sample(LLJointState* joint_state, F32 time, JointCursor& cursor, JointSampler& sampler)
+{
+    if ( joint_state == NULL )
+    {
+        return;
+    }
+
+    U32 usage = joint_state->getUsage();
+
+    if ((usage & LLJointState::SCALE) && mScaleCurve.mNumKeys)
+    {
+        mScaleCurve.sample(joint_state, time, cursor.mScale, sampler);
+    }
+
+    if ((usage & LLJointState::ROT) && mRotationCurve.mNumKeys)
+    {
+        mRotationCurve.sample(joint_state, time, cursor.mRotation, sampler);
+    }
+
+    if ((usage & LLJointState::POS) && mPositionCurve.mNumKeys)
+    {
+        mPositionCurve.sample(joint_state, time, cursor.mPosition, sampler);
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+// JointSampler class
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+void LLKeyframeMotion::JointSampler::clear()
+{
+    mBatch.clear();
+    mVectorTargets.clear();
+    mVectorIsScale.clear();
+    mRotationTargets.clear();
+}
+
+void LLKeyframeMotion::JointSampler::queueScale(LLJointState* joint_state, const LLVector3& before, const LLVector3& after, F32 u)
+{
+    mBatch.addLerp(before, after, u);
+    mVectorTargets.push_back(joint_state);
+    mVectorIsScale.push_back(1);
+}
+
+void LLKeyframeMotion::JointSampler::queueRotation(LLJointState* joint_state, const LLQuaternion& before, const LLQuaternion& after, F32 u)
+{
+    mBatch.addNlerp(before, after, u);
+    mRotationTargets.push_back(joint_state);
+}
+
+void LLKeyframeMotion::JointSampler::queuePosition(LLJointState* joint_state, const LLVector3& before, const LLVector3& after, F32 u)
+{
+    mBatch.addLerp(before, after, u);
+    mVectorTargets.push_back(joint_state);
+    mVectorIsScale.push_back(0);
+}
+
+void LLKeyframeMotion::JointSampler::apply()
+{
+    mBatch.interpolate();
+
+    for (S32 i = 0; i < mBatch.getNumVectors(); ++i)
+    {
+        if (mVectorIsScale[i])
+        {
+            mVectorTargets[i]->setScale(mBatch.getVector(i));
+        }
+        else
+        {
+            mVectorTargets[i]->setPosition(mBatch.getVector(i));
+        }
+    }
+
+    for (S32 i = 0; i < mBatch.getNumRotations(); ++i)
+    {
+        mRotationTargets[i]->setRotation(mBatch.getRotation(i));
+    }
+
+    clear();
+}
+
 
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
@@ -737,13 +857,22 @@ bool LLKeyframeMotion::onUpdate(F32 time, U8* joint_mask)
 //-----------------------------------------------------------------------------
 void LLKeyframeMotion::applyKeyframes(F32 time)
 {
-    llassert_always (mJointMotionList->getNumJointMotions() <= mJointStates.size());
-    for (U32 i=0; i<mJointMotionList->getNumJointMotions(); i++)
+    U32 num_joint_motions = mJointMotionList->getNumJointMotions();
+    llassert_always (num_joint_motions <= mJointStates.size());
+    if (mJointCursors.size() < num_joint_motions)
+    {
+        mJointCursors.resize(num_joint_motions);
+    }
+
+    // Find the keys for every joint first, then interpolate all of them at once
+    for (U32 i=0; i<num_joint_motions; i++)
     {
-        mJointMotionList->getJointMotion(i)->update(mJointStates[i],
+        mJointMotionList->getJointMotion(i)->sample(mJointStates[i],
                                                       time,
-                                                      mJointMotionList->mDuration );
+                                                      mJointCursors[i],
+                                                      mJointSampler );
     }
+    mJointSampler.apply();
 
     LLJoint::JointPriority* pose_priority = (LLJoint::JointPriority* )mCharacter->getAnimationData("Hand Pose Priority");
     if (pose_priority)
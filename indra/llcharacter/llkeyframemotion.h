@@ -36,6 +36,7 @@
 #include "llassetstorage.h"
 #include "llbboxlocal.h"
 #include "llhandmotion.h"
+#include "llkeyframekeys.h"
 #include "lljointstate.h"
 #include "llmotion.h"
 #include "llquaternion.h"
@@ -317,6 +318,43 @@ public:
         LLVector3   mPosition;
     };
 
+    //-------------------------------------------------------------------------
+    // JointSampler
+    //-------------------------------------------------------------------------
+    // Samples all the joints of a motion together.  The curves set values
+    // that fall on a key straight away and queue the ones between two keys,
+    // apply() then interpolates those in one pass and sets them.
+    class JointSampler
+    {
+    public:
+        void clear();
+        void queueScale(LLJointState* joint_state, const LLVector3& before, const LLVector3& after, F32 u);
+        void queueRotation(LLJointState* joint_state, const LLQuaternion& before, const LLQuaternion& after, F32 u);
+        void queuePosition(LLJointState* joint_state, const LLVector3& before, const LLVector3& after, F32 u);
+        void apply();
+
+    private:
+        LLKeyframeBatch             mBatch;
+        std::vector<LLJointState*>  mVectorTargets;
+        std::vector<U8>             mVectorIsScale;
+        std::vector<LLJointState*>  mRotationTargets;
+    };
+
+    //-------------------------------------------------------------------------
+    // JointCursor
+    //-------------------------------------------------------------------------
+    // Where each curve of a joint was last sampled, kept per motion instance
+    // as the curves are shared
+    class JointCursor
+    {
+    public:
+        JointCursor() : mScale(0), mRotation(0), mPosition(0) {}
+
+        S32 mScale;
+        S32 mRotation;
+        S32 mPosition;
+    };
+
     //-------------------------------------------------------------------------
     // ScaleCurve
     //-------------------------------------------------------------------------
@@ -326,11 +364,12 @@ public:
         ScaleCurve();
         ~ScaleCurve();
         LLVector3 getValue(F32 time, F32 duration);
-        LLVector3 interp(F32 u, ScaleKey& before, ScaleKey& after);
+        LLVector3 interp(F32 u, const ScaleKey& before, const ScaleKey& after);
+        void sample(LLJointState* joint_state, F32 time, S32& cursor, JointSampler& sampler);
 
         InterpolationType   mInterpolationType;
         S32                 mNumKeys;
-        typedef std::map<F32, ScaleKey> key_map_t;
+        typedef LLKeyframeKeys<ScaleKey> key_map_t;
         key_map_t           mKeys;
         ScaleKey            mLoopInKey;
         ScaleKey            mLoopOutKey;
@@ -345,11 +384,12 @@ public:
         RotationCurve();
         ~RotationCurve();
         LLQuaternion getValue(F32 time, F32 duration);
-        LLQuaternion interp(F32 u, RotationKey& before, RotationKey& after);
+        LLQuaternion interp(F32 u, const RotationKey& before, const RotationKey& after);
+        void sample(LLJointState* joint_state, F32 time, S32& cursor, JointSampler& sampler);
 
         InterpolationType   mInterpolationType;
         S32                 mNumKeys;
-        typedef std::map<F32, RotationKey> key_map_t;
+        typedef LLKeyframeKeys<RotationKey> key_map_t;
         key_map_t       mKeys;
         RotationKey     mLoopInKey;
         RotationKey     mLoopOutKey;
@@ -364,11 +404,12 @@ public:
         PositionCurve();
         ~PositionCurve();
         LLVector3 getValue(F32 time, F32 duration);
-        LLVector3 interp(F32 u, PositionKey& before, PositionKey& after);
+        LLVector3 interp(F32 u, const PositionKey& before, const PositionKey& after);
+        void sample(LLJointState* joint_state, F32 time, S32& cursor, JointSampler& sampler);
 
         InterpolationType   mInterpolationType;
         S32                 mNumKeys;
-        typedef std::map<F32, PositionKey> key_map_t;
+        typedef LLKeyframeKeys<PositionKey> key_map_t;
         key_map_t       mKeys;
         PositionKey     mLoopInKey;
         PositionKey     mLoopOutKey;
@@ -388,6 +429,9 @@ public:
         LLJoint::JointPriority  mPriority;
 
         void update(LLJointState* joint_state, F32 time, F32 duration);
+        // As update(), keeping the place in each curve in cursor and leaving
+        // interpolation between keys to sampler
+        void sample(LLJointState* joint_state, F32 time, JointCursor& cursor, JointSampler& sampler);
     };
 
     //-------------------------------------------------------------------------
@@ -426,6 +470,8 @@ public:
 protected:
     JointMotionList*                mJointMotionList;
     std::vector<LLPointer<LLJointState> > mJointStates;
+    std::vector<JointCursor>        mJointCursors;
+    JointSampler                    mJointSampler;
     LLJoint*                        mPelvisp;
     LLCharacter*                    mCharacter;
     typedef std::list<JointConstraint*> constraint_list_t;
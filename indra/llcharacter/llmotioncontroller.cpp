@@ -135,6 +135,7 @@ LLMotionController::LLMotionController()
       mPrevTimerElapsed(0.f),
       mLastTime(0.0f),
       mHasRunOnce(false),
+      mForceUpdate(false),
       mPaused(false),
       mPausedFrame(0),
       mTimeStep(0.f),
@@ -822,6 +823,18 @@ void LLMotionController::updateLoadingMotions()
 // updateMotion()
 //-----------------------------------------------------------------------------
 void LLMotionController::updateMotions(bool force_update)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
+    if (beginUpdateMotions(force_update))
+    {
+        evaluateMotions();
+    }
+}
+
+//-----------------------------------------------------------------------------
+// beginUpdateMotions()
+//-----------------------------------------------------------------------------
+bool LLMotionController::beginUpdateMotions(bool force_update)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
     // SL-763: "Distant animated objects run at super fast speed"
@@ -864,7 +877,7 @@ void LLMotionController::updateMotions(bool force_update)
 
                 updateLoadingMotions();
 
-                return;
+                return false;
             }
 
             // is calculating a new keyframe pose, make sure the last one gets applied
@@ -884,9 +897,21 @@ void LLMotionController::updateMotions(bool force_update)
 
     updateLoadingMotions();
 
+    mForceUpdate = force_update;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// evaluateMotions()
+//-----------------------------------------------------------------------------
+void LLMotionController::evaluateMotions()
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
+    bool use_quantum = (mTimeStep != 0.f);
+
     resetJointSignatures();
 
-    if (mPaused && !force_update)
+    if (mPaused && !mForceUpdate)
     {
         updateIdleActiveMotions();
     }
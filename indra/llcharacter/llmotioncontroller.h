@@ -132,6 +132,15 @@ public:
     // deactivates terminated motions`
     void updateMotions(bool force_update = false);
 
+    // updateMotions() in two steps, so the motions of many characters can
+    // be evaluated in parallel. beginUpdateMotions() does the timing and
+    // loads motions, on the main thread; it returns true if
+    // evaluateMotions() has to follow. evaluateMotions() runs the motions
+    // and blends their poses into the joints, touching nothing but this
+    // character, and can run on any thread.
+    bool beginUpdateMotions(bool force_update);
+    void evaluateMotions();
+
     // minimal update (e.g. while hidden)
     void updateMotionsMinimal();
 
@@ -225,6 +234,7 @@ protected:
     F32                 mAnimTime;
     F32                 mLastTime;
     bool                mHasRunOnce;
+    bool                mForceUpdate;
     bool                mPaused;
     S32                 mPausedFrame;
     F32                 mTimeStep;
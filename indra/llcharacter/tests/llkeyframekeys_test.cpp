@@ -0,0 +1,421 @@
+/**
+ * @file llkeyframekeys_test.cpp
+ * @date 2024-11
+ * @brief LLKeyframeKeys and LLKeyframeBatch test cases.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llkeyframekeys.h"
+
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <random>
+
+#include "lltimer.h"
+
+#include "../test/lltut.h"
+
+namespace
+{
+    bool same_bits(const LLVector3& a, const LLVector3& b)
+    {
+        return memcmp(a.mV, b.mV, sizeof(a.mV)) == 0;
+    }
+
+    bool same_bits(const LLQuaternion& a, const LLQuaternion& b)
+    {
+        return memcmp(a.mQ, b.mQ, sizeof(a.mQ)) == 0;
+    }
+
+    // One joint of a motion, with its keys both in the std::map the curves
+    // used to keep and in LLKeyframeKeys
+    struct TestJoint
+    {
+        std::map<F32, LLQuaternion>         mRotationMap;
+        std::map<F32, LLVector3>            mPositionMap;
+        LLKeyframeKeys<LLQuaternion>        mRotationKeys;
+        LLKeyframeKeys<LLVector3>           mPositionKeys;
+    };
+
+    struct TestMotion
+    {
+        std::vector<TestJoint>  mJoints;
+        F32                     mDuration;
+    };
+
+    // What the curves' getValue() did before, a tree search then nlerp()
+    LLQuaternion map_rotation(const std::map<F32, LLQuaternion>& keys, F32 time)
+    {
+        auto right = keys.lower_bound(time);
+        if (right == keys.end())
+        {
+            return (--right)->second;
+        }
+        if (right == keys.begin() || right->first == time)
+        {
+            return right->second;
+        }
+        auto left = right; --left;
+        F32 u = (time - left->first) / (right->first - left->first);
+        return nlerp(u, left->second, right->second);
+    }
+
+    LLVector3 map_position(const std::map<F32, LLVector3>& keys, F32 time)
+    {
+        auto right = keys.lower_bound(time);
+        if (right == keys.end())
+        {
+            return (--right)->second;
+        }
+        if (right == keys.begin() || right->first == time)
+        {
+            return right->second;
+        }
+        auto left = right; --left;
+        F32 u = (time - left->first) / (right->first - left->first);
+        return lerp(left->second, right->second, u);
+    }
+
+    // A motion shaped like an AO stand or walk: every joint rotates, the
+    // pelvis moves too, keys at a steady rate with some jitter.
+    void make_motion(TestMotion& motion, S32 joints, F32 duration, F32 key_rate, std::mt19937& rand)
+    {
+        std::uniform_real_distribution<F32> unit(-1.f, 1.f);
+        motion.mDuration = duration;
+        motion.mJoints.resize(joints);
+        for (S32 j = 0; j < joints; ++j)
+        {
+            TestJoint& joint = motion.mJoints[j];
+            LLVector3 axis(unit(rand), unit(rand), unit(rand) + 2.f);
+            axis.normVec();
+            S32 num_keys = llmax(2, (S32)(duration * key_rate));
+            for (S32 k = 0; k < num_keys; ++k)
+            {
+                F32 time = duration * ((F32)k + 0.3f * unit(rand) * (k > 0)) / (F32)(num_keys - 1);
+                time = llclamp(time, 0.f, duration);
+                LLQuaternion rot(unit(rand) * F_PI * 0.5f, axis);
+                joint.mRotationMap[time] = rot;
+                joint.mRotationKeys[time] = rot;
+                if (j == 0)
+                {
+                    LLVector3 pos(unit(rand) * 0.1f, unit(rand) * 0.1f, unit(rand) * 0.05f);
+                    joint.mPositionMap[time] = pos;
+                    joint.mPositionKeys[time] = pos;
+                }
+            }
+        }
+    }
+
+    // Per avatar state, the cursors of every curve of every motion it plays
+    struct TestAvatar
+    {
+        std::vector<const TestMotion*>  mMotions;
+        std::vector<std::vector<S32> >  mCursors;
+        F32                             mOffset;
+    };
+
+    F32 motion_time(const TestMotion& motion, F32 time)
+    {
+        return fmodf(time, motion.mDuration);
+    }
+}
+
+namespace tut
+{
+    struct keyframekeys
+    {
+        std::mt19937 mRand;
+
+        keyframekeys() : mRand(2024) {}
+    };
+    typedef test_group<keyframekeys> keyframekeys_t;
+    typedef keyframekeys_t::object keyframekeys_object;
+    tut::keyframekeys_t tut_keyframekeys("LLKeyframeKeys");
+
+    // seek() finds what lower_bound() does wherever the cursor starts,
+    // playing forward, jumping and looping
+    template<> template<>
+    void keyframekeys_object::test<1>()
+    {
+        LLKeyframeKeys<S32> keys;
+        std::uniform_real_distribution<F32> key_time(0.f, 10.f);
+        for (S32 i = 0; i < 60; ++i)
+        {
+            keys[key_time(mRand)] = i;
+        }
+        keys[0.f] = -1;
+        keys[10.f] = -2;
+        keys[5.f] = -3;
+
+        F32 last = -1.f;
+        for (const auto& key : keys)
+        {
+            ensure("sorted", last < key.first);
+            last = key.first;
+        }
+
+        auto check = [&](F32 time, S32& cursor)
+        {
+            S32 found = keys.seek(time, cursor);
+            ensure_equals("seek", found, (S32)(keys.lower_bound(time) - keys.begin()));
+            ensure_equals("cursor", cursor, found);
+        };
+
+        // Playing forward at frame rate, looping a few times
+        S32 cursor = 0;
+        for (S32 frame = 0; frame < 2000; ++frame)
+        {
+            check(fmodf(frame / 45.f, 10.5f) - 0.25f, cursor);
+        }
+
+        // Exactly on keys
+        for (const auto& key : keys)
+        {
+            check(key.first, cursor);
+        }
+
+        // Random jumps from random, possibly stale, cursors
+        std::uniform_int_distribution<S32> any_cursor(-5, 70);
+        std::uniform_real_distribution<F32> any_time(-1.f, 11.f);
+        for (S32 i = 0; i < 2000; ++i)
+        {
+            cursor = any_cursor(mRand);
+            check(any_time(mRand), cursor);
+        }
+
+        // No keys at all
+        LLKeyframeKeys<S32> empty;
+        cursor = 3;
+        ensure_equals("empty", empty.seek(1.f, cursor), 0);
+        ensure_equals("empty cursor", cursor, 0);
+    }
+
+    // findKeys() picks the keys the curves always sampled
+    template<> template<>
+    void keyframekeys_object::test<2>()
+    {
+        LLKeyframeKeys<S32> keys;
+        keys[1.f] = 0;
+        keys[2.f] = 1;
+        keys[4.f] = 2;
+
+        S32 cursor = 0;
+        F32 u;
+        ensure_equals("before first", keys.findKeys(0.5f, cursor, u), 0);
+        ensure_equals("before first u", u, -1.f);
+        ensure_equals("on first", keys.findKeys(1.f, cursor, u), 0);
+        ensure_equals("on first u", u, -1.f);
+        ensure_equals("between", keys.findKeys(3.f, cursor, u), 2);
+        ensure_equals("between u", u, 0.5f);
+        ensure_equals("on key", keys.findKeys(2.f, cursor, u), 1);
+        ensure_equals("on key u", u, -1.f);
+        ensure_equals("past last", keys.findKeys(5.f, cursor, u), 2);
+        ensure_equals("past last u", u, -1.f);
+    }
+
+    // The batch gives the same bits as lerp() and nlerp(), on both
+    // hemispheres
+    template<> template<>
+    void keyframekeys_object::test<3>()
+    {
+        std::uniform_real_distribution<F32> unit(-1.f, 1.f);
+        std::uniform_real_distribution<F32> frac(0.f, 1.f);
+        LLKeyframeBatch batch;
+
+        std::vector<LLVector3> vectors;
+        std::vector<LLQuaternion> rotations;
+        for (S32 i = 0; i < 1000; ++i)
+        {
+            LLVector3 a(unit(mRand), unit(mRand), unit(mRand));
+            LLVector3 b(unit(mRand), unit(mRand), unit(mRand));
+            F32 u = frac(mRand);
+            ensure_equals("vector index", batch.addLerp(a, b, u), i);
+            vectors.push_back(lerp(a, b, u));
+
+            LLQuaternion p(unit(mRand) * F_PI, LLVector3(unit(mRand), unit(mRand), 1.f));
+            LLQuaternion q(unit(mRand) * F_PI, LLVector3(unit(mRand), 1.f, unit(mRand)));
+            ensure_equals("rotation index", batch.addNlerp(p, q, u), i);
+            rotations.push_back(nlerp(u, p, q));
+        }
+
+        batch.interpolate();
+
+        for (S32 i = 0; i < 1000; ++i)
+        {
+            ensure("lerp", same_bits(batch.getVector(i), vectors[i]));
+            ensure("nlerp", same_bits(batch.getRotation(i), rotations[i]));
+        }
+    }
+
+    // 100 avatars each playing an AO stand or walk with a hand and face
+    // overlay, sampled the way LLKeyframeMotion::applyKeyframes() did with
+    // std::map curves and the way it does now.
+    template<> template<>
+    void keyframekeys_object::test<4>()
+    {
+        if (!getenv("LL_TEST_BENCHMARK"))
+        {
+            skip("benchmark, set LL_TEST_BENCHMARK to run it");
+        }
+
+        const S32 AVATARS = 100;
+        const S32 FRAMES = 900;
+        const F32 FRAME_TIME = 1.f / 45.f;
+
+        std::vector<TestMotion> motions(4);
+        make_motion(motions[0], 26, 12.f, 30.f, mRand);    // stand
+        make_motion(motions[1], 26, 1.2f, 30.f, mRand);    // walk
+        make_motion(motions[2], 12, 4.f, 15.f, mRand);     // hands
+        make_motion(motions[3], 8, 6.f, 10.f, mRand);      // face
+
+        std::uniform_real_distribution<F32> offset(0.f, 20.f);
+        std::vector<TestAvatar> avatars(AVATARS);
+        for (S32 a = 0; a < AVATARS; ++a)
+        {
+            TestAvatar& avatar = avatars[a];
+            avatar.mMotions.push_back(&motions[a % 2]);
+            avatar.mMotions.push_back(&motions[2]);
+            avatar.mMotions.push_back(&motions[3]);
+            avatar.mOffset = offset(mRand);
+            for (const TestMotion* motion : avatar.mMotions)
+            {
+                // Rotation and position cursor per joint
+                avatar.mCursors.emplace_back(motion->mJoints.size() * 2, 0);
+            }
+        }
+
+        std::vector<LLQuaternion> map_rotations;
+        std::vector<LLVector3> map_positions;
+        LLTimer timer;
+        for (S32 frame = 0; frame < FRAMES; ++frame)
+        {
+            map_rotations.clear();
+            map_positions.clear();
+            for (const TestAvatar& avatar : avatars)
+            {
+                for (const TestMotion* motion : avatar.mMotions)
+                {
+                    F32 time = motion_time(*motion, avatar.mOffset + frame * FRAME_TIME);
+                    for (const TestJoint& joint : motion->mJoints)
+                    {
+                        map_rotations.push_back(map_rotation(joint.mRotationMap, time));
+                        if (!joint.mPositionMap.empty())
+                        {
+                            map_positions.push_back(map_position(joint.mPositionMap, time));
+                        }
+                    }
+                }
+            }
+        }
+        const F64 map_ms = timer.getElapsedTimeF64() * 1000.0 / FRAMES;
+
+        LLKeyframeBatch batch;
+        std::vector<LLQuaternion> rotations;
+        std::vector<LLVector3> positions;
+        std::vector<S32> rotation_slots;
+        std::vector<S32> position_slots;
+        timer.reset();
+        for (S32 frame = 0; frame < FRAMES; ++frame)
+        {
+            rotations.clear();
+            positions.clear();
+            for (TestAvatar& avatar : avatars)
+            {
+                for (size_t m = 0; m < avatar.mMotions.size(); ++m)
+                {
+                    const TestMotion* motion = avatar.mMotions[m];
+                    std::vector<S32>& cursors = avatar.mCursors[m];
+                    F32 time = motion_time(*motion, avatar.mOffset + frame * FRAME_TIME);
+
+                    // As JointSampler: keys found per joint, interpolated
+                    // together per motion
+                    batch.clear();
+                    rotation_slots.clear();
+                    position_slots.clear();
+                    for (size_t j = 0; j < motion->mJoints.size(); ++j)
+                    {
+                        const TestJoint& joint = motion->mJoints[j];
+                        F32 u;
+                        S32 right = joint.mRotationKeys.findKeys(time, cursors[j * 2], u);
+                        if (u < 0.f)
+                        {
+                            rotations.push_back(joint.mRotationKeys.getKey(right).second);
+                        }
+                        else
+                        {
+                            batch.addNlerp(joint.mRotationKeys.getKey(right - 1).second, joint.mRotationKeys.getKey(right).second, u);
+                            rotation_slots.push_back((S32)rotations.size());
+                            rotations.emplace_back();
+                        }
+
+                        if (!joint.mPositionKeys.empty())
+                        {
+                            right = joint.mPositionKeys.findKeys(time, cursors[j * 2 + 1], u);
+                            if (u < 0.f)
+                            {
+                                positions.push_back(joint.mPositionKeys.getKey(right).second);
+                            }
+                            else
+                            {
+                                batch.addLerp(joint.mPositionKeys.getKey(right - 1).second, joint.mPositionKeys.getKey(right).second, u);
+                                position_slots.push_back((S32)positions.size());
+                                positions.emplace_back();
+                            }
+                        }
+                    }
+
+                    batch.interpolate();
+                    for (S32 i = 0; i < batch.getNumRotations(); ++i)
+                    {
+                        rotations[rotation_slots[i]] = batch.getRotation(i);
+                    }
+                    for (S32 i = 0; i < batch.getNumVectors(); ++i)
+                    {
+                        positions[position_slots[i]] = batch.getVector(i);
+                    }
+                }
+            }
+        }
+        const F64 keys_ms = timer.getElapsedTimeF64() * 1000.0 / FRAMES;
+
+        std::cout << "\n"
+                  << "std::map curves:       " << map_ms << " ms per frame\n"
+                  << "Flat curves, cursors:  " << keys_ms << " ms per frame"
+                  << std::endl;
+
+        // Both sampled the last frame the same
+        ensure_equals("rotation count", rotations.size(), map_rotations.size());
+        ensure_equals("position count", positions.size(), map_positions.size());
+        for (size_t i = 0; i < rotations.size(); ++i)
+        {
+            ensure("rotation", same_bits(rotations[i], map_rotations[i]));
+        }
+        for (size_t i = 0; i < positions.size(); ++i)
+        {
+            ensure("position", same_bits(positions[i], map_positions[i]));
+        }
+    }
+}
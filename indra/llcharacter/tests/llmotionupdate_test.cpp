@@ -0,0 +1,290 @@
+/**
+ * @file llmotionupdate_test.cpp
+ * @date 2024-11
+ * @brief Test cases for evaluating character motions in parallel.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llcharacter.h"
+#include "../llmotion.h"
+#include "llframetimer.h"
+#include "lltimer.h"
+#include "v3dmath.h"
+
+#include <cstring>
+#include <iostream>
+#include <memory>
+
+#include "../test/lltut.h"
+
+namespace
+{
+    // About as many joints as the base avatar skeleton animates
+    const S32 JOINT_COUNT = 60;
+
+    const LLUUID SWING_MOTION_ID("5ee3e4a6-1dd2-4a7c-8bd0-3a0d7c4b2f01");
+    const LLUUID WAVE_MOTION_ID("5ee3e4a6-1dd2-4a7c-8bd0-3a0d7c4b2f02");
+
+    // A character with a binary tree of joints and nothing else
+    class TestCharacter : public LLCharacter
+    {
+    public:
+        TestCharacter()
+        :   mJoints(JOINT_COUNT)
+        {
+            for (S32 i = 0; i < JOINT_COUNT; ++i)
+            {
+                mJoints[i].setName(llformat("mJoint%d", i));
+                mJoints[i].setJointNum(i);
+                mJoints[i].setPosition(LLVector3(0.f, 0.f, 0.1f));
+                if (i > 0)
+                {
+                    mJoints[(i - 1) / 2].addChild(&mJoints[i]);
+                }
+            }
+        }
+
+        const char* getAnimationPrefix() override                   { return "test"; }
+        LLJoint* getRootJoint() override                            { return &mJoints[0]; }
+        LLVector3 getCharacterPosition() override                   { return LLVector3::zero; }
+        LLQuaternion getCharacterRotation() override                { return LLQuaternion::DEFAULT; }
+        LLVector3 getCharacterVelocity() override                   { return LLVector3::zero; }
+        LLVector3 getCharacterAngularVelocity() override            { return LLVector3::zero; }
+        F32 getTimeDilation() override                              { return 1.f; }
+        F32 getPixelArea() const override                           { return 100000.f; }
+        LLPolyMesh* getHeadMesh() override                          { return NULL; }
+        LLPolyMesh* getUpperBodyMesh() override                     { return NULL; }
+        LLVector3d getPosGlobalFromAgent(const LLVector3& position) override { return LLVector3d(position); }
+        LLVector3 getPosAgentFromGlobal(const LLVector3d& position) override { return LLVector3(position); }
+        void addDebugText(const std::string& text) override         {}
+        const LLUUID& getID() const override                        { return mID; }
+
+        void getGround(const LLVector3& in_pos, LLVector3& out_pos, LLVector3& out_norm) override
+        {
+            out_pos = in_pos;
+            out_pos.mV[VZ] = 0.f;
+            out_norm = LLVector3::z_axis;
+        }
+
+        LLJoint* getCharacterJoint(U32 i) override
+        {
+            return i < (U32)JOINT_COUNT ? &mJoints[i] : NULL;
+        }
+
+        std::vector<LLJoint> mJoints;
+        LLUUID mID;
+    };
+
+    // Sets the rotation and position of every stride-th joint every update,
+    // with some trigonometry standing in for sampling keyframes
+    class TestMotion : public LLMotion
+    {
+    public:
+        TestMotion(const LLUUID& id, S32 stride, LLJoint::JointPriority priority)
+        :   LLMotion(id),
+            mStride(stride),
+            mPriority(priority)
+        {
+        }
+
+        bool getLoop() override                         { return true; }
+        F32 getDuration() override                      { return 0.f; }
+        F32 getEaseInDuration() override                { return 0.f; }
+        F32 getEaseOutDuration() override               { return 0.f; }
+        LLJoint::JointPriority getPriority() override   { return mPriority; }
+        LLMotionBlendType getBlendType() override       { return NORMAL_BLEND; }
+        F32 getMinPixelArea() override                  { return 0.f; }
+        bool onActivate() override                      { return true; }
+        void onDeactivate() override                    {}
+
+        LLMotionInitStatus onInitialize(LLCharacter* character) override
+        {
+            for (S32 i = 0; i < JOINT_COUNT; i += mStride)
+            {
+                LLPointer<LLJointState> state = new LLJointState(character->getCharacterJoint(i));
+                state->setUsage(LLJointState::POS | LLJointState::ROT);
+                addJointState(state);
+                mStates.push_back(state);
+            }
+            return STATUS_SUCCESS;
+        }
+
+        bool onUpdate(F32 time, U8* joint_mask) override
+        {
+            for (size_t i = 0; i < mStates.size(); ++i)
+            {
+                F32 phase = time * 2.f + (F32)i * 0.3f;
+                LLQuaternion rot(sinf(phase) * 0.5f, LLVector3::x_axis);
+                rot *= LLQuaternion(cosf(phase * 0.7f) * 0.3f, LLVector3::z_axis);
+                mStates[i]->setRotation(rot);
+                mStates[i]->setPosition(LLVector3(0.f, 0.f, 0.1f + 0.01f * sinf(phase)));
+            }
+            return true;
+        }
+
+        static LLMotion* createSwing(const LLUUID& id)  { return new TestMotion(id, 1, LLJoint::MEDIUM_PRIORITY); }
+        static LLMotion* createWave(const LLUUID& id)   { return new TestMotion(id, 3, LLJoint::HIGH_PRIORITY); }
+
+    private:
+        S32 mStride;
+        LLJoint::JointPriority mPriority;
+        std::vector<LLPointer<LLJointState> > mStates;
+    };
+
+    typedef std::vector<std::unique_ptr<TestCharacter> > characters_t;
+
+    void make_characters(characters_t& characters, S32 count)
+    {
+        for (S32 i = 0; i < count; ++i)
+        {
+            TestCharacter* character = new TestCharacter();
+            character->registerMotion(SWING_MOTION_ID, TestMotion::createSwing);
+            character->registerMotion(WAVE_MOTION_ID, TestMotion::createWave);
+            character->startMotion(SWING_MOTION_ID);
+            character->startMotion(WAVE_MOTION_ID);
+            characters.emplace_back(character);
+        }
+    }
+
+    void update_serial(characters_t& characters)
+    {
+        for (auto& character : characters)
+        {
+            character->updateMotions(LLCharacter::NORMAL_UPDATE);
+        }
+    }
+
+    // As LLVOAvatar::updateDeferredMotions()
+    void update_parallel(characters_t& characters)
+    {
+        std::vector<LLCharacter*> deferred;
+        for (auto& character : characters)
+        {
+            if (character->beginUpdateMotions(LLCharacter::NORMAL_UPDATE))
+            {
+                deferred.push_back(character.get());
+            }
+        }
+        LLCharacter::evaluateMotionsInParallel(deferred);
+    }
+
+    bool same_pose(TestCharacter& a, TestCharacter& b)
+    {
+        for (S32 i = 0; i < JOINT_COUNT; ++i)
+        {
+            LLQuaternion rot_a = a.mJoints[i].getRotation();
+            LLQuaternion rot_b = b.mJoints[i].getRotation();
+            LLVector3 pos_a = a.mJoints[i].getPosition();
+            LLVector3 pos_b = b.mJoints[i].getPosition();
+            if (memcmp(rot_a.mQ, rot_b.mQ, sizeof(rot_a.mQ)) != 0 ||
+                memcmp(pos_a.mV, pos_b.mV, sizeof(pos_a.mV)) != 0)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+namespace tut
+{
+    struct motionupdate_data
+    {
+    };
+    typedef test_group<motionupdate_data> motionupdate_test;
+    typedef motionupdate_test::object motionupdate_object;
+    tut::motionupdate_test motionupdate_testcase("LLMotionUpdate");
+
+    // Evaluating in parallel poses characters exactly as updating them one
+    // at a time does
+    template<> template<>
+    void motionupdate_object::test<1>()
+    {
+        const S32 CHARACTERS = 24;
+        const S32 FRAMES = 30;
+
+        characters_t serial;
+        characters_t parallel;
+        make_characters(serial, CHARACTERS);
+        make_characters(parallel, CHARACTERS);
+
+        for (S32 frame = 0; frame < FRAMES; ++frame)
+        {
+            LLFrameTimer::updateFrameTime();
+            update_serial(serial);
+            update_parallel(parallel);
+        }
+
+        for (S32 i = 0; i < CHARACTERS; ++i)
+        {
+            ensure(llformat("character %d pose", i), same_pose(*serial[i], *parallel[i]));
+        }
+        ensure("joints were animated", serial[0]->mJoints[1].getRotation() != LLQuaternion::DEFAULT);
+    }
+
+    // Scaling with the number of characters.  Only informative: the speedup
+    // depends on the cores available.
+    template<> template<>
+    void motionupdate_object::test<2>()
+    {
+        if (!getenv("LL_TEST_BENCHMARK"))
+        {
+            skip("benchmark, set LL_TEST_BENCHMARK to run it");
+        }
+
+        const S32 FRAMES = 60;
+        const S32 counts[] = { 10, 50, 200 };
+
+        std::cout << "\n";
+        for (S32 count : counts)
+        {
+            characters_t serial;
+            characters_t parallel;
+            make_characters(serial, count);
+            make_characters(parallel, count);
+
+            LLTimer timer;
+            for (S32 frame = 0; frame < FRAMES; ++frame)
+            {
+                LLFrameTimer::updateFrameTime();
+                update_serial(serial);
+            }
+            const F64 serial_ms = timer.getElapsedTimeF64() * 1000.0 / FRAMES;
+
+            timer.reset();
+            for (S32 frame = 0; frame < FRAMES; ++frame)
+            {
+                LLFrameTimer::updateFrameTime();
+                update_parallel(parallel);
+            }
+            const F64 parallel_ms = timer.getElapsedTimeF64() * 1000.0 / FRAMES;
+
+            std::cout << count << " characters: "
+                      << serial_ms << " ms per frame serial, "
+                      << parallel_ms << " ms per frame parallel\n";
+        }
+        std::cout << std::flush;
+    }
+}
@@ -0,0 +1,207 @@
+/**
+ * @file llindexedheap.h
+ * @brief Max-heap whose entries can be found, reprioritized and removed.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLINDEXEDHEAP_H
+#define LL_LLINDEXEDHEAP_H
+
+#include "llerror.h"
+
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+//--------------------------------------------------------
+// LLIndexedHeap
+//
+// Binary max-heap of unique keys, with a map from each key to its heap
+// slot so that a key's priority can be changed or the key removed in
+// O(log n) without searching.  Ties come out in no particular order.
+//--------------------------------------------------------
+
+template <typename Key, typename Priority, typename Hash = std::hash<Key> >
+class LLIndexedHeap
+{
+public:
+    typedef std::pair<Key, Priority> entry_t;
+    typedef typename std::vector<entry_t>::size_type size_type;
+
+    bool empty() const { return mHeap.empty(); }
+    size_type size() const { return mHeap.size(); }
+
+    void clear()
+    {
+        mHeap.clear();
+        mSlots.clear();
+    }
+
+    bool contains(const Key& key) const { return mSlots.find(key) != mSlots.end(); }
+
+    // Add key, or move it to its new priority if it is already queued.
+    void push(const Key& key, Priority priority)
+    {
+        auto inserted = mSlots.emplace(key, mHeap.size());
+        if (inserted.second)
+        {
+            mHeap.emplace_back(key, priority);
+            siftUp(mHeap.size() - 1);
+        }
+        else
+        {
+            update(inserted.first->second, priority);
+        }
+    }
+
+    // Like push(), but never lowers the priority of a queued key.
+    void pushMax(const Key& key, Priority priority)
+    {
+        auto inserted = mSlots.emplace(key, mHeap.size());
+        if (inserted.second)
+        {
+            mHeap.emplace_back(key, priority);
+            siftUp(mHeap.size() - 1);
+        }
+        else if (mHeap[inserted.first->second].second < priority)
+        {
+            update(inserted.first->second, priority);
+        }
+    }
+
+    // Returns false if key was not queued.
+    bool erase(const Key& key)
+    {
+        auto found = mSlots.find(key);
+        if (found == mSlots.end())
+        {
+            return false;
+        }
+        removeAt(found->second);
+        return true;
+    }
+
+    const Key& top() const
+    {
+        llassert(!mHeap.empty());
+        return mHeap.front().first;
+    }
+
+    Priority topPriority() const
+    {
+        llassert(!mHeap.empty());
+        return mHeap.front().second;
+    }
+
+    void pop()
+    {
+        llassert(!mHeap.empty());
+        removeAt(0);
+    }
+
+private:
+    void update(size_type slot, Priority priority)
+    {
+        const bool raised = mHeap[slot].second < priority;
+        mHeap[slot].second = priority;
+        if (raised)
+        {
+            siftUp(slot);
+        }
+        else
+        {
+            siftDown(slot);
+        }
+    }
+
+    void removeAt(size_type slot)
+    {
+        mSlots.erase(mHeap[slot].first);
+        const size_type last = mHeap.size() - 1;
+        if (slot != last)
+        {
+            mHeap[slot] = std::move(mHeap[last]);
+            mSlots[mHeap[slot].first] = slot;
+            mHeap.pop_back();
+            // The moved entry may belong above or below its new slot
+            siftDown(siftUp(slot));
+        }
+        else
+        {
+            mHeap.pop_back();
+        }
+    }
+
+    size_type siftUp(size_type slot)
+    {
+        while (slot > 0)
+        {
+            const size_type parent = (slot - 1) / 2;
+            if (!(mHeap[parent].second < mHeap[slot].second))
+            {
+                break;
+            }
+            swapSlots(slot, parent);
+            slot = parent;
+        }
+        return slot;
+    }
+
+    void siftDown(size_type slot)
+    {
+        const size_type count = mHeap.size();
+        while (true)
+        {
+            size_type largest = slot;
+            const size_type left = slot * 2 + 1;
+            const size_type right = left + 1;
+            if (left < count && mHeap[largest].second < mHeap[left].second)
+            {
+                largest = left;
+            }
+            if (right < count && mHeap[largest].second < mHeap[right].second)
+            {
+                largest = right;
+            }
+            if (largest == slot)
+            {
+                break;
+            }
+            swapSlots(slot, largest);
+            slot = largest;
+        }
+    }
+
+    void swapSlots(size_type a, size_type b)
+    {
+        std::swap(mHeap[a], mHeap[b]);
+        mSlots[mHeap[a].first] = a;
+        mSlots[mHeap[b].first] = b;
+    }
+
+    std::vector<entry_t> mHeap;
+    std::unordered_map<Key, size_type, Hash> mSlots;
+};
+
+#endif // LL_LLINDEXEDHEAP_H
@@ -1297,6 +1297,277 @@ bool LLSDBinaryParser::parseString(
 }
 
 
+/**
+ * LLSDBinaryView
+ */
+namespace
+{
+    U32 read_size_nbo(const U8* pos)
+    {
+        U32 value_nbo = 0;
+        memcpy(&value_nbo, pos, sizeof(U32));
+        return ntohl(value_nbo);
+    }
+}
+
+LLSDBinaryView::LLSDBinaryView()
+:   mPos(nullptr),
+    mEnd(nullptr),
+    mValid(true)
+{
+}
+
+LLSDBinaryView::LLSDBinaryView(const U8* data, size_t size, S32 max_depth)
+:   mPos(nullptr),
+    mEnd(nullptr),
+    mValid(false)
+{
+    if (data && size && skip(data, data + size, max_depth))
+    {
+        mPos = data;
+        mEnd = data + size;
+        mValid = true;
+    }
+}
+
+// Only used for values inside a buffer that has already been validated.
+LLSDBinaryView::LLSDBinaryView(const U8* pos, const U8* end)
+:   mPos(pos),
+    mEnd(end),
+    mValid(true)
+{
+}
+
+// static
+const U8* LLSDBinaryView::skip(const U8* pos, const U8* end, S32 max_depth)
+{
+    if (pos >= end || max_depth == 0)
+    {
+        return nullptr;
+    }
+    auto need = [end](const U8* at, size_t bytes) -> const U8*
+    {
+        return (size_t)(end - at) >= bytes ? at + bytes : nullptr;
+    };
+
+    switch (*pos++)
+    {
+    case '!':
+    case '1':
+    case '0':
+        return pos;
+    case 'i':
+        return need(pos, sizeof(S32));
+    case 'r':
+    case 'd':
+        return need(pos, sizeof(F64));
+    case 'u':
+        return need(pos, UUID_BYTES);
+    case 's':
+    case 'l':
+    case 'b':
+    {
+        if (!need(pos, sizeof(U32)))
+        {
+            return nullptr;
+        }
+        U32 size = read_size_nbo(pos);
+        return need(pos + sizeof(U32), size);
+    }
+    case '[':
+    {
+        if (!need(pos, sizeof(U32)))
+        {
+            return nullptr;
+        }
+        U32 count = read_size_nbo(pos);
+        pos += sizeof(U32);
+        for (U32 i = 0; i < count && pos; ++i)
+        {
+            pos = skip(pos, end, max_depth - 1);
+        }
+        return (pos && pos < end && *pos == ']') ? pos + 1 : nullptr;
+    }
+    case '{':
+    {
+        if (!need(pos, sizeof(U32)))
+        {
+            return nullptr;
+        }
+        U32 count = read_size_nbo(pos);
+        pos += sizeof(U32);
+        for (U32 i = 0; i < count && pos; ++i)
+        {
+            if (!need(pos, 1 + sizeof(U32)) || *pos != 'k')
+            {
+                return nullptr;
+            }
+            U32 key_size = read_size_nbo(pos + 1);
+            pos = need(pos + 1 + sizeof(U32), key_size);
+            if (pos)
+            {
+                pos = skip(pos, end, max_depth - 1);
+            }
+        }
+        return (pos && pos < end && *pos == '}') ? pos + 1 : nullptr;
+    }
+    default:
+        return nullptr;
+    }
+}
+
+LLSD::Type LLSDBinaryView::type() const
+{
+    if (!mPos)
+    {
+        return LLSD::TypeUndefined;
+    }
+    switch (*mPos)
+    {
+    case '1':
+    case '0': return LLSD::TypeBoolean;
+    case 'i': return LLSD::TypeInteger;
+    case 'r': return LLSD::TypeReal;
+    case 'u': return LLSD::TypeUUID;
+    case 's': return LLSD::TypeString;
+    case 'l': return LLSD::TypeURI;
+    case 'b': return LLSD::TypeBinary;
+    case 'd': return LLSD::TypeDate;
+    case '[': return LLSD::TypeArray;
+    case '{': return LLSD::TypeMap;
+    default:  return LLSD::TypeUndefined;
+    }
+}
+
+size_t LLSDBinaryView::size() const
+{
+    switch (type())
+    {
+    case LLSD::TypeMap:
+    case LLSD::TypeArray:
+    case LLSD::TypeString:
+    case LLSD::TypeURI:
+    case LLSD::TypeBinary:
+        return read_size_nbo(mPos + 1);
+    default:
+        return 0;
+    }
+}
+
+LLSDBinaryView LLSDBinaryView::operator[](size_t index) const
+{
+    if (!isArray() || index >= size())
+    {
+        return LLSDBinaryView();
+    }
+    const U8* pos = mPos + 1 + sizeof(U32);
+    for (size_t i = 0; i < index; ++i)
+    {
+        pos = skip(pos, mEnd, -1);
+    }
+    return LLSDBinaryView(pos, mEnd);
+}
+
+LLSDBinaryView LLSDBinaryView::operator[](std::string_view key) const
+{
+    if (!isMap())
+    {
+        return LLSDBinaryView();
+    }
+    const U8* pos = mPos + 1 + sizeof(U32);
+    for (size_t i = 0, count = size(); i < count; ++i)
+    {
+        U32 key_size = read_size_nbo(pos + 1);
+        std::string_view name((const char*)pos + 1 + sizeof(U32), key_size);
+        pos += 1 + sizeof(U32) + key_size;
+        if (name == key)
+        {
+            return LLSDBinaryView(pos, mEnd);
+        }
+        pos = skip(pos, mEnd, -1);
+    }
+    return LLSDBinaryView();
+}
+
+bool LLSDBinaryView::has(std::string_view key) const
+{
+    return (*this)[key].mPos != nullptr;
+}
+
+const U8* LLSDBinaryView::data() const
+{
+    switch (type())
+    {
+    case LLSD::TypeString:
+    case LLSD::TypeURI:
+    case LLSD::TypeBinary:
+        return mPos + 1 + sizeof(U32);
+    default:
+        return nullptr;
+    }
+}
+
+std::string_view LLSDBinaryView::asStringView() const
+{
+    const U8* payload = data();
+    return payload ? std::string_view((const char*)payload, size()) : std::string_view();
+}
+
+LLSD::Boolean LLSDBinaryView::asBoolean() const
+{
+    switch (type())
+    {
+    case LLSD::TypeBoolean: return *mPos == '1';
+    case LLSD::TypeInteger: return asInteger() != 0;
+    case LLSD::TypeReal:    return asReal() != 0.0;
+    default:                return false;
+    }
+}
+
+LLSD::Integer LLSDBinaryView::asInteger() const
+{
+    switch (type())
+    {
+    case LLSD::TypeBoolean: return *mPos == '1' ? 1 : 0;
+    case LLSD::TypeInteger: return (S32)read_size_nbo(mPos + 1);
+    case LLSD::TypeReal:
+    {
+        F64 real = asReal();
+        return !std::isnan(real) ? (LLSD::Integer)real : 0;
+    }
+    default:                return 0;
+    }
+}
+
+LLSD::Real LLSDBinaryView::asReal() const
+{
+    switch (type())
+    {
+    case LLSD::TypeBoolean: return *mPos == '1' ? 1.0 : 0.0;
+    case LLSD::TypeInteger: return (F64)asInteger();
+    case LLSD::TypeReal:
+    {
+        F64 real_nbo = 0.0;
+        memcpy(&real_nbo, mPos + 1, sizeof(F64));
+        return ll_ntohd(real_nbo);
+    }
+    default:                return 0.0;
+    }
+}
+
+LLSD LLSDBinaryView::asLLSD() const
+{
+    LLSD sd;
+    if (mPos)
+    {
+        const U8* end = skip(mPos, mEnd, -1);
+        boost::iostreams::stream<boost::iostreams::array_source> istrm((const char*)mPos, end - mPos);
+        LLSDSerialize::fromBinary(sd, istrm, end - mPos);
+    }
+    return sd;
+}
+
+
 /**
  * LLSDFormatter
  */
@@ -2254,18 +2525,40 @@ LLUZipHelper::EZipRresult LLUZipHelper::unzip_llsd(LLSD& data, std::istream& is,
 
 LLUZipHelper::EZipRresult LLUZipHelper::unzip_llsd(LLSD& data, const U8* in, S32 size)
 {
-    U8* result = NULL;
-    llssize cur_size = 0;
-    z_stream strm;
+    std::vector<U8> result;
+    EZipRresult ret = unzip_buffer(result, in, size);
+    if (ret != ZR_OK)
+    {
+        return ret;
+    }
+
+    //result now holds the decompressed LLSD block
+    boost::iostreams::stream<boost::iostreams::array_source> istrm((const char*)result.data(), result.size());
 
-    constexpr U32 CHUNK = 1024 * 512;
+    if (!LLSDSerialize::fromBinary(data, istrm, result.size(), UNZIP_LLSD_MAX_DEPTH))
+    {
+        return ZR_PARSE_ERROR;
+    }
+    return ZR_OK;
+}
 
-    static thread_local std::unique_ptr<U8[]> out;
-    if (!out)
+LLUZipHelper::EZipRresult LLUZipHelper::unzip_buffer(std::vector<U8>& out, std::istream& is, S32 size)
+{
+    std::unique_ptr<U8[]> in = std::unique_ptr<U8[]>(new(std::nothrow) U8[size]);
+    if (!in)
     {
-        out = std::unique_ptr<U8[]>(new(std::nothrow) U8[CHUNK]);
+        return ZR_MEM_ERROR;
     }
+    is.read((char*) in.get(), size);
+
+    return unzip_buffer(out, in.get(), size);
+}
+
+LLUZipHelper::EZipRresult LLUZipHelper::unzip_buffer(std::vector<U8>& out, const U8* in, S32 size)
+{
+    out.clear();
 
+    z_stream strm;
     strm.zalloc = Z_NULL;
     strm.zfree = Z_NULL;
     strm.opaque = Z_NULL;
@@ -2273,89 +2566,72 @@ LLUZipHelper::EZipRresult LLUZipHelper::unzip_llsd(LLSD& data, const U8* in, S32
     strm.next_in = const_cast<U8*>(in);
 
     S32 ret = inflateInit(&strm);
-
-    do
+    if (ret != Z_OK)
     {
-        strm.avail_out = CHUNK;
-        strm.next_out = out.get();
-        ret = inflate(&strm, Z_NO_FLUSH);
-        switch (ret)
-        {
-        case Z_NEED_DICT:
-        case Z_DATA_ERROR:
-        {
-            inflateEnd(&strm);
-            // free(result);
-            if( result )
-                free(result);
-            return ZR_DATA_ERROR;
-        }
-        case Z_STREAM_ERROR:
-        case Z_BUF_ERROR:
-        {
-            inflateEnd(&strm);
-            free(result);
-            return ZR_BUFFER_ERROR;
-        }
+        return ZR_MEM_ERROR;
+    }
 
-        case Z_MEM_ERROR:
-        {
-            inflateEnd(&strm);
-            // free(result);
-            if( result )
-                free(result);
-            return ZR_MEM_ERROR;
-        }
-        }
+    // Inflate straight into the output, growing it as needed, rather than
+    // going through a bounce buffer.
+    constexpr size_t CHUNK = 1024 * 512;
+    size_t cur_size = 0;
 
-        U32 have = CHUNK-strm.avail_out;
-
-        U8* new_result = (U8*)realloc(result, cur_size + have);
-        if (new_result == NULL)
+    try
+    {
+        do
         {
-            inflateEnd(&strm);
-            if (result)
+            if (out.size() - cur_size < CHUNK)
             {
-                free(result);
+                out.resize(cur_size + llmax(CHUNK, cur_size / 2));
             }
-            return ZR_MEM_ERROR;
-        }
-        result = new_result;
-        memcpy(result+cur_size, out.get(), have);
-        cur_size += have;
-
-    } while (ret == Z_OK && ret != Z_STREAM_END);
+            strm.avail_out = (uInt)(out.size() - cur_size);
+            strm.next_out = out.data() + cur_size;
+            ret = inflate(&strm, Z_NO_FLUSH);
+            switch (ret)
+            {
+            case Z_NEED_DICT:
+            case Z_DATA_ERROR:
+                inflateEnd(&strm);
+                out.clear();
+                return ZR_DATA_ERROR;
+            case Z_STREAM_ERROR:
+            case Z_BUF_ERROR:
+                inflateEnd(&strm);
+                out.clear();
+                return ZR_BUFFER_ERROR;
+            case Z_MEM_ERROR:
+                inflateEnd(&strm);
+                out.clear();
+                return ZR_MEM_ERROR;
+            }
+            cur_size = out.size() - strm.avail_out;
+        } while (ret == Z_OK);
+    }
+    catch (const std::bad_alloc&)
+    {
+        inflateEnd(&strm);
+        out.clear();
+        return ZR_MEM_ERROR;
+    }
 
     inflateEnd(&strm);
 
     if (ret != Z_STREAM_END)
     {
-        // free(result);
-        if( result )
-            free(result);
+        out.clear();
         return ZR_DATA_ERROR;
     }
 
-    //result now points to the decompressed LLSD block
+    llssize stripped_size = cur_size;
+    char* start = strip_deprecated_header((char*)out.data(), stripped_size);
+    out.resize(cur_size);
+    if (start != (char*)out.data())
     {
-        char* result_ptr = strip_deprecated_header((char*)result, cur_size);
-
-        boost::iostreams::stream<boost::iostreams::array_source> istrm(result_ptr, cur_size);
-
-        if (!LLSDSerialize::fromBinary(data, istrm, cur_size, UNZIP_LLSD_MAX_DEPTH))
-        {
-            // free(result);
-            if( result )
-                free(result);
-            return ZR_PARSE_ERROR;
-        }
+        out.erase(out.begin(), out.begin() + (cur_size - stripped_size));
     }
-
-    // free(result);
-    if( result )
-        free(result);
     return ZR_OK;
 }
+
 //This unzip function will only work with a gzip header and trailer - while the contents
 //of the actual compressed data is the same for either format (gzip vs zlib ), the headers
 //and trailers are different for the formats.
@@ -409,6 +409,97 @@ private:
 };
 
 
+/**
+ * @class LLSDBinaryView
+ * @brief Read-only view of binary formatted LLSD held in memory.
+ *
+ * Unlike LLSDBinaryParser this never builds an LLSD tree. Binary and
+ * string values are exposed as pointers into the caller's buffer, which
+ * must outlive every view taken from it. The whole buffer is validated
+ * once on construction; maps and arrays are then walked on demand, so
+ * lookups are linear in the size of the container being searched.
+ *
+ * Only the 'k' key encoding written by LLSDBinaryFormatter is accepted
+ * for map keys, anything else makes the view invalid.
+ */
+class LL_COMMON_API LLSDBinaryView
+{
+public:
+    /**
+     * @brief Construct an undefined view.
+     */
+    LLSDBinaryView();
+
+    /**
+     * @brief Construct a view of the single value at the start of data.
+     *
+     * @param data The binary LLSD, without the deprecated header.
+     * @param size The number of bytes available at data.
+     * @param max_depth Max nesting depth before the view is rejected,
+     *  -1 - unlimited.
+     */
+    LLSDBinaryView(const U8* data, size_t size, S32 max_depth = -1);
+
+    /**
+     * @brief Returns false if the buffer passed to the constructor did
+     * not hold a complete binary LLSD value.
+     */
+    bool isValid() const { return mValid; }
+
+    LLSD::Type type() const;
+    bool isUndefined() const { return type() == LLSD::TypeUndefined; }
+    bool isMap() const { return type() == LLSD::TypeMap; }
+    bool isArray() const { return type() == LLSD::TypeArray; }
+    bool isBinary() const { return type() == LLSD::TypeBinary; }
+
+    /**
+     * @brief Number of entries for maps and arrays, number of bytes for
+     * binaries and strings, 0 otherwise.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Array element, or an undefined view when out of range.
+     */
+    LLSDBinaryView operator[](size_t index) const;
+    LLSDBinaryView operator[](LLSD::Integer index) const { return (*this)[size_t(index)]; }
+
+    /**
+     * @brief Map value, or an undefined view when the key is absent.
+     */
+    LLSDBinaryView operator[](std::string_view key) const;
+    LLSDBinaryView operator[](const char* key) const { return (*this)[std::string_view(key)]; }
+    bool has(std::string_view key) const;
+
+    /**
+     * @brief Payload of a binary, string or uri value. Points into the
+     * viewed buffer and is NOT aligned.
+     */
+    const U8* data() const;
+    std::string_view asStringView() const;
+
+    LLSD::Boolean asBoolean() const;
+    LLSD::Integer asInteger() const;
+    LLSD::Real asReal() const;
+
+    /**
+     * @brief Copy this value, and everything below it, into an LLSD.
+     */
+    LLSD asLLSD() const;
+
+private:
+    LLSDBinaryView(const U8* pos, const U8* end);
+
+    // Returns a pointer just past the value starting at pos, or nullptr
+    // if the value is malformed or runs past end.
+    static const U8* skip(const U8* pos, const U8* end, S32 max_depth);
+
+    const U8* mPos;
+    const U8* mEnd;
+    bool mValid;
+};
+
+
 /**
  * @class LLSDFormatter
  * @brief Abstract base class for formatting LLSD.
@@ -864,6 +955,11 @@ public:
     // return OK or reason for failure
     static EZipRresult unzip_llsd(LLSD& data, std::istream& is, S32 size);
     static EZipRresult unzip_llsd(LLSD& data, const U8* in, S32 size);
+
+    // Inflate without parsing. On success out holds the binary LLSD,
+    // with any deprecated header already stripped.
+    static EZipRresult unzip_buffer(std::vector<U8>& out, const U8* in, S32 size);
+    static EZipRresult unzip_buffer(std::vector<U8>& out, std::istream& is, S32 size);
 };
 
 //dirty little zip functions -- yell at davep
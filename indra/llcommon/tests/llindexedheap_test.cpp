@@ -0,0 +1,166 @@
+/**
+ * @file   llindexedheap_test.cpp
+ * @date   2024-11
+ * @brief  Test for llindexedheap.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Copyright (c) 2024, Linden Research, Inc.
+ * $/LicenseInfo$
+ */
+
+// Precompiled header
+#include "linden_common.h"
+// associated header
+#include "llindexedheap.h"
+// STL headers
+#include <algorithm>
+#include <map>
+// std headers
+// external library headers
+// other Linden headers
+#include "../test/lltut.h"
+
+namespace
+{
+    U32 next_random(U32& state)
+    {
+        state = state * 1103515245u + 12345u;
+        return state >> 8;
+    }
+}
+
+/*****************************************************************************
+*   TUT
+*****************************************************************************/
+namespace tut
+{
+    struct llindexedheap_data
+    {
+        typedef LLIndexedHeap<S32, F32> heap_t;
+    };
+    typedef test_group<llindexedheap_data> llindexedheap_group;
+    typedef llindexedheap_group::object object;
+    llindexedheap_group llindexedheapgrp("llindexedheap");
+
+    template<> template<>
+    void object::test<1>()
+    {
+        set_test_name("pops in priority order after updates and erasures");
+        heap_t heap;
+        std::map<S32, F32> expected;
+        U32 state = 1;
+        for (S32 i = 0; i < 20000; ++i)
+        {
+            const S32 key = (S32)(next_random(state) % 500);
+            const F32 priority = (F32)(next_random(state) % 1000);
+            switch (next_random(state) % 4)
+            {
+            case 0:
+                heap.push(key, priority);
+                expected[key] = priority;
+                break;
+            case 1:
+                heap.pushMax(key, priority);
+                if (expected.find(key) == expected.end() || expected[key] < priority)
+                {
+                    expected[key] = priority;
+                }
+                break;
+            case 2:
+                ensure_equals("erase result", heap.erase(key), expected.erase(key) == 1);
+                break;
+            default:
+                if (!expected.empty())
+                {
+                    F32 best = -1.f;
+                    for (const auto& entry : expected)
+                    {
+                        best = llmax(best, entry.second);
+                    }
+                    ensure_equals("top priority", heap.topPriority(), best);
+                    ensure_equals("top key priority", expected[heap.top()], best);
+                    expected.erase(heap.top());
+                    heap.pop();
+                }
+                break;
+            }
+            ensure_equals("size", heap.size(), expected.size());
+        }
+
+        F32 last = 1.e9f;
+        while (!heap.empty())
+        {
+            ensure("contains", heap.contains(heap.top()));
+            ensure("non-increasing", heap.topPriority() <= last);
+            last = heap.topPriority();
+            expected.erase(heap.top());
+            heap.pop();
+        }
+        ensure("drained", expected.empty());
+    }
+
+    template<> template<>
+    void object::test<2>()
+    {
+        set_test_name("taking the largest first reaches new entries before a sweep does");
+        // An illustration of the scheduling, not a measurement of how soon
+        // the viewer sharpens a texture: a few textures come into view every
+        // frame and 2% of them are updated per frame, either round-robin or
+        // largest first from the heap. Since fewer are pushed than popped per
+        // frame the heap always catches up within the frame, which is what
+        // the heap guarantees rather than anything found out here; the sweep
+        // has to come round to each one.
+        const S32 TEXTURES = 20000;
+        const S32 UPDATES_PER_FRAME = TEXTURES / 50;
+        const S32 FRAMES = 500;
+
+        std::vector<S32> shown(TEXTURES, -1);
+        std::vector<F32> size(TEXTURES, 0.f);
+        heap_t heap;
+        S32 sweep = 0;
+        U32 state = 7;
+        S32 sweep_worst = 0;
+        S32 heap_worst = 0;
+        std::vector<bool> swept(TEXTURES, true);
+        std::vector<bool> popped(TEXTURES, true);
+
+        for (S32 frame = 0; frame < FRAMES; ++frame)
+        {
+            for (S32 i = 0; i < 20; ++i)
+            {
+                const S32 texture = (S32)(next_random(state) % TEXTURES);
+                shown[texture] = frame;
+                size[texture] = (F32)(next_random(state) % 1024 + 1);
+                swept[texture] = false;
+                popped[texture] = false;
+                heap.pushMax(texture, size[texture]);
+            }
+
+            for (S32 i = 0; i < UPDATES_PER_FRAME; ++i)
+            {
+                sweep = (sweep + 1) % TEXTURES;
+                if (!swept[sweep])
+                {
+                    swept[sweep] = true;
+                    const S32 wait = frame - shown[sweep];
+                    sweep_worst = llmax(sweep_worst, wait);
+                }
+            }
+
+            for (S32 i = 0; i < UPDATES_PER_FRAME && !heap.empty(); ++i)
+            {
+                const S32 texture = heap.top();
+                heap.pop();
+                if (!popped[texture])
+                {
+                    popped[texture] = true;
+                    const S32 wait = frame - shown[texture];
+                    heap_worst = llmax(heap_worst, wait);
+                }
+            }
+        }
+
+        ensure_equals("heap drains what was pushed in the same frame", heap_worst, 0);
+        ensure("round robin lags", sweep_worst > 10);
+    }
+} // namespace tut
@@ -1584,12 +1584,86 @@ namespace tut
             1);
     }
 
-/*
     template<> template<>
     void TestLLSDBinaryParsingObject::test<11>()
     {
+        // LLSDBinaryView must see the same values the parser would
+        LLSD face;
+        face["Position"] = LLSD::Binary{ 1, 2, 3, 4, 5, 6 };
+        face["TriangleList"] = LLSD::Binary();
+        face["PositionDomain"]["Min"] = llsd::array(-0.5, 0.25, 1.0);
+        face["Count"] = 42;
+        face["Flag"] = true;
+        face["Name"] = "face";
+        LLSD input = llsd::array(face, LLSD(), LLSD::emptyMap());
+
+        std::ostringstream ostr;
+        LLSDSerialize::toBinary(input, ostr);
+        const std::string bin = ostr.str();
+        const U8* data = (const U8*)bin.data();
+
+        LLSDBinaryView view(data, bin.size());
+        ensure("valid", view.isValid());
+        ensure("array", view.isArray());
+        ensure_equals("face count", view.size(), input.size());
+        ensure("undefined element", view[1].isUndefined());
+        ensure("empty map", view[2].isMap() && view[2].size() == 0);
+        ensure("out of range", view[3].isUndefined());
+
+        LLSDBinaryView fv = view[0];
+        ensure("has key", fv.has("Count"));
+        ensure("missing key", !fv.has("Weights"));
+        ensure_equals("integer", fv["Count"].asInteger(), 42);
+        ensure("boolean", fv["Flag"].asBoolean());
+        ensure_equals("string", std::string(fv["Name"].asStringView()), "face");
+        ensure_equals("real", fv["PositionDomain"]["Min"][0].asReal(), -0.5);
+        ensure_equals("real", fv["PositionDomain"]["Min"][2].asReal(), 1.0);
+
+        LLSDBinaryView pos = fv["Position"];
+        ensure("binary", pos.isBinary());
+        ensure_equals("binary size", pos.size(), size_t(6));
+        ensure("binary is a view", pos.data() > data && pos.data() + pos.size() <= data + bin.size());
+        ensure("binary contents", std::equal(pos.data(), pos.data() + pos.size(), face["Position"].asBinary().begin()));
+        ensure_equals("empty binary", fv["TriangleList"].size(), size_t(0));
+
+        ensure_equals("asLLSD", view.asLLSD(), input);
+        ensure_equals("asLLSD subtree", fv["PositionDomain"].asLLSD(), face["PositionDomain"]);
+
+        // truncated or too deep input is rejected up front
+        for (size_t size = 0; size < bin.size(); ++size)
+        {
+            ensure("truncated", !LLSDBinaryView(data, size).isValid());
+        }
+        ensure("too deep", !LLSDBinaryView(data, bin.size(), 4).isValid());
+        ensure("deep enough", LLSDBinaryView(data, bin.size(), 5).isValid());
+    }
+
+    template<> template<>
+    void TestLLSDBinaryParsingObject::test<12>()
+    {
+        // unzip_buffer must hand back the same bytes unzip_llsd parses
+        LLSD input = llsd::array(llsd::map("Position", LLSD::Binary(1000, 7)), 3);
+        std::string zipped = zip_llsd(input);
+        ensure("zipped", !zipped.empty());
+
+        std::vector<U8> buffer;
+        ensure_equals("unzip_buffer",
+                      LLUZipHelper::unzip_buffer(buffer, (const U8*)zipped.data(), static_cast<S32>(zipped.size())),
+                      LLUZipHelper::ZR_OK);
+        LLSDBinaryView view(buffer.data(), buffer.size());
+        ensure("valid", view.isValid());
+        ensure_equals("view", view.asLLSD(), input);
+
+        LLSD parsed;
+        ensure_equals("unzip_llsd",
+                      LLUZipHelper::unzip_llsd(parsed, (const U8*)zipped.data(), static_cast<S32>(zipped.size())),
+                      LLUZipHelper::ZR_OK);
+        ensure_equals("parsed", parsed, input);
+
+        ensure("truncated",
+               LLUZipHelper::unzip_buffer(buffer, (const U8*)zipped.data(), static_cast<S32>(zipped.size() / 2)) != LLUZipHelper::ZR_OK);
+        ensure("cleared on failure", buffer.empty());
     }
-*/
 
    /**
      * @class TestLLSDCrossCompatible
@@ -0,0 +1,323 @@
+/**
+ * @file   workexecutor_test.cpp
+ * @date   2024-11
+ * @brief  Test for workexecutor.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Copyright (c) 2024, Linden Research, Inc.
+ * $/LicenseInfo$
+ */
+
+// Precompiled header
+#include "linden_common.h"
+// associated header
+#include "workexecutor.h"
+// STL headers
+#include <vector>
+// std headers
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <thread>
+// external library headers
+// other Linden headers
+#include "../test/lltut.h"
+#include "stringize.h"
+#include "workqueue.h"
+
+using namespace LL;
+using namespace std::literals::chrono_literals; // ms suffix
+
+namespace
+{
+    // poll pred until it's true or we give up
+    bool wait_for(const std::function<bool()>& pred, std::chrono::milliseconds timeout = 10000ms)
+    {
+        auto until = std::chrono::steady_clock::now() + timeout;
+        while (! pred())
+        {
+            if (std::chrono::steady_clock::now() > until)
+            {
+                return false;
+            }
+            std::this_thread::sleep_for(1ms);
+        }
+        return true;
+    }
+
+    size_t test_width()
+    {
+        return llclamp((size_t)std::thread::hardware_concurrency(), (size_t)2, (size_t)8);
+    }
+
+    double seconds_since(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+/*****************************************************************************
+*   TUT
+*****************************************************************************/
+namespace tut
+{
+    struct workexecutor_data
+    {
+        WorkExecutor executor{ "test", test_width(), false };
+    };
+    typedef test_group<workexecutor_data> workexecutor_group;
+    typedef workexecutor_group::object object;
+    workexecutor_group workexecutorgrp("workexecutor");
+
+    template<> template<>
+    void object::test<1>()
+    {
+        set_test_name("post from outside");
+        ensure_equals("width", executor.getWidth(), test_width());
+        ensure_equals("not a worker", executor.getCurrentWorker(), WorkExecutor::ANY_WORKER);
+
+        const int COUNT = 10000;
+        std::atomic<int> ran{ 0 };
+        std::vector<std::atomic<int>> seen(COUNT);
+        for (int i = 0; i < COUNT; ++i)
+        {
+            auto priority = WorkExecutor::EPriority(i % WorkExecutor::PRIORITY_COUNT);
+            int affinity = (i % 3) ? WorkExecutor::ANY_WORKER : i % (int)executor.getWidth();
+            ensure("post", executor.post([&seen, &ran, i](){ ++seen[i]; ++ran; }, priority, affinity));
+        }
+        ensure("all ran", wait_for([&ran](){ return ran == COUNT; }));
+        for (int i = 0; i < COUNT; ++i)
+        {
+            ensure_equals(STRINGIZE("task " << i), seen[i].load(), 1);
+        }
+    }
+
+    template<> template<>
+    void object::test<2>()
+    {
+        set_test_name("post from workers");
+        // each task fans out into two more, all from worker threads
+        const int DEPTH = 14;
+        std::atomic<int> ran{ 0 };
+        std::atomic<int> strangers{ 0 };
+        std::function<void(int)> spawn = [&](int depth)
+        {
+            if (executor.getCurrentWorker() == WorkExecutor::ANY_WORKER)
+            {
+                ++strangers;
+            }
+            ++ran;
+            if (depth < DEPTH)
+            {
+                executor.post([&spawn, depth](){ spawn(depth + 1); });
+                executor.post([&spawn, depth](){ spawn(depth + 1); }, WorkExecutor::PRIORITY_LOW);
+            }
+        };
+        executor.post([&spawn](){ spawn(0); });
+        const int expected = (1 << (DEPTH + 1)) - 1;
+        ensure("all ran", wait_for([&ran, expected](){ return ran == expected; }));
+        ensure_equals("ran on workers", strangers.load(), 0);
+    }
+
+    template<> template<>
+    void object::test<3>()
+    {
+        set_test_name("priority");
+        WorkExecutor single{ "single", 1, false };
+        // hold the only worker while we queue
+        std::mutex gate;
+        std::unique_lock<std::mutex> held(gate);
+        std::atomic<bool> started{ false };
+        single.post([&](){ started = true; std::lock_guard<std::mutex> lock(gate); });
+        ensure("gate task started", wait_for([&started](){ return started.load(); }));
+
+        std::mutex mutex;
+        std::vector<int> order;
+        auto record = [&](int value)
+        {
+            return [&, value]()
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                order.push_back(value);
+            };
+        };
+        single.post(record(WorkExecutor::PRIORITY_LOW), WorkExecutor::PRIORITY_LOW);
+        single.post(record(WorkExecutor::PRIORITY_NORMAL), WorkExecutor::PRIORITY_NORMAL);
+        single.post(record(WorkExecutor::PRIORITY_HIGH), WorkExecutor::PRIORITY_HIGH);
+        held.unlock();
+        single.close();
+        ensure_equals("all ran", order.size(), 3);
+        ensure_equals("high first", order[0], int(WorkExecutor::PRIORITY_HIGH));
+        ensure_equals("normal next", order[1], int(WorkExecutor::PRIORITY_NORMAL));
+        ensure_equals("low last", order[2], int(WorkExecutor::PRIORITY_LOW));
+        ensure("closed", single.isClosed());
+        ensure("post after close", ! single.post([](){}));
+    }
+
+    template<> template<>
+    void object::test<4>()
+    {
+        set_test_name("forEach");
+        const size_t COUNT = 5000;
+        std::vector<std::atomic<int>> seen(COUNT);
+        executor.forEach(COUNT, [&seen](size_t i){ ++seen[i]; });
+        for (size_t i = 0; i < COUNT; ++i)
+        {
+            ensure_equals(STRINGIZE("index " << i), seen[i].load(), 1);
+        }
+
+        // nested, from worker threads
+        const size_t OUTER = 16, INNER = 200;
+        std::vector<std::atomic<int>> nested(OUTER * INNER);
+        std::atomic<bool> done{ false };
+        executor.post([&]()
+            {
+                executor.forEach(OUTER, [&](size_t i)
+                    {
+                        executor.forEach(INNER, [&, i](size_t j){ ++nested[i * INNER + j]; });
+                    });
+                done = true;
+            });
+        ensure("nested done", wait_for([&done](){ return done.load(); }));
+        for (size_t i = 0; i < nested.size(); ++i)
+        {
+            ensure_equals(STRINGIZE("nested " << i), nested[i].load(), 1);
+        }
+
+        // still works, on the calling thread alone, once closed
+        executor.close();
+        size_t sum = 0;
+        executor.forEach(10, [&sum](size_t i){ sum += i; });
+        ensure_equals("closed forEach", sum, 45);
+    }
+
+    template<> template<>
+    void object::test<5>()
+    {
+        set_test_name("WorkQueue on executor");
+        // width 1: one drain at a time, so work runs in order
+        WorkQueue queue("ordered", 1024*1024);
+        queue.runOnExecutor(executor, 1);
+        const int COUNT = 20000;
+        std::vector<int> order;
+        order.reserve(COUNT);
+        std::atomic<int> count{ 0 };
+        for (int i = 0; i < COUNT; ++i)
+        {
+            ensure("post", queue.post([&order, &count, i](){ order.push_back(i); ++count; }));
+        }
+        ensure("all ran", wait_for([&count](){ return count == COUNT; }));
+        for (int i = 0; i < COUNT; ++i)
+        {
+            ensure_equals(STRINGIZE("order " << i), order[i], i);
+        }
+
+        // wider, closed and waited for while work is still queued
+        WorkQueue wide("wide", 1024*1024);
+        wide.runOnExecutor(executor, executor.getWidth(), WorkExecutor::PRIORITY_LOW);
+        std::atomic<int> ran{ 0 };
+        for (int i = 0; i < COUNT; ++i)
+        {
+            wide.post([&ran](){ ++ran; });
+        }
+        wide.close();
+        wide.waitForExecutor();
+        ensure_equals("drained by close", ran.load(), COUNT);
+        ensure("rejected after close", ! wide.post([](){}));
+    }
+
+    template<> template<>
+    void object::test<6>()
+    {
+        set_test_name("contention benchmark");
+        if (! getenv("LL_TEST_BENCHMARK"))
+        {
+            skip("benchmark, set LL_TEST_BENCHMARK to run it");
+        }
+        // Throughput of small tasks posted by 1 to 32 producers, consumed by
+        // as many threads as the executor has:
+        // - a WorkQueue served by dedicated threads, as ThreadPool does now
+        // - the same WorkQueue run on the executor, as ThreadPool can
+        // - posted to the executor directly
+        // Only informative, nothing fails on speed.
+        const size_t width = executor.getWidth();
+        const int TASKS = 200000;
+        std::atomic<int> ran{ 0 };
+        std::atomic<U64> sink{ 0 };
+        auto task = [&ran, &sink]()
+        {
+            // a little arithmetic, so that consumers do more than fight
+            U64 x = 0x9e3779b97f4a7c15ull;
+            for (int i = 0; i < 64; ++i)
+            {
+                x ^= x >> 13;
+                x *= 0xff51afd7ed558ccdull;
+            }
+            sink.fetch_add(x & 1, std::memory_order_relaxed);
+            ran.fetch_add(1, std::memory_order_relaxed);
+        };
+
+        auto produce = [&](int producers, const std::function<void()>& post_one)
+        {
+            ran = 0;
+            auto start = std::chrono::steady_clock::now();
+            std::vector<std::thread> threads;
+            for (int p = 0; p < producers; ++p)
+            {
+                const int share = TASKS / producers + (p < TASKS % producers ? 1 : 0);
+                threads.emplace_back([share, &post_one]()
+                    {
+                        for (int i = 0; i < share; ++i)
+                        {
+                            post_one();
+                        }
+                    });
+            }
+            for (auto& thread : threads)
+            {
+                thread.join();
+            }
+            wait_for([&ran, TASKS](){ return ran.load() == TASKS; }, 60000ms);
+            ensure_equals("all ran", ran.load(), TASKS);
+            return TASKS / seconds_since(start) / 1000.0;
+        };
+
+        std::cout << "\nWorkExecutor contention, " << TASKS << " tasks, " << width
+                  << " consumers (thousand tasks/s)\n"
+                  << std::setw(10) << "producers" << std::setw(20) << "threads+WorkQueue"
+                  << std::setw(20) << "executor+WorkQueue" << std::setw(10) << "executor" << "\n"
+                  << std::fixed << std::setprecision(0);
+        for (int producers = 1; producers <= 32; producers *= 2)
+        {
+            double dedicated, drained, direct;
+            {
+                WorkQueue queue("dedicated", 1024*1024);
+                std::vector<std::thread> consumers;
+                for (size_t i = 0; i < width; ++i)
+                {
+                    consumers.emplace_back([&queue](){ queue.runUntilClose(); });
+                }
+                dedicated = produce(producers, [&queue, &task](){ queue.post(task); });
+                queue.close();
+                for (auto& consumer : consumers)
+                {
+                    consumer.join();
+                }
+            }
+            {
+                WorkQueue queue("drained", 1024*1024);
+                queue.runOnExecutor(executor, width);
+                drained = produce(producers, [&queue, &task](){ queue.post(task); });
+                queue.close();
+                queue.waitForExecutor();
+            }
+            direct = produce(producers, [this, &task](){ executor.post(task); });
+
+            std::cout << std::setw(10) << producers << std::setw(20) << dedicated
+                      << std::setw(20) << drained << std::setw(10) << direct << "\n";
+        }
+        std::cout << std::flush;
+    }
+} // namespace tut
@@ -84,6 +84,31 @@ void LL::ThreadPoolBase::start()
             });
     }
 
+    listenForShutdown();
+}
+
+void LL::ThreadPoolBase::startOnExecutor(WorkExecutor::EPriority priority)
+{
+    WorkQueue* queue = dynamic_cast<WorkQueue*>(mQueue.get());
+    if (! queue)
+    {
+        LL_ERRS("ThreadPool") << mName << " can only run a WorkQueue on the WorkExecutor" << LL_ENDL;
+    }
+
+    WorkExecutor& executor{ WorkExecutor::getShared() };
+    // Leave at least one worker out of the drains, so that forEach()
+    // helpers and other high priority work don't wait behind them.
+    const size_t max_width = executor.getWidth() > 1 ? executor.getWidth() - 1 : 1;
+    mExecutorWidth = llclamp(mThreadCount, (size_t)1, max_width);
+    LL_INFOS("ThreadPool") << mName << " running on " << executor.getName()
+                           << ", width " << mExecutorWidth << LL_ENDL;
+    queue->runOnExecutor(executor, mExecutorWidth, priority);
+
+    listenForShutdown();
+}
+
+void LL::ThreadPoolBase::listenForShutdown()
+{
     if (!mAutomaticShutdown)
     {
         // Some threads, like main window's might need to run a bit longer
@@ -131,6 +156,11 @@ void LL::ThreadPoolBase::close()
                 pair.second.join();
             }
         }
+        if (mExecutorWidth)
+        {
+            LL_DEBUGS("ThreadPool") << mName << " waiting on WorkExecutor" << LL_ENDL;
+            static_cast<WorkQueue&>(*mQueue).waitForExecutor();
+        }
         LL_DEBUGS("ThreadPool") << mName << " shutdown complete" << LL_ENDL;
     }
 }
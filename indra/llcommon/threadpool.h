@@ -51,6 +51,16 @@ namespace LL
          */
         void start();
 
+        /**
+         * Alternative to start(): rather than launching threads of its own,
+         * run this ThreadPool's WorkQueue on the shared WorkExecutor, on at
+         * most as many workers at a time as start() would have launched
+         * threads, and never on all of them. Only for a ThreadPool with a
+         * plain WorkQueue that doesn't override run(), and whose work
+         * doesn't block for long.
+         */
+        void startOnExecutor(WorkExecutor::EPriority priority = WorkExecutor::PRIORITY_NORMAL);
+
         /**
          * ThreadPool listens for application shutdown messages on the "LLApp"
          * LLEventPump. Call close() to shut down this ThreadPool early.
@@ -58,7 +68,7 @@ namespace LL
         virtual void close();
 
         std::string getName() const { return mName; }
-        size_t getWidth() const { return mThreads.size(); }
+        size_t getWidth() const { return mExecutorWidth ? mExecutorWidth : mThreads.size(); }
 
         /**
          * Override run() if you need special processing. The default run()
@@ -92,9 +102,12 @@ namespace LL
 
     private:
         void run(const std::string& name);
+        void listenForShutdown();
 
         std::string mName;
         size_t mThreadCount;
+        // nonzero when running on the shared WorkExecutor
+        size_t mExecutorWidth{ 0 };
     };
 
     /**
@@ -0,0 +1,551 @@
+/**
+ * @file   workexecutor.cpp
+ * @date   2024-11
+ * @brief  Implementation for WorkExecutor.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Copyright (c) 2024, Linden Research, Inc.
+ * $/LicenseInfo$
+ */
+
+// Precompiled header
+#include "linden_common.h"
+// associated header
+#include "workexecutor.h"
+// STL headers
+// std headers
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+// external library headers
+#include "concurrentqueue.h"
+#include "lightweightsemaphore.h"
+// other Linden headers
+#include "llerror.h"
+#include "llevents.h"
+#include "llexception.h"
+#include "llsd.h"
+#include "stringize.h"
+#include "threadpool.h"
+
+namespace
+{
+    // which executor, if any, the calling thread works for
+    thread_local const LL::WorkExecutor* sCurrentExecutor = nullptr;
+    thread_local int sCurrentWorker = LL::WorkExecutor::ANY_WORKER;
+
+    const S64 INITIAL_DEQUE_CAPACITY = 256;
+
+    using Task = LL::WorkExecutor::Work;
+
+    /**
+     * Chase-Lev work-stealing deque, as in "Correct and Efficient
+     * Work-Stealing for Weak Memory Models" (Le, Pop, Cohen, Zappa Nardelli,
+     * 2013). The owning worker pushes and pops at the bottom, anyone may
+     * steal from the top. A full ring is replaced by one twice the size;
+     * thieves may still be reading the old one, so it is kept until the
+     * deque goes away.
+     */
+    class TaskDeque
+    {
+    public:
+        TaskDeque():
+            mRing(new Ring(INITIAL_DEQUE_CAPACITY))
+        {
+            mRetired.emplace_back(mRing.load());
+        }
+
+        ~TaskDeque()
+        {
+            for (Task* task = pop(); task; task = pop())
+            {
+                delete task;
+            }
+        }
+
+        // owner only
+        void push(Task* task)
+        {
+            S64 bottom = mBottom.load(std::memory_order_relaxed);
+            S64 top = mTop.load(std::memory_order_acquire);
+            Ring* ring = mRing.load(std::memory_order_relaxed);
+            if (bottom - top >= ring->mSize)
+            {
+                ring = grow(ring, top, bottom);
+            }
+            ring->put(bottom, task);
+            std::atomic_thread_fence(std::memory_order_release);
+            mBottom.store(bottom + 1, std::memory_order_relaxed);
+        }
+
+        // owner only, newest first
+        Task* pop()
+        {
+            S64 bottom = mBottom.load(std::memory_order_relaxed) - 1;
+            Ring* ring = mRing.load(std::memory_order_relaxed);
+            mBottom.store(bottom, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            S64 top = mTop.load(std::memory_order_relaxed);
+            if (top > bottom)
+            {
+                // empty
+                mBottom.store(bottom + 1, std::memory_order_relaxed);
+                return nullptr;
+            }
+            Task* task = ring->get(bottom);
+            if (top == bottom)
+            {
+                // last one, race the thieves for it
+                if (! mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                                   std::memory_order_relaxed))
+                {
+                    task = nullptr;
+                }
+                mBottom.store(bottom + 1, std::memory_order_relaxed);
+            }
+            return task;
+        }
+
+        // any thread, oldest first
+        Task* steal()
+        {
+            S64 top = mTop.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            S64 bottom = mBottom.load(std::memory_order_acquire);
+            if (top >= bottom)
+            {
+                return nullptr;
+            }
+            Ring* ring = mRing.load(std::memory_order_acquire);
+            Task* task = ring->get(top);
+            if (! mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                               std::memory_order_relaxed))
+            {
+                // lost to the owner or another thief
+                return nullptr;
+            }
+            return task;
+        }
+
+        bool empty() const
+        {
+            return mBottom.load(std::memory_order_relaxed) <= mTop.load(std::memory_order_relaxed);
+        }
+
+    private:
+        struct Ring
+        {
+            Ring(S64 size):
+                mSize(size),
+                mSlots(new std::atomic<Task*>[size])
+            {}
+
+            Task* get(S64 index) const
+            {
+                return mSlots[index & (mSize - 1)].load(std::memory_order_relaxed);
+            }
+
+            void put(S64 index, Task* task)
+            {
+                mSlots[index & (mSize - 1)].store(task, std::memory_order_relaxed);
+            }
+
+            const S64 mSize;
+            std::unique_ptr<std::atomic<Task*>[]> mSlots;
+        };
+
+        Ring* grow(Ring* ring, S64 top, S64 bottom)
+        {
+            Ring* bigger = new Ring(ring->mSize * 2);
+            for (S64 i = top; i < bottom; ++i)
+            {
+                bigger->put(i, ring->get(i));
+            }
+            mRetired.emplace_back(bigger);
+            mRing.store(bigger, std::memory_order_release);
+            return bigger;
+        }
+
+        // top and bottom on separate cache lines, thieves hammer the top
+        alignas(64) std::atomic<S64> mTop{ 0 };
+        alignas(64) std::atomic<S64> mBottom{ 0 };
+        std::atomic<Ring*> mRing;
+        std::vector<std::unique_ptr<Ring>> mRetired;
+    };
+
+    using Inbox = moodycamel::ConcurrentQueue<Task*>;
+}
+
+struct LL::WorkExecutor::Worker
+{
+    TaskDeque mDeques[PRIORITY_COUNT];
+    // affinity posts from other threads
+    Inbox mInboxes[PRIORITY_COUNT];
+    moodycamel::LightweightSemaphore mWake;
+    std::atomic<bool> mSleeping{ false };
+    std::thread mThread;
+};
+
+struct LL::WorkExecutor::Inboxes
+{
+    Inbox mInboxes[PRIORITY_COUNT];
+};
+
+LL::WorkExecutor::WorkExecutor(const std::string& name, size_t width, bool auto_shutdown):
+    mName("WorkExecutor:" + name),
+    mInboxes(new Inboxes),
+    mAutomaticShutdown(auto_shutdown)
+{
+    width = llmax(width, (size_t)1);
+    for (size_t i = 0; i < width; ++i)
+    {
+        mWorkers.emplace_back(new Worker);
+    }
+    // every Worker exists before any thread looks for work to steal
+    for (size_t i = 0; i < width; ++i)
+    {
+        std::string tname{ stringize(mName, ':', (i+1), '/', width) };
+        mWorkers[i]->mThread = std::thread([this, tname, i]()
+            {
+                LL_PROFILER_SET_THREAD_NAME(tname.c_str());
+                LL_INFOS("THREAD") << "Started thread " << tname << LL_ENDL;
+                run((int)i);
+            });
+    }
+
+    if (mAutomaticShutdown)
+    {
+        // Same as ThreadPool: when the app is shutting down, stop taking
+        // work and join the workers.
+        LLEventPumps::instance().obtain("LLApp").listen(
+            mName,
+            [this](const LLSD& stat)
+            {
+                std::string status(stat["status"]);
+                if (status != "running")
+                {
+                    LL_DEBUGS("WorkExecutor") << mName << " saw " << status << LL_ENDL;
+                    close();
+                }
+                return false;
+            });
+    }
+}
+
+LL::WorkExecutor::~WorkExecutor()
+{
+    close();
+    if (mAutomaticShutdown && !LLEventPumps::wasDeleted())
+    {
+        LLEventPumps::instance().obtain("LLApp").stopListening(mName);
+    }
+}
+
+//static
+LL::WorkExecutor& LL::WorkExecutor::getShared()
+{
+    // Not an LLSingleton: the first caller may well be a worker thread of
+    // some other pool.
+    static WorkExecutor executor("Shared",
+        ThreadPoolBase::getConfiguredWidth("WorkExecutor",
+            llmax((S32)std::thread::hardware_concurrency() - 1, 1)));
+    return executor;
+}
+
+bool LL::WorkExecutor::post(const Work& work, EPriority priority, int affinity)
+{
+    return postTask(new Work(work), priority, affinity);
+}
+
+bool LL::WorkExecutor::post(Work&& work, EPriority priority, int affinity)
+{
+    return postTask(new Work(std::move(work)), priority, affinity);
+}
+
+bool LL::WorkExecutor::postTask(Work* task, EPriority priority, int affinity)
+{
+    llassert(priority >= 0 && priority < PRIORITY_COUNT);
+    // Count it before checking mClosed, so that a worker which saw mClosed
+    // set also sees this task pending and does not quit before it runs.
+    ++mPending;
+    if (mClosed.load())
+    {
+        --mPending;
+        delete task;
+        // A closing worker may have seen our count and gone back to sleep
+        // waiting for this task.
+        for (auto& worker : mWorkers)
+        {
+            if (worker->mSleeping.exchange(false))
+            {
+                worker->mWake.signal();
+            }
+        }
+        return false;
+    }
+
+    const int worker = (sCurrentExecutor == this) ? sCurrentWorker : ANY_WORKER;
+    if (affinity >= (int)mWorkers.size())
+    {
+        affinity = ANY_WORKER;
+    }
+    if (worker != ANY_WORKER && (affinity == ANY_WORKER || affinity == worker))
+    {
+        mWorkers[worker]->mDeques[priority].push(task);
+        // An idle worker can take it off our hands.
+        wake(ANY_WORKER);
+    }
+    else if (affinity != ANY_WORKER)
+    {
+        mWorkers[affinity]->mInboxes[priority].enqueue(task);
+        wake(affinity);
+    }
+    else
+    {
+        mInboxes->mInboxes[priority].enqueue(task);
+        wake(ANY_WORKER);
+    }
+    return true;
+}
+
+void LL::WorkExecutor::wake(int preferred)
+{
+    // Pairs with the fence in run(): either the worker going to sleep sees
+    // the task we just queued, or we see it in mSleepers.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (mSleepers.load(std::memory_order_relaxed) == 0)
+    {
+        return;
+    }
+    if (preferred != ANY_WORKER && mWorkers[preferred]->mSleeping.exchange(false))
+    {
+        mWorkers[preferred]->mWake.signal();
+        return;
+    }
+    // Start the search at our own neighbour so that posters don't all wake
+    // the same worker.
+    const size_t width = mWorkers.size();
+    const size_t start = (sCurrentExecutor == this) ? sCurrentWorker + 1 : 0;
+    for (size_t i = 0; i < width; ++i)
+    {
+        Worker& worker = *mWorkers[(start + i) % width];
+        if (worker.mSleeping.load(std::memory_order_relaxed) && worker.mSleeping.exchange(false))
+        {
+            worker.mWake.signal();
+            return;
+        }
+    }
+}
+
+LL::WorkExecutor::Work* LL::WorkExecutor::findTask(int index)
+{
+    Worker& self = *mWorkers[index];
+    const int width = (int)mWorkers.size();
+    Task* task = nullptr;
+    for (int priority = 0; priority < PRIORITY_COUNT; ++priority)
+    {
+        if ((task = self.mDeques[priority].pop()) ||
+            self.mInboxes[priority].try_dequeue(task) ||
+            mInboxes->mInboxes[priority].try_dequeue(task))
+        {
+            return task;
+        }
+        for (int i = 1; i < width; ++i)
+        {
+            Worker& victim = *mWorkers[(index + i) % width];
+            if ((task = victim.mDeques[priority].steal()) ||
+                victim.mInboxes[priority].try_dequeue(task))
+            {
+                return task;
+            }
+        }
+    }
+    return nullptr;
+}
+
+void LL::WorkExecutor::run(int index)
+{
+    sCurrentExecutor = this;
+    sCurrentWorker = index;
+    Worker& self = *mWorkers[index];
+
+    for (;;)
+    {
+        Task* task = findTask(index);
+        if (! task)
+        {
+            if (mClosed.load() && mPending.load() == 0)
+            {
+                break;
+            }
+
+            // Announce that we are going to sleep, then look once more, in
+            // case a task was queued after we looked and before the poster
+            // could see us.
+            self.mSleeping.store(true);
+            ++mSleepers;
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            task = findTask(index);
+            if (! task && ! (mClosed.load() && mPending.load() == 0))
+            {
+                self.mWake.wait();
+            }
+            // If a poster already cleared the flag, its signal() is still
+            // outstanding and costs us one spurious wakeup later.
+            self.mSleeping.store(false);
+            --mSleepers;
+            if (! task)
+            {
+                continue;
+            }
+        }
+
+        --mPending;
+        try
+        {
+            LL_PROFILE_ZONE_SCOPED_CATEGORY_THREAD;
+            (*task)();
+        }
+        catch (...)
+        {
+            // No matter what goes wrong with any individual task, the worker
+            // must go on!
+            LOG_UNHANDLED_EXCEPTION(mName);
+        }
+        delete task;
+    }
+
+    sCurrentExecutor = nullptr;
+    sCurrentWorker = ANY_WORKER;
+}
+
+void LL::WorkExecutor::forEach(size_t count, const std::function<void(size_t)>& func,
+                               EPriority priority)
+{
+    if (count == 0)
+    {
+        return;
+    }
+    if (count == 1)
+    {
+        func(0);
+        return;
+    }
+
+    // Helpers may be dequeued long after we return, so they share the
+    // bookkeeping rather than pointing into our stack.
+    struct State
+    {
+        std::atomic<size_t> mNext{ 0 };
+        size_t mCount;
+        const std::function<void(size_t)>* mFunc;
+        std::mutex mMutex;
+        std::condition_variable mDone;
+        size_t mRunning{ 0 };
+        bool mFinished{ false };
+    };
+    auto state = std::make_shared<State>();
+    state->mCount = count;
+    state->mFunc = &func;
+
+    auto helper = [state]()
+    {
+        {
+            std::lock_guard<std::mutex> lock(state->mMutex);
+            if (state->mFinished)
+            {
+                // the caller already did it all
+                return;
+            }
+            ++state->mRunning;
+        }
+        try
+        {
+            for (size_t i = state->mNext++; i < state->mCount; i = state->mNext++)
+            {
+                (*state->mFunc)(i);
+            }
+        }
+        catch (...)
+        {
+            LOG_UNHANDLED_EXCEPTION("WorkExecutor::forEach");
+        }
+        std::lock_guard<std::mutex> lock(state->mMutex);
+        if (--state->mRunning == 0)
+        {
+            state->mDone.notify_one();
+        }
+    };
+
+    const size_t helpers = llmin(count - 1, getWidth());
+    for (size_t k = 0; k < helpers; ++k)
+    {
+        if (! post(helper, priority))
+        {
+            // closed, the calling thread does the rest
+            break;
+        }
+    }
+
+    std::exception_ptr failure;
+    try
+    {
+        for (size_t i = state->mNext++; i < count; i = state->mNext++)
+        {
+            func(i);
+        }
+    }
+    catch (...)
+    {
+        // let the helpers stop early, but they must be done with func before
+        // we rethrow
+        state->mNext = count;
+        failure = std::current_exception();
+    }
+
+    std::unique_lock<std::mutex> lock(state->mMutex);
+    state->mFinished = true;
+    state->mDone.wait(lock, [&state]() { return state->mRunning == 0; });
+    lock.unlock();
+    if (failure)
+    {
+        std::rethrow_exception(failure);
+    }
+}
+
+void LL::WorkExecutor::close()
+{
+    if (mClosed.exchange(true))
+    {
+        return;
+    }
+
+    LL_DEBUGS("WorkExecutor") << mName << " closing and joining workers" << LL_ENDL;
+    for (auto& worker : mWorkers)
+    {
+        worker->mSleeping.store(false);
+        worker->mWake.signal();
+    }
+    for (auto& worker : mWorkers)
+    {
+        if (worker->mThread.joinable())
+        {
+            if (worker->mThread.get_id() == std::this_thread::get_id())
+            {
+                // closed from one of our own tasks, that worker quits once
+                // the queues are empty
+                worker->mThread.detach();
+            }
+            else
+            {
+                worker->mThread.join();
+            }
+        }
+    }
+    LL_DEBUGS("WorkExecutor") << mName << " shutdown complete" << LL_ENDL;
+}
+
+int LL::WorkExecutor::getCurrentWorker() const
+{
+    return (sCurrentExecutor == this) ? sCurrentWorker : ANY_WORKER;
+}
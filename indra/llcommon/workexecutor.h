@@ -0,0 +1,131 @@
+/**
+ * @file   workexecutor.h
+ * @date   2024-11
+ * @brief  WorkExecutor is a fixed set of worker threads that balance work
+ *         between themselves by stealing it.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Copyright (c) 2024, Linden Research, Inc.
+ * $/LicenseInfo$
+ */
+
+#if ! defined(LL_WORKEXECUTOR_H)
+#define LL_WORKEXECUTOR_H
+
+#include <atomic>
+#include <functional>               // std::function
+#include <memory>                   // std::unique_ptr
+#include <string>
+#include <vector>
+
+namespace LL
+{
+
+    /**
+     * Every ThreadPool used to start its own threads, so the viewer ran
+     * several times as many busy threads as there are cores and left the OS
+     * to sort them out. WorkExecutor is meant to be the one set of threads,
+     * about one per core, that such pools run their work on instead.
+     *
+     * Each worker keeps a Chase-Lev deque per priority. Work posted by a
+     * worker goes to the bottom of its own deque, where only it can push or
+     * pop without locking; idle workers steal from the top of the others'
+     * deques. Work posted from any other thread goes to a shared inbox, or
+     * to the inbox of a particular worker when the poster gives an affinity
+     * hint. Workers always take the highest priority work they can find, and
+     * sleep when there is none.
+     *
+     * Work should not block for long: a worker waiting on a lock or on I/O
+     * is a core nobody else gets to use. Keep blocking and GL work on
+     * dedicated threads.
+     */
+    class WorkExecutor
+    {
+    public:
+        using Work = std::function<void()>;
+
+        enum EPriority
+        {
+            PRIORITY_HIGH = 0,  // somebody is waiting for it, e.g. forEach()
+            PRIORITY_NORMAL,
+            PRIORITY_LOW,       // background work
+            PRIORITY_COUNT
+        };
+
+        // affinity for work that may run on any worker
+        static constexpr int ANY_WORKER = -1;
+
+        /**
+         * Launches width worker threads right away (at least one). With
+         * auto_shutdown, close() is called when the "LLApp" LLEventPump says
+         * the application is no longer running.
+         */
+        WorkExecutor(const std::string& name, size_t width, bool auto_shutdown = true);
+        ~WorkExecutor();
+
+        WorkExecutor(const WorkExecutor&) = delete;
+        WorkExecutor& operator=(const WorkExecutor&) = delete;
+
+        /**
+         * The executor ThreadPools and parallel loops share. Its width is
+         * the "WorkExecutor" entry of the "ThreadPoolSizes" setting, else one
+         * less than the number of cores, leaving one for the main thread.
+         */
+        static WorkExecutor& getShared();
+
+        /**
+         * Queue work, unless the executor is closed. affinity is a hint: the
+         * named worker runs it if it gets there first, but an idle worker
+         * may steal it.
+         */
+        bool post(const Work& work, EPriority priority = PRIORITY_NORMAL,
+                  int affinity = ANY_WORKER);
+        bool post(Work&& work, EPriority priority = PRIORITY_NORMAL,
+                  int affinity = ANY_WORKER);
+
+        /**
+         * Call func(i) for each i in [0, count) on the calling thread and on
+         * up to getWidth() workers, and return when all calls are done.
+         * Helpers that have not started by the time the calling thread runs
+         * out of indices are skipped rather than waited for, so this is safe
+         * to call from a worker, or while the executor is busy or closed.
+         */
+        void forEach(size_t count, const std::function<void(size_t)>& func,
+                     EPriority priority = PRIORITY_HIGH);
+
+        /**
+         * Stop accepting work, let the workers finish what is queued, and
+         * join them.
+         */
+        void close();
+        bool isClosed() const { return mClosed.load(); }
+
+        const std::string& getName() const { return mName; }
+        size_t getWidth() const { return mWorkers.size(); }
+
+        // index of the calling thread among this executor's workers, or
+        // ANY_WORKER if it is not one of them
+        int getCurrentWorker() const;
+
+    private:
+        struct Worker;
+        struct Inboxes;
+
+        bool postTask(Work* task, EPriority priority, int affinity);
+        void run(int index);
+        Work* findTask(int index);
+        void wake(int preferred);
+
+        std::string mName;
+        std::vector<std::unique_ptr<Worker>> mWorkers;
+        std::unique_ptr<Inboxes> mInboxes;
+        // tasks posted and not yet taken by a worker
+        std::atomic<size_t> mPending{ 0 };
+        std::atomic<size_t> mSleepers{ 0 };
+        std::atomic<bool> mClosed{ false };
+        bool mAutomaticShutdown;
+    };
+
+} // namespace LL
+
+#endif /* ! defined(LL_WORKEXECUTOR_H) */
@@ -15,6 +15,7 @@
 #include "workqueue.h"
 // STL headers
 // std headers
+#include <thread>                   // std::this_thread::sleep_for()
 // external library headers
 // other Linden headers
 #include "llcoros.h"
@@ -141,6 +142,16 @@ LL::WorkQueue::WorkQueue(const std::string& name, size_t capacity):
 {
 }
 
+LL::WorkQueue::~WorkQueue()
+{
+    if (mExecutor)
+    {
+        // drain tasks point back at us
+        close();
+        waitForExecutor();
+    }
+}
+
 void LL::WorkQueue::close()
 {
     mQueue.close();
@@ -163,12 +174,125 @@ bool LL::WorkQueue::done()
 
 bool LL::WorkQueue::post(const Work& callable)
 {
-    return mQueue.pushIfOpen(callable);
+    if (! mQueue.pushIfOpen(callable))
+    {
+        return false;
+    }
+    scheduleDrain();
+    return true;
 }
 
 bool LL::WorkQueue::tryPost(const Work& callable)
 {
-    return mQueue.tryPush(callable);
+    if (! mQueue.tryPush(callable))
+    {
+        return false;
+    }
+    scheduleDrain();
+    return true;
+}
+
+void LL::WorkQueue::runOnExecutor(WorkExecutor& executor, size_t width,
+                                  WorkExecutor::EPriority priority, int affinity)
+{
+    mExecutorWidth = llmax(width, (size_t)1);
+    mExecutorPriority = priority;
+    mExecutorAffinity = affinity;
+    mExecutor = &executor;
+    scheduleDrain();
+}
+
+void LL::WorkQueue::scheduleDrain()
+{
+    if (! mExecutor)
+    {
+        return;
+    }
+
+    // Pairs with the decrement in drain(): either the last drain sees the
+    // work we just pushed, or we see that it is gone.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    size_t drains = mDrains.load();
+    do
+    {
+        if (drains >= mExecutorWidth)
+        {
+            // as many as allowed are already on it
+            return;
+        }
+    } while (! mDrains.compare_exchange_weak(drains, drains + 1));
+
+    if (! postDrain())
+    {
+        // executor closed, waitForExecutor() picks up the work
+        --mDrains;
+    }
+}
+
+bool LL::WorkQueue::postDrain()
+{
+    // Counted separately from mDrains: a drain task still looks at the queue
+    // after giving up its slot.
+    ++mDrainTasks;
+    if (mExecutor->post([this]() { drain(); --mDrainTasks; }, mExecutorPriority, mExecutorAffinity))
+    {
+        return true;
+    }
+    --mDrainTasks;
+    return false;
+}
+
+void LL::WorkQueue::drain()
+{
+    // Give other work at our priority a turn after this many items.
+    const size_t DRAIN_BATCH = 32;
+
+    for (;;)
+    {
+        size_t count = 0;
+        for (Work work; count < DRAIN_BATCH && mQueue.tryPop(work); ++count)
+        {
+            callWork(work);
+        }
+        if (count == DRAIN_BATCH)
+        {
+            // likely more to do, go to the back of the line
+            if (postDrain())
+            {
+                return;
+            }
+            continue;
+        }
+
+        --mDrains;
+        // A post() between our last tryPop() and the decrement may have
+        // found every drain slot taken. If so, it is up to us.
+        if (mQueue.size() == 0)
+        {
+            return;
+        }
+        size_t drains = mDrains.load();
+        do
+        {
+            if (drains >= mExecutorWidth)
+            {
+                return;
+            }
+        } while (! mDrains.compare_exchange_weak(drains, drains + 1));
+    }
+}
+
+void LL::WorkQueue::waitForExecutor()
+{
+    if (! mExecutor)
+    {
+        return;
+    }
+    while (mDrainTasks.load() > 0)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    runPending();
 }
 
 LL::WorkQueue::Work LL::WorkQueue::pop_()
@@ -17,6 +17,8 @@
 #include "llinstancetracker.h"
 #include "llinstancetrackersubclass.h"
 #include "threadsafeschedule.h"
+#include "workexecutor.h"
+#include <atomic>
 #include <chrono>
 #include <exception>                // std::current_exception
 #include <functional>               // std::function
@@ -213,6 +215,8 @@ namespace LL
          * synthesized; for practical purposes that makes it anonymous.
          */
         WorkQueue(const std::string& name = std::string(), size_t capacity=1024);
+        /// waits for any drain tasks still queued on a WorkExecutor
+        ~WorkQueue() override;
 
         /**
          * Since the point of WorkQueue is to pass work to some other worker
@@ -254,12 +258,46 @@ namespace LL
          */
         bool tryPost(const Work&) override;
 
+        /*------------------------- executor API ---------------------------*/
+
+        /**
+         * Instead of having threads of its own call runUntilClose(), let
+         * this queue be serviced by executor, by at most width workers at a
+         * time. Each post() makes sure a drain task is scheduled on the
+         * executor to run what is queued. With width 1 the work still runs
+         * in the order it was posted. Call before anything is posted.
+         */
+        void runOnExecutor(WorkExecutor& executor, size_t width,
+                           WorkExecutor::EPriority priority = WorkExecutor::PRIORITY_NORMAL,
+                           int affinity = WorkExecutor::ANY_WORKER);
+
+        /**
+         * After close(), wait until no drain task of ours is queued or
+         * running on the executor, then run anything still queued (e.g.
+         * because the executor closed first) on the calling thread. Don't
+         * call from one of this queue's own work items.
+         */
+        void waitForExecutor();
+
     private:
         using Queue = LLThreadSafeQueue<Work>;
         Queue mQueue;
 
         Work pop_() override;
         bool tryPop_(Work&) override;
+
+        void scheduleDrain();
+        bool postDrain();
+        void drain();
+
+        WorkExecutor* mExecutor{ nullptr };
+        size_t mExecutorWidth{ 0 };
+        WorkExecutor::EPriority mExecutorPriority{ WorkExecutor::PRIORITY_NORMAL };
+        int mExecutorAffinity{ WorkExecutor::ANY_WORKER };
+        // drain slots taken, at most mExecutorWidth
+        std::atomic<size_t> mDrains{ 0 };
+        // drain tasks queued or running on mExecutor
+        std::atomic<size_t> mDrainTasks{ 0 };
     };
 
 /*****************************************************************************
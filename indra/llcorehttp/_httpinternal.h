@@ -156,13 +156,20 @@ constexpr long HTTP_PIPELINING_MAX = 20L;
 // Miscellaneous defaults
 constexpr bool HTTP_USE_RETRY_AFTER_DEFAULT = true;
 constexpr long HTTP_THROTTLE_RATE_DEFAULT = 0L;
+constexpr long HTTP_MULTIPLEX_DEFAULT = 0L;
 
 // Tuning parameters
 
-// Time worker thread sleeps after a pass through the
-// request, ready and active queues.
+// Longest time worker thread waits after a pass through the
+// request, ready and active queues when work is being held back
+// by policy (throttles, retry times, stalls, full classes).
 constexpr int HTTP_SERVICE_LOOP_SLEEP_NORMAL_MS = 2;
 
+// Longest time worker thread waits on transfer sockets when
+// nothing else is pending.  Socket activity, libcurl timers and
+// request queue writes all end the wait earlier.
+constexpr int HTTP_SERVICE_LOOP_POLL_MAX_MS = 100;
+
 // Block allocation size (a tuning parameter) is found
 // in bufferarray.h.
 
@@ -32,6 +32,9 @@
 #include "_httppolicy.h"
 
 #include "llhttpconstants.h"
+#include "lltimer.h"
+
+#include <vector>
 
 namespace
 {
@@ -51,6 +54,32 @@ void check_curl_multi_setopt(CURLM* handle, CURLMoption option, ARG argument)
 
 static const char * const LOG_CORE("CoreHttp");
 
+#if LIBCURL_VERSION_NUM >= 0x074400
+// Convert descriptors from a curl_multi_fdset() call into
+// curl_waitfd entries for curl_multi_poll().
+void add_wait_fds(std::vector<curl_waitfd> & fds, const fd_set & set, int max_fd, short events)
+{
+#if LL_WINDOWS
+    // Winsock fd_set is an array of sockets, not a bitmap
+    (void) max_fd;
+    for (u_int i(0); i < set.fd_count; ++i)
+    {
+        curl_waitfd wait_fd = { set.fd_array[i], events, 0 };
+        fds.push_back(wait_fd);
+    }
+#else
+    for (int fd(0); fd <= max_fd; ++fd)
+    {
+        if (FD_ISSET(fd, &set))
+        {
+            curl_waitfd wait_fd = { fd, events, 0 };
+            fds.push_back(wait_fd);
+        }
+    }
+#endif
+}
+#endif
+
 } // end anonymous namespace
 
 
@@ -190,7 +219,7 @@ HttpService::ELoopSpeed HttpLibcurl::processTransport()
 
                     completeRequest(mMultiHandles[policy_class], handle, result);
                     handle = NULL;                  // No longer valid on return
-                    ret = HttpService::NORMAL;      // If anything completes, we may have a free slot.
+                    ret = HttpService::IMMEDIATE;   // If anything completes, we may have a free slot.
                                                     // Turning around quickly reduces connection gap by 7-10mS.
                 }
                 else if (CURLMSG_NONE == msg->msg)
@@ -211,12 +240,84 @@ HttpService::ELoopSpeed HttpLibcurl::processTransport()
 
     if (! mActiveOps.empty())
     {
-        ret = HttpService::NORMAL;
+        ret = (std::min)(ret, HttpService::NORMAL);
     }
     return ret;
 }
 
 
+void HttpLibcurl::waitForActivity(int timeout_ms)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_NETWORK;
+#if LIBCURL_VERSION_NUM >= 0x074400     // curl_multi_poll() and curl_multi_wakeup(), 7.68.0
+    if (! mMultiHandles || ! mMultiHandles[0])
+    {
+        ms_sleep(timeout_ms);
+        return;
+    }
+
+    // Always wait on the class 0 handle as that's the one wakeup()
+    // signals.  Sockets of the other classes' transfers are passed
+    // along as extra descriptors and their timers cap the timeout.
+    std::vector<curl_waitfd> extra_fds;
+    for (unsigned int policy_class(1); policy_class < mPolicyCount; ++policy_class)
+    {
+        if (! mMultiHandles[policy_class] || ! mActiveHandles[policy_class])
+        {
+            continue;
+        }
+
+        long class_timeout(-1);
+        if (CURLM_OK == curl_multi_timeout(mMultiHandles[policy_class], &class_timeout)
+            && class_timeout >= 0 && class_timeout < timeout_ms)
+        {
+            timeout_ms = int(class_timeout);
+        }
+
+        fd_set read_fds, write_fds, exc_fds;
+        FD_ZERO(&read_fds);
+        FD_ZERO(&write_fds);
+        FD_ZERO(&exc_fds);
+        int max_fd(-1);
+        if (CURLM_OK != curl_multi_fdset(mMultiHandles[policy_class], &read_fds, &write_fds, &exc_fds, &max_fd)
+            || max_fd < 0)
+        {
+            // Transfers without a socket we can wait on (resolving,
+            // or descriptors past FD_SETSIZE) get polled as before.
+            timeout_ms = (std::min)(timeout_ms, HTTP_SERVICE_LOOP_SLEEP_NORMAL_MS);
+            continue;
+        }
+        add_wait_fds(extra_fds, read_fds, max_fd, CURL_WAIT_POLLIN);
+        add_wait_fds(extra_fds, write_fds, max_fd, CURL_WAIT_POLLOUT);
+        add_wait_fds(extra_fds, exc_fds, max_fd, CURL_WAIT_POLLPRI);
+    }
+
+    if (timeout_ms > 0)
+    {
+        LL_PROFILE_ZONE_NAMED_CATEGORY_NETWORK("httppt - curl_multi_poll");
+        curl_multi_poll(mMultiHandles[0],
+                        extra_fds.empty() ? NULL : &extra_fds[0],
+                        (unsigned int) extra_fds.size(),
+                        timeout_ms,
+                        NULL);
+    }
+#else
+    ms_sleep((std::min)(timeout_ms, HTTP_SERVICE_LOOP_SLEEP_NORMAL_MS));
+#endif
+}
+
+
+void HttpLibcurl::wakeup()
+{
+#if LIBCURL_VERSION_NUM >= 0x074400
+    if (mMultiHandles && mMultiHandles[0])
+    {
+        curl_multi_wakeup(mMultiHandles[0]);
+    }
+#endif
+}
+
+
 // Caller has provided us with a ref count on op.
 void HttpLibcurl::addOp(const HttpOpRequest::ptr_t &op)
 {
@@ -543,10 +644,18 @@ void HttpLibcurl::policyUpdated(unsigned int policy_class)
 
         if (options.mPipelining > 1)
         {
-            // We'll try to do pipelining on this multihandle
+            // We'll try to do pipelining on this multihandle.  Newer
+            // libcurl dropped HTTP/1.1 pipelining, classes that opted
+            // in multiplex over HTTP/2 instead.
+#if defined(CURLPIPE_MULTIPLEX)
+            check_curl_multi_setopt(multi_handle,
+                                     CURLMOPT_PIPELINING,
+                                     long(options.mMultiplex ? CURLPIPE_HTTP1 | CURLPIPE_MULTIPLEX : CURLPIPE_HTTP1));
+#else
             check_curl_multi_setopt(multi_handle,
                                      CURLMOPT_PIPELINING,
                                      1L);
+#endif
             check_curl_multi_setopt(multi_handle,
                                      CURLMOPT_MAX_PIPELINE_LENGTH,
                                      long(options.mPipelining));
@@ -77,6 +77,20 @@ public:
     /// Threading:  called by worker thread.
     HttpService::ELoopSpeed processTransport();
 
+    /// Block until there is socket activity on any active request,
+    /// a libcurl timer is due, wakeup() is called or @timeout_ms
+    /// milliseconds pass, whichever comes first.  Falls back to a
+    /// plain sleep with libcurl releases that can't be woken.
+    ///
+    /// Threading:  called by worker thread.
+    void waitForActivity(int timeout_ms);
+
+    /// Make the current or next waitForActivity() call return
+    /// immediately.
+    ///
+    /// Threading:  callable by any thread between start() and shutdown().
+    void wakeup();
+
     /// Add request to the active list.  Caller is expected to have
     /// provided us with a reference count on the op to hold the
     /// request.  (No additional references will be added.)
@@ -121,6 +121,10 @@ void check_curl_easy_setopt(CURL* handle, CURLoption option, ARG argument)
 
 static const char * const LOG_CORE("CoreHttp");
 
+// Largest 'Content-Length' we'll trust enough to preallocate
+// a reply body for.  Bigger bodies just grow block by block.
+static const size_t REPLY_RESERVE_MAX(64 * 1024 * 1024);
+
 } // end anonymous namespace
 
 
@@ -148,6 +152,7 @@ HttpOpRequest::HttpOpRequest()
       mReplyOffset(0),
       mReplyLength(0),
       mReplyFullLength(0),
+      mReplyContentLength(0),
       mReplyHeaders(),
       mPolicyRetries(0),
       mPolicy503Retries(0),
@@ -491,6 +496,7 @@ HttpStatus HttpOpRequest::prepareRequest(HttpService * service)
     mReplyOffset = 0;
     mReplyLength = 0;
     mReplyFullLength = 0;
+    mReplyContentLength = 0;
     mReplyHeaders.reset();
     mReplyConType.clear();
 
@@ -757,10 +763,24 @@ HttpStatus HttpOpRequest::prepareRequest(HttpService * service)
         // xfer_timeout *= cpolicy.mPipelining;
         xfer_timeout *= 2L;
 
-        // Also try requesting HTTP/2.
+        // Also try requesting HTTP/2, if the class asked for it.  Over
+        // TLS it is negotiated with ALPN and falls back to 1.1 if the
+        // server doesn't offer it.  PIPEWAIT makes new requests queue up
+        // behind a connection that may turn out to be multiplexed
+        // instead of opening another one.
+        if (cpolicy.mMultiplex)
+        {
+#if defined(CURL_HTTP_VERSION_2TLS)
+            check_curl_easy_setopt(mCurlHandle, CURLOPT_HTTP_VERSION,
+                                   long(getenv("VIEWERASSET") ? CURL_HTTP_VERSION_2_0 : CURL_HTTP_VERSION_2TLS));
+            check_curl_easy_setopt(mCurlHandle, CURLOPT_PIPEWAIT, 1L);
+#else
+            check_curl_easy_setopt(mCurlHandle, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2_0);
+#endif
+        }
 /******************************/
         // but for test purposes, only if overriding VIEWERASSET
-        if (getenv("VIEWERASSET"))
+        else if (getenv("VIEWERASSET"))
 /******************************/
         check_curl_easy_setopt(mCurlHandle, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2_0);
     }
@@ -803,6 +823,13 @@ size_t HttpOpRequest::writeCallback(void * data, size_t size, size_t nmemb, void
     if (! op->mReplyBody)
     {
         op->mReplyBody = new BufferArray();
+
+        // With a declared length, get the whole body into one
+        // block so consumers can take it without a copy.
+        if (op->mReplyContentLength && op->mReplyContentLength <= REPLY_RESERVE_MAX)
+        {
+            op->mReplyBody->reserve(op->mReplyContentLength);
+        }
     }
     const size_t req_size(size * nmemb);
     const size_t write_size(op->mReplyBody->append(static_cast<char *>(data), req_size));
@@ -882,6 +909,7 @@ size_t HttpOpRequest::headerCallback(void * data, size_t size, size_t nmemb, voi
     static const size_t status_line_len = sizeof(status_line) - 1;
     static const char con_ran_line[] = "content-range";
     static const char con_retry_line[] = "retry-after";
+    static const char con_len_line[] = "content-length";
 
     HttpOpRequest::ptr_t op(HttpOpRequest::fromHandle<HttpOpRequest>(userdata));
 
@@ -896,6 +924,7 @@ size_t HttpOpRequest::headerCallback(void * data, size_t size, size_t nmemb, voi
         op->mReplyOffset = 0;
         op->mReplyLength = 0;
         op->mReplyFullLength = 0;
+        op->mReplyContentLength = 0;
         op->mReplyRetryAfter = 0;
         op->mStatus = HttpStatus();
         if (op->mReplyHeaders)
@@ -1015,6 +1044,19 @@ size_t HttpOpRequest::headerCallback(void * data, size_t size, size_t nmemb, voi
         }
     }
 
+    // Detect and parse 'Content-Length' headers
+    if (is_header
+        && value && *value
+        && ! strcmp(name, con_len_line))
+    {
+        char * end(NULL);
+        const unsigned long long length(strtoull(value, &end, 10));
+        if (end != value)
+        {
+            op->mReplyContentLength = static_cast<size_t>(length);
+        }
+    }
+
     // Detect and parse 'Retry-After' headers
     if (is_header
         && op->mProcFlags & PF_USE_RETRY_AFTER
@@ -215,6 +215,7 @@ public:
     off_t               mReplyOffset;
     size_t              mReplyLength;
     size_t              mReplyFullLength;
+    size_t              mReplyContentLength;    // From 'Content-Length', 0 if unknown
     HttpHeaders::ptr_t  mReplyHeaders;
     std::string         mReplyConType;
     int                 mReplyRetryAfter;
@@ -29,6 +29,7 @@
 
 
 #include <vector>
+#include <functional>
 
 #include "httpcommon.h"
 #include "_refcounted.h"
@@ -116,6 +117,15 @@ public:
     /// Threading:  callable by any thread.
     void wakeAll();
 
+    /// Install a hook invoked when an operation lands on an
+    /// empty queue or the queue is stopped.  Lets the worker
+    /// thread block somewhere other than the queue's condition
+    /// variable.  Pass an empty function to remove it; once that
+    /// returns, the hook will not be called again.
+    ///
+    /// Threading:  callable by any thread.
+    void setWakeupHook(std::function<void()> hook);
+
     /// Disallow further request queuing.  Callers to @addOp will
     /// get a failure status (LLCORE, HE_SHUTTING_DOWN).  Callers
     /// to @fetchAll or @fetchOp will get requests that are on the
@@ -134,6 +144,7 @@ protected:
     LLCoreInt::HttpMutex                mQueueMutex;
     LLCoreInt::HttpConditionVariable    mQueueCV;
     bool                                mQueueStopped;
+    std::function<void()>               mWakeupHook;    // Guarded by mQueueMutex
 
 }; // end class HttpRequestQueue
 
@@ -63,6 +63,7 @@ const HttpService::OptionDescriptor HttpService::sOptionDesc[] =
     {   true,       true,       true,       false,      false   },      // PO_TRACE
     {   true,       true,       false,      true,       false   },      // PO_ENABLE_PIPELINING
     {   true,       true,       false,      true,       false   },      // PO_THROTTLE_RATE
+    {   true,       true,       false,      true,       false   },      // PO_HTTP2_MULTIPLEX
     {   false,      false,      true,       false,      true    }       // PO_SSL_VERIFY_CALLBACK
 };
 HttpService * HttpService::sInstance(NULL);
@@ -212,6 +213,10 @@ void HttpService::startThread()
     mPolicy->start();
     mTransport->start(mLastPolicy + 1);
 
+    // Request queue writes end the transport's wait for socket activity
+    HttpLibcurl * transport(mTransport);
+    mRequestQueue->setWakeupHook([transport]() { transport->wakeup(); });
+
     mThread = new LLCoreInt::HttpThread(boost::bind(&HttpService::threadRun, this, _1));
     sState = RUNNING;
 }
@@ -256,6 +261,7 @@ void HttpService::shutdown()
     LL_PROFILE_ZONE_SCOPED_CATEGORY_NETWORK;
     // Disallow future enqueue of requests
     mRequestQueue->stopQueue();
+    mRequestQueue->setWakeupHook(std::function<void()>());
 
     // Cancel requests already on the request queue
     HttpRequestQueue::OpContainer ops;
@@ -278,9 +284,9 @@ void HttpService::shutdown()
 
 // Working thread loop-forever method.  Gives time to
 // each of the request queue, policy layer and transport
-// layer pieces and then either sleeps for a small time
-// or waits for a request to come in.  Repeats until
-// requested to stop.
+// layer pieces and then either waits on the transport's
+// sockets (woken early by new requests) or waits for a
+// request to come in.  Repeats until requested to stop.
 void HttpService::threadRun(LLCoreInt::HttpThread * thread)
 {
     LL_PROFILER_SET_THREAD_NAME("HttpService");
@@ -298,17 +304,20 @@ void HttpService::threadRun(LLCoreInt::HttpThread * thread)
             loop = processRequestQueue(loop);
 
             // Process ready queue issuing new requests as needed
-            ELoopSpeed new_loop = mPolicy->processReadyQueue();
-            loop = (std::min)(loop, new_loop);
+            const ELoopSpeed ready_loop(mPolicy->processReadyQueue());
+            loop = (std::min)(loop, ready_loop);
 
             // Give libcurl some cycles
-            new_loop = mTransport->processTransport();
+            ELoopSpeed new_loop = mTransport->processTransport();
             loop = (std::min)(loop, new_loop);
 
-            // Determine whether to spin, sleep briefly or sleep for next request
-            if (REQUEST_SLEEP != loop)
+            // Determine whether to spin, wait on transfers or sleep for next request.
+            // Requests held back by policy get rechecked at the old polling interval.
+            if (NORMAL == loop)
             {
-                ms_sleep(HTTP_SERVICE_LOOP_SLEEP_NORMAL_MS);
+                mTransport->waitForActivity(REQUEST_SLEEP != ready_loop
+                                            ? HTTP_SERVICE_LOOP_SLEEP_NORMAL_MS
+                                            : HTTP_SERVICE_LOOP_POLL_MAX_MS);
             }
         }
         catch (const LLContinueError&)
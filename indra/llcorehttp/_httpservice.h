@@ -104,7 +104,8 @@ public:
     // requests.
     enum ELoopSpeed
     {
-        NORMAL,                 ///< continuous polling of request, ready, active queues
+        IMMEDIATE,              ///< go around again without waiting, e.g. a slot just freed up
+        NORMAL,                 ///< wait on transfer sockets and request queue writes
         REQUEST_SLEEP           ///< can sleep indefinitely waiting for request queue write
     };
 
@@ -49,36 +49,29 @@ namespace LLCore
 // BufferArray::Block Declaration
 // ==================================
 
+// Blocks are plain values in the container, the data is a separate
+// 16-byte aligned allocation so that a consumer can take it over
+// as-is (see detachContiguousData()).  Owner frees explicitly.
 class BufferArray::Block
 {
 public:
-    ~Block();
+    Block()
+        : mUsed(0),
+          mAlloced(0),
+          mData(NULL)
+        {}
 
-    void operator delete(void *);
-    void operator delete(void *, size_t len);
+    // Allocate a block with room for 'len' bytes.
+    //
+    // @throw std::bad_alloc
+    static Block alloc(size_t len);
 
-protected:
-    Block(size_t len);
-
-    Block(const Block &);                       // Not defined
-    void operator=(const Block &);              // Not defined
-
-    // Allocate the block with the additional space for the
-    // buffered data at the end of the object.
-    void * operator new(size_t len, size_t addl_len);
-
-public:
-    // Only public entry to get a block.
-    static Block * alloc(size_t len);
+    void free();
 
 public:
     size_t mUsed;
     size_t mAlloced;
-
-    // *NOTE:  Must be last member of the object.  We'll
-    // overallocate as requested via operator new and index
-    // into the array at will.
-    char mData[1];
+    char * mData;
 };
 
 
@@ -103,8 +96,7 @@ BufferArray::~BufferArray()
          it != mBlocks.end();
          ++it)
     {
-        delete *it;
-        *it = NULL;
+        it->free();
     }
     mBlocks.clear();
 }
@@ -118,7 +110,7 @@ size_t BufferArray::append(const void * src, size_t len)
     // First, try to copy into the last block
     if (len && ! mBlocks.empty())
     {
-        Block & last(*mBlocks.back());
+        Block & last(mBlocks.back());
         if (last.mUsed < last.mAlloced)
         {
             // Some will fit...
@@ -138,14 +130,9 @@ size_t BufferArray::append(const void * src, size_t len)
     {
         const size_t copy_len((std::min)(len, BLOCK_ALLOC_SIZE));
 
-        if (mBlocks.size() >= mBlocks.capacity())
-        {
-            mBlocks.reserve(mBlocks.size() + 5);
-        }
-        Block * block;
         try
         {
-            block = Block::alloc(BLOCK_ALLOC_SIZE);
+            addBlock(BLOCK_ALLOC_SIZE);
         }
         catch (std::bad_alloc&)
         {
@@ -157,10 +144,10 @@ size_t BufferArray::append(const void * src, size_t len)
             LL_WARNS() << "Bad memory allocation in thrown by Block::alloc in read!" << LL_ENDL;
             break;
         }
-        memcpy(block->mData, c_src, copy_len);
-        block->mUsed = copy_len;
-        llassert_always(block->mUsed <= block->mAlloced);
-        mBlocks.push_back(block);
+        Block & block(mBlocks.back());
+        memcpy(block.mData, c_src, copy_len);
+        block.mUsed = copy_len;
+        llassert_always(block.mUsed <= block.mAlloced);
         mLen += copy_len;
         c_src += copy_len;
         len -= copy_len;
@@ -172,15 +159,94 @@ size_t BufferArray::append(const void * src, size_t len)
 void * BufferArray::appendBufferAlloc(size_t len)
 {
     // If someone asks for zero-length, we give them a valid pointer.
-    if (mBlocks.size() >= mBlocks.capacity())
+    addBlock((std::max)(BLOCK_ALLOC_SIZE, len));
+    Block & block(mBlocks.back());
+    memset(block.mData, 0, len);
+    block.mUsed = len;
+    mLen += len;
+    return block.mData;
+}
+
+
+void BufferArray::reserve(size_t len)
+{
+    if (! len)
     {
-        mBlocks.reserve(mBlocks.size() + 5);
+        return;
+    }
+    if (! mBlocks.empty())
+    {
+        Block & last(mBlocks.back());
+        if (last.mAlloced - last.mUsed >= len)
+        {
+            // Already fits
+            return;
+        }
+        if (! last.mUsed)
+        {
+            // Empty reservation that's too small, replace it
+            last.free();
+            mBlocks.pop_back();
+        }
+    }
+
+    try
+    {
+        addBlock((std::max)(BLOCK_ALLOC_SIZE, len));
+    }
+    catch (std::bad_alloc&)
+    {
+        // Only a hint, appends will find their own memory
+        LL_WARNS() << "Unable to reserve " << len << " bytes in BufferArray" << LL_ENDL;
     }
-    Block * block = Block::alloc((std::max)(BLOCK_ALLOC_SIZE, len));
-    block->mUsed = len;
-    mBlocks.push_back(block);
-    mLen += len;
-    return block->mData;
+}
+
+
+char * BufferArray::contiguousData()
+{
+    char * result(NULL);
+    for (container_t::iterator it(mBlocks.begin());
+         it != mBlocks.end();
+         ++it)
+    {
+        if (it->mUsed)
+        {
+            if (result)
+            {
+                // Second non-empty block
+                return NULL;
+            }
+            result = it->mData;
+        }
+    }
+    return result;
+}
+
+
+char * BufferArray::detachContiguousData(size_t * len)
+{
+    if (! contiguousData())
+    {
+        return NULL;
+    }
+
+    char * result(NULL);
+    for (container_t::iterator it(mBlocks.begin());
+         it != mBlocks.end();
+         ++it)
+    {
+        if (it->mUsed)
+        {
+            result = it->mData;
+            it->mData = NULL;
+        }
+        it->free();
+    }
+    mBlocks.clear();
+
+    *len = mLen;
+    mLen = 0;
+    return result;
 }
 
 
@@ -203,7 +269,7 @@ size_t BufferArray::read(size_t pos, void * dst, size_t len)
 
     do
     {
-        Block & block(*mBlocks[block_start]);
+        Block & block(mBlocks[block_start]);
         size_t block_limit(block.mUsed - offset);
         size_t block_len((std::min)(block_limit, len));
 
@@ -237,7 +303,7 @@ size_t BufferArray::write(size_t pos, const void * src, size_t len)
         // existing data.
         do
         {
-            Block & block(*mBlocks[block_start]);
+            Block & block(mBlocks[block_start]);
             size_t block_limit(block.mUsed - offset);
             size_t block_len((std::min)(block_limit, len));
 
@@ -255,7 +321,7 @@ size_t BufferArray::write(size_t pos, const void * src, size_t len)
     // space of the last block.
     if (len && ! mBlocks.empty())
     {
-        Block & last(*mBlocks.back());
+        Block & last(mBlocks.back());
         if (last.mUsed < last.mAlloced)
         {
             // Some will fit...
@@ -291,12 +357,12 @@ int BufferArray::findBlock(size_t pos, size_t * ret_offset)
     const int block_limit(narrow<size_t>(mBlocks.size()));
     for (int i(0); i < block_limit; ++i)
     {
-        if (pos < mBlocks[i]->mUsed)
+        if (pos < mBlocks[i].mUsed)
         {
             *ret_offset = pos;
             return i;
         }
-        pos -= mBlocks[i]->mUsed;
+        pos -= mBlocks[i].mUsed;
     }
 
     // Shouldn't get here but...
@@ -311,58 +377,51 @@ bool BufferArray::getBlockStartEnd(int block, const char ** start, const char **
         return false;
     }
 
-    const Block & b(*mBlocks[block]);
+    const Block & b(mBlocks[block]);
     *start = &b.mData[0];
     *end = &b.mData[b.mUsed];
     return true;
 }
 
 
+void BufferArray::addBlock(size_t len)
+{
+    if (mBlocks.size() >= mBlocks.capacity())
+    {
+        mBlocks.reserve(mBlocks.size() + 5);
+    }
+    mBlocks.push_back(Block::alloc(len));
+}
+
+
 // ==================================
 // BufferArray::Block Definitions
 // ==================================
 
 
-BufferArray::Block::Block(size_t len)
-    : mUsed(0),
-      mAlloced(len)
+BufferArray::Block BufferArray::Block::alloc(size_t len)
 {
-    memset(mData, 0, len);
+    Block block;
+    block.mData = static_cast<char *>(ll_aligned_malloc_16(len));
+    if (! block.mData)
+    {
+        throw std::bad_alloc();
+    }
+    block.mAlloced = len;
+    return block;
 }
 
 
-BufferArray::Block::~Block()
+void BufferArray::Block::free()
 {
+    if (mData)
+    {
+        ll_aligned_free_16(mData);
+    }
+    mData = NULL;
     mUsed = 0;
     mAlloced = 0;
 }
 
 
-void * BufferArray::Block::operator new(size_t len, size_t addl_len)
-{
-    void * mem = new char[len + addl_len + sizeof(void *)];
-    return mem;
-}
-
-
-void BufferArray::Block::operator delete(void * mem)
-{
-    char * cmem = static_cast<char *>(mem);
-    delete [] cmem;
-}
-
-
-void BufferArray::Block::operator delete(void * mem, size_t)
-{
-    operator delete(mem);
-}
-
-
-BufferArray::Block * BufferArray::Block::alloc(size_t len)
-{
-    Block * block = new (len) Block(len);
-    return block;
-}
-
-
 }  // end namespace LLCore
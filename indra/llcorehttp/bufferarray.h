@@ -58,6 +58,12 @@ class BufferArrayStreamBuf;
 /// write and append operations and beyond which the current position
 /// cannot be set.
 ///
+/// Consumers that want the data in one piece can check for a single
+/// contiguous block with contiguousData() and even take ownership of
+/// it with detachContiguousData() instead of copying it out with
+/// read().  Producers that know the final size up front (e.g. from a
+/// Content-Length header) can use reserve() to make that likely.
+///
 /// Threading:  not thread-safe
 ///
 /// Allocation:  Refcounted, heap only.  Caller of the constructor
@@ -103,6 +109,29 @@ public:
     ///                 of BufferArray of 'len' size.
     void * appendBufferAlloc(size_t len);
 
+    /// Make room so that the next 'len' bytes appended land
+    /// in a single contiguous block.  Only a hint, appending
+    /// more than that spills into further blocks as usual.
+    /// Doesn't change size() or position.
+    void reserve(size_t len);
+
+    /// If all of the data is held in a single contiguous
+    /// block, return a pointer to it, otherwise NULL.  Also
+    /// NULL when the instance is empty.  The pointer is valid
+    /// until the next modifying call.
+    char * contiguousData();
+
+    /// Like @see contiguousData() but the caller takes
+    /// ownership of the block and the instance is left empty.
+    /// The memory is 16-byte aligned and must be released
+    /// with ll_aligned_free_16().  Caller must be the only
+    /// user of the instance.
+    ///
+    /// @return         Pointer to the data, length in 'len',
+    ///                 or NULL and the instance untouched if
+    ///                 the data isn't contiguous.
+    char * detachContiguousData(size_t * len);
+
     /// Current count of bytes in BufferArray instance.
     size_t size() const
         {
@@ -127,7 +156,9 @@ protected:
 
 protected:
     class Block;
-    typedef std::vector<Block *> container_t;
+    typedef std::vector<Block> container_t;
+
+    void addBlock(size_t len);
 
     container_t         mBlocks;
     size_t              mLen;
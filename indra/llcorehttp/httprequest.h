@@ -226,6 +226,15 @@ public:
         /// Per-class only
         PO_THROTTLE_RATE,
 
+        /// Long value that, when non-zero, lets a pipelined class
+        /// negotiate HTTP/2 over TLS and multiplex its requests on
+        /// one connection.  Has no effect unless PO_PIPELINING_DEPTH
+        /// is 2 or more.  Zero, the default, keeps the class on
+        /// HTTP/1.1.
+        ///
+        /// Per-class only
+        PO_HTTP2_MULTIPLEX,
+
         /// Controls the callback function used to control SSL CTX
         /// certificate verification.
         ///
@@ -27,6 +27,7 @@
 #define TEST_LLCORE_BUFFER_ARRAY_H_
 
 #include "bufferarray.h"
+#include "llmemory.h"
 
 #include <iostream>
 
@@ -374,6 +375,109 @@ void BufferArrayTestObjectType::test<8>()
     ba->release();
 }
 
+template <> template <>
+void BufferArrayTestObjectType::test<9>()
+{
+    set_test_name("BufferArray reserve keeps large bodies contiguous");
+
+    const size_t chunk_len(16384);
+    const size_t total_len(BufferArray::BLOCK_ALLOC_SIZE * 3 + 100);
+    char chunk[chunk_len];
+
+    // Without a reservation, appends spill across blocks
+    BufferArray * ba = new BufferArray();
+    ensure("Empty BufferArray has no contiguous data", NULL == ba->contiguousData());
+    for (size_t len(0); len < total_len; len += chunk_len)
+    {
+        memset(chunk, int('a' + (len / chunk_len) % 26), chunk_len);
+        ba->append(chunk, (std::min)(chunk_len, total_len - len));
+    }
+    ensure("Unreserved BufferArray length correct", total_len == ba->size());
+    ensure("Unreserved BufferArray not contiguous", NULL == ba->contiguousData());
+    ba->release();
+
+    // With one, the whole body lands in a single block
+    ba = new BufferArray();
+    ba->reserve(total_len);
+    ensure("Reserved, empty BufferArray has no contiguous data", NULL == ba->contiguousData());
+    for (size_t len(0); len < total_len; len += chunk_len)
+    {
+        memset(chunk, int('a' + (len / chunk_len) % 26), chunk_len);
+        ba->append(chunk, (std::min)(chunk_len, total_len - len));
+    }
+    ensure("Reserved BufferArray length correct", total_len == ba->size());
+
+    const char * data(ba->contiguousData());
+    ensure("Reserved BufferArray contiguous", NULL != data);
+    bool content_ok(true);
+    for (size_t i(0); i < total_len && content_ok; ++i)
+    {
+        content_ok = (data[i] == char('a' + (i / chunk_len) % 26));
+    }
+    ensure("Contiguous content correct", content_ok);
+
+    ba->release();
+}
+
+template <> template <>
+void BufferArrayTestObjectType::test<10>()
+{
+    set_test_name("BufferArray detachContiguousData");
+
+    char str1[] = "abcdefghij";
+    size_t str1_len(strlen(str1));
+
+    BufferArray * ba = new BufferArray();
+
+    size_t len(1234);
+    ensure("Nothing to detach when empty", NULL == ba->detachContiguousData(&len));
+    ensure("Length untouched on failed detach", 1234 == len);
+
+    ba->append(str1, str1_len);
+    ba->append(str1, str1_len);
+
+    char * data(ba->detachContiguousData(&len));
+    ensure("Detached data non-NULL", NULL != data);
+    ensure("Detached length correct", 2 * str1_len == len);
+    ensure("Detached content correct.1", 0 == strncmp(data, str1, str1_len));
+    ensure("Detached content correct.2", 0 == strncmp(data + str1_len, str1, str1_len));
+    ensure("Detached data aligned", 0 == (reinterpret_cast<uintptr_t>(data) & 0xf));
+    ll_aligned_free_16(data);
+
+    ensure("BufferArray empty after detach", 0 == ba->size());
+    ensure("No contiguous data after detach", NULL == ba->contiguousData());
+
+    // Still usable afterwards
+    ba->append(str1, str1_len);
+    char buffer[32];
+    memset(buffer, 'X', sizeof(buffer));
+    len = ba->read(0, buffer, sizeof(buffer));
+    ensure("Reuse length correct", str1_len == len);
+    ensure("Reuse content correct", 0 == strncmp(buffer, str1, str1_len));
+
+    ba->release();
+}
+
+template <> template <>
+void BufferArrayTestObjectType::test<11>()
+{
+    set_test_name("BufferArray detachContiguousData on multiple blocks");
+
+    const size_t total_len(BufferArray::BLOCK_ALLOC_SIZE + 10);
+    char * src(new char [total_len]);
+    memset(src, 'q', total_len);
+
+    BufferArray * ba = new BufferArray();
+    ba->append(src, total_len);
+
+    size_t len(0);
+    ensure("Can't detach non-contiguous data", NULL == ba->detachContiguousData(&len));
+    ensure("Data still present after failed detach", total_len == ba->size());
+
+    ba->release();
+    delete [] src;
+}
+
 }  // end namespace tut
 
 
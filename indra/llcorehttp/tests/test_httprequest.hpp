@@ -34,10 +34,12 @@
 #include "httpoptions.h"
 #include "_httpservice.h"
 #include "_httprequestqueue.h"
+#include "lltimer.h"
 
 #include <curl/curl.h>
 #include <boost/regex.hpp>
 #include <sstream>
+#include <algorithm>
 
 #include "llcorehttp_test.h"
 
@@ -3036,6 +3038,121 @@ void HttpRequestTestObjectType::test<23>()
 }
 
 
+template <> template <>
+void HttpRequestTestObjectType::test<24>()
+{
+    ScopedCurlInit ready;
+
+    std::string url_base(get_base_url());
+
+    set_test_name("HttpRequest GET issue-to-callback latency");
+
+    // Handler can be stack-allocated *if* there are no dangling
+    // references to it after completion of this method.
+    TestHandler2 handler(this, "handler");
+    LLCore::HttpHandler::ptr_t handlerp(&handler, NoOpDeletor);
+    mHandlerCalls = 0;
+
+    HttpRequest * req = NULL;
+
+    try
+    {
+        // Get singletons created
+        HttpRequest::createService();
+
+        // Start threading early so that thread memory is invariant
+        // over the test.
+        HttpRequest::startThread();
+
+        // create a new ref counted object with an implicit reference
+        req = new HttpRequest();
+
+        // Issue GETs one at a time against the loopback server so
+        // each one finds the service idle and measure how long it
+        // takes for the completion to reach the handler.  The first
+        // request pays for the connection and isn't counted.
+        mStatus = HttpStatus(200);
+        const int request_count(50);
+        std::vector<F64> latencies;
+        for (int i(0); i <= request_count; ++i)
+        {
+            const int calls(mHandlerCalls);
+            const U64 start(LLTimer::getTotalTime());
+            HttpHandle handle = req->requestGet(HttpRequest::DEFAULT_POLICY_ID,
+                                                url_base,
+                                                HttpOptions::ptr_t(),
+                                                HttpHeaders::ptr_t(),
+                                                handlerp);
+            ensure("Valid handle returned for latency request", handle != LLCORE_HTTP_HANDLE_INVALID);
+
+            // Run the notification pump with a fine-grained sleep
+            int count(0);
+            int limit(LOOP_COUNT_LONG * 100);
+            while (count++ < limit && mHandlerCalls == calls)
+            {
+                req->update(0);
+                usleep(LOOP_SLEEP_INTERVAL / 100);
+            }
+            ensure("Latency request executed in reasonable time", count < limit);
+            if (i > 0)
+            {
+                latencies.push_back(F64(LLTimer::getTotalTime() - start) / 1000.0);
+            }
+        }
+        ensure("One handler invocation per request", mHandlerCalls == request_count + 1);
+
+        std::sort(latencies.begin(), latencies.end());
+        F64 total(0.0);
+        for (F64 latency : latencies)
+        {
+            total += latency;
+        }
+        std::cout << "HttpRequest loopback GET latency over " << request_count << " requests:  mean "
+                  << total / request_count << "ms, median " << latencies[request_count / 2]
+                  << "ms, max " << latencies.back() << "ms" << std::endl;
+
+        // Okay, request a shutdown of the servicing thread
+        mStatus = HttpStatus();
+        mHandlerCalls = 0;
+        HttpHandle handle = req->requestStopThread(handlerp);
+        ensure("Valid handle returned for second request", handle != LLCORE_HTTP_HANDLE_INVALID);
+
+        // Run the notification pump again
+        int count(0);
+        int limit(LOOP_COUNT_LONG);
+        while (count++ < limit && mHandlerCalls < 1)
+        {
+            req->update(1000000);
+            usleep(LOOP_SLEEP_INTERVAL);
+        }
+        ensure("Second request executed in reasonable time", count < limit);
+        ensure("Second handler invocation", mHandlerCalls == 1);
+
+        // See that we actually shutdown the thread
+        count = 0;
+        limit = LOOP_COUNT_SHORT;
+        while (count++ < limit && ! HttpService::isStopped())
+        {
+            usleep(LOOP_SLEEP_INTERVAL);
+        }
+        ensure("Thread actually stopped running", HttpService::isStopped());
+
+        // release the request object
+        delete req;
+        req = NULL;
+
+        // Shut down service
+        HttpRequest::destroyService();
+    }
+    catch (...)
+    {
+        stop_thread(req);
+        delete req;
+        HttpRequest::destroyService();
+        throw;
+    }
+}
+
 }  // end namespace tut
 
 namespace
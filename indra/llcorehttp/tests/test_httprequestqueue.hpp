@@ -151,6 +151,48 @@ void HttpRequestqueueTestObjectType::test<4>()
     }
 }
 
+template <> template <>
+void HttpRequestqueueTestObjectType::test<5>()
+{
+    set_test_name("HttpRequestQueue wakeup hook");
+
+    // create a new ref counted object with an implicit reference
+    HttpRequestQueue::init();
+
+    HttpRequestQueue * rq = HttpRequestQueue::instanceOf();
+
+    int wakeups(0);
+    rq->setWakeupHook([&wakeups]() { ++wakeups; });
+
+    HttpOperation::ptr_t op (new HttpOpNull());
+    rq->addOp(op);
+    ensure("Write to empty queue wakes", 1 == wakeups);
+
+    op.reset(new HttpOpNull());
+    rq->addOp(op);
+    ensure("Write to non-empty queue doesn't wake again", 1 == wakeups);
+
+    {
+        HttpRequestQueue::OpContainer ops;
+        rq->fetchAll(false, ops);
+        ensure("Two go in, two come out", 2 == ops.size());
+    }
+
+    op.reset(new HttpOpNull());
+    rq->addOp(op);
+    ensure("Write to drained queue wakes", 2 == wakeups);
+
+    rq->stopQueue();
+    ensure("Stopping queue wakes", 3 == wakeups);
+
+    rq->setWakeupHook(std::function<void()>());
+    rq->stopQueue();
+    ensure("Removed hook isn't called", 3 == wakeups);
+
+    op.reset();
+    HttpRequestQueue::term();
+}
+
 }  // end namespace tut
 
 
@@ -50,6 +50,7 @@
 static const std::string CACHE_FILENAME_PREFIX("sl_cache");
 
 std::string LLDiskCache::sCacheDir;
+std::unique_ptr<LLDiskCachePackStore> LLDiskCache::sPackStore;
 
 // <FS:Ansariel> Optimize asset simple disk cache
 static const char* subdirs = "0123456789abcdef";
@@ -61,9 +62,12 @@ LLDiskCache::LLDiskCache(const std::string& cache_dir,
                          ,const F32 highwater_mark_percent
                          ,const F32 lowwater_mark_percent
 // </FS:Beq>
+                         ,const bool use_pack_store
+                         ,const bool read_only
                          ) :
     mMaxSizeBytes(max_size_bytes),
-    mEnableCacheDebugInfo(enable_cache_debug_info)
+    mEnableCacheDebugInfo(enable_cache_debug_info),
+    mReadOnly(read_only)
 {
     sCacheDir = cache_dir;
     LLFile::mkdir(cache_dir);
@@ -75,6 +79,16 @@ LLDiskCache::LLDiskCache(const std::string& cache_dir,
         LLFile::mkdir(dirname);
     }
     // </FS:Ansariel>
+
+    if (use_pack_store)
+    {
+        LL_INFOS("LLDiskCache") << "Using pack file storage for the disk cache" << LL_ENDL;
+        sPackStore = std::make_unique<LLDiskCachePackStore>(cache_dir, read_only);
+    }
+
+    // the directory is only walked (from purge()) if there is no usable index
+    loadIndex();
+
     // <FS:Beq> add static assets into the new cache after clear.
     // Only missing entries are copied on init, skiplist is setup
     // For everything we populate FS specific assets to allow future updates
@@ -112,220 +126,378 @@ LLDiskCache::LLDiskCache(const std::string& cache_dir,
 // asset will have to be re-requested.
 void LLDiskCache::purge()
 {
+    if (!mIndex.isValid())
+    {
+        rebuildIndex();
+    }
+    flushAccessTimes();
+
     if (mEnableCacheDebugInfo)
     {
         LL_INFOS() << "Total dir size before purge is " << dirFileSize(sCacheDir) << LL_ENDL;
     }
 
-    boost::system::error_code ec;
     auto start_time = std::chrono::high_resolution_clock::now();
 
-    typedef std::pair<std::time_t, std::pair<uintmax_t, std::string>> file_info_t;
-    std::vector<file_info_t> file_info;
-
-#if LL_WINDOWS
-    std::wstring cache_path(utf8str_to_utf16str(sCacheDir));
-#else
-    std::string cache_path(sCacheDir);
-#endif
-    uintmax_t file_size_total = 0; // <FS:Beq/> try to make simple cache less naive.
-    
-    if (boost::filesystem::is_directory(cache_path, ec) && !ec.failed())
-    {
-        // <FS:Ansariel> Optimize asset simple disk cache
-        //boost::filesystem::directory_iterator iter(cache_path, ec);
-        //while (iter != boost::filesystem::directory_iterator() && !ec.failed())
-        boost::filesystem::recursive_directory_iterator iter(cache_path, ec);
-        while (iter != boost::filesystem::recursive_directory_iterator() && !ec.failed())
-        // </FS:Ansariel>
-        {
-            if (boost::filesystem::is_regular_file(*iter, ec) && !ec.failed())
-            {
-                if ((*iter).path().string().find(CACHE_FILENAME_PREFIX) != std::string::npos)
-                {
-                    uintmax_t file_size = boost::filesystem::file_size(*iter, ec);
-                    if (ec.failed())
-                    {
-                        continue;
-                    }
-                    const std::string file_path = (*iter).path().string();
-                    const std::time_t file_time = boost::filesystem::last_write_time(*iter, ec);
-                    if (ec.failed())
-                    {
-                        continue;
-                    }
-                    file_size_total += file_size; // <FS:Beq/> try to make simple cache less naive.
+    // <FS:Beq> add high water/low water thresholds to reduce the churn in the cache.
+    // If we are above the trigger level we must purge until we've removed enough
+    // to take us down to the low water mark.
+    auto target_size = (uintmax_t)(mMaxSizeBytes * (mLowPercent / 100));
+    // </FS:Beq>
 
-                    file_info.push_back(file_info_t(file_time, { file_size, file_path }));
-                }
-            }
-            iter.increment(ec);
-        }
-    }
+    const uintmax_t file_size_total = mIndex.getSize();
+    const size_t file_count = mIndex.getCount();
 
-    // <FS:Beq> add high water/low water thresholds to reduce the churn in the cache.
-    LL_DEBUGS("LLDiskCache") << "Cache is " << (int)(((F32)file_size_total)/mMaxSizeBytes*100.0) << "% full" << LL_ENDL;
-    if( file_size_total < mMaxSizeBytes * (mHighPercent/100) )
+    LL_DEBUGS("LLDiskCache") << "Cache is " << (int)(((F32)file_size_total) / mMaxSizeBytes * 100.0) << "% full" << LL_ENDL;
+    if (file_size_total < mMaxSizeBytes * (mHighPercent / 100))
     {
-        // Nothing to do here 
+        // Nothing to do here
         LL_DEBUGS("LLDiskCache") << "Not exceded high water - do nothing" << LL_ENDL;
         return;
     }
-    // If we reach here we are above the trigger level so we must purge until we've removed enough to take us down to the low water mark.
-    // </FS:Beq>
-    std::sort(file_info.begin(), file_info.end(), [](file_info_t& x, file_info_t& y)
-    {
-        return x.first < y.first; // <FS:Beq/> sort oldest to newest, to we can remove the oldest files first.
-    });
-
-
-    // <FS:Beq> add high water/low water thresholds to reduce the churn in the cache.
-    auto target_size = (uintmax_t)(mMaxSizeBytes * (mLowPercent/100));
     LL_INFOS() << "Purging cache to a maximum of " << target_size << " bytes" << LL_ENDL;
-    // </FS:Beq>
 
-    // <FS:Beq> Extra accounting to track the retention of static assets
-    //std::vector<bool> file_removed;
-    enum class purge_action { delete_file=0, keep_file, skip_file };
-    std::map<std::string,purge_action> file_removed;
-    auto keep{file_info.size()};
-    auto del{0};
-    auto skip{0};
-    // </FS:Beq>
-    // <FS:Beq> revised purge logic to track amount removed not retained to shortern loop
-    // uintmax_t file_size_total = 0;
-    // if (mEnableCacheDebugInfo)
-    // {
-    //     file_removed.reserve(file_info.size());
-    // }
-    // uintmax_t file_size_total = 0;
-    // for (file_info_t& entry : file_info)
-    // {
-    //     file_size_total += entry.second.first;
-
-    //     bool should_remove = file_size_total > mMaxSizeBytes;
-    //     if (mEnableCacheDebugInfo)
-    //     {
-    //         file_removed.push_back(should_remove);
-    //     }
-    uintmax_t deleted_size_total = 0;
-    for (const file_info_t& entry : file_info)
+    // <FS> Make sure static assets are not eliminated
+    auto keep = [this](const LLUUID& id)
     {
-        // first check if we still need to delete more files
-        bool should_remove = (file_size_total - deleted_size_total) > target_size;
-
-        // <FS> Make sure static assets are not eliminated
-        auto action{ should_remove ? purge_action::delete_file : purge_action::keep_file };
-        if (!should_remove)
+        if (std::find(mSkipList.begin(), mSkipList.end(), id.asString()) != mSkipList.end())
         {
-            break;
+            return true;
         }
+        LLMutexLock lock(&mMappedMutex);
+        return mMapped.find(id) != mMapped.end();
+    };
+    // </FS>
+    LLDiskCacheIndex::entry_list_t purged;
+    const size_t skip = mIndex.purge(target_size, keep, purged);
 
-        auto this_file_size = entry.second.first;
-        deleted_size_total += this_file_size;
-        auto uuid_as_string = gDirUtilp->getBaseFileName(entry.second.second, true);
-        uuid_as_string      = uuid_as_string.substr(CACHE_FILENAME_PREFIX.size() + 1, 36);  // skip "sl_cache_" and trailing "_N"
-        // LL_INFOS() << "checking UUID=" <<uuid_as_string<< LL_ENDL;
-        if (std::find(mSkipList.begin(), mSkipList.end(), uuid_as_string) != mSkipList.end())
-        {
-            // this is one of our protected items so no purging
-            should_remove = false;
-            action = purge_action::skip_file;
-            boost::filesystem::last_write_time(entry.second.second, ec);  // force these to the front of the list next time so that purge size works 
-            skip++;
-        }
-        else{
-            del++;
-        }
-        keep--;
-        if (mEnableCacheDebugInfo)
+    // The files are removed without holding the index lock so that readers
+    // and writers on other threads are not held up by the filesystem.
+    LLDiskCacheIndex::entry_list_t failed;
+    uintmax_t deleted_size_total = 0;
+    if (sPackStore)
+    {
+        for (const auto& entry : purged)
         {
-            file_removed.emplace(entry.second.second, action);
+            sPackStore->remove(entry.mID);
+            deleted_size_total += entry.mSize;
         }
-    // </FS>
-        if (should_remove)
+        // reclaim the space taken by what we just removed
+        sPackStore->compact();
+    }
+    else
+    {
+        boost::system::error_code ec;
+        for (const auto& entry : purged)
         {
-            boost::filesystem::remove(entry.second.second, ec);
-            if (ec.failed())
+            // Held across the remove so the file can't be mapped in between
+            LLMutexLock lock(&mMappedMutex);
+            if (mMapped.find(entry.mID) != mMapped.end())
+            {
+                failed.push_back(entry);
+                continue;
+            }
+
+            const std::string file_path = metaDataToFilepath(entry.mID, LLAssetType::AT_UNKNOWN);
+#if LL_WINDOWS
+            boost::filesystem::remove(utf8str_to_utf16str(file_path), ec);
+#else
+            boost::filesystem::remove(file_path, ec);
+#endif
+            if (ec.failed() && ec != boost::system::errc::no_such_file_or_directory)
             {
-                LL_WARNS() << "Failed to delete cache file " << entry.second.second << ": " << ec.message() << LL_ENDL;
+                LL_WARNS() << "Failed to delete cache file " << file_path << ": " << ec.message() << LL_ENDL;
+                failed.push_back(entry);
+                continue;
             }
+            deleted_size_total += entry.mSize;
         }
     }
+
+    // A file that could not be removed (it may be open elsewhere, which
+    // prevents removal on Windows, or was mapped since it was picked) is
+    // still taking up space, so it goes back into the index to be tried
+    // again next time.
+    mIndex.restore(failed);
+
 // <FS:Beq> update the debug logging to be more useful
     auto end_time = std::chrono::high_resolution_clock::now();
     auto execute_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
 // </FS:Beq>
     if (mEnableCacheDebugInfo)
     {
-        // <FS:Beq> update the debug logging to be more useful
-        // auto end_time = std::chrono::high_resolution_clock::now();
-        // auto execute_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
-        // </FS:Beq>
-
         // Log afterward so it doesn't affect the time measurement
         // Logging thousands of file results can take hundreds of milliseconds
         uintmax_t deleted_so_far{ 0 }; // <FS:Beq/> update the debug logging to be more useful
-        for (size_t i = 0; i < file_info.size(); ++i)
+        for (const auto& entry : purged)
         {
-            const file_info_t& entry = file_info[i];
-            // <FS> Static asset stuff
-            deleted_so_far += entry.second.first; // <FS:Beq/> update the debug logging to be more useful
-            //const bool removed = file_removed[i];
-            //const std::string action = removed ? "DELETE:" : "KEEP:";
-            std::string action{};
-
-            // Check if the file exists in the map
-            auto& filename{ entry.second.second };
-            if (file_removed.find(filename) != file_removed.end()) {
-            // File found in the map, retrieve the corresponding enum value
-            switch (file_removed[filename])
-            {
-                case purge_action::delete_file:
-                    action = "DELETE";
-                    del++;
-                break;
-                case purge_action::skip_file:
-                    action = "STATIC";
-                    skip++;
-                break;
-                default:
-                // Handle any unexpected enum value
-                    action = "UNKNOWN";
-                break;
-            }
-            }
-            else 
-            {
-                action = "KEEP";
-            }            
-            // </FS>
+            deleted_so_far += entry.mSize; // <FS:Beq/> update the debug logging to be more useful
 
             // have to do this because of LL_INFO/LL_END weirdness
             std::ostringstream line;
 
-            line << action << "  ";
-            line << entry.first << "  ";
-            line << entry.second.first << "  ";
-            line << entry.second.second;
+            line << "DELETE  ";
+            line << entry.mLastAccess << "  ";
+            line << entry.mSize << "  ";
+            line << metaDataToFilepath(entry.mID, LLAssetType::AT_UNKNOWN);
             line << " (" << file_size_total - deleted_so_far << "/" << mMaxSizeBytes << ")"; // <FS:Beq/> update the debug logging to be more useful
             LL_INFOS() << line.str() << LL_ENDL;
         }
-// <FS:Beq> make the summary stats more easily enabled.
     }
-    // <FS:Beq> update the debug logging to be more useful
-        // LL_INFOS() << "Total dir size after purge is " << dirFileSize(sCacheDir) << LL_ENDL;
-        // LL_INFOS() << "Cache purge took " << execute_time << " ms to execute for " << file_info.size() << " files" << LL_ENDL;
 
-    auto newCacheSize = updateCacheSize(file_size_total - deleted_size_total); 
-    LL_INFOS("LLDiskCache") << "Total dir size after purge is " << newCacheSize << LL_ENDL; 
-    LL_INFOS("LLDiskCache") << "Cache purge took " << execute_time << " ms to execute for " << file_info.size() << " files" << LL_ENDL;
+// <FS:Beq> make the summary stats more easily enabled.
+    auto newCacheSize = updateCacheSize(file_size_total - deleted_size_total);
+    LL_INFOS("LLDiskCache") << "Total dir size after purge is " << newCacheSize << LL_ENDL;
+    LL_INFOS("LLDiskCache") << "Cache purge took " << execute_time << " ms to execute for " << file_count << " files" << LL_ENDL;
 // </FS:Beq>
-    LL_INFOS("LLDiskCache") << "Deleted: " << del << " Skipped: " << skip << " Kept: " << keep << LL_ENDL;    // <FS:Beq/> Extra accounting to track the retention of static assets
+    const size_t deleted = purged.size() - failed.size();
+    LL_INFOS("LLDiskCache") << "Deleted: " << deleted << " Skipped: " << skip << " Kept: " << file_count - deleted << LL_ENDL;    // <FS:Beq/> Extra accounting to track the retention of static assets
     LL_INFOS("LLDiskCache") << "Total of " << deleted_size_total << " bytes removed." << LL_ENDL;    // <FS:Beq/> Extra accounting to track the retention of static assets
-    // } <FS:Beq/> this bracket was moved up a few lines.
 }
 
+void LLDiskCache::recordWrite(const LLUUID& id, uintmax_t size, bool truncated)
+{
+    mIndex.recordWrite(id, size, truncated, std::time(nullptr));
+}
+
+void LLDiskCache::recordAccess(const LLUUID& id)
+{
+    const std::time_t now = std::time(nullptr);
+    mIndex.recordAccess(id, now);
+    LLMutexLock lock(&mPendingAccessMutex);
+    mPendingAccess[id] = now;
+}
+
+void LLDiskCache::recordMapped(const LLUUID& id)
+{
+    LLMutexLock lock(&mMappedMutex);
+    ++mMapped[id];
+}
+
+void LLDiskCache::recordUnmapped(const LLUUID& id)
+{
+    LLMutexLock lock(&mMappedMutex);
+    auto it = mMapped.find(id);
+    if (it != mMapped.end() && --it->second <= 0)
+    {
+        mMapped.erase(it);
+    }
+}
+
+void LLDiskCache::flushAccessTimes()
+{
+    LLDiskCacheIndex::access_map_t pending;
+    {
+        LLMutexLock lock(&mPendingAccessMutex);
+        pending.swap(mPendingAccess);
+    }
+
+    // Anything read before the index was rebuilt could not be moved to
+    // the recent end of the LRU list at the time, so catch up now
+    mIndex.recordAccesses(pending);
+
+    // The file (or pack) times are only needed to rebuild the index after
+    // a crash, so they can lag behind by a purge interval
+    for (const auto& access : pending)
+    {
+        if (sPackStore)
+        {
+            sPackStore->setLastAccess(access.first, access.second);
+        }
+        else
+        {
+            updateFileAccessTime(metaDataToFilepath(access.first, LLAssetType::AT_UNKNOWN), access.second);
+        }
+    }
+}
+
+void LLDiskCache::updateFileAccessTime(const std::string& file_path, std::time_t access_time)
+{
+    /**
+     * Threshold in time_t units that is used to decide if the last access time
+     * time of the file is updated or not. Added as a precaution for the concern
+     * outlined in SL-14582  about frequent writes on older SSDs reducing their
+     * lifespan. I think this is the right place for the threshold value - rather
+     * than it being a pref - do comment on that Jira if you disagree...
+     *
+     * Let's start with 1 hour in time_t units and see how that unfolds
+     */
+    constexpr std::time_t time_threshold = 1 * 60 * 60;
+
+    // time the file was last read
+    const std::time_t cur_time = access_time;
+
+    boost::system::error_code ec;
+#if LL_WINDOWS
+    // file last write time
+    const std::time_t last_write_time = boost::filesystem::last_write_time(utf8str_to_utf16str(file_path), ec);
+    if (ec.failed())
+    {
+        // it may well have been purged since it was read
+        if (ec != boost::system::errc::no_such_file_or_directory)
+        {
+            LL_WARNS() << "Failed to read last write time for cache file " << file_path << ": " << ec.message() << LL_ENDL;
+        }
+        return;
+    }
+
+    // delta between cur time and last time the file was written
+    const std::time_t delta_time = cur_time - last_write_time;
+
+    // we only write the new value if the time in time_threshold has elapsed
+    // before the last one
+    if (delta_time > time_threshold)
+    {
+        boost::filesystem::last_write_time(utf8str_to_utf16str(file_path), cur_time, ec);
+    }
+#else
+    // file last write time
+    const std::time_t last_write_time = boost::filesystem::last_write_time(file_path, ec);
+    if (ec.failed())
+    {
+        // it may well have been purged since it was read
+        if (ec != boost::system::errc::no_such_file_or_directory)
+        {
+            LL_WARNS() << "Failed to read last write time for cache file " << file_path << ": " << ec.message() << LL_ENDL;
+        }
+        return;
+    }
+
+    // delta between cur time and last time the file was written
+    const std::time_t delta_time = cur_time - last_write_time;
+
+    // we only write the new value if the time in time_threshold has elapsed
+    // before the last one
+    if (delta_time > time_threshold)
+    {
+        boost::filesystem::last_write_time(file_path, cur_time, ec);
+    }
+#endif
+
+    if (ec.failed())
+    {
+        LL_WARNS() << "Failed to update last write time for cache file " << file_path << ": " << ec.message() << LL_ENDL;
+    }
+}
+
+
+void LLDiskCache::recordRemove(const LLUUID& id)
+{
+    mIndex.recordRemove(id);
+}
+
+void LLDiskCache::recordRename(const LLUUID& old_id, const LLUUID& new_id)
+{
+    mIndex.recordRename(old_id, new_id, std::time(nullptr));
+}
+
+// static
+const std::string LLDiskCache::indexFilepath()
+{
+    return sCacheDir + gDirUtilp->getDirDelimiter() + "cache_index.dat";
+}
+
+bool LLDiskCache::loadIndex()
+{
+    const std::string filename = indexFilepath();
+    if (!LLFile::isfile(filename))
+    {
+        LL_INFOS("LLDiskCache") << "No cache index found, it will be rebuilt" << LL_ENDL;
+        return false;
+    }
+
+    const bool success = mIndex.load(filename);
+
+    // The index is only trusted for this session; if we do not exit cleanly
+    // the next session must rebuild it from the directory. A read only
+    // instance leaves it to the instance that owns the cache.
+    if (!mReadOnly)
+    {
+        LLFile::remove(filename, ENOENT);
+    }
+
+    if (!success)
+    {
+        LL_WARNS("LLDiskCache") << "Cache index " << filename << " is corrupt, it will be rebuilt" << LL_ENDL;
+    }
+    return success;
+}
+
+bool LLDiskCache::saveIndex()
+{
+    if (mReadOnly)
+    {
+        // the instance that owns the cache saves its own index
+        return false;
+    }
+    return mIndex.save(indexFilepath());
+}
+
+void LLDiskCache::rebuildIndex()
+{
+    auto start_time = std::chrono::high_resolution_clock::now();
+
+    LLDiskCacheIndex::entry_list_t file_info;
+
+    if (sPackStore)
+    {
+        LLDiskCachePackStore::entry_list_t entries;
+        sPackStore->getEntries(entries);
+        for (const auto& entry : entries)
+        {
+            file_info.push_back({ entry.mID, (uintmax_t)entry.mSize, entry.mLastAccess });
+        }
+    }
+
+    boost::system::error_code ec;
+#if LL_WINDOWS
+    std::wstring cache_path(utf8str_to_utf16str(sCacheDir));
+#else
+    std::string cache_path(sCacheDir);
+#endif
+    if (!sPackStore && boost::filesystem::is_directory(cache_path, ec) && !ec.failed())
+    {
+        // <FS:Ansariel> Optimize asset simple disk cache
+        boost::filesystem::recursive_directory_iterator iter(cache_path, ec);
+        while (iter != boost::filesystem::recursive_directory_iterator() && !ec.failed())
+        // </FS:Ansariel>
+        {
+            if (boost::filesystem::is_regular_file(*iter, ec) && !ec.failed())
+            {
+                const std::string file_name = (*iter).path().filename().string();
+                if (file_name.compare(0, CACHE_FILENAME_PREFIX.size(), CACHE_FILENAME_PREFIX) == 0)
+                {
+                    // skip "sl_cache_" and trailing "_N.asset"
+                    const std::string uuid_as_string = file_name.substr(CACHE_FILENAME_PREFIX.size() + 1, UUID_STR_LENGTH - 1);
+                    uintmax_t file_size = boost::filesystem::file_size(*iter, ec);
+                    if (!ec.failed() && LLUUID::validate(uuid_as_string))
+                    {
+                        const std::time_t file_time = boost::filesystem::last_write_time(*iter, ec);
+                        if (!ec.failed())
+                        {
+                            file_info.push_back({ LLUUID(uuid_as_string), file_size, file_time });
+                        }
+                    }
+                }
+            }
+            iter.increment(ec);
+        }
+    }
+
+    const size_t found = file_info.size();
+    mIndex.rebuild(file_info);
+
+    auto execute_time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - start_time).count();
+    LL_INFOS("LLDiskCache") << "Rebuilt cache index from " << found << " files in " << execute_time << " ms" << LL_ENDL;
+}
+
+void LLDiskCache::cleanupSingleton()
+{
+    saveIndex();
+    sPackStore.reset();
+}
+
+
 const std::string LLDiskCache::metaDataToFilepath(const LLUUID& id, LLAssetType::EType at)
 {
     return llformat("%s%s%s_%s_0.asset", sCacheDir.c_str(), gDirUtilp->getDirDelimiter().c_str(), CACHE_FILENAME_PREFIX.c_str(), id.asString().c_str());
@@ -370,7 +542,31 @@ void LLDiskCache::prepopulateCacheWithStatic()
                 auto uuid_as_string{ gDirUtilp->getBaseFileName(from_asset_file, true) };
                 LLUUID uuid{ uuid_as_string };
                 auto to_asset_file = metaDataToFilepath(uuid, LLAssetType::AT_UNKNOWN);
-                if (!gDirUtilp->fileExists(to_asset_file))
+                if (sPackStore)
+                {
+                    if (!sPackStore->exists(uuid))
+                    {
+                        std::vector<U8> data;
+                        LLFILE* from_file = LLFile::fopen(from_asset_file, "rb");
+                        if (from_file)
+                        {
+                            fseek(from_file, 0, SEEK_END);
+                            data.resize(llmax(ftell(from_file), 0L));
+                            fseek(from_file, 0, SEEK_SET);
+                            data.resize(fread(data.data(), 1, data.size(), from_file));
+                            fclose(from_file);
+                        }
+                        if (data.empty() || sPackStore->write(uuid, 0, data.data(), (S32)data.size(), true) < 0)
+                        {
+                            LL_WARNS("LLDiskCache") << "Failed to copy " << from_asset_file << " to the cache" << LL_ENDL;
+                        }
+                        else
+                        {
+                            recordWrite(uuid, data.size(), true);
+                        }
+                    }
+                }
+                else if (!gDirUtilp->fileExists(to_asset_file))
                 {
                     if (mEnableCacheDebugInfo)
                     {
@@ -380,6 +576,14 @@ void LLDiskCache::prepopulateCacheWithStatic()
                     {
                         LL_WARNS("LLDiskCache") << "Failed to copy " << from_asset_file << " to " << to_asset_file << LL_ENDL;
                     }
+                    else
+                    {
+                        llstat file_stat;
+                        if (LLFile::stat(to_asset_file, &file_stat) == 0)
+                        {
+                            recordWrite(uuid, file_stat.st_size, true);
+                        }
+                    }
                 }
                 if (std::find(mSkipList.begin(), mSkipList.end(), uuid_as_string) == mSkipList.end())
                 {
@@ -432,6 +636,19 @@ void LLDiskCache::clearCache()
             }
             iter.increment(ec);
         }
+
+        if (sPackStore)
+        {
+            sPackStore->clear();
+        }
+        else
+        {
+            LLDiskCachePackStore::deletePacks(sCacheDir);
+        }
+
+        // the cache is empty now so the index is trivially up to date
+        mIndex.clear();
+
         // <FS:Beq> add static assets into the new cache after clear
     LL_INFOS() << "prepopulating new cache " << LL_ENDL;
         prepopulateCacheWithStatic();
@@ -485,6 +702,15 @@ uintmax_t LLDiskCache::updateCacheSize(const uintmax_t newsize)
 
 uintmax_t LLDiskCache::dirFileSize(const std::string& dir, bool force)
 {
+    if (dir == sCacheDir)
+    {
+        // The index tracks the size of the cache so no need to walk it
+        if (mIndex.isValid())
+        {
+            return updateCacheSize(mIndex.getSize());
+        }
+    }
+
     using namespace std::chrono;
     const seconds cache_duration{ 120 };// A rather arbitrary number. it takes 5 seconds+ on a fast drive to scan 80K+ items. purge runs every minute and will update. so 120 should mean we never need a superfluous cache scan.
 
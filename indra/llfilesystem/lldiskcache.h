@@ -36,6 +36,13 @@
  *    the same sized directory of files, writing the last updated
  *    time to each took less than 600ms indicating that this
  *    important part of the mechanism has almost no overhead.
+ * 6/ With several hundred thousand files the directory walk in 3/
+ *    becomes far too slow, so the size and last access time of each
+ *    file is also tracked in an index that is updated as files are
+ *    written, read and removed, and saved to the cache folder on exit.
+ *    The directory is only walked when that index is missing or corrupt.
+ *    Reads only touch the index; the file times that the index is
+ *    rebuilt from are updated in batches by LLPurgeDiskCacheThread.
  *
  * $LicenseInfo:firstyear=2009&license=viewerlgpl$
  * Second Life Viewer Source Code
@@ -63,7 +70,14 @@
 #define _LLDISKCACHE
 
 #include "llsingleton.h"
+#include "llassettype.h"
+#include "lldiskcacheindex.h"
+#include "lldiskcachepack.h"
+#include "llmutex.h"
+#include "lluuid.h"
 #include <chrono>
+#include <memory>
+#include <unordered_map>
 using namespace std::chrono;
 
 
@@ -104,8 +118,19 @@ class LLDiskCache :
                     /**
                      * A floating point percentage of the max_size_bytes which the cache purge will aim to reach once triggered.
                      */
-                    const F32 lowwater_mark_percent
+                    const F32 lowwater_mark_percent,
                     // </FS:Beq>
+                    /**
+                     * Store assets in a handful of large pack files rather
+                     * than one file per asset. Defined by the setting at
+                     * 'FSDiskCachePackStore'
+                     */
+                    const bool use_pack_store,
+                    /**
+                     * Another viewer instance owns the cache, so leave the
+                     * pack files and the index alone
+                     */
+                    const bool read_only = false
                     );
 
         virtual ~LLDiskCache() = default;
@@ -120,6 +145,12 @@ class LLDiskCache :
          */
         static const std::string metaDataToFilepath(const LLUUID& id, LLAssetType::EType at);
 
+        /**
+         * The pack file backend when it is enabled, nullptr when assets are
+         * stored one file per asset.
+         */
+        static LLDiskCachePackStore* getPackStore() { return sPackStore.get(); }
+
         /**
          * Purge the oldest items in the cache so that the combined size of all files
          * is no bigger than mMaxSizeBytes.
@@ -152,6 +183,26 @@ class LLDiskCache :
 
         void removeOldVFSFiles();
 
+        /**
+         * Incremental updates for the cache index. These are called by
+         * LLFileSystem whenever a cache file is written, read, removed or
+         * renamed so that purge() never has to stat the whole directory.
+         * Safe to call from any thread.
+         */
+        void recordWrite(const LLUUID& id, uintmax_t size, bool truncated);
+        void recordAccess(const LLUUID& id);
+        void recordRemove(const LLUUID& id);
+        void recordRename(const LLUUID& old_id, const LLUUID& new_id);
+
+        /**
+         * Called by LLFileSystem around mapping a cache file into memory.
+         * purge() does not remove a file while it is mapped, since reading
+         * the mapping afterwards would fault. The same file may be mapped
+         * by several LLFileSystem objects at once.
+         */
+        void recordMapped(const LLUUID& id);
+        void recordUnmapped(const LLUUID& id);
+
         // <FS:Ansariel> Better asset cache size control
         void setMaxSizeBytes(uintmax_t size) { mMaxSizeBytes = size; }
         // <FS:Beq> High/Low water control
@@ -160,6 +211,12 @@ class LLDiskCache :
         // </FS:Beq>
 
     private:
+        /**
+         * Writes the in-memory index back to disk so that the next session
+         * does not have to rebuild it by walking the cache directory.
+         */
+        void cleanupSingleton() override;
+
         /**
          * Utility function to gather the total size the files in a given
          * directory. Primarily used here to determine the directory size
@@ -175,6 +232,54 @@ class LLDiskCache :
         uintmax_t mStoredCacheSize{ 0 };
         time_point<system_clock> mLastScanTime{ };
 
+        /**
+         * Load the index written by a previous session. The file is removed
+         * once it has been read so that a crash (which would leave the index
+         * out of date) forces a rebuild on the next start.
+         */
+        bool loadIndex();
+        bool saveIndex();
+
+        /**
+         * Walk the cache directory to recreate the index when it is missing
+         * or corrupt. Entries recorded since startup take precedence over
+         * what was found on disk.
+         */
+        void rebuildIndex();
+
+        /**
+         * Update the "last write time" of the files read since the last
+         * flush. Reads only update the in-memory index so that they don't
+         * pay for a stat and a write on the reading thread; this brings the
+         * files (or the pack store's access times) up to date and is called
+         * from purge().
+         */
+        void flushAccessTimes();
+
+        /**
+         * Update the "last write time" of a file to the time it was last
+         * read. The file times are what the index is rebuilt from after a
+         * crash, so they have to follow reads too.
+         */
+        static void updateFileAccessTime(const std::string& file_path, std::time_t access_time);
+
+        static const std::string indexFilepath();
+
+        /**
+         * Persistent index of the cache contents, so that purging is a
+         * matter of taking the least recently used entries off it instead
+         * of collecting and sorting every file in the cache.
+         */
+        LLDiskCacheIndex mIndex;
+
+        // reads whose file times have not been updated yet
+        LLMutex mPendingAccessMutex;
+        LLDiskCacheIndex::access_map_t mPendingAccess;
+
+        // number of LLFileSystem mappings of each file
+        LLMutex mMappedMutex;
+        std::unordered_map<LLUUID, S32> mMapped;
+
     private:
         /**
          * The maximum size of the cache in bytes. After purge is called, the
@@ -195,11 +300,19 @@ class LLDiskCache :
          */
         static std::string sCacheDir;
 
+        static std::unique_ptr<LLDiskCachePackStore> sPackStore;
+
         /**
          * When enabled, displays additional debugging information in
          * various parts of the code
          */
         bool mEnableCacheDebugInfo;
+
+        /**
+         * Another viewer instance owns the cache, so its index is neither
+         * removed when loaded nor overwritten on exit
+         */
+        const bool mReadOnly;
         
         std::vector<std::string> mSkipList;  // <FS:Beq/> Vector of "static" untouchable assets that should never be purged
 };
@@ -0,0 +1,353 @@
+/**
+ * @file lldiskcacheindex.cpp
+ * @brief Persistent LRU index of the disk cache contents.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "lldiskcacheindex.h"
+
+#include <algorithm>
+
+namespace
+{
+    // On-disk layout of the cache index. Native byte order is fine since the
+    // file never leaves the machine that wrote it.
+    constexpr U32 INDEX_MAGIC = 0x4944434c; // "LCDI"
+    constexpr U32 INDEX_VERSION = 1;
+
+    struct index_header_t
+    {
+        U32 mMagic;
+        U32 mVersion;
+        U64 mCount;
+    };
+
+    struct index_record_t
+    {
+        U8 mID[UUID_BYTES];
+        U64 mSize;
+        S64 mLastAccess;
+    };
+    static_assert(sizeof(index_record_t) == 32, "unexpected cache index record size");
+}
+
+bool LLDiskCacheIndex::load(const std::string& filename)
+{
+    LLMutexLock lock(&mMutex);
+    clearEntries();
+    mValid = false;
+
+    LLFILE* file = LLFile::fopen(filename, "rb");
+    if (!file)
+    {
+        return false;
+    }
+
+    index_header_t header;
+    if (fread(&header, sizeof(header), 1, file) == 1
+        && header.mMagic == INDEX_MAGIC
+        && header.mVersion == INDEX_VERSION)
+    {
+        llstat file_stat;
+        if (LLFile::stat(filename, &file_stat) == 0
+            && (U64)file_stat.st_size == sizeof(header) + header.mCount * sizeof(index_record_t))
+        {
+            std::vector<index_record_t> records(header.mCount);
+            if (header.mCount == 0 || fread(records.data(), sizeof(index_record_t), records.size(), file) == records.size())
+            {
+                mIndex.reserve(records.size());
+                // records are stored oldest first so they go straight into the LRU list
+                for (const index_record_t& record : records)
+                {
+                    LLUUID id;
+                    memcpy(id.mData, record.mID, UUID_BYTES);
+                    insertEntry(id, record.mSize, (std::time_t)record.mLastAccess);
+                }
+                mValid = true;
+            }
+        }
+    }
+    fclose(file);
+
+    if (!mValid)
+    {
+        clearEntries();
+    }
+    return mValid;
+}
+
+bool LLDiskCacheIndex::save(const std::string& filename)
+{
+    const std::string temp_filename = filename + ".tmp";
+
+    std::vector<index_record_t> records;
+    {
+        LLMutexLock lock(&mMutex);
+        if (!mValid)
+        {
+            return false;
+        }
+        records.reserve(mLRU.size());
+        for (const LLUUID& id : mLRU)
+        {
+            const index_entry_t& entry = mIndex[id];
+            index_record_t record;
+            memcpy(record.mID, id.mData, UUID_BYTES);
+            record.mSize = entry.mSize;
+            record.mLastAccess = entry.mLastAccess;
+            records.push_back(record);
+        }
+    }
+
+    LLFILE* file = LLFile::fopen(temp_filename, "wb");
+    if (!file)
+    {
+        LL_WARNS("LLDiskCache") << "Unable to write cache index " << temp_filename << LL_ENDL;
+        return false;
+    }
+
+    index_header_t header{ INDEX_MAGIC, INDEX_VERSION, (U64)records.size() };
+    bool success = fwrite(&header, sizeof(header), 1, file) == 1;
+    if (success && !records.empty())
+    {
+        success = fwrite(records.data(), sizeof(index_record_t), records.size(), file) == records.size();
+    }
+    success = (fclose(file) == 0) && success;
+#if LL_WINDOWS
+    // rename does not replace an existing file there
+    if (success)
+    {
+        LLFile::remove(filename, ENOENT);
+    }
+#endif
+
+    if (success && LLFile::rename(temp_filename, filename) == 0)
+    {
+        LL_INFOS("LLDiskCache") << "Saved cache index with " << records.size() << " entries" << LL_ENDL;
+        return true;
+    }
+
+    LL_WARNS("LLDiskCache") << "Failed to save cache index " << filename << LL_ENDL;
+    LLFile::remove(temp_filename, ENOENT);
+    return false;
+}
+
+void LLDiskCacheIndex::rebuild(entry_list_t& found)
+{
+    std::stable_sort(found.begin(), found.end(), [](const entry_t& x, const entry_t& y)
+    {
+        return x.mLastAccess < y.mLastAccess;
+    });
+
+    LLMutexLock lock(&mMutex);
+
+    // Anything recorded while the cache was walked is newer than what is on
+    // disk, so pull it out and put it back at the recent end of the list.
+    entry_list_t recorded;
+    recorded.reserve(mLRU.size());
+    for (const LLUUID& id : mLRU)
+    {
+        const index_entry_t& entry = mIndex[id];
+        recorded.push_back({ id, entry.mSize, entry.mLastAccess });
+    }
+
+    clearEntries();
+    mIndex.reserve(found.size() + recorded.size());
+    for (const entry_t& entry : found)
+    {
+        insertEntry(entry.mID, entry.mSize, entry.mLastAccess);
+    }
+    for (const entry_t& entry : recorded)
+    {
+        insertEntry(entry.mID, entry.mSize, entry.mLastAccess);
+    }
+    mValid = true;
+}
+
+bool LLDiskCacheIndex::isValid()
+{
+    LLMutexLock lock(&mMutex);
+    return mValid;
+}
+
+void LLDiskCacheIndex::clear()
+{
+    LLMutexLock lock(&mMutex);
+    clearEntries();
+    mValid = true;
+}
+
+void LLDiskCacheIndex::insertEntry(const LLUUID& id, uintmax_t size, std::time_t last_access)
+{
+    auto it = mIndex.find(id);
+    if (it != mIndex.end())
+    {
+        mSize -= it->second.mSize;
+        it->second.mSize = size;
+        it->second.mLastAccess = last_access;
+        mLRU.splice(mLRU.end(), mLRU, it->second.mLRUIter);
+    }
+    else
+    {
+        auto lru_iter = mLRU.insert(mLRU.end(), id);
+        mIndex.emplace(id, index_entry_t{ size, last_access, lru_iter });
+    }
+    mSize += size;
+}
+
+void LLDiskCacheIndex::eraseEntry(index_map_t::iterator it)
+{
+    mSize -= it->second.mSize;
+    mLRU.erase(it->second.mLRUIter);
+    mIndex.erase(it);
+}
+
+void LLDiskCacheIndex::clearEntries()
+{
+    mIndex.clear();
+    mLRU.clear();
+    mSize = 0;
+}
+
+void LLDiskCacheIndex::recordWrite(const LLUUID& id, uintmax_t size, bool truncated, std::time_t now)
+{
+    LLMutexLock lock(&mMutex);
+    if (!truncated)
+    {
+        // A write into the middle of an existing file does not shrink it
+        auto it = mIndex.find(id);
+        if (it != mIndex.end())
+        {
+            size = llmax(size, it->second.mSize);
+        }
+    }
+    insertEntry(id, size, now);
+}
+
+void LLDiskCacheIndex::recordAccess(const LLUUID& id, std::time_t now)
+{
+    LLMutexLock lock(&mMutex);
+    auto it = mIndex.find(id);
+    if (it != mIndex.end())
+    {
+        it->second.mLastAccess = now;
+        mLRU.splice(mLRU.end(), mLRU, it->second.mLRUIter);
+    }
+}
+
+void LLDiskCacheIndex::recordRemove(const LLUUID& id)
+{
+    LLMutexLock lock(&mMutex);
+    auto it = mIndex.find(id);
+    if (it != mIndex.end())
+    {
+        eraseEntry(it);
+    }
+}
+
+void LLDiskCacheIndex::recordRename(const LLUUID& old_id, const LLUUID& new_id, std::time_t now)
+{
+    LLMutexLock lock(&mMutex);
+    auto it = mIndex.find(old_id);
+    if (it != mIndex.end())
+    {
+        const uintmax_t size = it->second.mSize;
+        eraseEntry(it);
+        insertEntry(new_id, size, now);
+    }
+}
+
+void LLDiskCacheIndex::recordAccesses(const access_map_t& accesses)
+{
+    LLMutexLock lock(&mMutex);
+    for (const auto& access : accesses)
+    {
+        auto it = mIndex.find(access.first);
+        if (it != mIndex.end() && it->second.mLastAccess < access.second)
+        {
+            it->second.mLastAccess = access.second;
+            mLRU.splice(mLRU.end(), mLRU, it->second.mLRUIter);
+        }
+    }
+}
+
+size_t LLDiskCacheIndex::purge(uintmax_t target_size, const std::function<bool(const LLUUID&)>& keep, entry_list_t& purged)
+{
+    LLMutexLock lock(&mMutex);
+    size_t kept = 0;
+    size_t to_visit = mLRU.size();
+    auto lru_iter = mLRU.begin();
+    while (to_visit-- > 0 && lru_iter != mLRU.end() && mSize > target_size)
+    {
+        auto current = lru_iter++;
+        auto it = mIndex.find(*current);
+        if (keep(it->first))
+        {
+            mLRU.splice(mLRU.end(), mLRU, current);
+            ++kept;
+            continue;
+        }
+        purged.push_back({ it->first, it->second.mSize, it->second.mLastAccess });
+        eraseEntry(it);
+    }
+    return kept;
+}
+
+void LLDiskCacheIndex::restore(const entry_list_t& entries)
+{
+    LLMutexLock lock(&mMutex);
+    for (auto entry = entries.rbegin(); entry != entries.rend(); ++entry)
+    {
+        if (mIndex.find(entry->mID) == mIndex.end())
+        {
+            auto lru_iter = mLRU.insert(mLRU.begin(), entry->mID);
+            mIndex.emplace(entry->mID, index_entry_t{ entry->mSize, entry->mLastAccess, lru_iter });
+            mSize += entry->mSize;
+        }
+    }
+}
+
+void LLDiskCacheIndex::getEntries(entry_list_t& entries)
+{
+    LLMutexLock lock(&mMutex);
+    entries.reserve(entries.size() + mLRU.size());
+    for (const LLUUID& id : mLRU)
+    {
+        const index_entry_t& entry = mIndex[id];
+        entries.push_back({ id, entry.mSize, entry.mLastAccess });
+    }
+}
+
+uintmax_t LLDiskCacheIndex::getSize()
+{
+    LLMutexLock lock(&mMutex);
+    return mSize;
+}
+
+size_t LLDiskCacheIndex::getCount()
+{
+    LLMutexLock lock(&mMutex);
+    return mIndex.size();
+}
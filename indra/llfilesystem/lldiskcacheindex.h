@@ -0,0 +1,143 @@
+/**
+ * @file lldiskcacheindex.h
+ * @brief Persistent LRU index of the disk cache contents.
+ *
+ * @Description:
+ * Tracks the size and time of last access of every entry in the disk
+ * cache, in least recently used order (oldest first), so that the cache
+ * can be purged by taking entries off the old end instead of collecting
+ * and sorting every file in the cache. The index is saved to a file when
+ * the viewer exits and loaded again on the next start.
+ *
+ * All methods are safe to call from any thread.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLDISKCACHEINDEX_H
+#define LL_LLDISKCACHEINDEX_H
+
+#include "llmutex.h"
+#include "lluuid.h"
+
+#include <ctime>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+class LLDiskCacheIndex
+{
+public:
+    struct entry_t
+    {
+        LLUUID mID;
+        uintmax_t mSize;
+        std::time_t mLastAccess;
+    };
+    typedef std::vector<entry_t> entry_list_t;
+
+    /**
+     * Replace the contents with an index written by save(). Returns false,
+     * leaving the index empty and invalid, if the file is missing or
+     * corrupt.
+     */
+    bool load(const std::string& filename);
+
+    /**
+     * Write the index to 'filename' through a temporary file, so that a
+     * partially written index is never left behind. Does nothing if the
+     * index is not valid.
+     */
+    bool save(const std::string& filename);
+
+    /**
+     * Replace the contents with 'found', the entries of a walk of the
+     * cache, in any order. Anything recorded since the index was last
+     * valid is newer than what was found and stays at the recent end.
+     */
+    void rebuild(entry_list_t& found);
+
+    /**
+     * Whether the index describes the whole cache, rather than only what
+     * was recorded since startup
+     */
+    bool isValid();
+
+    // Empty the index, which is then valid
+    void clear();
+
+    void recordWrite(const LLUUID& id, uintmax_t size, bool truncated, std::time_t now);
+    void recordAccess(const LLUUID& id, std::time_t now);
+    void recordRemove(const LLUUID& id);
+    void recordRename(const LLUUID& old_id, const LLUUID& new_id, std::time_t now);
+
+    /**
+     * Catch up with reads that happened before the index was rebuilt,
+     * which could not move their entries to the recent end at the time
+     */
+    typedef std::unordered_map<LLUUID, std::time_t> access_map_t;
+    void recordAccesses(const access_map_t& accesses);
+
+    /**
+     * Take the least recently used entries out of the index until its
+     * total size is no more than 'target_size', and return them in
+     * 'purged', oldest first. Entries 'keep' returns true for stay, but
+     * move to the recent end so they are not looked at again this time.
+     * Every entry is looked at most once. Returns the number kept.
+     */
+    size_t purge(uintmax_t target_size, const std::function<bool(const LLUUID&)>& keep, entry_list_t& purged);
+
+    /**
+     * Put back entries purge() returned that could not be removed from the
+     * cache after all, at the old end, unless they were written since.
+     */
+    void restore(const entry_list_t& entries);
+
+    // Every entry, least recently used first
+    void getEntries(entry_list_t& entries);
+
+    uintmax_t getSize();
+    size_t getCount();
+
+private:
+    struct index_entry_t
+    {
+        uintmax_t mSize;
+        std::time_t mLastAccess;
+        std::list<LLUUID>::iterator mLRUIter;
+    };
+    typedef std::unordered_map<LLUUID, index_entry_t> index_map_t;
+
+    // Must be called with mMutex held
+    void insertEntry(const LLUUID& id, uintmax_t size, std::time_t last_access);
+    void eraseEntry(index_map_t::iterator it);
+    void clearEntries();
+
+    LLMutex mMutex;
+    index_map_t mIndex;
+    std::list<LLUUID> mLRU;
+    uintmax_t mSize{ 0 };
+    bool mValid{ false };
+};
+
+#endif // LL_LLDISKCACHEINDEX_H
@@ -0,0 +1,1016 @@
+/**
+ * @file lldiskcachepack.cpp
+ * @brief Pack file backend for the disk cache.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "lldiskcachepack.h"
+
+#include "llcrc.h"
+#include "lldir.h"
+
+#include <boost/filesystem.hpp>
+#include <algorithm>
+#include <chrono>
+
+namespace
+{
+    constexpr U32 RECORD_MAGIC = 0x4b50434c; // "LCPK"
+    constexpr U32 RECORD_FLAG_DELETED = 0x1;
+    // the record continues the asset with this ID rather than replacing it
+    constexpr U32 RECORD_FLAG_EXTENT = 0x2;
+
+    // Don't bother compacting a pack until it has at least this much garbage
+    constexpr U64 COMPACT_MIN_DEAD_BYTES = 16 * 1024 * 1024;
+
+    // What a read only store keeps in memory per pack before it starts
+    // forgetting assets
+    constexpr U64 SCRATCH_MAX_BYTES = 8 * 1024 * 1024;
+
+    // Times of last access saved next to each pack
+    constexpr U32 TIMES_MAGIC = 0x544d434c; // "LCMT"
+    constexpr U32 TIMES_VERSION = 1;
+
+    struct times_header_t
+    {
+        U32 mMagic;
+        U32 mVersion;
+        U64 mPackSize;  // when the times were saved
+        U64 mCount;
+    };
+
+    struct times_record_t
+    {
+        U8 mID[UUID_BYTES];
+        S64 mLastAccess;
+    };
+    static_assert(sizeof(times_record_t) == 24, "unexpected pack times record size");
+
+    // LLCRC picking up where an earlier checksum left off
+    class LLCRCContinued : public LLCRC
+    {
+    public:
+        LLCRCContinued(U32 crc) { mCurrent = ~crc; }
+    };
+
+    bool seek_to(LLFILE* file, U64 offset)
+    {
+#if LL_WINDOWS
+        return _fseeki64(file, (__int64)offset, SEEK_SET) == 0;
+#else
+        return fseeko(file, (off_t)offset, SEEK_SET) == 0;
+#endif
+    }
+
+    U64 file_length(LLFILE* file)
+    {
+#if LL_WINDOWS
+        _fseeki64(file, 0, SEEK_END);
+        return (U64)_ftelli64(file);
+#else
+        fseeko(file, 0, SEEK_END);
+        return (U64)ftello(file);
+#endif
+    }
+
+    U32 checksum(const U8* data, U32 length)
+    {
+        LLCRC crc;
+        crc.update(data, length);
+        return crc.getCRC();
+    }
+
+    std::time_t file_time(const std::string& filename)
+    {
+        boost::system::error_code ec;
+#if LL_WINDOWS
+        const std::time_t time = boost::filesystem::last_write_time(utf8str_to_utf16str(filename), ec);
+#else
+        const std::time_t time = boost::filesystem::last_write_time(filename, ec);
+#endif
+        return ec.failed() ? std::time(nullptr) : time;
+    }
+
+    void truncate_file(const std::string& filename, U64 size)
+    {
+        boost::system::error_code ec;
+#if LL_WINDOWS
+        boost::filesystem::resize_file(utf8str_to_utf16str(filename), size, ec);
+#else
+        boost::filesystem::resize_file(filename, size, ec);
+#endif
+        if (ec.failed())
+        {
+            LL_WARNS("LLDiskCache") << "Failed to truncate pack " << filename << ": " << ec.message() << LL_ENDL;
+        }
+    }
+}
+
+struct LLDiskCachePackStore::record_header_t
+{
+    U32 mMagic;
+    U8 mID[UUID_BYTES];
+    U32 mLength;
+    U32 mChecksum;
+    U32 mFlags;
+};
+
+namespace
+{
+    // Offset of the first thing at or after 'pos' that looks like a record
+    // header, or 'length' if there is none
+    template<typename header_t>
+    U64 find_record(LLFILE* file, U64 pos, U64 length)
+    {
+        std::vector<U8> buffer(64 * 1024);
+        while (pos + sizeof(header_t) <= length && seek_to(file, pos))
+        {
+            const size_t got = fread(buffer.data(), 1, (size_t)llmin((U64)buffer.size(), length - pos), file);
+            if (got < sizeof(header_t))
+            {
+                break;
+            }
+            for (size_t i = 0; i + sizeof(header_t) <= got; ++i)
+            {
+                if (memcmp(buffer.data() + i, &RECORD_MAGIC, sizeof(RECORD_MAGIC)) == 0)
+                {
+                    header_t header;
+                    memcpy(&header, buffer.data() + i, sizeof(header));
+                    if (pos + i + sizeof(header) + header.mLength <= length)
+                    {
+                        return pos + i;
+                    }
+                }
+            }
+            pos += got - sizeof(header_t) + 1;
+        }
+        return length;
+    }
+}
+
+LLDiskCachePackStore::LLDiskCachePackStore(const std::string& cache_dir, bool read_only)
+    : mReadOnly(read_only)
+{
+    static_assert(sizeof(record_header_t) == 32, "unexpected pack record header size");
+
+    for (U32 i = 0; i < SHARD_COUNT; ++i)
+    {
+        shard_t& shard = mShards[i];
+        LLMutexLock lock(&shard.mMutex);
+        shard.mFilename = packFilepath(cache_dir, i);
+        openShard(shard);
+    }
+}
+
+LLDiskCachePackStore::~LLDiskCachePackStore()
+{
+    for (shard_t& shard : mShards)
+    {
+        LLMutexLock lock(&shard.mMutex);
+        if (!mReadOnly && shard.mFile)
+        {
+            saveTimes(shard);
+        }
+        closeShard(shard);
+    }
+}
+
+// static
+std::string LLDiskCachePackStore::packFilepath(const std::string& cache_dir, U32 index)
+{
+    static const char* shard_names = "0123456789abcdef";
+    return cache_dir + gDirUtilp->getDirDelimiter() + "pack_" + shard_names[index] + ".dat";
+}
+
+// static
+U64 LLDiskCachePackStore::recordBytes(const entry_t& entry)
+{
+    return entry.mExtents.size() * sizeof(record_header_t) + entry.mLength;
+}
+
+// static
+std::string LLDiskCachePackStore::timesFilepath(const std::string& pack_filename)
+{
+    return pack_filename + ".times";
+}
+
+// static
+void LLDiskCachePackStore::deletePacks(const std::string& cache_dir)
+{
+    for (U32 i = 0; i < SHARD_COUNT; ++i)
+    {
+        const std::string filename = packFilepath(cache_dir, i);
+        LLFile::remove(filename, ENOENT);
+        LLFile::remove(filename + ".tmp", ENOENT);
+        LLFile::remove(timesFilepath(filename), ENOENT);
+        LLFile::remove(timesFilepath(filename) + ".tmp", ENOENT);
+    }
+}
+
+void LLDiskCachePackStore::openShard(shard_t& shard)
+{
+    ++shard.mGeneration;
+    shard.mEntries.clear();
+    shard.mScratch.clear();
+    shard.mScratchBytes = 0;
+    shard.mFileSize = 0;
+    shard.mDeadBytes = 0;
+
+    if (mReadOnly)
+    {
+        // Another instance owns the pack, including any compaction of it
+        // that is under way
+        shard.mFile = LLFile::fopen(shard.mFilename, "rb");
+        if (!shard.mFile)
+        {
+            return;
+        }
+    }
+    else
+    {
+        // A leftover from a compaction that never finished
+        LLFile::remove(shard.mFilename + ".tmp", ENOENT);
+
+        shard.mFile = LLFile::fopen(shard.mFilename, "r+b");
+        if (!shard.mFile)
+        {
+            shard.mFile = LLFile::fopen(shard.mFilename, "w+b");
+            if (!shard.mFile)
+            {
+                LL_WARNS("LLDiskCache") << "Unable to create pack " << shard.mFilename << LL_ENDL;
+            }
+            return;
+        }
+    }
+
+    const U64 length = file_length(shard.mFile);
+    U64 pos = 0;
+    U64 end = 0;
+    U64 damaged = 0;
+    record_header_t header;
+    while (pos + sizeof(header) <= length)
+    {
+        if (!seek_to(shard.mFile, pos)
+            || fread(&header, sizeof(header), 1, shard.mFile) != 1
+            || header.mMagic != RECORD_MAGIC
+            || pos + sizeof(header) + header.mLength > length)
+        {
+            // Skip to the next record rather than lose everything after
+            // this one; it is counted as garbage if anything follows it.
+            const U64 next = find_record<record_header_t>(shard.mFile, pos + 1, length);
+            damaged += next - pos;
+            pos = next;
+            continue;
+        }
+
+        shard.mDeadBytes += damaged;
+        damaged = 0;
+        indexRecord(shard, header, pos, false);
+        pos += sizeof(header) + header.mLength;
+        end = pos;
+    }
+
+    if (end < length)
+    {
+        // Most likely a record torn by a crash. No record follows it, so
+        // there is nothing to lose by cutting it off.
+        LL_WARNS("LLDiskCache") << "Discarding " << (length - end) << " bytes of damaged data at the end of " << shard.mFilename << LL_ENDL;
+        if (!mReadOnly)
+        {
+            fclose(shard.mFile);
+            truncate_file(shard.mFilename, end);
+            shard.mFile = LLFile::fopen(shard.mFilename, "r+b");
+        }
+    }
+    shard.mFileSize = end;
+
+    // Anything written since the times were saved is at least as recent
+    // as the last write to the pack
+    const std::time_t pack_time = file_time(shard.mFilename);
+    for (auto& entry : shard.mEntries)
+    {
+        entry.second.mLastAccess = pack_time;
+    }
+    loadTimes(shard);
+}
+
+void LLDiskCachePackStore::loadTimes(shard_t& shard)
+{
+    LLFILE* file = LLFile::fopen(timesFilepath(shard.mFilename), "rb");
+    if (!file)
+    {
+        return;
+    }
+
+    times_header_t header;
+    if (fread(&header, sizeof(header), 1, file) == 1
+        && header.mMagic == TIMES_MAGIC
+        && header.mVersion == TIMES_VERSION
+        && header.mPackSize <= shard.mFileSize)
+    {
+        times_record_t record;
+        for (U64 i = 0; i < header.mCount && fread(&record, sizeof(record), 1, file) == 1; ++i)
+        {
+            LLUUID id;
+            memcpy(id.mData, record.mID, UUID_BYTES);
+            auto it = shard.mEntries.find(id);
+            // a record beyond where the pack ended then was written since
+            if (it != shard.mEntries.end() && it->second.mExtents.back().mOffset < header.mPackSize)
+            {
+                it->second.mLastAccess = (std::time_t)record.mLastAccess;
+            }
+        }
+    }
+    fclose(file);
+}
+
+void LLDiskCachePackStore::saveTimes(shard_t& shard)
+{
+    const std::string filename = timesFilepath(shard.mFilename);
+    const std::string temp_filename = filename + ".tmp";
+
+    std::vector<times_record_t> records;
+    records.reserve(shard.mEntries.size());
+    for (const auto& entry : shard.mEntries)
+    {
+        times_record_t record;
+        memcpy(record.mID, entry.first.mData, UUID_BYTES);
+        record.mLastAccess = entry.second.mLastAccess;
+        records.push_back(record);
+    }
+
+    LLFILE* file = LLFile::fopen(temp_filename, "wb");
+    bool success = file != nullptr;
+    if (success)
+    {
+        times_header_t header{ TIMES_MAGIC, TIMES_VERSION, shard.mFileSize, (U64)records.size() };
+        success = fwrite(&header, sizeof(header), 1, file) == 1;
+        if (success && !records.empty())
+        {
+            success = fwrite(records.data(), sizeof(times_record_t), records.size(), file) == records.size();
+        }
+        success = (fclose(file) == 0) && success;
+    }
+#if LL_WINDOWS
+    // rename does not replace an existing file there
+    if (success)
+    {
+        LLFile::remove(filename, ENOENT);
+    }
+#endif
+    if (!success || LLFile::rename(temp_filename, filename) != 0)
+    {
+        LL_WARNS("LLDiskCache") << "Failed to save access times for " << shard.mFilename << LL_ENDL;
+        LLFile::remove(temp_filename, ENOENT);
+    }
+}
+
+void LLDiskCachePackStore::closeShard(shard_t& shard)
+{
+    if (shard.mFile)
+    {
+        fclose(shard.mFile);
+        shard.mFile = nullptr;
+    }
+}
+
+void LLDiskCachePackStore::indexRecord(shard_t& shard, const record_header_t& header, U64 offset, bool verified)
+{
+    LLUUID id;
+    memcpy(id.mData, header.mID, UUID_BYTES);
+    auto it = shard.mEntries.find(id);
+
+    if (header.mFlags & RECORD_FLAG_EXTENT)
+    {
+        if (it == shard.mEntries.end())
+        {
+            // the asset it belonged to is gone
+            shard.mDeadBytes += sizeof(header) + header.mLength;
+            return;
+        }
+        entry_t& entry = it->second;
+        entry.mExtents.push_back({ offset, header.mLength });
+        entry.mLength += header.mLength;
+        entry.mChecksum = header.mChecksum;
+        return;
+    }
+
+    if (it != shard.mEntries.end())
+    {
+        shard.mDeadBytes += recordBytes(it->second);
+    }
+
+    if (header.mFlags & RECORD_FLAG_DELETED)
+    {
+        shard.mDeadBytes += sizeof(header);
+        if (it != shard.mEntries.end())
+        {
+            shard.mEntries.erase(it);
+        }
+        return;
+    }
+
+    entry_t& entry = shard.mEntries[id];
+    entry.mExtents.assign(1, { offset, header.mLength });
+    entry.mLength = header.mLength;
+    entry.mChecksum = header.mChecksum;
+    entry.mVerified = verified;
+}
+
+bool LLDiskCachePackStore::appendRecord(shard_t& shard, const LLUUID& id, const U8* data, U32 length, U32 flags)
+{
+    if (mReadOnly || !shard.mFile || !seek_to(shard.mFile, shard.mFileSize))
+    {
+        return false;
+    }
+
+    record_header_t header;
+    header.mMagic = RECORD_MAGIC;
+    memcpy(header.mID, id.mData, UUID_BYTES);
+    header.mLength = length;
+    header.mChecksum = length ? checksum(data, length) : 0;
+    header.mFlags = flags;
+    if (flags & RECORD_FLAG_EXTENT)
+    {
+        auto it = shard.mEntries.find(id);
+        if (it == shard.mEntries.end())
+        {
+            return false;
+        }
+        LLCRCContinued crc(it->second.mChecksum);
+        crc.update(data, length);
+        header.mChecksum = crc.getCRC();
+    }
+
+    bool success = fwrite(&header, sizeof(header), 1, shard.mFile) == 1;
+    if (success && length)
+    {
+        success = fwrite(data, 1, length, shard.mFile) == length;
+    }
+    success = (fflush(shard.mFile) == 0) && success;
+    if (!success)
+    {
+        // Leave whatever was partially written beyond mFileSize, it is
+        // overwritten by the next record or cut off on the next start.
+        LL_WARNS("LLDiskCache") << "Failed to write to pack " << shard.mFilename << LL_ENDL;
+        return false;
+    }
+
+    // we just computed the checksum from this data so it is known good
+    indexRecord(shard, header, shard.mFileSize, true);
+    shard.mFileSize += sizeof(header) + length;
+    if (!(flags & RECORD_FLAG_DELETED))
+    {
+        shard.mEntries[id].mLastAccess = std::time(nullptr);
+    }
+    return true;
+}
+
+// static
+bool LLDiskCachePackStore::readExtents(LLFILE* file, const LLUUID& id, const entry_t& entry, std::vector<U8>& data)
+{
+    data.resize(entry.mLength);
+    LLCRC crc;
+    U32 pos = 0;
+    bool success = file != nullptr;
+    for (size_t i = 0; success && i < entry.mExtents.size(); ++i)
+    {
+        const extent_t& extent = entry.mExtents[i];
+        record_header_t header;
+        success = seek_to(file, extent.mOffset)
+            && fread(&header, sizeof(header), 1, file) == 1
+            && header.mMagic == RECORD_MAGIC
+            && header.mLength == extent.mLength
+            && memcmp(header.mID, id.mData, UUID_BYTES) == 0
+            && (extent.mLength == 0 || fread(data.data() + pos, 1, extent.mLength, file) == extent.mLength);
+        if (success)
+        {
+            crc.update(data.data() + pos, extent.mLength);
+            success = crc.getCRC() == header.mChecksum;
+            pos += extent.mLength;
+        }
+    }
+    return success;
+}
+
+bool LLDiskCachePackStore::readRecord(shard_t& shard, const LLUUID& id, entry_t& entry, std::vector<U8>& data)
+{
+    if (!readExtents(shard.mFile, id, entry, data))
+    {
+        LL_WARNS("LLDiskCache") << "Corrupt record for " << id << " in " << shard.mFilename << LL_ENDL;
+        return false;
+    }
+    entry.mVerified = true;
+    return true;
+}
+
+void LLDiskCachePackStore::dropEntry(shard_t& shard, entry_map_t::iterator it)
+{
+    // Record a tombstone so the entry stays gone after a restart
+    if (!appendRecord(shard, it->first, nullptr, 0, RECORD_FLAG_DELETED))
+    {
+        shard.mDeadBytes += sizeof(record_header_t) + recordBytes(it->second);
+        shard.mEntries.erase(it);
+    }
+}
+
+bool LLDiskCachePackStore::exists(const LLUUID& id)
+{
+    shard_t& shard = getShard(id);
+    LLMutexLock lock(&shard.mMutex);
+    auto scratch = shard.mScratch.find(id);
+    if (scratch != shard.mScratch.end())
+    {
+        return !scratch->second.empty();
+    }
+    auto it = shard.mEntries.find(id);
+    return it != shard.mEntries.end() && it->second.mLength > 0;
+}
+
+S32 LLDiskCachePackStore::getSize(const LLUUID& id)
+{
+    shard_t& shard = getShard(id);
+    LLMutexLock lock(&shard.mMutex);
+    auto scratch = shard.mScratch.find(id);
+    if (scratch != shard.mScratch.end())
+    {
+        return (S32)scratch->second.size();
+    }
+    auto it = shard.mEntries.find(id);
+    return it != shard.mEntries.end() ? (S32)it->second.mLength : 0;
+}
+
+S32 LLDiskCachePackStore::read(const LLUUID& id, S32 offset, U8* buffer, S32 bytes)
+{
+    shard_t& shard = getShard(id);
+    LLMutexLock lock(&shard.mMutex);
+    if (offset < 0)
+    {
+        return -1;
+    }
+
+    auto scratch = shard.mScratch.find(id);
+    if (scratch != shard.mScratch.end())
+    {
+        const S32 to_read = llclamp((S32)scratch->second.size() - offset, 0, bytes);
+        if (to_read > 0)
+        {
+            memcpy(buffer, scratch->second.data() + offset, to_read);
+        }
+        return to_read;
+    }
+
+    auto it = shard.mEntries.find(id);
+    if (it == shard.mEntries.end())
+    {
+        return -1;
+    }
+
+    entry_t& entry = it->second;
+    const S32 to_read = llclamp((S32)entry.mLength - offset, 0, bytes);
+
+    if (!entry.mVerified)
+    {
+        // First access since startup, check the whole asset
+        std::vector<U8> data;
+        if (!readRecord(shard, id, entry, data))
+        {
+            dropEntry(shard, it);
+            return -1;
+        }
+        if (to_read > 0)
+        {
+            memcpy(buffer, data.data() + offset, to_read);
+        }
+        return to_read;
+    }
+
+    // Copy from each extent the requested range overlaps
+    S32 done = 0;
+    U32 extent_start = 0;
+    for (const extent_t& extent : entry.mExtents)
+    {
+        if (done == to_read)
+        {
+            break;
+        }
+        const U32 extent_end = extent_start + extent.mLength;
+        const U32 pos = (U32)(offset + done);
+        if (pos < extent_end)
+        {
+            const S32 count = llmin(to_read - done, (S32)(extent_end - pos));
+            if (!seek_to(shard.mFile, extent.mOffset + sizeof(record_header_t) + (pos - extent_start))
+                || fread(buffer + done, 1, count, shard.mFile) != (size_t)count)
+            {
+                return -1;
+            }
+            done += count;
+        }
+        extent_start = extent_end;
+    }
+    return to_read;
+}
+
+S32 LLDiskCachePackStore::write(const LLUUID& id, S32 offset, const U8* buffer, S32 bytes, bool truncate)
+{
+    shard_t& shard = getShard(id);
+    LLMutexLock lock(&shard.mMutex);
+
+    if (mReadOnly)
+    {
+        return writeScratch(shard, id, offset, buffer, bytes, truncate);
+    }
+
+    auto it = shard.mEntries.find(id);
+    if (truncate || (it == shard.mEntries.end() && offset <= 0))
+    {
+        return appendRecord(shard, id, buffer, bytes, 0) ? bytes : -1;
+    }
+
+    const U32 length = it != shard.mEntries.end() ? it->second.mLength : 0;
+    const S32 pos = offset < 0 ? (S32)length : offset;
+    if (it != shard.mEntries.end() && (U32)pos == length)
+    {
+        // Adding to the end, which is how assets arrive in pieces: only the
+        // new piece is written
+        if (bytes > 0 && !appendRecord(shard, id, buffer, bytes, RECORD_FLAG_EXTENT))
+        {
+            return -1;
+        }
+        return pos + bytes;
+    }
+
+    // Anything else rewrites the whole asset as a new record
+    std::vector<U8> data;
+    if (it != shard.mEntries.end() && !readRecord(shard, id, it->second, data))
+    {
+        // Don't let the rest of the asset turn into zeroes
+        dropEntry(shard, it);
+        return -1;
+    }
+    if ((S32)data.size() < pos + bytes)
+    {
+        data.resize(pos + bytes);
+    }
+    memcpy(data.data() + pos, buffer, bytes);
+
+    return appendRecord(shard, id, data.data(), (U32)data.size(), 0) ? pos + bytes : -1;
+}
+
+S32 LLDiskCachePackStore::writeScratch(shard_t& shard, const LLUUID& id, S32 offset, const U8* buffer, S32 bytes, bool truncate)
+{
+    auto scratch = shard.mScratch.find(id);
+    if (scratch == shard.mScratch.end())
+    {
+        // Take over the asset from the pack
+        std::vector<U8> data;
+        auto it = shard.mEntries.find(id);
+        if (it != shard.mEntries.end())
+        {
+            const bool success = truncate || readRecord(shard, id, it->second, data);
+            shard.mEntries.erase(it);
+            if (!success)
+            {
+                return -1;
+            }
+        }
+        shard.mScratchBytes += data.size();
+        scratch = shard.mScratch.emplace(id, std::move(data)).first;
+    }
+
+    std::vector<U8>& data = scratch->second;
+    shard.mScratchBytes -= data.size();
+    if (truncate)
+    {
+        data.clear();
+    }
+    const S32 pos = offset < 0 ? (S32)data.size() : offset;
+    if ((S32)data.size() < pos + bytes)
+    {
+        data.resize(pos + bytes);
+    }
+    memcpy(data.data() + pos, buffer, bytes);
+    shard.mScratchBytes += data.size();
+
+    // Make room by forgetting other assets, it is only a cache
+    for (auto other = shard.mScratch.begin(); other != shard.mScratch.end() && shard.mScratchBytes > SCRATCH_MAX_BYTES; )
+    {
+        if (other->first == id)
+        {
+            ++other;
+            continue;
+        }
+        shard.mScratchBytes -= other->second.size();
+        other = shard.mScratch.erase(other);
+    }
+    return pos + bytes;
+}
+
+bool LLDiskCachePackStore::remove(const LLUUID& id)
+{
+    shard_t& shard = getShard(id);
+    LLMutexLock lock(&shard.mMutex);
+    bool removed = false;
+    auto scratch = shard.mScratch.find(id);
+    if (scratch != shard.mScratch.end())
+    {
+        shard.mScratchBytes -= scratch->second.size();
+        shard.mScratch.erase(scratch);
+        removed = true;
+    }
+    auto it = shard.mEntries.find(id);
+    if (it != shard.mEntries.end())
+    {
+        dropEntry(shard, it);
+        removed = true;
+    }
+    return removed;
+}
+
+void LLDiskCachePackStore::setLastAccess(const LLUUID& id, std::time_t time)
+{
+    shard_t& shard = getShard(id);
+    LLMutexLock lock(&shard.mMutex);
+    auto it = shard.mEntries.find(id);
+    if (it != shard.mEntries.end() && it->second.mLastAccess < time)
+    {
+        it->second.mLastAccess = time;
+    }
+}
+
+bool LLDiskCachePackStore::rename(const LLUUID& old_id, const LLUUID& new_id)
+{
+    std::vector<U8> data;
+    {
+        shard_t& shard = getShard(old_id);
+        LLMutexLock lock(&shard.mMutex);
+        auto scratch = shard.mScratch.find(old_id);
+        if (scratch != shard.mScratch.end())
+        {
+            data = scratch->second;
+        }
+        else
+        {
+            auto it = shard.mEntries.find(old_id);
+            if (it == shard.mEntries.end() || !readRecord(shard, old_id, it->second, data))
+            {
+                return false;
+            }
+        }
+    }
+
+    if (write(new_id, 0, data.data(), (S32)data.size(), true) < 0)
+    {
+        return false;
+    }
+    remove(old_id);
+    return true;
+}
+
+void LLDiskCachePackStore::clear()
+{
+    for (shard_t& shard : mShards)
+    {
+        LLMutexLock lock(&shard.mMutex);
+        if (mReadOnly)
+        {
+            shard.mEntries.clear();
+            shard.mScratch.clear();
+            shard.mScratchBytes = 0;
+            continue;
+        }
+        closeShard(shard);
+        LLFile::remove(shard.mFilename, ENOENT);
+        LLFile::remove(timesFilepath(shard.mFilename), ENOENT);
+        openShard(shard);
+    }
+}
+
+void LLDiskCachePackStore::compact()
+{
+    if (mReadOnly)
+    {
+        return;
+    }
+
+    for (shard_t& shard : mShards)
+    {
+        bool wasteful;
+        {
+            LLMutexLock lock(&shard.mMutex);
+            wasteful = shard.mDeadBytes >= COMPACT_MIN_DEAD_BYTES && shard.mDeadBytes * 2 > shard.mFileSize;
+        }
+        if (wasteful)
+        {
+            compactShard(shard);
+        }
+    }
+}
+
+void LLDiskCachePackStore::compactShard(shard_t& shard)
+{
+    auto start_time = std::chrono::high_resolution_clock::now();
+
+    // Records are only ever appended, so everything before the current end
+    // of the pack stays put while the live records are copied unlocked
+    entry_map_t snapshot;
+    U64 old_size;
+    U32 generation;
+    {
+        LLMutexLock lock(&shard.mMutex);
+        snapshot = shard.mEntries;
+        old_size = shard.mFileSize;
+        generation = shard.mGeneration;
+    }
+
+    // Keep records in their original order so that older assets stay
+    // towards the front of the pack
+    std::vector<std::pair<U64, LLUUID>> order;
+    order.reserve(snapshot.size());
+    for (const auto& entry : snapshot)
+    {
+        order.emplace_back(entry.second.mExtents.front().mOffset, entry.first);
+    }
+    std::sort(order.begin(), order.end());
+
+    const std::string temp_filename = shard.mFilename + ".tmp";
+    LLFILE* pack_file = LLFile::fopen(shard.mFilename, "rb");
+    LLFILE* temp_file = pack_file ? LLFile::fopen(temp_filename, "wb") : nullptr;
+    if (!temp_file)
+    {
+        if (pack_file)
+        {
+            fclose(pack_file);
+        }
+        LL_WARNS("LLDiskCache") << "Unable to compact pack " << shard.mFilename << LL_ENDL;
+        return;
+    }
+
+    entry_map_t new_entries;
+    new_entries.reserve(snapshot.size());
+    U64 pos = 0;
+    bool success = true;
+    std::vector<U8> data;
+    for (const auto& item : order)
+    {
+        const entry_t& entry = snapshot[item.second];
+        if (!readExtents(pack_file, item.second, entry, data))
+        {
+            // drop corrupt records rather than carry them forward
+            continue;
+        }
+
+        record_header_t header;
+        header.mMagic = RECORD_MAGIC;
+        memcpy(header.mID, item.second.mData, UUID_BYTES);
+        header.mLength = entry.mLength;
+        header.mChecksum = entry.mChecksum;
+        header.mFlags = 0;
+        if (fwrite(&header, sizeof(header), 1, temp_file) != 1
+            || (entry.mLength && fwrite(data.data(), 1, entry.mLength, temp_file) != entry.mLength))
+        {
+            success = false;
+            break;
+        }
+        // any extents are merged into a single record
+        new_entries[item.second] = { { { pos, entry.mLength } }, entry.mLength, entry.mChecksum, true, entry.mLastAccess };
+        pos += sizeof(header) + entry.mLength;
+    }
+    fclose(pack_file);
+
+    LLMutexLock lock(&shard.mMutex);
+    if (shard.mGeneration != generation || !shard.mFile)
+    {
+        // the pack was cleared meanwhile
+        fclose(temp_file);
+        LLFile::remove(temp_filename, ENOENT);
+        return;
+    }
+
+    // Whatever was written meanwhile is copied as it is and indexed below
+    std::vector<U8> tail(shard.mFileSize - old_size);
+    if (success && !tail.empty())
+    {
+        success = seek_to(shard.mFile, old_size)
+            && fread(tail.data(), 1, tail.size(), shard.mFile) == tail.size()
+            && fwrite(tail.data(), 1, tail.size(), temp_file) == tail.size();
+    }
+    success = (fclose(temp_file) == 0) && success;
+
+    if (!success)
+    {
+        LL_WARNS("LLDiskCache") << "Failed to compact pack " << shard.mFilename << LL_ENDL;
+        LLFile::remove(temp_filename, ENOENT);
+        return;
+    }
+
+    // The old pack has to be closed before it can be replaced on Windows,
+    // where rename does not replace an existing file either
+    closeShard(shard);
+#if LL_WINDOWS
+    LLFile::remove(shard.mFilename, ENOENT);
+#endif
+    if (LLFile::rename(temp_filename, shard.mFilename) != 0)
+    {
+        LL_WARNS("LLDiskCache") << "Failed to replace pack " << shard.mFilename << " after compaction" << LL_ENDL;
+        LLFile::remove(temp_filename, ENOENT);
+        shard.mFile = LLFile::fopen(shard.mFilename, "r+b");
+        if (!shard.mFile)
+        {
+            openShard(shard);
+        }
+        return;
+    }
+    shard.mFile = LLFile::fopen(shard.mFilename, "r+b");
+    // the saved access times describe the old pack
+    LLFile::remove(timesFilepath(shard.mFilename), ENOENT);
+
+    entry_map_t old_entries;
+    old_entries.swap(shard.mEntries);
+    shard.mEntries.swap(new_entries);
+    shard.mDeadBytes = 0;
+    for (U64 tail_pos = 0; tail_pos + sizeof(record_header_t) <= tail.size(); )
+    {
+        record_header_t header;
+        memcpy(&header, tail.data() + tail_pos, sizeof(header));
+        indexRecord(shard, header, pos + tail_pos, false);
+        tail_pos += sizeof(header) + header.mLength;
+    }
+    shard.mFileSize = pos + tail.size();
+
+    // Carry over access times, and drop anything that was let go without
+    // a tombstone (see dropEntry) meanwhile
+    for (auto it = shard.mEntries.begin(); it != shard.mEntries.end(); )
+    {
+        auto old = old_entries.find(it->first);
+        if (old == old_entries.end())
+        {
+            shard.mDeadBytes += recordBytes(it->second);
+            it = shard.mEntries.erase(it);
+            continue;
+        }
+        it->second.mLastAccess = old->second.mLastAccess;
+        ++it;
+    }
+
+    auto execute_time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - start_time).count();
+    LL_INFOS("LLDiskCache") << "Compacted " << shard.mFilename << " from " << old_size << " to " << shard.mFileSize << " bytes in " << execute_time << " ms" << LL_ENDL;
+}
+
+void LLDiskCachePackStore::getEntries(entry_list_t& entries)
+{
+    for (shard_t& shard : mShards)
+    {
+        LLMutexLock lock(&shard.mMutex);
+        std::vector<std::pair<U64, entry_map_t::const_iterator>> order;
+        order.reserve(shard.mEntries.size());
+        for (auto it = shard.mEntries.cbegin(); it != shard.mEntries.cend(); ++it)
+        {
+            order.emplace_back(it->second.mExtents.front().mOffset, it);
+        }
+        std::sort(order.begin(), order.end(), [](const auto& x, const auto& y) { return x.first < y.first; });
+        for (const auto& item : order)
+        {
+            entries.push_back({ item.second->first, (S32)item.second->second.mLength, item.second->second.mLastAccess });
+        }
+        // written by a read only store this session
+        const std::time_t now = std::time(nullptr);
+        for (const auto& scratch : shard.mScratch)
+        {
+            entries.push_back({ scratch.first, (S32)scratch.second.size(), now });
+        }
+    }
+}
+
+U64 LLDiskCachePackStore::getTotalBytes()
+{
+    U64 total = 0;
+    for (shard_t& shard : mShards)
+    {
+        LLMutexLock lock(&shard.mMutex);
+        total += shard.mFileSize + shard.mScratchBytes;
+    }
+    return total;
+}
@@ -0,0 +1,204 @@
+/**
+ * @file lldiskcachepack.h
+ * @brief Pack file backend for the disk cache.
+ *
+ * @Description:
+ * Instead of one file per asset, assets are appended to a small, fixed
+ * number of pack files (shards, selected by the first byte of the asset
+ * ID). Each record in a pack is a small header (ID, length, checksum,
+ * flags) followed by the asset data. Removing an asset appends a
+ * tombstone record; overwriting one appends a new version. Data added to
+ * the end of an asset is appended as an extent record holding just the new
+ * bytes, so an asset written in pieces is not copied again for every piece.
+ * The location of the current version of every asset is kept in memory and
+ * rebuilt at startup by walking the record headers of each pack.
+ *
+ * Crash safety: records are only ever appended, so after a crash the
+ * worst case is a torn record at the end of a pack, which is cut off when
+ * the pack is opened. A damaged record anywhere else is skipped over so
+ * that the records after it are kept. Record data is checksummed and
+ * verified the first time it is read; the checksum of an extent covers
+ * the asset up to its end, so a lost extent fails the check too.
+ *
+ * A read only store (the cache of a second viewer instance) never writes
+ * to the packs. What that instance writes is kept in memory instead.
+ *
+ * Space taken by superseded records is reclaimed by compact(), which
+ * LLDiskCache calls from the purge thread.
+ *
+ * The time of last access of each asset is kept in memory and saved next
+ * to each pack on exit, so that the disk cache index can be rebuilt in
+ * least recently used order. Assets written since the times were saved
+ * take the time the pack was last written.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLDISKCACHEPACK_H
+#define LL_LLDISKCACHEPACK_H
+
+#include "llmutex.h"
+#include "lluuid.h"
+
+#include <array>
+#include <ctime>
+#include <unordered_map>
+#include <vector>
+
+class LLDiskCachePackStore
+{
+public:
+    LLDiskCachePackStore(const std::string& cache_dir, bool read_only = false);
+    ~LLDiskCachePackStore();
+
+    LLDiskCachePackStore(const LLDiskCachePackStore&) = delete;
+    LLDiskCachePackStore& operator=(const LLDiskCachePackStore&) = delete;
+
+    bool exists(const LLUUID& id);
+    S32 getSize(const LLUUID& id);
+
+    /**
+     * Read up to 'bytes' bytes of the asset starting at 'offset'.
+     * Returns the number of bytes read or -1 if the asset is missing or
+     * fails its checksum (in which case it is dropped from the store).
+     */
+    S32 read(const LLUUID& id, S32 offset, U8* buffer, S32 bytes);
+
+    /**
+     * Write 'bytes' bytes at 'offset' (or at the end of the asset if
+     * offset is negative). When 'truncate' is set the asset is replaced,
+     * otherwise the rest of the existing data is preserved; this mirrors
+     * the WRITE, APPEND and READ_WRITE modes of LLFileSystem. Returns the
+     * position just past the written data, or -1 on failure. A partial
+     * write to an asset that fails its checksum fails too, and drops it.
+     */
+    S32 write(const LLUUID& id, S32 offset, const U8* buffer, S32 bytes, bool truncate);
+
+    bool remove(const LLUUID& id);
+
+    /**
+     * Bring the time of last access of an asset up to 'time'. The times
+     * are saved when the store is destroyed.
+     */
+    void setLastAccess(const LLUUID& id, std::time_t time);
+    bool rename(const LLUUID& old_id, const LLUUID& new_id);
+
+    /**
+     * Remove every asset and delete the pack files. A read only store
+     * only forgets them.
+     */
+    void clear();
+
+    /**
+     * Delete any pack files in 'cache_dir' without opening them, used when
+     * the cache is switched back to one file per asset.
+     */
+    static void deletePacks(const std::string& cache_dir);
+
+    /**
+     * Rewrite any pack where superseded records take up more space than
+     * the live ones. The live records are copied without holding up
+     * access to the pack; only the records written meanwhile are copied
+     * with the pack locked. Does nothing in a read only store.
+     */
+    void compact();
+
+    /**
+     * Every asset, its size and time of last access, oldest write first
+     * within each pack.
+     */
+    struct entry_info_t
+    {
+        LLUUID mID;
+        S32 mSize;
+        std::time_t mLastAccess;
+    };
+    typedef std::vector<entry_info_t> entry_list_t;
+    void getEntries(entry_list_t& entries);
+
+    U64 getTotalBytes();
+
+private:
+    static constexpr U32 SHARD_COUNT = 16;
+
+    struct record_header_t;
+
+    struct extent_t
+    {
+        U64 mOffset;    // of the record header
+        U32 mLength;
+    };
+
+    struct entry_t
+    {
+        // the record holding the start of the asset, then any extents
+        std::vector<extent_t> mExtents;
+        U32 mLength;
+        U32 mChecksum;  // of the whole asset
+        bool mVerified;
+        std::time_t mLastAccess;
+    };
+    typedef std::unordered_map<LLUUID, entry_t> entry_map_t;
+    typedef std::unordered_map<LLUUID, std::vector<U8>> scratch_map_t;
+
+    struct shard_t
+    {
+        LLMutex mMutex;
+        LLFILE* mFile{ nullptr };
+        std::string mFilename;
+        entry_map_t mEntries;
+        U64 mFileSize{ 0 };
+        U64 mDeadBytes{ 0 };
+        // bumped whenever the pack is reopened, so that a compaction can
+        // tell that the pack it copied has gone
+        U32 mGeneration{ 0 };
+        // assets written by a read only store
+        scratch_map_t mScratch;
+        U64 mScratchBytes{ 0 };
+    };
+
+    static std::string packFilepath(const std::string& cache_dir, U32 index);
+    static U64 recordBytes(const entry_t& entry);
+    static std::string timesFilepath(const std::string& pack_filename);
+    static bool readExtents(LLFILE* file, const LLUUID& id, const entry_t& entry, std::vector<U8>& data);
+
+    shard_t& getShard(const LLUUID& id) { return mShards[id.mData[0] % SHARD_COUNT]; }
+
+    // All of the following must be called with the shard mutex held
+    void openShard(shard_t& shard);
+    void closeShard(shard_t& shard);
+    void indexRecord(shard_t& shard, const record_header_t& header, U64 offset, bool verified);
+    bool appendRecord(shard_t& shard, const LLUUID& id, const U8* data, U32 length, U32 flags);
+    bool readRecord(shard_t& shard, const LLUUID& id, entry_t& entry, std::vector<U8>& data);
+    void dropEntry(shard_t& shard, entry_map_t::iterator it);
+    void loadTimes(shard_t& shard);
+    void saveTimes(shard_t& shard);
+    S32 writeScratch(shard_t& shard, const LLUUID& id, S32 offset, const U8* buffer, S32 bytes, bool truncate);
+
+    // Takes the shard mutex itself, and only for part of the time
+    void compactShard(shard_t& shard);
+
+    std::array<shard_t, SHARD_COUNT> mShards;
+    const bool mReadOnly;
+};
+
+#endif // LL_LLDISKCACHEPACK_H
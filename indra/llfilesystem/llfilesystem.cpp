@@ -34,12 +34,19 @@
 #include "llfasttimer.h"
 #include "lldiskcache.h"
 
-#include "boost/filesystem.hpp"
+#if LL_WINDOWS
+#include "llwin32headerslean.h"
+#include <io.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 constexpr S32 LLFileSystem::READ        = 0x00000001;
 constexpr S32 LLFileSystem::WRITE       = 0x00000002;
 constexpr S32 LLFileSystem::READ_WRITE  = 0x00000003;  // LLFileSystem::READ & LLFileSystem::WRITE
 constexpr S32 LLFileSystem::APPEND      = 0x00000006;  // 0x00000004 & LLFileSystem::WRITE
+constexpr S32 LLFileSystem::MAPPED      = 0x00000008;  // combined with LLFileSystem::READ
 
 static LLTrace::BlockTimerStatHandle FTM_VFILE_WAIT("VFile Wait");
 
@@ -50,31 +57,137 @@ LLFileSystem::LLFileSystem(const LLUUID& file_id, const LLAssetType::EType file_
     mPosition = 0;
     mBytesRead = 0;
     mMode = mode;
+    mMappedData = nullptr;
+    mMappedSize = 0;
+
+    if (mode == (LLFileSystem::READ | LLFileSystem::MAPPED))
+    {
+        // fall back to plain reads if the file can't be mapped
+        mMode = LLFileSystem::READ;
+        if (!LLDiskCache::getPackStore())
+        {
+            // Registered before the file is opened so that a purge can't
+            // remove it from under the mapping
+            if (LLDiskCache::instanceExists())
+            {
+                LLDiskCache::getInstance()->recordMapped(mFileID);
+            }
+            if (mapFile(LLDiskCache::metaDataToFilepath(mFileID, mFileType)))
+            {
+                mMode = mode;
+            }
+            else if (LLDiskCache::instanceExists())
+            {
+                LLDiskCache::getInstance()->recordUnmapped(mFileID);
+            }
+        }
+    }
 
     // This block of code was originally called in the read() method but after comments here:
     // https://bitbucket.org/lindenlab/viewer/commits/e28c1b46e9944f0215a13cab8ee7dded88d7fc90#comment-10537114
     // we decided to follow Henri's suggestion and move the code to update the last access time here.
-    if (mode == LLFileSystem::READ)
+    if ((mode & LLFileSystem::READ) && !(mode & LLFileSystem::WRITE))
     {
-        // build the filename (TODO: we do this in a few places - perhaps we should factor into a single function)
-        const std::string filename = LLDiskCache::metaDataToFilepath(mFileID, mFileType);
-
-        // update the last access time for the file if it exists - this is required
+        // update the last access time for the file - this is required
         // even though we are reading and not writing because this is the
         // way the cache works - it relies on a valid "last accessed time" for
-        // each file so it knows how to remove the oldest, unused files
-        bool exists = gDirUtilp->fileExists(filename);
-        if (exists)
+        // each file so it knows how to remove the oldest, unused files.
+        // Only the in-memory index is touched here, the file times are
+        // brought up to date in batches by LLPurgeDiskCacheThread.
+        if (LLDiskCache::instanceExists())
         {
-            updateFileAccessTime(filename);
+            LLDiskCache::getInstance()->recordAccess(mFileID);
         }
     }
 }
 
+LLFileSystem::~LLFileSystem()
+{
+    unmapFile();
+}
+
+bool LLFileSystem::mapFile(const std::string& filename)
+{
+    LL_PROFILE_ZONE_SCOPED;
+    LLFILE* file = LLFile::fopen(filename, "rb");
+    if (!file)
+    {
+        return false;
+    }
+
+    // The mapping stays valid after the file is closed so we don't need to
+    // keep the descriptor (or handle) around.
+#if LL_WINDOWS
+    HANDLE file_handle = (HANDLE)_get_osfhandle(_fileno(file));
+    LARGE_INTEGER file_size;
+    if (file_handle != INVALID_HANDLE_VALUE && GetFileSizeEx(file_handle, &file_size)
+        && file_size.QuadPart > 0 && file_size.QuadPart <= INT_MAX)
+    {
+        HANDLE mapping = CreateFileMappingW(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping)
+        {
+            mMappedData = (U8*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            if (mMappedData)
+            {
+                mMappedSize = (S32)file_size.QuadPart;
+            }
+            CloseHandle(mapping);
+        }
+    }
+#else
+    struct stat file_stat;
+    if (fstat(fileno(file), &file_stat) == 0 && file_stat.st_size > 0 && file_stat.st_size <= INT_MAX)
+    {
+        void* data = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fileno(file), 0);
+        if (data != MAP_FAILED)
+        {
+            mMappedData = (U8*)data;
+            mMappedSize = (S32)file_stat.st_size;
+        }
+    }
+#endif
+    fclose(file);
+
+    return mMappedData != nullptr;
+}
+
+void LLFileSystem::unmapFile()
+{
+    if (mMappedData)
+    {
+#if LL_WINDOWS
+        UnmapViewOfFile(mMappedData);
+#else
+        munmap(mMappedData, mMappedSize);
+#endif
+        mMappedData = nullptr;
+        mMappedSize = 0;
+
+        if (LLDiskCache::instanceExists())
+        {
+            LLDiskCache::getInstance()->recordUnmapped(mFileID);
+        }
+    }
+}
+
+const U8* LLFileSystem::getMappedData(S32 offset, S32 bytes) const
+{
+    if (!mMappedData || offset < 0 || bytes < 0 || offset > mMappedSize - bytes)
+    {
+        return nullptr;
+    }
+    return mMappedData + offset;
+}
+
 // static
 bool LLFileSystem::getExists(const LLUUID& file_id, const LLAssetType::EType file_type)
 {
     LL_PROFILE_ZONE_SCOPED;
+    if (LLDiskCachePackStore* pack_store = LLDiskCache::getPackStore())
+    {
+        return pack_store->exists(file_id);
+    }
+
     const std::string filename = LLDiskCache::metaDataToFilepath(file_id, file_type);
 
     // <FS:Ansariel> IO-streams replacement
@@ -98,9 +211,21 @@ bool LLFileSystem::getExists(const LLUUID& file_id, const LLAssetType::EType fil
 bool LLFileSystem::removeFile(const LLUUID& file_id, const LLAssetType::EType file_type, int suppress_error /*= 0*/)
 {
     LL_PROFILE_ZONE_COLOR(tracy::Color::Gold); // <FS:Beq> measure cache performance
-    const std::string filename = LLDiskCache::metaDataToFilepath(file_id, file_type);
+    if (LLDiskCachePackStore* pack_store = LLDiskCache::getPackStore())
+    {
+        pack_store->remove(file_id);
+    }
+    else
+    {
+        const std::string filename = LLDiskCache::metaDataToFilepath(file_id, file_type);
 
-    LLFile::remove(filename.c_str(), suppress_error);
+        LLFile::remove(filename.c_str(), suppress_error);
+    }
+
+    if (LLDiskCache::instanceExists())
+    {
+        LLDiskCache::getInstance()->recordRemove(file_id);
+    }
 
     return true;
 }
@@ -110,6 +235,19 @@ bool LLFileSystem::renameFile(const LLUUID& old_file_id, const LLAssetType::ETyp
                               const LLUUID& new_file_id, const LLAssetType::EType new_file_type)
 {
     LL_PROFILE_ZONE_COLOR(tracy::Color::Gold); // <FS:Beq> measure cache performance
+    if (LLDiskCachePackStore* pack_store = LLDiskCache::getPackStore())
+    {
+        if (pack_store->rename(old_file_id, new_file_id))
+        {
+            LLDiskCache::getInstance()->recordRename(old_file_id, new_file_id);
+        }
+        else
+        {
+            LL_WARNS() << "Failed to rename " << old_file_id << " to " << new_file_id << LL_ENDL;
+        }
+        return true;
+    }
+
     const std::string old_filename = LLDiskCache::metaDataToFilepath(old_file_id, old_file_type);
     const std::string new_filename = LLDiskCache::metaDataToFilepath(new_file_id, new_file_type);
 
@@ -124,6 +262,10 @@ bool LLFileSystem::renameFile(const LLUUID& old_file_id, const LLAssetType::ETyp
         //return false;
         LL_WARNS() << "Failed to rename " << old_file_id << " to " << new_file_id << " reason: " << strerror(errno) << LL_ENDL;
     }
+    else if (LLDiskCache::instanceExists())
+    {
+        LLDiskCache::getInstance()->recordRename(old_file_id, new_file_id);
+    }
 
     return true;
 }
@@ -132,6 +274,11 @@ bool LLFileSystem::renameFile(const LLUUID& old_file_id, const LLAssetType::ETyp
 S32 LLFileSystem::getFileSize(const LLUUID& file_id, const LLAssetType::EType file_type)
 {
     LL_PROFILE_ZONE_COLOR(tracy::Color::Gold); // <FS:Beq> measure cache performance
+    if (LLDiskCachePackStore* pack_store = LLDiskCache::getPackStore())
+    {
+        return pack_store->getSize(file_id);
+    }
+
     const std::string filename = LLDiskCache::metaDataToFilepath(file_id, file_type);
 
     S32 file_size = 0;
@@ -157,6 +304,25 @@ bool LLFileSystem::read(U8* buffer, S32 bytes)
     LL_PROFILE_ZONE_COLOR(tracy::Color::Gold); // <FS:Beq> measure cache performance
     bool success = false;
 
+    if (mMappedData)
+    {
+        mBytesRead = llclamp(mMappedSize - mPosition, 0, bytes);
+        if (mBytesRead)
+        {
+            memcpy(buffer, mMappedData + mPosition, mBytesRead);
+            mPosition += mBytesRead;
+            success = true;
+        }
+        return success;
+    }
+
+    if (LLDiskCachePackStore* pack_store = LLDiskCache::getPackStore())
+    {
+        mBytesRead = llmax(pack_store->read(mFileID, mPosition, buffer, bytes), 0);
+        mPosition += mBytesRead;
+        return mBytesRead > 0;
+    }
+
     const std::string filename = LLDiskCache::metaDataToFilepath(mFileID, mFileType);
 
     // <FS:Ansariel> IO-streams replacement
@@ -225,6 +391,32 @@ bool LLFileSystem::write(const U8* buffer, S32 bytes)
 
     bool success = false;
 
+    if (LLDiskCachePackStore* pack_store = LLDiskCache::getPackStore())
+    {
+        // same semantics as the file modes below: WRITE replaces the asset,
+        // APPEND adds to the end and READ_WRITE overwrites in place
+        S32 new_position = -1;
+        if (mMode == APPEND)
+        {
+            new_position = pack_store->write(mFileID, -1, buffer, bytes, false);
+        }
+        else if (mMode == READ_WRITE)
+        {
+            new_position = pack_store->write(mFileID, mPosition, buffer, bytes, false);
+        }
+        else
+        {
+            new_position = pack_store->write(mFileID, 0, buffer, bytes, true);
+        }
+        if (new_position >= 0)
+        {
+            mPosition = new_position;
+            LLDiskCache::getInstance()->recordWrite(mFileID, mPosition, mMode != READ_WRITE);
+            return true;
+        }
+        return false;
+    }
+
     // <FS:Ansariel> IO-streams replacement
     //if (mMode == APPEND)
     //{
@@ -322,6 +514,12 @@ bool LLFileSystem::write(const U8* buffer, S32 bytes)
     }
     // </FS:Ansariel>
 
+    if (success && LLDiskCache::instanceExists())
+    {
+        // only READ_WRITE can leave data beyond the end of what we just wrote
+        LLDiskCache::getInstance()->recordWrite(mFileID, mPosition, mMode != READ_WRITE);
+    }
+
     return success;
 }
 
@@ -365,6 +563,10 @@ S32 LLFileSystem::tell() const
 S32 LLFileSystem::getSize() const
 {
     LL_PROFILE_ZONE_COLOR(tracy::Color::Gold); // <FS:Beq> measure cache performance
+    if (mMappedData)
+    {
+        return mMappedSize;
+    }
     return LLFileSystem::getFileSize(mFileID, mFileType);
 }
 
@@ -392,64 +594,3 @@ bool LLFileSystem::remove() const
     LLFileSystem::removeFile(mFileID, mFileType);
     return true;
 }
-
-void LLFileSystem::updateFileAccessTime(const std::string& file_path)
-{
-    /**
-     * Threshold in time_t units that is used to decide if the last access time
-     * time of the file is updated or not. Added as a precaution for the concern
-     * outlined in SL-14582  about frequent writes on older SSDs reducing their
-     * lifespan. I think this is the right place for the threshold value - rather
-     * than it being a pref - do comment on that Jira if you disagree...
-     *
-     * Let's start with 1 hour in time_t units and see how that unfolds
-     */
-    constexpr std::time_t time_threshold = 1 * 60 * 60;
-
-    // current time
-    const std::time_t cur_time = std::time(nullptr);
-
-    boost::system::error_code ec;
-#if LL_WINDOWS
-    // file last write time
-    const std::time_t last_write_time = boost::filesystem::last_write_time(utf8str_to_utf16str(file_path), ec);
-    if (ec.failed())
-    {
-        LL_WARNS() << "Failed to read last write time for cache file " << file_path << ": " << ec.message() << LL_ENDL;
-        return;
-    }
-
-    // delta between cur time and last time the file was written
-    const std::time_t delta_time = cur_time - last_write_time;
-
-    // we only write the new value if the time in time_threshold has elapsed
-    // before the last one
-    if (delta_time > time_threshold)
-    {
-        boost::filesystem::last_write_time(utf8str_to_utf16str(file_path), cur_time, ec);
-    }
-#else
-    // file last write time
-    const std::time_t last_write_time = boost::filesystem::last_write_time(file_path, ec);
-    if (ec.failed())
-    {
-        LL_WARNS() << "Failed to read last write time for cache file " << file_path << ": " << ec.message() << LL_ENDL;
-        return;
-    }
-
-    // delta between cur time and last time the file was written
-    const std::time_t delta_time = cur_time - last_write_time;
-
-    // we only write the new value if the time in time_threshold has elapsed
-    // before the last one
-    if (delta_time > time_threshold)
-    {
-        boost::filesystem::last_write_time(file_path, cur_time, ec);
-    }
-#endif
-
-    if (ec.failed())
-    {
-        LL_WARNS() << "Failed to update last write time for cache file " << file_path << ": " << ec.message() << LL_ENDL;
-    }
-}
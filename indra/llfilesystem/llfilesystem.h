@@ -38,7 +38,10 @@ class LLFileSystem
 {
     public:
         LLFileSystem(const LLUUID& file_id, const LLAssetType::EType file_type, S32 mode = LLFileSystem::READ);
-        ~LLFileSystem() = default;
+        ~LLFileSystem();
+
+        LLFileSystem(const LLFileSystem&) = delete;
+        LLFileSystem& operator=(const LLFileSystem&) = delete;
 
         bool read(U8* buffer, S32 bytes);
         S32  getLastBytesRead() const;
@@ -54,11 +57,25 @@ class LLFileSystem
         bool remove() const;
 
         /**
-         * Update the "last write time" of a file to "now". This must be called whenever a
-         * file in the cache is read (not written) so that the last time the file was
-         * accessed is up to date (This is used in the mechanism for purging the cache)
+         * When opened with READ | MAPPED the whole file is mapped into memory
+         * once and read() becomes a memcpy from the mapping, so callers that
+         * read several ranges of the same asset (mesh header, LODs, skin...)
+         * do not reopen the file every time. Returns a pointer to 'bytes'
+         * bytes of the mapping starting at 'offset' for callers that can
+         * parse the data in place, or nullptr if the file is not mapped or
+         * the range is out of bounds. The pointer is only valid for the
+         * lifetime of this object.
+         *
+         * The mapping is not a snapshot: pages not read yet see later
+         * writes to the file, and reading a page past the end of a file
+         * that was truncated or removed since it was mapped raises SIGBUS.
+         * Callers must keep the file from being written, truncated or
+         * removed while it is mapped (e.g. the mesh repository drops its
+         * open file for a mesh before the mesh is written to the cache).
+         * LLDiskCache::purge() leaves mapped files alone.
          */
-        void updateFileAccessTime(const std::string& file_path);
+        const U8* getMappedData(S32 offset, S32 bytes) const;
+        bool isMapped() const { return mMappedData != nullptr; }
 
         static bool getExists(const LLUUID& file_id, const LLAssetType::EType file_type);
         static bool removeFile(const LLUUID& file_id, const LLAssetType::EType file_type, int suppress_error = 0);
@@ -71,6 +88,7 @@ class LLFileSystem
         static const S32 WRITE;
         static const S32 READ_WRITE;
         static const S32 APPEND;
+        static const S32 MAPPED;
 
     protected:
         LLAssetType::EType mFileType;
@@ -78,6 +96,13 @@ class LLFileSystem
         S32     mPosition;
         S32     mMode;
         S32     mBytesRead;
+
+    private:
+        bool mapFile(const std::string& filename);
+        void unmapFile();
+
+        U8*     mMappedData;
+        S32     mMappedSize;
 };
 
 #endif  // LL_FILESYSTEM_H
@@ -0,0 +1,306 @@
+/**
+ * @file lldiskcache_test.cpp
+ * @date 2024-10
+ * @brief LLDiskCache and LLDiskCacheIndex test cases.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../lldir.h"
+#include "../lldiskcache.h"
+#include "../lldiskcacheindex.h"
+#include "../llfilesystem.h"
+
+#include "../test/lltut.h"
+#include "stringize.h"
+
+#include <boost/filesystem.hpp>
+#include <fstream>
+#include <memory>
+
+namespace tut
+{
+    struct LLDiskCacheFixture
+    {
+        // Every asset is this big, so a cache opened for N assets is full
+        // with N of them
+        static constexpr S32 ASSET_SIZE = 1000;
+
+        LLDiskCacheFixture()
+        {
+            mCacheDir = gDirUtilp->add(gDirUtilp->getTempDir(), "lldiskcache_test");
+            boost::filesystem::remove_all(mCacheDir);
+            LLFile::mkdir(mCacheDir);
+        }
+
+        ~LLDiskCacheFixture()
+        {
+            LLDiskCache::deleteSingleton();
+            boost::filesystem::remove_all(mCacheDir);
+        }
+
+        void open(S32 asset_count)
+        {
+            LLDiskCache::initParamSingleton(mCacheDir, asset_count * ASSET_SIZE, false, 95.f, 70.f, false);
+        }
+
+        LLUUID writeAsset()
+        {
+            LLUUID id;
+            id.generate();
+            std::vector<U8> data(ASSET_SIZE, (U8)id.mData[0]);
+            LLFileSystem file(id, LLAssetType::AT_TEXTURE, LLFileSystem::WRITE);
+            file.write(data.data(), ASSET_SIZE);
+            return id;
+        }
+
+        void readAsset(const LLUUID& id)
+        {
+            U8 byte;
+            LLFileSystem file(id, LLAssetType::AT_TEXTURE);
+            file.read(&byte, 1);
+        }
+
+        bool exists(const LLUUID& id)
+        {
+            return LLFileSystem::getExists(id, LLAssetType::AT_TEXTURE);
+        }
+
+        std::string indexFilepath() const
+        {
+            return gDirUtilp->add(mCacheDir, "cache_index.dat");
+        }
+
+        static std::vector<LLUUID> makeIds(S32 count)
+        {
+            std::vector<LLUUID> ids(count);
+            for (LLUUID& id : ids)
+            {
+                id.generate();
+            }
+            return ids;
+        }
+
+        void ensure_order(const std::string& msg, LLDiskCacheIndex& index, const std::vector<LLUUID>& expected)
+        {
+            LLDiskCacheIndex::entry_list_t entries;
+            index.getEntries(entries);
+            tut::ensure_equals(msg + " count", entries.size(), expected.size());
+            for (size_t i = 0; i < entries.size(); ++i)
+            {
+                tut::ensure(STRINGIZE(msg << " entry " << i), entries[i].mID == expected[i]);
+            }
+        }
+
+        std::string mCacheDir;
+    };
+    typedef test_group<LLDiskCacheFixture> LLDiskCacheTest_factory;
+    typedef LLDiskCacheTest_factory::object LLDiskCacheTest_t;
+    LLDiskCacheTest_factory tf("LLDiskCache");
+
+    template<> template<>
+    void LLDiskCacheTest_t::test<1>()
+    {
+        set_test_name("purge removes the least recently used down to the low water mark, except mapped files");
+
+        const S32 count = 10;
+        open(count);
+        std::vector<LLUUID> ids;
+        std::unique_ptr<LLFileSystem> mapped;
+        for (S32 i = 0; i < count; ++i)
+        {
+            ids.push_back(writeAsset());
+            if (i == 1)
+            {
+                // mapped while it is still one of the oldest
+                mapped = std::make_unique<LLFileSystem>(ids[1], LLAssetType::AT_TEXTURE, LLFileSystem::READ | LLFileSystem::MAPPED);
+                ensure("asset 1 mapped", mapped->isMapped());
+            }
+        }
+        // the oldest write becomes the most recent access
+        readAsset(ids[0]);
+
+        // full, so purge down to 70%
+        LLDiskCache::getInstance()->purge();
+        ensure("read asset kept", exists(ids[0]));
+        ensure("mapped asset kept", exists(ids[1]));
+        for (S32 i = 2; i <= 4; ++i)
+        {
+            ensure(STRINGIZE("asset " << i << " purged"), !exists(ids[i]));
+        }
+        for (S32 i = 5; i < count; ++i)
+        {
+            ensure(STRINGIZE("asset " << i << " kept"), exists(ids[i]));
+        }
+
+        // below the high water mark, so nothing more goes
+        mapped.reset();
+        LLDiskCache::getInstance()->purge();
+        for (S32 i = 5; i < count; ++i)
+        {
+            ensure(STRINGIZE("asset " << i << " still kept"), exists(ids[i]));
+        }
+    }
+
+    template<> template<>
+    void LLDiskCacheTest_t::test<2>()
+    {
+        set_test_name("index is saved and loaded in least recently used order");
+
+        LLDiskCacheIndex index;
+        index.clear();
+        const std::vector<LLUUID> ids = makeIds(4);
+        for (S32 i = 0; i < 4; ++i)
+        {
+            index.recordWrite(ids[i], 100 * (i + 1), true, 1000 + i);
+        }
+        index.recordAccess(ids[0], 2000);
+        ensure("index saved", index.save(indexFilepath()));
+
+        LLDiskCacheIndex loaded;
+        ensure("index loaded", loaded.load(indexFilepath()));
+        ensure("loaded index valid", loaded.isValid());
+        ensure_equals("size", loaded.getSize(), (uintmax_t)1000);
+        ensure_order("loaded order", loaded, { ids[1], ids[2], ids[3], ids[0] });
+
+        LLDiskCacheIndex::entry_list_t entries;
+        loaded.getEntries(entries);
+        ensure_equals("access time", entries.back().mLastAccess, (std::time_t)2000);
+        ensure_equals("entry size", entries.front().mSize, (uintmax_t)200);
+    }
+
+    template<> template<>
+    void LLDiskCacheTest_t::test<3>()
+    {
+        set_test_name("corrupt index is rejected and rebuilt from the cache files");
+
+        {
+            std::ofstream out(indexFilepath(), std::ios::binary | std::ios::trunc);
+            out << "not an index";
+        }
+        LLDiskCacheIndex index;
+        ensure("corrupt index rejected", !index.load(indexFilepath()));
+        ensure("index invalid", !index.isValid());
+        ensure_equals("index empty", index.getCount(), (size_t)0);
+
+        // written while the cache is walked, so newer than anything found
+        const std::vector<LLUUID> ids = makeIds(4);
+        index.recordWrite(ids[3], 10, true, 500);
+
+        // found newest first, as a directory walk would in any order
+        LLDiskCacheIndex::entry_list_t found;
+        found.push_back({ ids[2], 10, 3000 });
+        found.push_back({ ids[1], 10, 2000 });
+        found.push_back({ ids[0], 10, 1000 });
+        index.rebuild(found);
+        ensure("rebuilt index valid", index.isValid());
+        ensure_equals("size", index.getSize(), (uintmax_t)40);
+        ensure_order("rebuilt order", index, { ids[0], ids[1], ids[2], ids[3] });
+    }
+
+    template<> template<>
+    void LLDiskCacheTest_t::test<4>()
+    {
+        set_test_name("access moves an entry to the recent end");
+
+        LLDiskCacheIndex index;
+        index.clear();
+        const std::vector<LLUUID> ids = makeIds(4);
+        for (S32 i = 0; i < 4; ++i)
+        {
+            index.recordWrite(ids[i], 10, true, 1000 + i);
+        }
+        index.recordAccess(ids[1], 2000);
+        ensure_order("after access", index, { ids[0], ids[2], ids[3], ids[1] });
+
+        // batched access times only move entries they are newer for
+        LLDiskCacheIndex::access_map_t accesses;
+        accesses[ids[0]] = 3000;
+        accesses[ids[1]] = 1500;
+        index.recordAccesses(accesses);
+        ensure_order("after batched access", index, { ids[2], ids[3], ids[1], ids[0] });
+
+        // an unknown id is not added by an access
+        LLUUID unknown;
+        unknown.generate();
+        index.recordAccess(unknown, 4000);
+        ensure_equals("count", index.getCount(), (size_t)4);
+    }
+
+    template<> template<>
+    void LLDiskCacheTest_t::test<5>()
+    {
+        set_test_name("purge stops at the target size and skips kept entries");
+
+        LLDiskCacheIndex index;
+        index.clear();
+        const std::vector<LLUUID> ids = makeIds(10);
+        for (S32 i = 0; i < 10; ++i)
+        {
+            index.recordWrite(ids[i], 100, true, 1000 + i);
+        }
+
+        const LLUUID& kept_id = ids[1];
+        LLDiskCacheIndex::entry_list_t purged;
+        const size_t kept = index.purge(700, [&](const LLUUID& id) { return id == kept_id; }, purged);
+        ensure_equals("kept", kept, (size_t)1);
+        ensure_equals("purged", purged.size(), (size_t)3);
+        ensure("oldest purged first", purged[0].mID == ids[0] && purged[1].mID == ids[2] && purged[2].mID == ids[3]);
+        ensure_equals("size at target", index.getSize(), (uintmax_t)700);
+        ensure_order("after purge", index, { ids[4], ids[5], ids[6], ids[7], ids[8], ids[9], ids[1] });
+
+        // below the target, so nothing more goes
+        purged.clear();
+        index.purge(700, [](const LLUUID&) { return false; }, purged);
+        ensure("nothing purged below target", purged.empty());
+
+        // everything kept, so each entry is only looked at once
+        purged.clear();
+        ensure_equals("all kept", index.purge(0, [](const LLUUID&) { return true; }, purged), (size_t)7);
+        ensure("nothing purged when all kept", purged.empty());
+    }
+
+    template<> template<>
+    void LLDiskCacheTest_t::test<6>()
+    {
+        set_test_name("entries that could not be removed are restored at the old end");
+
+        LLDiskCacheIndex index;
+        index.clear();
+        const std::vector<LLUUID> ids = makeIds(4);
+        for (S32 i = 0; i < 4; ++i)
+        {
+            index.recordWrite(ids[i], 100, true, 1000 + i);
+        }
+        LLDiskCacheIndex::entry_list_t purged;
+        index.purge(200, [](const LLUUID&) { return false; }, purged);
+        ensure_equals("purged", purged.size(), (size_t)2);
+
+        // the second one was written again after it was purged
+        index.recordWrite(ids[1], 50, true, 2000);
+        index.restore(purged);
+        ensure_equals("size", index.getSize(), (uintmax_t)350);
+        ensure_order("after restore", index, { ids[0], ids[2], ids[3], ids[1] });
+    }
+}
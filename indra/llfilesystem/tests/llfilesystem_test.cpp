@@ -0,0 +1,482 @@
+/**
+ * @file llfilesystem_test.cpp
+ * @date 2024-10
+ * @brief LLFileSystem test cases.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../lldir.h"
+#include "../lldiskcache.h"
+#include "../lldiskcachepack.h"
+#include "../llfilesystem.h"
+
+#include "../test/lltut.h"
+
+#include <boost/filesystem.hpp>
+#include <chrono>
+#include <fstream>
+#include <memory>
+
+namespace
+{
+    // Number of read system calls made by this process so far, or -1 where
+    // that isn't available.
+    S64 read_syscalls()
+    {
+#if LL_LINUX
+        std::ifstream io("/proc/self/io");
+        std::string key;
+        S64 value;
+        while (io >> key >> value)
+        {
+            if (key == "syscr:")
+            {
+                return value;
+            }
+        }
+#endif
+        return -1;
+    }
+}
+
+namespace tut
+{
+    struct LLFileSystemFixture
+    {
+        LLFileSystemFixture()
+        {
+            mCacheDir = gDirUtilp->add(gDirUtilp->getTempDir(), "llfilesystem_test");
+            if (!LLDiskCache::instanceExists())
+            {
+                LLDiskCache::initParamSingleton(mCacheDir, 64 * 1024 * 1024, false, 95.f, 70.f, false);
+            }
+        }
+
+        ~LLFileSystemFixture()
+        {
+            LLDiskCache::getInstance()->clearCache();
+        }
+
+        // Write an asset shaped roughly like a mesh: a header followed by
+        // several blocks that are read back individually
+        LLUUID writeAsset(S32 size)
+        {
+            LLUUID id;
+            id.generate();
+            std::vector<U8> data(size);
+            for (S32 i = 0; i < size; ++i)
+            {
+                data[i] = (U8)(i * 31 + 7);
+            }
+            LLFileSystem file(id, LLAssetType::AT_MESH, LLFileSystem::WRITE);
+            file.write(data.data(), size);
+            return id;
+        }
+
+        std::string mCacheDir;
+    };
+    typedef test_group<LLFileSystemFixture> LLFileSystemTest_factory;
+    typedef LLFileSystemTest_factory::object LLFileSystemTest_t;
+    LLFileSystemTest_factory tf("LLFileSystem");
+
+    template<> template<>
+    void LLFileSystemTest_t::test<1>()
+    {
+        set_test_name("mapped reads match buffered reads");
+
+        const S32 size = 64 * 1024 + 123;
+        LLUUID id = writeAsset(size);
+
+        LLFileSystem buffered(id, LLAssetType::AT_MESH);
+        LLFileSystem mapped(id, LLAssetType::AT_MESH, LLFileSystem::READ | LLFileSystem::MAPPED);
+        ensure("file mapped", mapped.isMapped());
+        ensure_equals("mapped size", mapped.getSize(), buffered.getSize());
+
+        std::vector<U8> a(size), b(size);
+        for (S32 offset : { 0, 4096, size - 100 })
+        {
+            buffered.seek(offset, 0);
+            mapped.seek(offset, 0);
+            ensure("buffered read", buffered.read(a.data(), 4096));
+            ensure("mapped read", mapped.read(b.data(), 4096));
+            ensure_equals("bytes read", mapped.getLastBytesRead(), buffered.getLastBytesRead());
+            ensure("same data", memcmp(a.data(), b.data(), buffered.getLastBytesRead()) == 0);
+            ensure("zero copy view", memcmp(mapped.getMappedData(offset, buffered.getLastBytesRead()), a.data(), buffered.getLastBytesRead()) == 0);
+        }
+        ensure("eof", mapped.eof());
+        ensure("read past end fails", !mapped.read(b.data(), 1));
+        ensure("out of range view", mapped.getMappedData(size - 10, 11) == nullptr);
+    }
+
+    template<> template<>
+    void LLFileSystemTest_t::test<2>()
+    {
+        set_test_name("missing asset is not mapped");
+
+        LLUUID id;
+        id.generate();
+        LLFileSystem mapped(id, LLAssetType::AT_MESH, LLFileSystem::READ | LLFileSystem::MAPPED);
+        ensure("not mapped", !mapped.isMapped());
+        ensure_equals("size", mapped.getSize(), 0);
+        U8 byte;
+        ensure("read fails", !mapped.read(&byte, 1));
+    }
+
+    template<> template<>
+    void LLFileSystemTest_t::test<3>()
+    {
+        set_test_name("mesh style read benchmark");
+
+        // Each "asset" is read the way LLMeshRepoThread reads it: the 4KB
+        // header through its own buffered read, then a couple of LODs and
+        // the skin, each from a separate fetch. Buffered, every fetch opens
+        // the file again; mapped, the repo thread keeps one mapping per
+        // asset for all of them.
+        const S32 asset_count = 200;
+        const S32 asset_size = 96 * 1024;
+        const S32 header_size = 4096;
+        const S32 block_size = 8 * 1024;
+        std::vector<LLUUID> ids;
+        for (S32 i = 0; i < asset_count; ++i)
+        {
+            ids.push_back(writeAsset(asset_size));
+        }
+
+        std::vector<U8> buffer(block_size);
+        auto run = [&](bool mapped)
+        {
+            const S64 syscalls_before = read_syscalls();
+            auto start = std::chrono::steady_clock::now();
+            for (const LLUUID& id : ids)
+            {
+                {
+                    LLFileSystem header(id, LLAssetType::AT_MESH, LLFileSystem::READ);
+                    header.read(buffer.data(), header_size);
+                }
+
+                std::unique_ptr<LLFileSystem> kept;
+                if (mapped)
+                {
+                    kept = std::make_unique<LLFileSystem>(id, LLAssetType::AT_MESH, LLFileSystem::READ | LLFileSystem::MAPPED);
+                }
+                for (S32 offset = header_size; offset + block_size <= asset_size; offset += 3 * block_size)
+                {
+                    std::unique_ptr<LLFileSystem> fresh;
+                    if (!mapped)
+                    {
+                        fresh = std::make_unique<LLFileSystem>(id, LLAssetType::AT_MESH, LLFileSystem::READ);
+                    }
+                    LLFileSystem& file = mapped ? *kept : *fresh;
+                    if (file.getSize() >= offset + block_size)
+                    {
+                        file.seek(offset, 0);
+                        file.read(buffer.data(), block_size);
+                    }
+                }
+            }
+            auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+            const S64 syscalls = read_syscalls() - syscalls_before;
+            LL_INFOS() << (mapped ? "mapped" : "buffered") << ": "
+                       << (F32)elapsed / asset_count << " us/asset, "
+                       << (syscalls_before < 0 ? -1.f : (F32)syscalls / asset_count) << " read syscalls/asset" << LL_ENDL;
+            return syscalls;
+        };
+
+        const S64 buffered_syscalls = run(false);
+        const S64 mapped_syscalls = run(true);
+        if (buffered_syscalls >= 0)
+        {
+            ensure("mapped reads make fewer syscalls", mapped_syscalls < buffered_syscalls);
+        }
+    }
+
+    template<> template<>
+    void LLFileSystemTest_t::test<4>()
+    {
+        set_test_name("pack store read, write, remove and recovery");
+
+        const std::string pack_dir = gDirUtilp->add(gDirUtilp->getTempDir(), "llfilesystem_test_pack");
+        LLFile::mkdir(pack_dir);
+        LLDiskCachePackStore::deletePacks(pack_dir);
+
+        LLUUID a, b, c;
+        a.generate();
+        b.generate();
+        c.generate();
+        const U8 data[] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+        U8 buffer[16];
+        {
+            LLDiskCachePackStore store(pack_dir);
+            ensure_equals("write", store.write(a, 0, data, 8, true), 8);
+            ensure_equals("append", store.write(a, -1, data, 4, false), 12);
+            ensure_equals("write in place", store.write(a, 2, data, 2, false), 4);
+            ensure_equals("size", store.getSize(a), 12);
+            ensure_equals("read", store.read(a, 0, buffer, sizeof(buffer)), 12);
+            const U8 expected[] = { 1, 2, 1, 2, 5, 6, 7, 8, 1, 2, 3, 4 };
+            ensure("contents", memcmp(buffer, expected, 12) == 0);
+            ensure_equals("read at offset", store.read(a, 10, buffer, 4), 2);
+
+            store.write(b, 0, data, 8, true);
+            ensure("rename", store.rename(b, c));
+            ensure("renamed from", !store.exists(b));
+            ensure_equals("renamed to", store.getSize(c), 8);
+            ensure("remove", store.remove(c));
+            ensure("removed", !store.exists(c));
+
+            // Appending only writes the new piece
+            const U64 before = store.getTotalBytes();
+            ensure_equals("append piece", store.write(a, -1, data, 8, false), 20);
+            ensure_equals("append piece size", store.getTotalBytes() - before, 32 + 8);
+            ensure_equals("read across pieces", store.read(a, 10, buffer, sizeof(buffer)), 10);
+            const U8 expected_tail[] = { 3, 4, 1, 2, 3, 4, 5, 6, 7, 8 };
+            ensure("pieces contents", memcmp(buffer, expected_tail, 10) == 0);
+        }
+
+        // Simulate a crash in the middle of writing a record
+        const std::string pack_file = gDirUtilp->add(pack_dir, llformat("pack_%x.dat", a.mData[0] % 16));
+        LLFILE* file = LLFile::fopen(pack_file, "ab");
+        fwrite(data, 1, sizeof(data), file);
+        fclose(file);
+
+        {
+            LLDiskCachePackStore store(pack_dir);
+            ensure_equals("survives torn record", store.getSize(a), 20);
+            ensure_equals("read after reopen", store.read(a, 0, buffer, sizeof(buffer)), 16);
+            ensure("remove survives reopen", !store.exists(c));
+        }
+
+        // A second instance reads the packs but leaves them alone
+        {
+            LLDiskCachePackStore store(pack_dir);
+            const U64 size = store.getTotalBytes();
+            {
+                LLDiskCachePackStore read_only(pack_dir, true);
+                ensure_equals("read only read", read_only.read(a, 0, buffer, 8), 8);
+                ensure_equals("read only write", read_only.write(a, -1, data, 4, false), 24);
+                ensure_equals("read only sees write", read_only.getSize(a), 24);
+                ensure("read only remove", read_only.remove(a));
+                ensure("read only removed", !read_only.exists(a));
+                read_only.clear();
+            }
+            LLDiskCachePackStore reopened(pack_dir);
+            ensure_equals("packs untouched", reopened.getTotalBytes(), size);
+            ensure_equals("asset untouched", reopened.getSize(a), 20);
+        }
+
+        // Damage the header of one record and the data of the next: the
+        // record after them is kept, and a partial write to the damaged
+        // asset fails rather than filling it with zeroes
+        LLUUID d, e;
+        d.generate();
+        e.generate();
+        d.mData[0] = e.mData[0] = a.mData[0];
+        {
+            LLDiskCachePackStore store(pack_dir);
+            store.clear();
+            ensure_equals("first", store.write(d, 0, data, 8, true), 8);
+            ensure_equals("second", store.write(e, 0, data, 8, true), 8);
+            ensure_equals("third", store.write(a, 0, data, 8, true), 8);
+        }
+        file = LLFile::fopen(pack_file, "r+b");
+        fwrite(data, 1, 1, file);
+        fseek(file, 40 + 32 + 2, SEEK_SET);
+        fwrite(data, 1, 1, file);
+        fclose(file);
+        {
+            LLDiskCachePackStore store(pack_dir);
+            ensure("damaged header", !store.exists(d));
+            ensure_equals("damaged data size", store.getSize(e), 8);
+            ensure_equals("record after damage", store.read(a, 0, buffer, 8), 8);
+            ensure_equals("damaged write", store.write(e, 4, data, 2, false), -1);
+            ensure("damaged dropped", !store.exists(e));
+            store.clear();
+            ensure("cleared", !store.exists(a));
+        }
+    }
+
+    template<> template<>
+    void LLFileSystemTest_t::test<5>()
+    {
+        set_test_name("per-file vs pack store benchmark");
+        if (!getenv("LL_TEST_BENCHMARK"))
+        {
+            skip("benchmark, set LL_TEST_BENCHMARK to run it");
+        }
+
+        // 100K small assets: write them all, read them all back, then purge
+        // the older half, the way the disk cache does without an index:
+        // list what is stored, oldest first, and remove from the front.
+        const S32 asset_count = 100000;
+        const S32 asset_size = 1024;
+        std::vector<LLUUID> ids(asset_count);
+        for (LLUUID& id : ids)
+        {
+            id.generate();
+        }
+        std::vector<U8> data(asset_size, 0x5a);
+        std::vector<U8> buffer(asset_size);
+
+        auto elapsed_ms = [](std::chrono::steady_clock::time_point start)
+        {
+            return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+        };
+
+        {
+            auto start = std::chrono::steady_clock::now();
+            for (const LLUUID& id : ids)
+            {
+                LLFileSystem file(id, LLAssetType::AT_TEXTURE, LLFileSystem::WRITE);
+                file.write(data.data(), asset_size);
+            }
+            auto write_ms = elapsed_ms(start);
+
+            start = std::chrono::steady_clock::now();
+            for (const LLUUID& id : ids)
+            {
+                LLFileSystem file(id, LLAssetType::AT_TEXTURE);
+                file.read(buffer.data(), asset_size);
+            }
+            auto read_ms = elapsed_ms(start);
+
+            start = std::chrono::steady_clock::now();
+            std::vector<std::pair<std::time_t, std::string>> files;
+            boost::system::error_code ec;
+            for (boost::filesystem::recursive_directory_iterator iter(mCacheDir, ec), end; iter != end && !ec.failed(); iter.increment(ec))
+            {
+                if (boost::filesystem::is_regular_file(*iter, ec))
+                {
+                    files.emplace_back(boost::filesystem::last_write_time(*iter, ec), iter->path().string());
+                }
+            }
+            std::stable_sort(files.begin(), files.end(), [](const auto& x, const auto& y) { return x.first < y.first; });
+            for (size_t i = 0; i < files.size() / 2; ++i)
+            {
+                boost::filesystem::remove(files[i].second, ec);
+            }
+            auto purge_ms = elapsed_ms(start);
+
+            LL_INFOS() << "per-file: write " << write_ms << " ms, read " << read_ms << " ms, purge " << purge_ms << " ms" << LL_ENDL;
+            LLDiskCache::getInstance()->clearCache();
+        }
+
+        {
+            const std::string pack_dir = gDirUtilp->add(gDirUtilp->getTempDir(), "llfilesystem_test_pack");
+            LLFile::mkdir(pack_dir);
+            LLDiskCachePackStore::deletePacks(pack_dir);
+            LLDiskCachePackStore store(pack_dir);
+
+            auto start = std::chrono::steady_clock::now();
+            for (const LLUUID& id : ids)
+            {
+                store.write(id, 0, data.data(), asset_size, true);
+            }
+            auto write_ms = elapsed_ms(start);
+
+            start = std::chrono::steady_clock::now();
+            for (const LLUUID& id : ids)
+            {
+                ensure_equals("pack read", store.read(id, 0, buffer.data(), asset_size), asset_size);
+            }
+            auto read_ms = elapsed_ms(start);
+
+            start = std::chrono::steady_clock::now();
+            LLDiskCachePackStore::entry_list_t entries;
+            store.getEntries(entries);
+            for (size_t i = 0; i < entries.size() / 2; ++i)
+            {
+                store.remove(entries[i].mID);
+            }
+            store.compact();
+            auto purge_ms = elapsed_ms(start);
+
+            LL_INFOS() << "pack store: write " << write_ms << " ms, read " << read_ms << " ms, purge " << purge_ms << " ms" << LL_ENDL;
+            entries.clear();
+            store.getEntries(entries);
+            ensure_equals("purged", (S32)entries.size(), asset_count - asset_count / 2);
+            store.clear();
+        }
+    }
+
+    template<> template<>
+    void LLFileSystemTest_t::test<6>()
+    {
+        set_test_name("pack store access times and compaction");
+
+        const std::string pack_dir = gDirUtilp->add(gDirUtilp->getTempDir(), "llfilesystem_test_pack");
+        LLFile::mkdir(pack_dir);
+        LLDiskCachePackStore::deletePacks(pack_dir);
+
+        auto last_access = [](LLDiskCachePackStore& store, const LLUUID& id)
+        {
+            LLDiskCachePackStore::entry_list_t entries;
+            store.getEntries(entries);
+            for (const auto& entry : entries)
+            {
+                if (entry.mID == id)
+                {
+                    return entry.mLastAccess;
+                }
+            }
+            return (std::time_t)0;
+        };
+
+        LLUUID a, b;
+        a.generate();
+        b.generate();
+        b.mData[0] = a.mData[0];
+        const std::time_t later = std::time(nullptr) + 1000;
+        std::vector<U8> data(1024 * 1024, 0x5a);
+        {
+            LLDiskCachePackStore store(pack_dir);
+            store.write(b, 0, data.data(), 100, true);
+            // superseded versions of 'a' make the pack worth compacting
+            for (S32 i = 0; i < 20; ++i)
+            {
+                store.write(a, 0, data.data(), (S32)data.size(), true);
+            }
+            store.setLastAccess(b, later);
+            ensure("written now", last_access(store, a) < later);
+
+            const U64 before = store.getTotalBytes();
+            store.compact();
+            ensure("compacted", store.getTotalBytes() < before / 10);
+            std::vector<U8> buffer(data.size());
+            ensure_equals("read after compaction", store.read(a, 0, buffer.data(), (S32)buffer.size()), (S32)data.size());
+            ensure("contents after compaction", buffer == data);
+            ensure_equals("access time after compaction", last_access(store, b), later);
+
+            // written after compaction, so indexed on top of the copied records
+            store.write(a, -1, data.data(), 10, false);
+            ensure_equals("append after compaction", store.getSize(a), (S32)data.size() + 10);
+        }
+        {
+            LLDiskCachePackStore store(pack_dir);
+            ensure_equals("access time after reopen", last_access(store, b), later);
+            ensure("write time after reopen", last_access(store, a) < later);
+            ensure_equals("size after reopen", store.getSize(a), (S32)data.size() + 10);
+            store.clear();
+        }
+    }
+}
@@ -43,6 +43,10 @@
 
 #include <boost/preprocessor.hpp>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
 //..................................................................................
 //..................................................................................
 // Helper macrose's for generate cycle unwrap templates
@@ -220,6 +224,77 @@ private:
 };
 
 
+//---------------------------------------------------------------------------
+// SIMD kernels
+// SSE2 is part of the baseline (see llsimdmath.h); byte shuffles need SSSE3,
+// which we only assume when building for AVX2. Every kernel does the same
+// integer arithmetic as the scalar code it replaces, so the output is bit
+// for bit identical.
+//---------------------------------------------------------------------------
+
+namespace
+{
+    // Low 32 bits of the products of four unsigned 32 bit lanes (SSE2 has no
+    // _mm_mullo_epi32)
+    inline __m128i mullo_epi32_sse2(__m128i a, __m128i b)
+    {
+        __m128i even = _mm_mul_epu32(a, b);
+        __m128i odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+        return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                                  _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+    }
+
+    // One RGBA pixel widened to four 32 bit lanes
+    inline __m128i load_pixel_4ch(const U8* pix)
+    {
+        U32 packed;
+        memcpy(&packed, pix, sizeof(packed));
+        const __m128i zero = _mm_setzero_si128();
+        return _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero), zero);
+    }
+
+    // pixel * weight for weights up to 1 << 14, madd keeps it in one op
+    inline __m128i mul_pixel_4ch(const U8* pix, S32 weight)
+    {
+        return _mm_madd_epi16(load_pixel_4ch(pix), _mm_set1_epi32(weight));
+    }
+
+    inline void store_pixel_4ch(U8* dptr, __m128i comp)
+    {
+        comp = _mm_and_si128(comp, _mm_set1_epi32(0xff));
+        comp = _mm_packs_epi32(comp, comp);
+        comp = _mm_packus_epi16(comp, comp);
+        U32 packed = _mm_cvtsi128_si32(comp);
+        memcpy(dptr, &packed, sizeof(packed));
+    }
+
+    // Horizontal run of one source row, the cx accumulation of the scalar
+    // scale down loop
+    inline __m128i accumulate_row_4ch(const U8* pix, S32 xap, S32 Cx)
+    {
+        __m128i cx = mul_pixel_4ch(pix, xap);
+        pix += 4;
+        S32 i;
+        for (i = (1 << 14) - xap; i > Cx; i -= Cx)
+        {
+            cx = _mm_add_epi32(cx, mul_pixel_4ch(pix, Cx));
+            pix += 4;
+        }
+        if (i > 0)
+        {
+            cx = _mm_add_epi32(cx, mul_pixel_4ch(pix, i));
+        }
+        return cx;
+    }
+
+    // fastFractionalMult() on eight 16 bit lanes
+    inline __m128i fractional_mult_epi16(__m128i a, __m128i b)
+    {
+        __m128i i = _mm_add_epi16(_mm_mullo_epi16(a, b), _mm_set1_epi16(128));
+        return _mm_srli_epi16(_mm_add_epi16(i, _mm_srli_epi16(i, 8)), 8);
+    }
+}
+
 template<U8 ch>
 inline void bilinear_scale(
     const U8 *src, U32 srcW, U32 srcH, U32 srcStride
@@ -460,6 +535,45 @@ inline void bilinear_scale(
     }
     else
     { //scale x/y - down
+        if constexpr (ch == 4)
+        {
+            if (LLImageRaw::sUseSIMDKernels)
+            {
+                // Same as below with the four channels of a pixel in one register
+                for (y = 0; y < dstH; y++)
+                {
+                    const S32 Cy = info.yapoints[y] >> 16;
+                    const S32 yap = info.yapoints[y] & 0xffff;
+
+                    dptr = dst + (y * dstStride);
+                    for (x = 0; x < dstW; x++)
+                    {
+                        const S32 Cx = info.xapoints[x] >> 16;
+                        const S32 xap = info.xapoints[x] & 0xffff;
+
+                        sptr = info.ystrides[y] + info.xpoints[x] * ch;
+                        __m128i comp = mullo_epi32_sse2(_mm_srli_epi32(accumulate_row_4ch(sptr, xap, Cx), 5), _mm_set1_epi32(yap));
+                        sptr += srcStride;
+
+                        S32 j;
+                        for (j = (1 << 14) - yap; j > Cy; j -= Cy)
+                        {
+                            comp = _mm_add_epi32(comp, mullo_epi32_sse2(_mm_srli_epi32(accumulate_row_4ch(sptr, xap, Cx), 5), _mm_set1_epi32(Cy)));
+                            sptr += srcStride;
+                        }
+                        if (j > 0)
+                        {
+                            comp = _mm_add_epi32(comp, mullo_epi32_sse2(_mm_srli_epi32(accumulate_row_4ch(sptr, xap, Cx), 5), _mm_set1_epi32(j)));
+                        }
+
+                        store_pixel_4ch(dptr, _mm_srli_epi32(comp, 23));
+                        dptr += ch;
+                    }
+                }
+                return;
+            }
+        }
+
         S32 Cx, Cy, i, j;
         S32 xap, yap;
 
@@ -814,6 +928,7 @@ U32 LLImageBase::getAllocationErrors()
 //---------------------------------------------------------------------------
 
 S32 LLImageRaw::sRawImageCount = 0;
+bool LLImageRaw::sUseSIMDKernels = true;
 
 LLImageRaw::LLImageRaw()
     : LLImageBase()
@@ -1303,6 +1418,47 @@ void LLImageRaw::compositeUnscaled4onto3( const LLImageRaw* src )
         return;
     }
     // </FS:Beq>
+    if (sUseSIMDKernels)
+    {
+        // The blend below gives the same result as the copy and skip
+        // branches at alpha 255 and 0, so four pixels can go through it
+        // unconditionally. Runs of fully transparent pixels are skipped.
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i alpha_mask = _mm_set1_epi32(0xff000000);
+        for (; pixels >= 4; pixels -= 4, src_data += 16, dst_data += 12)
+        {
+            __m128i src = _mm_loadu_si128((const __m128i*)src_data);
+            if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(src, alpha_mask), zero)) == 0xffff)
+            {
+                continue;
+            }
+            U32 dst_pixels[4];
+            for (S32 i = 0; i < 4; ++i)
+            {
+                dst_pixels[i] = dst_data[i * 3] | (dst_data[i * 3 + 1] << 8) | (dst_data[i * 3 + 2] << 16);
+            }
+            __m128i dst = _mm_loadu_si128((const __m128i*)dst_pixels);
+
+            // alpha and 255 - alpha in every channel
+            __m128i alpha = _mm_srli_epi32(src, 24);
+            alpha = _mm_or_si128(alpha, _mm_slli_epi32(alpha, 8));
+            alpha = _mm_or_si128(alpha, _mm_slli_epi32(alpha, 16));
+            __m128i transparency = _mm_xor_si128(alpha, _mm_set1_epi8((char)0xff));
+
+            const __m128i byte_mask = _mm_set1_epi16(0xff);
+            __m128i lo = _mm_add_epi16(fractional_mult_epi16(_mm_unpacklo_epi8(dst, zero), _mm_unpacklo_epi8(transparency, zero)),
+                                       fractional_mult_epi16(_mm_unpacklo_epi8(src, zero), _mm_unpacklo_epi8(alpha, zero)));
+            __m128i hi = _mm_add_epi16(fractional_mult_epi16(_mm_unpackhi_epi8(dst, zero), _mm_unpackhi_epi8(transparency, zero)),
+                                       fractional_mult_epi16(_mm_unpackhi_epi8(src, zero), _mm_unpackhi_epi8(alpha, zero)));
+            _mm_storeu_si128((__m128i*)dst_pixels, _mm_packus_epi16(_mm_and_si128(lo, byte_mask), _mm_and_si128(hi, byte_mask)));
+            for (S32 i = 0; i < 4; ++i)
+            {
+                dst_data[i * 3] = (U8)dst_pixels[i];
+                dst_data[i * 3 + 1] = (U8)(dst_pixels[i] >> 8);
+                dst_data[i * 3 + 2] = (U8)(dst_pixels[i] >> 16);
+            }
+        }
+    }
     while( pixels-- )
     {
         U8 alpha = src_data[3];
@@ -1538,6 +1694,19 @@ void LLImageRaw::copyUnscaled4onto3( const LLImageRaw* src )
     S32 pixels = getWidth() * getHeight();
     const U8* src_data = src->getData();
     U8* dst_data = dst->getData();
+#if defined(__AVX2__)
+    if (sUseSIMDKernels)
+    {
+        const __m128i drop_alpha = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+        for (; pixels >= 4; pixels -= 4, src_data += 16, dst_data += 12)
+        {
+            __m128i rgb = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)src_data), drop_alpha);
+            _mm_storel_epi64((__m128i*)dst_data, rgb);
+            U32 tail = _mm_cvtsi128_si32(_mm_srli_si128(rgb, 8));
+            memcpy(dst_data + 8, &tail, sizeof(tail));
+        }
+    }
+#endif
     for( S32 i=0; i<pixels; i++ )
     {
         dst_data[0] = src_data[0];
@@ -1563,6 +1732,19 @@ void LLImageRaw::copyUnscaled3onto4( const LLImageRaw* src )
     S32 pixels = getWidth() * getHeight();
     const U8* src_data = src->getData();
     U8* dst_data = dst->getData();
+#if defined(__AVX2__)
+    if (sUseSIMDKernels)
+    {
+        // Loads 16 bytes for 12, so stop while there are 6 pixels left
+        const __m128i add_alpha = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+        const __m128i opaque = _mm_set1_epi32(0xff000000);
+        for (; pixels >= 6; pixels -= 4, src_data += 12, dst_data += 16)
+        {
+            __m128i rgba = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)src_data), add_alpha);
+            _mm_storeu_si128((__m128i*)dst_data, _mm_or_si128(rgba, opaque));
+        }
+    }
+#endif
     for( S32 i=0; i<pixels; i++ )
     {
         dst_data[0] = src_data[0];
@@ -2005,6 +2187,40 @@ void LLImageRaw::addEmissiveUnscaled(LLImageRaw* src)
 
     U8* const src_data = src->getData();
     U8* const dst_data = dst->getData();
+    if (sUseSIMDKernels && src->getComponents() == dst->getComponents())
+    {
+        // Same layout, so this is a saturating add over the whole buffer.
+        // With 4 components the source alpha is masked out so the
+        // destination keeps its own.
+        const S32 bytes = dst->getWidth() * dst->getHeight() * dst->getComponents();
+        const U32 alpha_mask = dst->getComponents() == 4 ? 0x00ffffff : 0xffffffff;
+        S32 i = 0;
+#if defined(__AVX2__)
+        const __m256i mask256 = _mm256_set1_epi32(alpha_mask);
+        for (; i + 32 <= bytes; i += 32)
+        {
+            __m256i sum = _mm256_adds_epu8(_mm256_loadu_si256((const __m256i*)(dst_data + i)),
+                                           _mm256_and_si256(_mm256_loadu_si256((const __m256i*)(src_data + i)), mask256));
+            _mm256_storeu_si256((__m256i*)(dst_data + i), sum);
+        }
+#endif
+        const __m128i mask = _mm_set1_epi32(alpha_mask);
+        for (; i + 16 <= bytes; i += 16)
+        {
+            __m128i sum = _mm_adds_epu8(_mm_loadu_si128((const __m128i*)(dst_data + i)),
+                                        _mm_and_si128(_mm_loadu_si128((const __m128i*)(src_data + i)), mask));
+            _mm_storeu_si128((__m128i*)(dst_data + i), sum);
+        }
+        const S32 components = dst->getComponents();
+        for (; i < bytes; ++i)
+        {
+            if (components != 4 || (i & 3) != 3)
+            {
+                dst_data[i] = llmin(255, dst_data[i] + src_data[i]);
+            }
+        }
+        return;
+    }
     for(S32 y = 0; y < dst->getHeight(); ++y)
     {
         const S32 src_row_offset = src->getComponents() * src->getWidth() * y;
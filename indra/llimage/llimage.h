@@ -318,6 +318,10 @@ protected:
 
 public:
     static S32 sRawImageCount;
+    // Use the SSE2 (and, when built for it, AVX2) kernels for scaling,
+    // compositing and channel conversion. Results are identical to the
+    // scalar code, which is only selected to compare against it.
+    static bool sUseSIMDKernels;
     // <FS:Techwolf Lupindo> texture comment metadata reader
     std::string mComment;
     // </FS:Techwolf Lupindo>
@@ -35,23 +35,57 @@
 #include "v3math.h"
 #include "llsdserialize.h"
 #include "llstring.h"
+#include "workexecutor.h"
+
+#include <array>
+
+//---------------------------------------------------------------------------
+// Bands of rows run on the shared WorkExecutor
+//---------------------------------------------------------------------------
+
+namespace
+{
+    // Below this many rows per band, handing work to another thread costs
+    // more than it saves
+    constexpr S32 MIN_ROWS_PER_BAND = 32;
+
+    // [begin, end) rows of each band
+    std::vector<std::pair<S32, S32>> split_rows(S32 height)
+    {
+        S32 count = 1;
+        if (LLImageFilter::sUseTiledExecution)
+        {
+            count = llclamp(height / MIN_ROWS_PER_BAND, 1, (S32)LL::WorkExecutor::getShared().getWidth() + 1);
+        }
+        std::vector<std::pair<S32, S32>> bands;
+        for (S32 k = 0; k < count; ++k)
+        {
+            bands.emplace_back(height * k / count, height * (k + 1) / count);
+        }
+        return bands;
+    }
+
+    // Run func(0) .. func(count - 1), on the executor and the calling thread,
+    // and return once all of them are done
+    void run_bands(S32 count, const std::function<void(S32)>& func)
+    {
+        LL::WorkExecutor::getShared().forEach(count, [&func](size_t k) { func((S32)k); });
+    }
+}
 
 //---------------------------------------------------------------------------
 // LLImageFilter
 //---------------------------------------------------------------------------
 
+bool LLImageFilter::sUseTiledExecution = true;
+
 LLImageFilter::LLImageFilter(const std::string& file_path) :
     mFilterData(LLSD::emptyArray()),
     mImage(NULL),
     mHistoRed(NULL),
     mHistoGreen(NULL),
     mHistoBlue(NULL),
-    mHistoBrightness(NULL),
-    mStencilBlendMode(STENCIL_BLEND_MODE_BLEND),
-    mStencilShape(STENCIL_SHAPE_UNIFORM),
-    mStencilGamma(1.0),
-    mStencilMin(0.0),
-    mStencilMax(1.0)
+    mHistoBrightness(NULL)
 {
     // Load filter description from file
     llifstream filter_xml(file_path.c_str());
@@ -271,16 +305,17 @@ void LLImageFilter::executeFilter(LLPointer<LLImageRaw> raw_image)
             LL_WARNS() << "Filter unknown, cannot execute filter command : " << filter_name << LL_ENDL;
         }
     }
+    flushRowOps();
 }
 
 //============================================================================
 // Filter Primitives
 //============================================================================
 
-void LLImageFilter::blendStencil(F32 alpha, U8* pixel, U8 red, U8 green, U8 blue)
+void LLImageFilter::Stencil::blend(F32 alpha, U8* pixel, U8 red, U8 green, U8 blue) const
 {
     F32 inv_alpha = 1.0f - alpha;
-    switch (mStencilBlendMode)
+    switch (mBlendMode)
     {
         case STENCIL_BLEND_MODE_BLEND:
             // Classic blend of incoming color with the background image
@@ -309,24 +344,60 @@ void LLImageFilter::blendStencil(F32 alpha, U8* pixel, U8 red, U8 green, U8 blue
     }
 }
 
+void LLImageFilter::queueRowOp(row_op_t op)
+{
+    mRowOps.push_back(std::move(op));
+    if (!sUseTiledExecution)
+    {
+        flushRowOps();
+    }
+}
+
+void LLImageFilter::flushRowOps()
+{
+    if (mRowOps.empty())
+    {
+        return;
+    }
+
+    const S32 row_bytes = mImage->getWidth() * mImage->getComponents();
+    U8* data = mImage->getData();
+    const auto bands = split_rows(mImage->getHeight());
+    run_bands((S32)bands.size(), [&](S32 k)
+    {
+        // Every queued step on a row while it is in cache
+        for (S32 j = bands[k].first; j < bands[k].second; j++)
+        {
+            for (const row_op_t& op : mRowOps)
+            {
+                op(data + j * row_bytes, j);
+            }
+        }
+    });
+    mRowOps.clear();
+}
+
 void LLImageFilter::colorCorrect(const U8* lut_red, const U8* lut_green, const U8* lut_blue)
 {
     const S32 components = mImage->getComponents();
     llassert( components >= 1 && components <= 4 );
 
     S32 width  = mImage->getWidth();
-    S32 height = mImage->getHeight();
 
-    U8* dst_data = mImage->getData();
-    for (S32 j = 0; j < height; j++)
+    std::array<U8, 256> red, green, blue;
+    std::copy(lut_red, lut_red + 256, red.begin());
+    std::copy(lut_green, lut_green + 256, green.begin());
+    std::copy(lut_blue, lut_blue + 256, blue.begin());
+
+    queueRowOp([=, stencil = mStencil](U8* dst_data, S32 j)
     {
         for (S32 i = 0; i < width; i++)
         {
             // Blend LUT value
-            blendStencil(getStencilAlpha(i,j), dst_data, lut_red[dst_data[VRED]], lut_green[dst_data[VGREEN]], lut_blue[dst_data[VBLUE]]);
+            stencil.blend(stencil.getAlpha(i,j), dst_data, red[dst_data[VRED]], green[dst_data[VGREEN]], blue[dst_data[VBLUE]]);
             dst_data += components;
         }
-    }
+    });
 }
 
 void LLImageFilter::colorTransform(const LLMatrix3 &transform)
@@ -335,10 +406,8 @@ void LLImageFilter::colorTransform(const LLMatrix3 &transform)
     llassert( components >= 1 && components <= 4 );
 
     S32 width  = mImage->getWidth();
-    S32 height = mImage->getHeight();
 
-    U8* dst_data = mImage->getData();
-    for (S32 j = 0; j < height; j++)
+    queueRowOp([=, stencil = mStencil](U8* dst_data, S32 j)
     {
         for (S32 i = 0; i < width; i++)
         {
@@ -348,10 +417,10 @@ void LLImageFilter::colorTransform(const LLMatrix3 &transform)
             dst.clamp(0.0f,255.0f);
 
             // Blend result
-            blendStencil(getStencilAlpha(i,j), dst_data, (U8)dst.mV[VRED], (U8)dst.mV[VGREEN], (U8)dst.mV[VBLUE]);
+            stencil.blend(stencil.getAlpha(i,j), dst_data, (U8)dst.mV[VRED], (U8)dst.mV[VGREEN], (U8)dst.mV[VBLUE]);
             dst_data += components;
         }
-    }
+    });
 }
 
 void LLImageFilter::convolve(const LLMatrix3 &kernel, bool normalize, bool abs_value)
@@ -359,6 +428,9 @@ void LLImageFilter::convolve(const LLMatrix3 &kernel, bool normalize, bool abs_v
     const S32 components = mImage->getComponents();
     llassert( components >= 1 && components <= 4 );
 
+    // Needs the neighbouring pixels as left by the previous steps
+    flushRowOps();
+
     // Compute normalization factors
     F32 kernel_min = 0.0;
     F32 kernel_max = 0.0;
@@ -381,114 +453,123 @@ void LLImageFilter::convolve(const LLMatrix3 &kernel, bool normalize, bool abs_v
     }
     F32 kernel_range = kernel_max - kernel_min;
 
-    // Allocate temporary buffers and initialize algorithm's data
     S32 width  = mImage->getWidth();
     S32 height = mImage->getHeight();
 
-    U8* dst_data = mImage->getData();
+    U8* data = mImage->getData();
 
     S32 buffer_size = width * components;
     llassert_always(buffer_size > 0);
-    std::vector<U8> even_buffer(buffer_size);
-    std::vector<U8> odd_buffer(buffer_size);
 
-    U8* south_data = dst_data + buffer_size;
-    U8* east_west_data;
-    U8* north_data;
-
-    // Line 0 : we set the line to 0 (debatable)
-    memcpy( &even_buffer[0], dst_data, buffer_size );   /* Flawfinder: ignore */
-    for (S32 i = 0; i < width; i++)
+    // Bands are filtered in place at the same time, so the rows just outside
+    // each band are saved first: the band next door may change them before
+    // they are read.
+    const auto bands = split_rows(height);
+    std::vector<std::vector<U8>> halo_north(bands.size()), halo_south(bands.size());
+    for (size_t k = 0; k < bands.size(); k++)
     {
-        blendStencil(getStencilAlpha(i,0), dst_data, 0, 0, 0);
-        dst_data += components;
+        if (bands[k].first > 0)
+        {
+            halo_north[k].assign(data + (bands[k].first - 1) * buffer_size, data + bands[k].first * buffer_size);
+        }
+        if (bands[k].second < height)
+        {
+            halo_south[k].assign(data + bands[k].second * buffer_size, data + (bands[k].second + 1) * buffer_size);
+        }
     }
-    south_data += buffer_size;
 
-    // All other lines
-    for (S32 j = 1; j < (height-1); j++)
+    const Stencil& stencil = mStencil;
+    run_bands((S32)bands.size(), [&](S32 k)
     {
-        // We need to buffer 2 lines. We flip north and east-west (current) to avoid moving too much memory around
-        if (j % 2)
+        // We need to buffer 2 lines: the original north and current lines. South is still untouched in the image.
+        std::vector<U8> north_buffer(buffer_size);
+        std::vector<U8> east_west_buffer(buffer_size);
+        if (!halo_north[k].empty())
         {
-            memcpy( &odd_buffer[0], dst_data, buffer_size );    /* Flawfinder: ignore */
-            east_west_data = &odd_buffer[0];
-            north_data = &even_buffer[0];
+            north_buffer = halo_north[k];
         }
-        else
+
+        for (S32 j = bands[k].first; j < bands[k].second; j++)
         {
-            memcpy( &even_buffer[0], dst_data, buffer_size );   /* Flawfinder: ignore */
-            east_west_data = &even_buffer[0];
-            north_data = &odd_buffer[0];
-        }
-        // First pixel : set to 0
-        blendStencil(getStencilAlpha(0,j), dst_data, 0, 0, 0);
-        dst_data += components;
-        // Set pointers to kernel
-        U8* NW = north_data;
-        U8* N = NW+components;
-        U8* NE = N+components;
-        U8* W = east_west_data;
-        U8* C = W+components;
-        U8* E = C+components;
-        U8* SW = south_data;
-        U8* S = SW+components;
-        U8* SE = S+components;
-        // All other pixels
-        for (S32 i = 1; i < (width-1); i++)
-        {
-            // Compute convolution
-            LLVector3 dst;
-            dst.mV[VRED] = (kernel.mMatrix[0][0]*NW[VRED] + kernel.mMatrix[0][1]*N[VRED] + kernel.mMatrix[0][2]*NE[VRED] +
-                            kernel.mMatrix[1][0]*W[VRED]  + kernel.mMatrix[1][1]*C[VRED] + kernel.mMatrix[1][2]*E[VRED] +
-                            kernel.mMatrix[2][0]*SW[VRED] + kernel.mMatrix[2][1]*S[VRED] + kernel.mMatrix[2][2]*SE[VRED]);
-            dst.mV[VGREEN] = (kernel.mMatrix[0][0]*NW[VGREEN] + kernel.mMatrix[0][1]*N[VGREEN] + kernel.mMatrix[0][2]*NE[VGREEN] +
-                              kernel.mMatrix[1][0]*W[VGREEN]  + kernel.mMatrix[1][1]*C[VGREEN] + kernel.mMatrix[1][2]*E[VGREEN] +
-                              kernel.mMatrix[2][0]*SW[VGREEN] + kernel.mMatrix[2][1]*S[VGREEN] + kernel.mMatrix[2][2]*SE[VGREEN]);
-            dst.mV[VBLUE] = (kernel.mMatrix[0][0]*NW[VBLUE] + kernel.mMatrix[0][1]*N[VBLUE] + kernel.mMatrix[0][2]*NE[VBLUE] +
-                             kernel.mMatrix[1][0]*W[VBLUE]  + kernel.mMatrix[1][1]*C[VBLUE] + kernel.mMatrix[1][2]*E[VBLUE] +
-                             kernel.mMatrix[2][0]*SW[VBLUE] + kernel.mMatrix[2][1]*S[VBLUE] + kernel.mMatrix[2][2]*SE[VBLUE]);
-            if (abs_value)
-            {
-                dst.mV[VRED]   = llabs(dst.mV[VRED]);
-                dst.mV[VGREEN] = llabs(dst.mV[VGREEN]);
-                dst.mV[VBLUE]  = llabs(dst.mV[VBLUE]);
-            }
-            if (normalize)
+            U8* dst_data = data + j * buffer_size;
+            if (j == 0 || j == height - 1)
             {
-                dst.mV[VRED]   = (dst.mV[VRED] - kernel_min)/kernel_range;
-                dst.mV[VGREEN] = (dst.mV[VGREEN] - kernel_min)/kernel_range;
-                dst.mV[VBLUE]  = (dst.mV[VBLUE] - kernel_min)/kernel_range;
+                // First and last lines : we set the line to 0 (debatable)
+                memcpy( &north_buffer[0], dst_data, buffer_size );  /* Flawfinder: ignore */
+                for (S32 i = 0; i < width; i++)
+                {
+                    stencil.blend(stencil.getAlpha(i,0), dst_data, 0, 0, 0);
+                    dst_data += components;
+                }
+                continue;
             }
-            dst.clamp(0.0f,255.0f);
 
-            // Blend result
-            blendStencil(getStencilAlpha(i,j), dst_data, (U8)dst.mV[VRED], (U8)dst.mV[VGREEN], (U8)dst.mV[VBLUE]);
+            memcpy( &east_west_buffer[0], dst_data, buffer_size );  /* Flawfinder: ignore */
+            U8* south_data = (j + 1 == bands[k].second) ? &halo_south[k][0] : dst_data + buffer_size;
 
-            // Next pixel
+            // First pixel : set to 0
+            stencil.blend(stencil.getAlpha(0,j), dst_data, 0, 0, 0);
             dst_data += components;
-            NW += components;
-            N += components;
-            NE += components;
-            W += components;
-            C += components;
-            E += components;
-            SW += components;
-            S += components;
-            SE += components;
-        }
-        // Last pixel : set to 0
-        blendStencil(getStencilAlpha(width-1,j), dst_data, 0, 0, 0);
-        dst_data += components;
-        south_data += buffer_size;
-    }
+            // Set pointers to kernel
+            U8* NW = &north_buffer[0];
+            U8* N = NW+components;
+            U8* NE = N+components;
+            U8* W = &east_west_buffer[0];
+            U8* C = W+components;
+            U8* E = C+components;
+            U8* SW = south_data;
+            U8* S = SW+components;
+            U8* SE = S+components;
+            // All other pixels
+            for (S32 i = 1; i < (width-1); i++)
+            {
+                // Compute convolution
+                LLVector3 dst;
+                dst.mV[VRED] = (kernel.mMatrix[0][0]*NW[VRED] + kernel.mMatrix[0][1]*N[VRED] + kernel.mMatrix[0][2]*NE[VRED] +
+                                kernel.mMatrix[1][0]*W[VRED]  + kernel.mMatrix[1][1]*C[VRED] + kernel.mMatrix[1][2]*E[VRED] +
+                                kernel.mMatrix[2][0]*SW[VRED] + kernel.mMatrix[2][1]*S[VRED] + kernel.mMatrix[2][2]*SE[VRED]);
+                dst.mV[VGREEN] = (kernel.mMatrix[0][0]*NW[VGREEN] + kernel.mMatrix[0][1]*N[VGREEN] + kernel.mMatrix[0][2]*NE[VGREEN] +
+                                  kernel.mMatrix[1][0]*W[VGREEN]  + kernel.mMatrix[1][1]*C[VGREEN] + kernel.mMatrix[1][2]*E[VGREEN] +
+                                  kernel.mMatrix[2][0]*SW[VGREEN] + kernel.mMatrix[2][1]*S[VGREEN] + kernel.mMatrix[2][2]*SE[VGREEN]);
+                dst.mV[VBLUE] = (kernel.mMatrix[0][0]*NW[VBLUE] + kernel.mMatrix[0][1]*N[VBLUE] + kernel.mMatrix[0][2]*NE[VBLUE] +
+                                 kernel.mMatrix[1][0]*W[VBLUE]  + kernel.mMatrix[1][1]*C[VBLUE] + kernel.mMatrix[1][2]*E[VBLUE] +
+                                 kernel.mMatrix[2][0]*SW[VBLUE] + kernel.mMatrix[2][1]*S[VBLUE] + kernel.mMatrix[2][2]*SE[VBLUE]);
+                if (abs_value)
+                {
+                    dst.mV[VRED]   = llabs(dst.mV[VRED]);
+                    dst.mV[VGREEN] = llabs(dst.mV[VGREEN]);
+                    dst.mV[VBLUE]  = llabs(dst.mV[VBLUE]);
+                }
+                if (normalize)
+                {
+                    dst.mV[VRED]   = (dst.mV[VRED] - kernel_min)/kernel_range;
+                    dst.mV[VGREEN] = (dst.mV[VGREEN] - kernel_min)/kernel_range;
+                    dst.mV[VBLUE]  = (dst.mV[VBLUE] - kernel_min)/kernel_range;
+                }
+                dst.clamp(0.0f,255.0f);
+
+                // Blend result
+                stencil.blend(stencil.getAlpha(i,j), dst_data, (U8)dst.mV[VRED], (U8)dst.mV[VGREEN], (U8)dst.mV[VBLUE]);
+
+                // Next pixel
+                dst_data += components;
+                NW += components;
+                N += components;
+                NE += components;
+                W += components;
+                C += components;
+                E += components;
+                SW += components;
+                S += components;
+                SE += components;
+            }
+            // Last pixel : set to 0
+            stencil.blend(stencil.getAlpha(width-1,j), dst_data, 0, 0, 0);
 
-    // Last line
-    for (S32 i = 0; i < width; i++)
-    {
-        blendStencil(getStencilAlpha(i,0), dst_data, 0, 0, 0);
-        dst_data += components;
-    }
+            // The current line is the north line of the next one
+            north_buffer.swap(east_west_buffer);
+        }
+    });
 }
 
 void LLImageFilter::filterScreen(EScreenMode mode, const F32 wave_length, const F32 angle)
@@ -504,15 +585,14 @@ void LLImageFilter::filterScreen(EScreenMode mode, const F32 wave_length, const
     F32 cos = cosf(angle*DEG_TO_RAD);
 
     // Precompute the gamma table : gives us the gray level to use when cutting outside the screen (prevents strong aliasing on the screen)
-    U8 gamma[256];
+    std::array<U8, 256> gamma;
     for (S32 i = 0; i < 256; i++)
     {
         F32 gamma_i = llclampf((float)(powf((float)(i)/255.0f,1.0f/4.0f)));
         gamma[i] = (U8)(255.0 * gamma_i);
     }
 
-    U8* dst_data = mImage->getData();
-    for (S32 j = 0; j < height; j++)
+    queueRowOp([=, stencil = mStencil](U8* dst_data, S32 j)
     {
         for (S32 i = 0; i < width; i++)
         {
@@ -535,10 +615,10 @@ void LLImageFilter::filterScreen(EScreenMode mode, const F32 wave_length, const
             U8 dst_value = (dst_data[VRED] >= (U8)(value) ? gamma[dst_data[VRED] - (U8)(value)] : 0);
 
             // Blend result
-            blendStencil(getStencilAlpha(i,j), dst_data, dst_value, dst_value, dst_value);
+            stencil.blend(stencil.getAlpha(i,j), dst_data, dst_value, dst_value, dst_value);
             dst_data += components;
         }
-    }
+    });
 }
 
 //============================================================================
@@ -546,55 +626,55 @@ void LLImageFilter::filterScreen(EScreenMode mode, const F32 wave_length, const
 //============================================================================
 void LLImageFilter::setStencil(EStencilShape shape, EStencilBlendMode mode, F32 min, F32 max, F32* params)
 {
-    mStencilShape = shape;
-    mStencilBlendMode = mode;
-    mStencilMin = llmin(llmax(min, -1.0f), 1.0f);
-    mStencilMax = llmin(llmax(max, -1.0f), 1.0f);
+    mStencil.mShape = shape;
+    mStencil.mBlendMode = mode;
+    mStencil.mMin = llmin(llmax(min, -1.0f), 1.0f);
+    mStencil.mMax = llmin(llmax(max, -1.0f), 1.0f);
 
     // Each shape will interpret the 4 params differenly.
     // We compute each systematically, though, clearly, values are meaningless when the shape doesn't correspond to the parameters
-    mStencilCenterX = (S32)(mImage->getWidth()  + params[0] * (F32)(mImage->getHeight()))/2;
-    mStencilCenterY = (S32)(mImage->getHeight() + params[1] * (F32)(mImage->getHeight()))/2;
-    mStencilWidth = (S32)(params[2] * (F32)(mImage->getHeight()))/2;
-    mStencilGamma = (params[3] <= 0.0f ? 1.0f : params[3]);
+    mStencil.mCenterX = (S32)(mImage->getWidth()  + params[0] * (F32)(mImage->getHeight()))/2;
+    mStencil.mCenterY = (S32)(mImage->getHeight() + params[1] * (F32)(mImage->getHeight()))/2;
+    mStencil.mWidth = (S32)(params[2] * (F32)(mImage->getHeight()))/2;
+    mStencil.mGamma = (params[3] <= 0.0f ? 1.0f : params[3]);
 
-    mStencilWavelength = (params[0] <= 0.0f ? 10.0f : params[0] * (F32)(mImage->getHeight()) / 2.0f);
-    mStencilSine   = sinf(params[1]*DEG_TO_RAD);
-    mStencilCosine = cosf(params[1]*DEG_TO_RAD);
+    mStencil.mWavelength = (params[0] <= 0.0f ? 10.0f : params[0] * (F32)(mImage->getHeight()) / 2.0f);
+    mStencil.mSine   = sinf(params[1]*DEG_TO_RAD);
+    mStencil.mCosine = cosf(params[1]*DEG_TO_RAD);
 
-    mStencilStartX = ((F32)(mImage->getWidth())  + params[0] * (F32)(mImage->getHeight()))/2.0f;
-    mStencilStartY = ((F32)(mImage->getHeight()) + params[1] * (F32)(mImage->getHeight()))/2.0f;
+    mStencil.mStartX = ((F32)(mImage->getWidth())  + params[0] * (F32)(mImage->getHeight()))/2.0f;
+    mStencil.mStartY = ((F32)(mImage->getHeight()) + params[1] * (F32)(mImage->getHeight()))/2.0f;
     F32 end_x      = ((F32)(mImage->getWidth())  + params[2] * (F32)(mImage->getHeight()))/2.0f;
     F32 end_y      = ((F32)(mImage->getHeight()) + params[3] * (F32)(mImage->getHeight()))/2.0f;
-    mStencilGradX  = end_x - mStencilStartX;
-    mStencilGradY  = end_y - mStencilStartY;
-    mStencilGradN  = mStencilGradX*mStencilGradX + mStencilGradY*mStencilGradY;
+    mStencil.mGradX  = end_x - mStencil.mStartX;
+    mStencil.mGradY  = end_y - mStencil.mStartY;
+    mStencil.mGradN  = mStencil.mGradX*mStencil.mGradX + mStencil.mGradY*mStencil.mGradY;
 }
 
-F32 LLImageFilter::getStencilAlpha(S32 i, S32 j)
+F32 LLImageFilter::Stencil::getAlpha(S32 i, S32 j) const
 {
     F32 alpha = 1.0;    // That init actually takes care of the STENCIL_SHAPE_UNIFORM case...
-    if (mStencilShape == STENCIL_SHAPE_VIGNETTE)
+    if (mShape == STENCIL_SHAPE_VIGNETTE)
     {
         // alpha is a modified gaussian value, with a center and fading in a circular pattern toward the edges
         // The gamma parameter controls the intensity of the drop down from alpha 1.0 (center) to 0.0
-        F32 d_center_square = (F32)((i - mStencilCenterX)*(i - mStencilCenterX) + (j - mStencilCenterY)*(j - mStencilCenterY));
-        alpha = powf(F_E, -(powf((d_center_square/(mStencilWidth*mStencilWidth)),mStencilGamma)/2.0f));
+        F32 d_center_square = (F32)((i - mCenterX)*(i - mCenterX) + (j - mCenterY)*(j - mCenterY));
+        alpha = powf(F_E, -(powf((d_center_square/(mWidth*mWidth)),mGamma)/2.0f));
     }
-    else if (mStencilShape == STENCIL_SHAPE_SCAN_LINES)
+    else if (mShape == STENCIL_SHAPE_SCAN_LINES)
     {
         // alpha varies according to a squared sine function.
-        F32 d = mStencilSine*i - mStencilCosine*j;
-        alpha = (sinf(2*F_PI*d/mStencilWavelength) > 0.0f ? 1.0f : 0.0f);
+        F32 d = mSine*i - mCosine*j;
+        alpha = (sinf(2*F_PI*d/mWavelength) > 0.0f ? 1.0f : 0.0f);
     }
-    else if (mStencilShape == STENCIL_SHAPE_GRADIENT)
+    else if (mShape == STENCIL_SHAPE_GRADIENT)
     {
-        alpha = (((F32)(i) - mStencilStartX)*mStencilGradX + ((F32)(j) - mStencilStartY)*mStencilGradY) / mStencilGradN;
+        alpha = (((F32)(i) - mStartX)*mGradX + ((F32)(j) - mStartY)*mGradY) / mGradN;
         alpha = llclampf(alpha);
     }
 
     // We rescale alpha between min and max
-    return (mStencilMin + alpha * (mStencilMax - mStencilMin));
+    return (mMin + alpha * (mMax - mMin));
 }
 
 //============================================================================
@@ -605,6 +685,7 @@ U32* LLImageFilter::getBrightnessHistogram()
 {
     if (!mHistoBrightness)
     {
+        flushRowOps();
         computeHistograms();
     }
     return mHistoBrightness;
@@ -642,19 +723,39 @@ void LLImageFilter::computeHistograms()
         mHistoBrightness[i] = 0;
     }
 
-    // Compute them
-    S32 pixels = mImage->getWidth() * mImage->getHeight();
-    U8* dst_data = mImage->getData();
-    for (S32 i = 0; i < pixels; i++)
+    // Compute them, one set per band then summed up
+    const S32 width = mImage->getWidth();
+    const S32 row_bytes = width * components;
+    const U8* data = mImage->getData();
+    const auto bands = split_rows(mImage->getHeight());
+    std::vector<std::array<U32, 256 * 4>> band_histos(bands.size());
+    run_bands((S32)bands.size(), [&](S32 k)
+    {
+        std::array<U32, 256 * 4>& histo = band_histos[k];
+        histo.fill(0);
+        const U8* dst_data = data + bands[k].first * row_bytes;
+        const S32 pixels = width * (bands[k].second - bands[k].first);
+        for (S32 i = 0; i < pixels; i++)
+        {
+            histo[dst_data[VRED]]++;
+            histo[256 + dst_data[VGREEN]]++;
+            histo[512 + dst_data[VBLUE]]++;
+            // Note: this is a very simple shorthand for brightness but it's OK for our use
+            S32 brightness = ((S32)(dst_data[VRED]) + (S32)(dst_data[VGREEN]) + (S32)(dst_data[VBLUE])) / 3;
+            histo[768 + brightness]++;
+            // next pixel...
+            dst_data += components;
+        }
+    });
+    for (const auto& histo : band_histos)
     {
-        mHistoRed[dst_data[VRED]]++;
-        mHistoGreen[dst_data[VGREEN]]++;
-        mHistoBlue[dst_data[VBLUE]]++;
-        // Note: this is a very simple shorthand for brightness but it's OK for our use
-        S32 brightness = ((S32)(dst_data[VRED]) + (S32)(dst_data[VGREEN]) + (S32)(dst_data[VBLUE])) / 3;
-        mHistoBrightness[brightness]++;
-        // next pixel...
-        dst_data += components;
+        for (S32 i = 0; i < 256; i++)
+        {
+            mHistoRed[i] += histo[i];
+            mHistoGreen[i] += histo[256 + i];
+            mHistoBlue[i] += histo[512 + i];
+            mHistoBrightness[i] += histo[768 + i];
+        }
     }
 }
 
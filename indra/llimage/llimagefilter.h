@@ -30,6 +30,9 @@
 #include "llsd.h"
 #include "llimage.h"
 
+#include <functional>
+#include <vector>
+
 class LLImageRaw;
 class LLColor4U;
 class LLColor3;
@@ -69,7 +72,45 @@ public:
 
     void executeFilter(LLPointer<LLImageRaw> raw_image);
 
+    // Split the image into bands of rows run on the shared WorkExecutor,
+    // applying consecutive per pixel steps in a single sweep. When
+    // false, every step sweeps the whole image on the calling thread. The
+    // result is the same either way.
+    static bool sUseTiledExecution;
+
 private:
+    // Procedural stencil: how much of each step's result is blended into
+    // the image at every pixel. Copied into each queued row operation so a
+    // later "stencil" step doesn't change operations already queued.
+    struct Stencil
+    {
+        F32 getAlpha(S32 i, S32 j) const;
+        void blend(F32 alpha, U8* pixel, U8 red, U8 green, U8 blue) const;
+
+        EStencilBlendMode mBlendMode{ STENCIL_BLEND_MODE_BLEND };
+        EStencilShape mShape{ STENCIL_SHAPE_UNIFORM };
+        F32 mMin{ 0.f };
+        F32 mMax{ 1.f };
+
+        S32 mCenterX;
+        S32 mCenterY;
+        S32 mWidth;
+        F32 mGamma{ 1.f };
+
+        F32 mWavelength;
+        F32 mSine;
+        F32 mCosine;
+
+        F32 mStartX;
+        F32 mStartY;
+        F32 mGradX;
+        F32 mGradY;
+        F32 mGradN;
+    };
+
+    // Applied to one row of the image: (row data, row index)
+    typedef std::function<void(U8*, S32)> row_op_t;
+
     // Filter Operations : Transforms
     void filterGrayScale();                         // Convert to grayscale
     void filterSepia();                             // Convert to sepia
@@ -91,12 +132,15 @@ private:
     void colorTransform(const LLMatrix3 &transform);
     void colorCorrect(const U8* lut_red, const U8* lut_green, const U8* lut_blue);
     void filterScreen(EScreenMode mode, const F32 wave_length, const F32 angle);
-    void blendStencil(F32 alpha, U8* pixel, U8 red, U8 green, U8 blue);
     void convolve(const LLMatrix3 &kernel, bool normalize, bool abs_value);
 
+    // Per pixel steps are queued and applied together by flushRowOps()
+    // before anything that needs to see their result
+    void queueRowOp(row_op_t op);
+    void flushRowOps();
+
     // Procedural Stencils
     void setStencil(EStencilShape shape, EStencilBlendMode mode, F32 min, F32 max, F32* params);
-    F32 getStencilAlpha(S32 i, S32 j);
 
     // Histograms
     U32* getBrightnessHistogram();
@@ -111,26 +155,10 @@ private:
     U32 *mHistoBlue;
     U32 *mHistoBrightness;
 
+    std::vector<row_op_t> mRowOps;
+
     // Current Stencil Settings
-    EStencilBlendMode mStencilBlendMode;
-    EStencilShape mStencilShape;
-    F32 mStencilMin;
-    F32 mStencilMax;
-
-    S32 mStencilCenterX;
-    S32 mStencilCenterY;
-    S32 mStencilWidth;
-    F32 mStencilGamma;
-
-    F32 mStencilWavelength;
-    F32 mStencilSine;
-    F32 mStencilCosine;
-
-    F32 mStencilStartX;
-    F32 mStencilStartY;
-    F32 mStencilGradX;
-    F32 mStencilGradY;
-    F32 mStencilGradN;
+    Stencil mStencil;
 };
 
 
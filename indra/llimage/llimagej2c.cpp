@@ -218,6 +218,7 @@ bool LLImageJ2C::decodeChannels(LLImageRaw *raw_imagep, F32 decode_time, S32 fir
         {
             // The whole data stream is finally decompressed when res is returned as true
             tester->updateDecompressionStats(this->getDataSize(), raw_imagep->getDataSize()) ;
+            tester->updateDecompressionStats(mRawDiscardLevel, raw_imagep->getWidth() * raw_imagep->getHeight(), elapsed.getElapsedTimeF32()) ;
         }
     }
 
@@ -474,6 +475,12 @@ LLImageCompressionTester::LLImageCompressionTester() : LLMetricPerformanceTester
     addMetric("Volume Out Decompression (kB)");
     addMetric("Decompression Ratio (x:1)");
     addMetric("Perf Decompression (kB/s)");
+    for (S32 i = 0; i <= MAX_DISCARD_LEVEL; i++)
+    {
+        addMetric(llformat("Decompression ms/MP (discard %d)", i));
+        mTimeDecompressionAtDiscard[i] = 0.0f;
+        mPixelsDecompressionAtDiscard[i] = 0.0;
+    }
 
     addMetric("Time Compression (s)");
     addMetric("Volume In Compression (kB)");
@@ -538,6 +545,15 @@ void LLImageCompressionTester::outputTestRecord(LLSD *sd)
     (*sd)[currentLabel]["Volume Out Decompression (kB)"]= (LLSD::Real)totalkBOutDecompression;
     (*sd)[currentLabel]["Decompression Ratio (x:1)"]    = (LLSD::Real)decompressionRate;
     (*sd)[currentLabel]["Perf Decompression (kB/s)"]    = (LLSD::Real)decompressionPerf;
+    for (S32 i = 0; i <= MAX_DISCARD_LEVEL; i++)
+    {
+        F32 ms_per_megapixel = 0.0f;
+        if (mPixelsDecompressionAtDiscard[i] > 0.0)
+        {
+            ms_per_megapixel = (F32)(mTimeDecompressionAtDiscard[i] * 1000.0 / (mPixelsDecompressionAtDiscard[i] / 1000000.0));
+        }
+        (*sd)[currentLabel][llformat("Decompression ms/MP (discard %d)", i)] = (LLSD::Real)ms_per_megapixel;
+    }
 
     (*sd)[currentLabel]["Time Compression (s)"]         = (LLSD::Real)mTotalTimeCompression;
     (*sd)[currentLabel]["Volume In Compression (kB)"]   = (LLSD::Real)totalkBInCompression;
@@ -570,6 +586,15 @@ void LLImageCompressionTester::updateDecompressionStats(const F32 deltaTime)
     mTotalTimeDecompression += deltaTime;
 }
 
+void LLImageCompressionTester::updateDecompressionStats(const S32 discardLevel, const S32 pixels, const F32 deltaTime)
+{
+    if (discardLevel >= 0 && discardLevel <= MAX_DISCARD_LEVEL)
+    {
+        mTimeDecompressionAtDiscard[discardLevel] += deltaTime;
+        mPixelsDecompressionAtDiscard[discardLevel] += pixels;
+    }
+}
+
 void LLImageCompressionTester::updateDecompressionStats(const S32 bytesIn, const S32 bytesOut)
 {
     mTotalBytesInDecompression += bytesIn;
@@ -144,6 +144,7 @@ class LLImageCompressionTester : public LLMetricPerformanceTesterBasic
 
         void updateDecompressionStats(const F32 deltaTime) ;
         void updateDecompressionStats(const S32 bytesIn, const S32 bytesOut) ;
+        void updateDecompressionStats(const S32 discardLevel, const S32 pixels, const F32 deltaTime) ;
         void updateCompressionStats(const F32 deltaTime) ;
         void updateCompressionStats(const S32 bytesIn, const S32 bytesOut) ;
 
@@ -167,6 +168,11 @@ class LLImageCompressionTester : public LLMetricPerformanceTesterBasic
         F32 mTotalTimeDecompression;        // Total time spent in computing decompression
         F32 mTotalTimeCompression;          // Total time spent in computing compression
         F32 mRunTimeDecompression;          // Time in this run (we output every 5 sec in decompress)
+        //
+        // Per discard level
+        //
+        F32 mTimeDecompressionAtDiscard[MAX_DISCARD_LEVEL + 1];   // Time spent in successful decodes at each discard level
+        F64 mPixelsDecompressionAtDiscard[MAX_DISCARD_LEVEL + 1]; // Pixels produced by those decodes
     };
 
 #endif
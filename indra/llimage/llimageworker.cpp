@@ -67,8 +67,10 @@ private:
 LLImageDecodeThread::LLImageDecodeThread(bool /*threaded*/)
     : mDecodeCount(0)
 {
+    // Decoding is pure CPU work, share the executor's workers with the rest
+    // of the viewer rather than adding a thread per core of our own.
     mThreadPool.reset(new LL::ThreadPool("ImageDecode", 8));
-    mThreadPool->start();
+    mThreadPool->startOnExecutor(LL::WorkExecutor::PRIORITY_NORMAL);
 }
 
 //virtual
@@ -0,0 +1,260 @@
+/**
+ * @file llimage_test.cpp
+ * @brief LLImageRaw scaling, compositing and conversion test cases.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llimage.h"
+#include "../llimagefilter.h"
+
+#include "../test/lltut.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <functional>
+
+namespace
+{
+    LLPointer<LLImageRaw> random_image(S32 width, S32 height, S8 components, U32& seed)
+    {
+        LLPointer<LLImageRaw> image = new LLImageRaw(width, height, components);
+        U8* data = image->getData();
+        for (S32 i = 0; i < image->getDataSize(); ++i)
+        {
+            seed = seed * 1664525 + 1013904223;
+            data[i] = (U8)(seed >> 24);
+        }
+        return image;
+    }
+
+    // Alpha channel with the mix of fully transparent, opaque and partial
+    // pixels that baked layers have
+    void vary_alpha(LLImageRaw* image, U32& seed)
+    {
+        U8* data = image->getData();
+        for (S32 i = 3; i < image->getDataSize(); i += 4)
+        {
+            seed = seed * 1664525 + 1013904223;
+            U32 pick = seed >> 28;
+            data[i] = pick < 6 ? 0 : pick < 10 ? 255 : data[i];
+        }
+    }
+
+    bool same(const LLImageRaw* a, const LLImageRaw* b)
+    {
+        return a->getWidth() == b->getWidth() && a->getHeight() == b->getHeight() && a->getComponents() == b->getComponents()
+            && memcmp(a->getData(), b->getData(), a->getDataSize()) == 0;
+    }
+
+    // Run op on a copy of dst with the scalar code and with the SIMD code
+    bool matches_scalar(const LLImageRaw* dst, const std::function<void(LLImageRaw*)>& op)
+    {
+        LLPointer<LLImageRaw> scalar = new LLImageRaw(dst->getData(), dst->getWidth(), dst->getHeight(), dst->getComponents());
+        LLPointer<LLImageRaw> simd = new LLImageRaw(dst->getData(), dst->getWidth(), dst->getHeight(), dst->getComponents());
+        LLImageRaw::sUseSIMDKernels = false;
+        op(scalar);
+        LLImageRaw::sUseSIMDKernels = true;
+        op(simd);
+        return same(scalar, simd);
+    }
+
+    // The filter definitions shipped with the viewer
+    std::vector<std::string> bundled_filters()
+    {
+        std::vector<std::string> filters;
+        std::filesystem::path dir = std::filesystem::path(__FILE__).parent_path() / ".." / ".." / "newview" / "app_settings" / "filters";
+        std::error_code ec;
+        for (const auto& entry : std::filesystem::directory_iterator(dir, ec))
+        {
+            if (entry.path().extension() == ".xml")
+            {
+                filters.push_back(entry.path().string());
+            }
+        }
+        std::sort(filters.begin(), filters.end());
+        return filters;
+    }
+
+    F32 time_ms(S32 iterations, const std::function<void()>& op)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (S32 i = 0; i < iterations; ++i)
+        {
+            op();
+        }
+        return std::chrono::duration<F32, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+    }
+}
+
+namespace tut
+{
+    struct LLImageRawFixture
+    {
+        LLImageRawFixture() : mSeed(12345) {}
+        ~LLImageRawFixture()
+        {
+            LLImageRaw::sUseSIMDKernels = true;
+            LLImageFilter::sUseTiledExecution = true;
+        }
+
+        U32 mSeed;
+    };
+    typedef test_group<LLImageRawFixture> LLImageRawTest_factory;
+    typedef LLImageRawTest_factory::object LLImageRawTest_t;
+    LLImageRawTest_factory tf("LLImageRaw");
+
+    template<> template<>
+    void LLImageRawTest_t::test<1>()
+    {
+        set_test_name("scaling matches scalar output");
+
+        const S32 sizes[][4] = { { 1024, 1024, 512, 512 }, { 512, 512, 128, 128 }, { 333, 257, 100, 31 },
+                                 { 64, 64, 63, 1 }, { 17, 5, 3, 2 }, { 200, 100, 400, 300 } };
+        for (S8 components : { 1, 3, 4 })
+        {
+            for (const auto& size : sizes)
+            {
+                LLPointer<LLImageRaw> src = random_image(size[0], size[1], components, mSeed);
+                LLPointer<LLImageRaw> dst = new LLImageRaw(size[2], size[3], components);
+                ensure(llformat("copyScaled %dx%d -> %dx%d, %d components", size[0], size[1], size[2], size[3], components),
+                       matches_scalar(dst, [&](LLImageRaw* image) { image->copyScaled(src); }));
+                ensure(llformat("scale %dx%d -> %dx%d, %d components", size[0], size[1], size[2], size[3], components),
+                       matches_scalar(src, [&](LLImageRaw* image) { image->scale(size[2], size[3]); }));
+            }
+        }
+    }
+
+    template<> template<>
+    void LLImageRawTest_t::test<2>()
+    {
+        set_test_name("compositing and channel conversion match scalar output");
+
+        for (S32 width : { 1, 3, 4, 7, 64, 257 })
+        {
+            LLPointer<LLImageRaw> rgba = random_image(width, 33, 4, mSeed);
+            vary_alpha(rgba, mSeed);
+            LLPointer<LLImageRaw> rgb = random_image(width, 33, 3, mSeed);
+            LLPointer<LLImageRaw> rgba_dst = random_image(width, 33, 4, mSeed);
+            LLPointer<LLImageRaw> emissive = random_image(width, 33, 3, mSeed);
+
+            ensure(llformat("composite %d", width), matches_scalar(rgb, [&](LLImageRaw* image) { image->composite(rgba); }));
+            ensure(llformat("copyUnscaled4onto3 %d", width), matches_scalar(rgb, [&](LLImageRaw* image) { image->copyUnscaled4onto3(rgba); }));
+            ensure(llformat("copyUnscaled3onto4 %d", width), matches_scalar(rgba_dst, [&](LLImageRaw* image) { image->copyUnscaled3onto4(rgb); }));
+            ensure(llformat("addEmissive 3 %d", width), matches_scalar(rgb, [&](LLImageRaw* image) { image->addEmissiveUnscaled(emissive); }));
+            ensure(llformat("addEmissive 4 %d", width), matches_scalar(rgba_dst, [&](LLImageRaw* image) { image->addEmissiveUnscaled(rgba); }));
+            ensure(llformat("addEmissive 4 onto 3 %d", width), matches_scalar(rgb, [&](LLImageRaw* image) { image->addEmissiveUnscaled(rgba); }));
+        }
+    }
+
+    template<> template<>
+    void LLImageRawTest_t::test<3>()
+    {
+        set_test_name("scalar vs SIMD benchmark");
+        if (!getenv("LL_TEST_BENCHMARK"))
+        {
+            skip("benchmark, set LL_TEST_BENCHMARK to run it");
+        }
+
+        LLPointer<LLImageRaw> src = random_image(2048, 2048, 4, mSeed);
+        vary_alpha(src, mSeed);
+        LLPointer<LLImageRaw> src_rgb = random_image(2048, 2048, 3, mSeed);
+        LLPointer<LLImageRaw> thumbnail = new LLImageRaw(256, 256, 4);
+        LLPointer<LLImageRaw> half = new LLImageRaw(1024, 1024, 4);
+        LLPointer<LLImageRaw> rgb = new LLImageRaw(2048, 2048, 3);
+        LLPointer<LLImageRaw> rgba = new LLImageRaw(2048, 2048, 4);
+
+        const std::pair<const char*, std::function<void()>> ops[] = {
+            { "downscale 2048 -> 1024", [&]() { half->copyScaled(src); } },
+            { "downscale 2048 -> 256", [&]() { thumbnail->copyScaled(src); } },
+            { "composite 4 onto 3", [&]() { rgb->composite(src); } },
+            { "copy 4 onto 3", [&]() { rgb->copyUnscaled4onto3(src); } },
+            { "copy 3 onto 4", [&]() { rgba->copyUnscaled3onto4(src_rgb); } },
+            { "add emissive", [&]() { rgb->addEmissiveUnscaled(src_rgb); } },
+        };
+        for (const auto& op : ops)
+        {
+            LLImageRaw::sUseSIMDKernels = false;
+            F32 scalar_ms = time_ms(5, op.second);
+            LLImageRaw::sUseSIMDKernels = true;
+            F32 simd_ms = time_ms(5, op.second);
+            LL_INFOS() << op.first << ": scalar " << scalar_ms << " ms, SIMD " << simd_ms << " ms" << LL_ENDL;
+        }
+    }
+
+    template<> template<>
+    void LLImageRawTest_t::test<4>()
+    {
+        set_test_name("tiled filters match whole image filters");
+
+        const std::vector<std::string> filters = bundled_filters();
+        ensure("found the bundled filters", !filters.empty());
+        for (const std::string& path : filters)
+        {
+            for (S8 components : { 3, 4 })
+            {
+                LLPointer<LLImageRaw> src = random_image(601, 419, components, mSeed);
+                LLPointer<LLImageRaw> whole = new LLImageRaw(src->getData(), src->getWidth(), src->getHeight(), components);
+                LLPointer<LLImageRaw> tiled = new LLImageRaw(src->getData(), src->getWidth(), src->getHeight(), components);
+
+                LLImageFilter::sUseTiledExecution = false;
+                LLImageFilter(path).executeFilter(whole);
+                LLImageFilter::sUseTiledExecution = true;
+                LLImageFilter(path).executeFilter(tiled);
+                ensure(path, same(whole, tiled));
+            }
+        }
+    }
+
+    template<> template<>
+    void LLImageRawTest_t::test<5>()
+    {
+        set_test_name("whole image vs tiled filter benchmark");
+        if (!getenv("LL_TEST_BENCHMARK"))
+        {
+            skip("benchmark, set LL_TEST_BENCHMARK to run it");
+        }
+
+        // A 4K snapshot
+        LLPointer<LLImageRaw> src = random_image(3840, 2160, 3, mSeed);
+        LLPointer<LLImageRaw> image = new LLImageRaw(src->getWidth(), src->getHeight(), 3);
+        F32 total_whole_ms = 0.f, total_tiled_ms = 0.f;
+        for (const std::string& path : bundled_filters())
+        {
+            F32 ms[2];
+            for (bool tiled : { false, true })
+            {
+                LLImageFilter::sUseTiledExecution = tiled;
+                LLImageFilter filter(path);
+                memcpy(image->getData(), src->getData(), src->getDataSize());
+                ms[tiled] = time_ms(1, [&]() { filter.executeFilter(image); });
+            }
+            total_whole_ms += ms[0];
+            total_tiled_ms += ms[1];
+            LL_INFOS() << std::filesystem::path(path).stem().string() << ": whole image " << ms[0] << " ms, tiled " << ms[1] << " ms" << LL_ENDL;
+        }
+        LL_INFOS() << "All filters: whole image " << total_whole_ms << " ms, tiled " << total_tiled_ms << " ms" << LL_ENDL;
+    }
+}
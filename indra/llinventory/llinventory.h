@@ -108,6 +108,11 @@ public:
     // Member Variables
     //--------------------------------------------------------------------
 protected:
+    // The binary inventory cache stores the members as they are, the
+    // accessors may follow links or correct the values.
+    friend class LLInventoryCacheReader;
+    friend class LLInventoryCacheWriter;
+
     LLUUID mUUID;
     LLUUID mParentUUID; // Parent category.  Root categories have LLUUID::NULL.
     LLUUID mThumbnailUUID;
@@ -214,6 +219,9 @@ public:
     // Member Variables
     //--------------------------------------------------------------------
 protected:
+    friend class LLInventoryCacheReader;
+    friend class LLInventoryCacheWriter;
+
     LLPermissions mPermissions;
     LLUUID mAssetUUID;
     std::string mDescription;
@@ -0,0 +1,480 @@
+/**
+ * @file llinventorycache.cpp
+ * @brief Binary inventory cache file reader and writer.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llinventorycache.h"
+
+#include "llfile.h"
+#include "llstring.h"
+#include "workexecutor.h"
+
+#if LL_WINDOWS
+#include "llwin32headerslean.h"
+#include <io.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+// Binary inventory cache file layout:
+//   U32 magic, U32 format version, S32 inventory cache version,
+//   S32 number of folders, S32 number of items, U32 string pool size,
+//   folder records: LLUUID id, parent, thumbnail and owner,
+//     U32 name offset and size in the string pool, S8 type, S8 preferred type,
+//   version table: S32 version per folder record,
+//   item records: LLUUID id, parent, thumbnail, shadowed asset, creator,
+//     owner, last owner and group, U32 base, owner, group, everyone and next
+//     owner masks, U32 flags, S32 sale price, S32 creation date, U32 name
+//     and description offsets and sizes, S8 type, S8 inventory type,
+//     U8 sale type,
+//   string pool.
+const U32 INVENTORY_CACHE_MAGIC = 0x43564e49; // "INVC"
+const U32 INVENTORY_CACHE_FORMAT_VERSION = 1;
+const size_t INVENTORY_CACHE_HEADER_SIZE = 2 * sizeof(U32) + 3 * sizeof(S32) + sizeof(U32);
+const size_t CATEGORY_RECORD_SIZE = 4 * UUID_BYTES + 2 * sizeof(U32) + 2 * sizeof(S8);
+const size_t VERSION_RECORD_SIZE = sizeof(S32);
+const size_t ITEM_RECORD_SIZE = 8 * UUID_BYTES + 6 * sizeof(U32) + 2 * sizeof(S32) + 4 * sizeof(U32) + 3 * sizeof(S8);
+const S32 RECORDS_PER_CHUNK = 4096;
+
+// Same key and result as the LLXORCipher asLLSD() shadows asset ids with,
+// without allocating a cipher per item.
+const LLUUID MAGIC_ID("3c115e51-04f4-523c-9fa6-98aff1034730");
+
+namespace
+{
+    template <typename T>
+    T read_value(const U8*& pos)
+    {
+        T value;
+        memcpy(&value, pos, sizeof(T));
+        pos += sizeof(T);
+        return value;
+    }
+
+    LLUUID read_uuid(const U8*& pos)
+    {
+        LLUUID id;
+        memcpy(id.mData, pos, UUID_BYTES);
+        pos += UUID_BYTES;
+        return id;
+    }
+
+    template <typename T>
+    void append_value(std::vector<U8>& out, const T& value)
+    {
+        const U8* bytes = reinterpret_cast<const U8*>(&value);
+        out.insert(out.end(), bytes, bytes + sizeof(T));
+    }
+
+    void append_uuid(std::vector<U8>& out, const LLUUID& id)
+    {
+        out.insert(out.end(), id.mData, id.mData + UUID_BYTES);
+    }
+
+    // Asset ids of items that aren't fully permissive are stored shadowed.
+    // Shadowing is its own inverse.
+    void shadow_asset_id(LLUUID& asset_id, PermissionMask base_mask)
+    {
+        if ((base_mask & PERM_ITEM_UNRESTRICTED) != PERM_ITEM_UNRESTRICTED)
+        {
+            for (S32 i = 0; i < UUID_BYTES; ++i)
+            {
+                asset_id.mData[i] ^= MAGIC_ID.mData[i];
+            }
+        }
+    }
+}
+
+///----------------------------------------------------------------------------
+/// Class LLInventoryCacheWriter
+///----------------------------------------------------------------------------
+
+LLInventoryCacheWriter::LLInventoryCacheWriter(S32 cache_version) :
+    mCacheVersion(cache_version),
+    mCategoryCount(0),
+    mItemCount(0)
+{
+}
+
+void LLInventoryCacheWriter::addCategory(const LLInventoryCategory& cat, const LLUUID& owner_id, S32 version)
+{
+    append_uuid(mCategories, cat.mUUID);
+    append_uuid(mCategories, cat.mParentUUID);
+    append_uuid(mCategories, cat.mThumbnailUUID);
+    append_uuid(mCategories, owner_id);
+    append_value(mCategories, (U32)mStrings.size());
+    append_value(mCategories, (U32)cat.mName.size());
+    mStrings.insert(mStrings.end(), cat.mName.begin(), cat.mName.end());
+    append_value(mCategories, (S8)cat.mType);
+    append_value(mCategories, (S8)cat.getPreferredType());
+
+    append_value(mVersions, version);
+    ++mCategoryCount;
+}
+
+void LLInventoryCacheWriter::addItem(const LLInventoryItem& item)
+{
+    const LLPermissions& perm = item.mPermissions;
+    LLUUID asset_id(item.mAssetUUID);
+    shadow_asset_id(asset_id, perm.getMaskBase());
+
+    append_uuid(mItems, item.mUUID);
+    append_uuid(mItems, item.mParentUUID);
+    append_uuid(mItems, item.mThumbnailUUID);
+    append_uuid(mItems, asset_id);
+    append_uuid(mItems, perm.getCreator());
+    append_uuid(mItems, perm.getOwner());
+    append_uuid(mItems, perm.getLastOwner());
+    append_uuid(mItems, perm.getGroup());
+    append_value(mItems, perm.getMaskBase());
+    append_value(mItems, perm.getMaskOwner());
+    append_value(mItems, perm.getMaskGroup());
+    append_value(mItems, perm.getMaskEveryone());
+    append_value(mItems, perm.getMaskNextOwner());
+    append_value(mItems, item.mFlags);
+    append_value(mItems, item.mSaleInfo.getSalePrice());
+    append_value(mItems, (S32)item.mCreationDate);
+    append_value(mItems, (U32)mStrings.size());
+    append_value(mItems, (U32)item.mName.size());
+    mStrings.insert(mStrings.end(), item.mName.begin(), item.mName.end());
+    append_value(mItems, (U32)mStrings.size());
+    append_value(mItems, (U32)item.mDescription.size());
+    mStrings.insert(mStrings.end(), item.mDescription.begin(), item.mDescription.end());
+    append_value(mItems, (S8)item.mType);
+    append_value(mItems, (S8)item.mInventoryType);
+    append_value(mItems, (U8)item.mSaleInfo.getSaleType());
+    ++mItemCount;
+}
+
+void LLInventoryCacheWriter::finish(std::vector<U8>& data)
+{
+    LL_PROFILE_ZONE_SCOPED;
+    data.clear();
+    data.reserve(INVENTORY_CACHE_HEADER_SIZE + mCategories.size() + mVersions.size() + mItems.size() + mStrings.size());
+    append_value(data, INVENTORY_CACHE_MAGIC);
+    append_value(data, INVENTORY_CACHE_FORMAT_VERSION);
+    append_value(data, mCacheVersion);
+    append_value(data, mCategoryCount);
+    append_value(data, mItemCount);
+    append_value(data, (U32)mStrings.size());
+    data.insert(data.end(), mCategories.begin(), mCategories.end());
+    data.insert(data.end(), mVersions.begin(), mVersions.end());
+    data.insert(data.end(), mItems.begin(), mItems.end());
+    data.insert(data.end(), mStrings.begin(), mStrings.end());
+
+    mCategories.clear();
+    mVersions.clear();
+    mItems.clear();
+    mStrings.clear();
+    mCategoryCount = 0;
+    mItemCount = 0;
+}
+
+// static
+bool LLInventoryCacheWriter::writeFile(const std::string& filename, const std::vector<U8>& data)
+{
+    LL_PROFILE_ZONE_SCOPED;
+    // Every writer gets its own temporary file, so a second instance
+    // saving the same cache can't write into ours
+    const std::string temp_filename = filename + "." + LLUUID::generateNewID().asString() + ".tmp";
+    LLFILE* file = LLFile::fopen(temp_filename, "wb");
+    if (!file)
+    {
+        LL_WARNS("Inventory") << "Unable to open " << temp_filename << " to save inventory" << LL_ENDL;
+        return false;
+    }
+
+    bool success = fwrite(data.data(), 1, data.size(), file) == data.size();
+    success = fclose(file) == 0 && success;
+    if (success)
+    {
+        // rename() won't replace an existing file on Windows
+        LLFile::remove(filename, ENOENT);
+        success = LLFile::rename(temp_filename, filename) == 0;
+    }
+
+    if (!success)
+    {
+        LL_WARNS("Inventory") << "Unable to save inventory to " << filename << LL_ENDL;
+        LLFile::remove(temp_filename);
+    }
+    return success;
+}
+
+///----------------------------------------------------------------------------
+/// Class LLInventoryCacheReader
+///----------------------------------------------------------------------------
+
+LLInventoryCacheReader::LLInventoryCacheReader() :
+    mMappedData(nullptr),
+    mMappedSize(0)
+{
+    close();
+}
+
+LLInventoryCacheReader::~LLInventoryCacheReader()
+{
+    close();
+}
+
+bool LLInventoryCacheReader::open(const std::string& filename)
+{
+    LL_PROFILE_ZONE_SCOPED;
+    close();
+
+    LLFILE* file = LLFile::fopen(filename, "rb");
+    if (!file)
+    {
+        return false;
+    }
+
+    // The mapping stays valid after the file is closed
+#if LL_WINDOWS
+    HANDLE file_handle = (HANDLE)_get_osfhandle(_fileno(file));
+    LARGE_INTEGER file_size;
+    if (file_handle != INVALID_HANDLE_VALUE && GetFileSizeEx(file_handle, &file_size) && file_size.QuadPart > 0)
+    {
+        HANDLE mapping = CreateFileMappingW(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping)
+        {
+            mMappedData = (U8*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            if (mMappedData)
+            {
+                mMappedSize = (size_t)file_size.QuadPart;
+            }
+            CloseHandle(mapping);
+        }
+    }
+#else
+    struct stat file_stat;
+    if (fstat(fileno(file), &file_stat) == 0 && file_stat.st_size > 0)
+    {
+        void* data = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fileno(file), 0);
+        if (data != MAP_FAILED)
+        {
+            mMappedData = (U8*)data;
+            mMappedSize = (size_t)file_stat.st_size;
+        }
+    }
+#endif
+    fclose(file);
+
+    if (!mMappedData)
+    {
+        return false;
+    }
+
+    if (!mMappedData || !parse(mMappedData, mMappedSize))
+    {
+        LL_INFOS("Inventory") << filename << " is not a binary inventory cache of this format version" << LL_ENDL;
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool LLInventoryCacheReader::open(const U8* data, size_t size)
+{
+    close();
+    return parse(data, size);
+}
+
+bool LLInventoryCacheReader::parse(const U8* data, size_t size)
+{
+    if (!data || size < INVENTORY_CACHE_HEADER_SIZE)
+    {
+        return false;
+    }
+
+    const U8* pos = data;
+    if (read_value<U32>(pos) != INVENTORY_CACHE_MAGIC
+        || read_value<U32>(pos) != INVENTORY_CACHE_FORMAT_VERSION)
+    {
+        return false;
+    }
+    const S32 cache_version = read_value<S32>(pos);
+    const S32 category_count = read_value<S32>(pos);
+    const S32 item_count = read_value<S32>(pos);
+    const U32 strings_size = read_value<U32>(pos);
+    if (category_count < 0 || item_count < 0)
+    {
+        return false;
+    }
+
+    const U64 expected_size = (U64)INVENTORY_CACHE_HEADER_SIZE
+        + (U64)category_count * (CATEGORY_RECORD_SIZE + VERSION_RECORD_SIZE)
+        + (U64)item_count * ITEM_RECORD_SIZE
+        + strings_size;
+    if (expected_size != (U64)size)
+    {
+        return false;
+    }
+
+    mCacheVersion = cache_version;
+    mCategoryCount = category_count;
+    mItemCount = item_count;
+    mCategories = pos;
+    mVersions = mCategories + (size_t)category_count * CATEGORY_RECORD_SIZE;
+    mItems = mVersions + (size_t)category_count * VERSION_RECORD_SIZE;
+    mStrings = mItems + (size_t)item_count * ITEM_RECORD_SIZE;
+    mStringsSize = strings_size;
+    return true;
+}
+
+void LLInventoryCacheReader::close()
+{
+    if (mMappedData)
+    {
+#if LL_WINDOWS
+        UnmapViewOfFile(mMappedData);
+#else
+        munmap(mMappedData, mMappedSize);
+#endif
+    }
+    mMappedData = nullptr;
+    mMappedSize = 0;
+    mCategories = nullptr;
+    mVersions = nullptr;
+    mItems = nullptr;
+    mStrings = nullptr;
+    mStringsSize = 0;
+    mCacheVersion = 0;
+    mCategoryCount = 0;
+    mItemCount = 0;
+}
+
+std::string LLInventoryCacheReader::readString(const U8* pos) const
+{
+    const U32 offset = read_value<U32>(pos);
+    const U32 size = read_value<U32>(pos);
+    if (offset > mStringsSize || size > mStringsSize - offset)
+    {
+        return std::string();
+    }
+    return std::string((const char*)mStrings + offset, size);
+}
+
+LLUUID LLInventoryCacheReader::getCategoryID(S32 index) const
+{
+    const U8* pos = mCategories + (size_t)index * CATEGORY_RECORD_SIZE;
+    return read_uuid(pos);
+}
+
+LLUUID LLInventoryCacheReader::getCategoryOwnerID(S32 index) const
+{
+    const U8* pos = mCategories + (size_t)index * CATEGORY_RECORD_SIZE + 3 * UUID_BYTES;
+    return read_uuid(pos);
+}
+
+S32 LLInventoryCacheReader::getCategoryVersion(S32 index) const
+{
+    const U8* pos = mVersions + (size_t)index * VERSION_RECORD_SIZE;
+    return read_value<S32>(pos);
+}
+
+void LLInventoryCacheReader::readCategory(S32 index, LLInventoryCategory& cat) const
+{
+    const U8* pos = mCategories + (size_t)index * CATEGORY_RECORD_SIZE;
+    cat.mUUID = read_uuid(pos);
+    cat.mParentUUID = read_uuid(pos);
+    cat.mThumbnailUUID = read_uuid(pos);
+    pos += UUID_BYTES; // owner, see getCategoryOwnerID()
+    cat.mName = readString(pos);
+    pos += 2 * sizeof(U32);
+    cat.mType = (LLAssetType::EType)read_value<S8>(pos);
+    cat.setPreferredType((LLFolderType::EType)read_value<S8>(pos));
+
+    LLStringUtil::replaceNonstandardASCII(cat.mName, ' ');
+    LLStringUtil::replaceChar(cat.mName, '|', ' ');
+}
+
+void LLInventoryCacheReader::readItem(S32 index, LLInventoryItem& item) const
+{
+    const U8* pos = mItems + (size_t)index * ITEM_RECORD_SIZE;
+    item.mUUID = read_uuid(pos);
+    item.mParentUUID = read_uuid(pos);
+    item.mThumbnailUUID = read_uuid(pos);
+    item.mAssetUUID = read_uuid(pos);
+    const LLUUID creator_id = read_uuid(pos);
+    const LLUUID owner_id = read_uuid(pos);
+    const LLUUID last_owner_id = read_uuid(pos);
+    const LLUUID group_id = read_uuid(pos);
+
+    // As ll_permissions_from_sd()
+    LLPermissions& perm = item.mPermissions;
+    perm.init(creator_id, owner_id, last_owner_id, group_id);
+    perm.setMaskBase(read_value<U32>(pos));
+    perm.setMaskOwner(read_value<U32>(pos));
+    perm.setMaskGroup(read_value<U32>(pos));
+    perm.setMaskEveryone(read_value<U32>(pos));
+    perm.setMaskNext(read_value<U32>(pos));
+    perm.fix();
+    shadow_asset_id(item.mAssetUUID, perm.getMaskBase());
+
+    item.mFlags = read_value<U32>(pos);
+    const S32 sale_price = read_value<S32>(pos);
+    item.mCreationDate = read_value<S32>(pos);
+    item.mName = readString(pos);
+    pos += 2 * sizeof(U32);
+    item.mDescription = readString(pos);
+    pos += 2 * sizeof(U32);
+    item.mType = (LLAssetType::EType)read_value<S8>(pos);
+    item.mInventoryType = (LLInventoryType::EType)read_value<S8>(pos);
+    item.mSaleInfo = LLSaleInfo((LLSaleInfo::EForSale)read_value<U8>(pos), sale_price);
+
+    // The corrections fromLLSD() makes
+    LLStringUtil::replaceNonstandardASCII(item.mName, ' ');
+    LLStringUtil::replaceChar(item.mName, '|', ' ');
+    LLStringUtil::replaceNonstandardASCII(item.mDescription, ' ');
+    if ((LLInventoryType::IT_NONE == item.mInventoryType)
+        || !inventory_and_asset_types_match(item.mInventoryType, item.mType))
+    {
+        item.mInventoryType = LLInventoryType::defaultForAssetType(item.mType);
+    }
+    perm.initMasks(item.mInventoryType);
+}
+
+// static
+void LLInventoryCacheReader::forEachChunk(S32 count, const std::function<void(S32, S32)>& func)
+{
+    LL_PROFILE_ZONE_SCOPED;
+    const S32 chunks = (count + RECORDS_PER_CHUNK - 1) / RECORDS_PER_CHUNK;
+    if (chunks <= 1)
+    {
+        if (count > 0)
+        {
+            func(0, count);
+        }
+        return;
+    }
+
+    LL::WorkExecutor::getShared().forEach(chunks, [count, &func](size_t chunk)
+        {
+            const S32 begin = (S32)chunk * RECORDS_PER_CHUNK;
+            func(begin, llmin(begin + RECORDS_PER_CHUNK, count));
+        });
+}
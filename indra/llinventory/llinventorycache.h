@@ -0,0 +1,126 @@
+/**
+ * @file llinventorycache.h
+ * @brief Binary inventory cache file reader and writer.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLINVENTORYCACHE_H
+#define LL_LLINVENTORYCACHE_H
+
+#include "llinventory.h"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Binary inventory cache
+//
+//   Folders and items as fixed-size records, with their names and
+//   descriptions in a string pool and the folder versions in a table of
+//   their own.  Any record can be decoded without looking at the others, so
+//   a mapped file is read in parallel chunks instead of line by line.
+//   Values are in host byte order, the cache never leaves the machine.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+class LLInventoryCacheWriter
+{
+public:
+    // cache_version is checked by the reader's owner, it is the version of
+    // the inventory contents rather than of the file format.
+    LLInventoryCacheWriter(S32 cache_version);
+
+    void addCategory(const LLInventoryCategory& cat, const LLUUID& owner_id, S32 version);
+    void addItem(const LLInventoryItem& item);
+
+    S32 getCategoryCount() const { return mCategoryCount; }
+    S32 getItemCount() const { return mItemCount; }
+
+    // Assemble the file contents, the writer is empty afterwards.
+    void finish(std::vector<U8>& data);
+
+    // Write data to filename through a temporary file, so a reader never
+    // sees half a cache.  Safe to call from any thread.
+    static bool writeFile(const std::string& filename, const std::vector<U8>& data);
+
+private:
+    S32 mCacheVersion;
+    S32 mCategoryCount;
+    S32 mItemCount;
+    std::vector<U8> mCategories;
+    std::vector<U8> mVersions;
+    std::vector<U8> mItems;
+    std::vector<U8> mStrings;
+};
+
+class LLInventoryCacheReader
+{
+public:
+    LLInventoryCacheReader();
+    ~LLInventoryCacheReader();
+
+    // Map filename and check its layout.  False if it is missing or is not
+    // a binary inventory cache of this format version.
+    bool open(const std::string& filename);
+    // Read from data the caller keeps around while the reader is used.
+    bool open(const U8* data, size_t size);
+    void close();
+
+    S32 getCacheVersion() const     { return mCacheVersion; }
+    S32 getCategoryCount() const    { return mCategoryCount; }
+    S32 getItemCount() const        { return mItemCount; }
+
+    // From the folder records and the version table alone, for checking
+    // folders against the skeleton before anything is decoded.
+    LLUUID getCategoryID(S32 index) const;
+    LLUUID getCategoryOwnerID(S32 index) const;
+    S32 getCategoryVersion(S32 index) const;
+
+    // Decode a record into an object created by the caller, with the same
+    // corrections fromLLSD() and importLLSD() apply to the LLSD cache.
+    // Thread safe, as long as each object is decoded by a single thread.
+    void readCategory(S32 index, LLInventoryCategory& cat) const;
+    void readItem(S32 index, LLInventoryItem& item) const;
+
+    // Call func(begin, end) over consecutive chunks of [0, count) on the
+    // shared WorkExecutor and on the calling thread, and return when all of
+    // them are done.
+    static void forEachChunk(S32 count, const std::function<void(S32, S32)>& func);
+
+private:
+    bool parse(const U8* data, size_t size);
+    std::string readString(const U8* pos) const;
+
+    U8* mMappedData;
+    size_t mMappedSize;
+    const U8* mCategories;
+    const U8* mVersions;
+    const U8* mItems;
+    const U8* mStrings;
+    U32 mStringsSize;
+    S32 mCacheVersion;
+    S32 mCategoryCount;
+    S32 mItemCount;
+};
+
+#endif // LL_LLINVENTORYCACHE_H
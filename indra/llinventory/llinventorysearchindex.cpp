@@ -0,0 +1,299 @@
+/**
+ * @file llinventorysearchindex.cpp
+ * @brief Trigram index over inventory names, descriptions and creators.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llinventorysearchindex.h"
+
+#include "llstring.h"
+
+#include <algorithm>
+
+// Replaced entries are only dropped from the trigram lists when there are
+// at least this many of them, and they make up half of the lists.
+const size_t MIN_STALE_TRIGRAMS_TO_REBUILD = 65536;
+
+namespace
+{
+    inline U32 trigram_at(const std::string& text, size_t pos)
+    {
+        return ((U32)(U8)text[pos] << 16) | ((U32)(U8)text[pos + 1] << 8) | (U32)(U8)text[pos + 2];
+    }
+
+    // Distinct trigrams of text, sorted
+    void get_trigrams(const std::string& text, std::vector<U32>& trigrams)
+    {
+        trigrams.clear();
+        if (text.size() < 3)
+        {
+            return;
+        }
+        for (size_t i = 0; i + 2 < text.size(); ++i)
+        {
+            trigrams.push_back(trigram_at(text, i));
+        }
+        std::sort(trigrams.begin(), trigrams.end());
+        trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+    }
+}
+
+LLInventorySearchIndex::LLInventorySearchIndex()
+:   mPostingCount(0),
+    mStaleCount(0),
+    mGeneration(0)
+{
+}
+
+void LLInventorySearchIndex::setField(const LLUUID& id, EField field, const std::string& text)
+{
+    std::string upper_text = text;
+    LLStringUtil::toUpper(upper_text);
+
+    auto inserted = mSlots.emplace(id, 0);
+    U32& slot = inserted.first->second;
+    if (!inserted.second)
+    {
+        if (mObjects[slot].mText[field] == upper_text)
+        {
+            return;
+        }
+        // The old entries stay listed until the next rebuild, confirming
+        // against the new text skips them.
+        mStaleCount += countTrigrams(mObjects[slot].mText[field]);
+    }
+    else
+    {
+        if (!mFreeSlots.empty())
+        {
+            slot = mFreeSlots.back();
+            mFreeSlots.pop_back();
+        }
+        else
+        {
+            slot = static_cast<U32>(mObjects.size());
+            mObjects.emplace_back();
+        }
+        mObjects[slot].mID = id;
+        mObjects[slot].mLive = true;
+    }
+
+    mObjects[slot].mText[field].swap(upper_text);
+    addTrigrams(slot, field);
+    ++mGeneration;
+
+    if (mStaleCount >= MIN_STALE_TRIGRAMS_TO_REBUILD && mStaleCount * 2 >= mPostingCount)
+    {
+        rebuildTrigrams();
+    }
+}
+
+void LLInventorySearchIndex::removeObject(const LLUUID& id)
+{
+    auto found = mSlots.find(id);
+    if (found == mSlots.end())
+    {
+        return;
+    }
+
+    const U32 slot = found->second;
+    Object& object = mObjects[slot];
+    for (S32 field = 0; field < FIELD_COUNT; ++field)
+    {
+        mStaleCount += countTrigrams(object.mText[field]);
+        object.mText[field].clear();
+    }
+    object.mLive = false;
+    mFreeSlots.push_back(slot);
+    mSlots.erase(found);
+    ++mGeneration;
+
+    if (mStaleCount >= MIN_STALE_TRIGRAMS_TO_REBUILD && mStaleCount * 2 >= mPostingCount)
+    {
+        rebuildTrigrams();
+    }
+}
+
+void LLInventorySearchIndex::clear()
+{
+    mObjects.clear();
+    mFreeSlots.clear();
+    mSlots.clear();
+    for (S32 field = 0; field < FIELD_COUNT; ++field)
+    {
+        mPostings[field].clear();
+    }
+    mPostingCount = 0;
+    mStaleCount = 0;
+    ++mGeneration;
+}
+
+bool LLInventorySearchIndex::hasObject(const LLUUID& id) const
+{
+    return mSlots.find(id) != mSlots.end();
+}
+
+const std::string& LLInventorySearchIndex::getField(const LLUUID& id, EField field) const
+{
+    auto found = mSlots.find(id);
+    if (found == mSlots.end())
+    {
+        return LLStringUtil::null;
+    }
+    return mObjects[found->second].mText[field];
+}
+
+bool LLInventorySearchIndex::matches(const LLUUID& id, U32 field_mask, const std::string& sub_string) const
+{
+    auto found = mSlots.find(id);
+    if (found == mSlots.end())
+    {
+        return false;
+    }
+
+    const Object& object = mObjects[found->second];
+    for (S32 field = 0; field < FIELD_COUNT; ++field)
+    {
+        if ((field_mask & (1 << field)) && object.mText[field].find(sub_string) != std::string::npos)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void LLInventorySearchIndex::find(U32 field_mask, const std::string& sub_string, uuid_vec_t& results) const
+{
+    std::vector<U32> slots;
+    if (sub_string.size() < 3)
+    {
+        // Too short to have a trigram, check everything.
+        for (U32 slot = 0; slot < mObjects.size(); ++slot)
+        {
+            const Object& object = mObjects[slot];
+            if (!object.mLive)
+            {
+                continue;
+            }
+            for (S32 field = 0; field < FIELD_COUNT; ++field)
+            {
+                if ((field_mask & (1 << field)) && object.mText[field].find(sub_string) != std::string::npos)
+                {
+                    slots.push_back(slot);
+                    break;
+                }
+            }
+        }
+    }
+    else
+    {
+        std::vector<U32> trigrams;
+        get_trigrams(sub_string, trigrams);
+        for (S32 field = 0; field < FIELD_COUNT; ++field)
+        {
+            if (!(field_mask & (1 << field)))
+            {
+                continue;
+            }
+
+            // Every match is listed under every trigram of the query, the
+            // shortest list has the fewest candidates to confirm.
+            const std::vector<U32>* candidates = NULL;
+            for (U32 trigram : trigrams)
+            {
+                auto found = mPostings[field].find(trigram);
+                if (found == mPostings[field].end())
+                {
+                    candidates = NULL;
+                    break;
+                }
+                if (!candidates || found->second.size() < candidates->size())
+                {
+                    candidates = &found->second;
+                }
+            }
+            if (!candidates)
+            {
+                continue;
+            }
+
+            for (U32 slot : *candidates)
+            {
+                const Object& object = mObjects[slot];
+                if (object.mLive && object.mText[field].find(sub_string) != std::string::npos)
+                {
+                    slots.push_back(slot);
+                }
+            }
+        }
+    }
+
+    // A slot is listed again when a field is changed back, and may match in
+    // several fields.
+    std::sort(slots.begin(), slots.end());
+    slots.erase(std::unique(slots.begin(), slots.end()), slots.end());
+    results.reserve(results.size() + slots.size());
+    for (U32 slot : slots)
+    {
+        results.push_back(mObjects[slot].mID);
+    }
+}
+
+void LLInventorySearchIndex::addTrigrams(U32 slot, EField field)
+{
+    get_trigrams(mObjects[slot].mText[field], mTrigrams);
+    for (U32 trigram : mTrigrams)
+    {
+        mPostings[field][trigram].push_back(slot);
+    }
+    mPostingCount += mTrigrams.size();
+}
+
+S32 LLInventorySearchIndex::countTrigrams(const std::string& text)
+{
+    get_trigrams(text, mTrigrams);
+    return static_cast<S32>(mTrigrams.size());
+}
+
+void LLInventorySearchIndex::rebuildTrigrams()
+{
+    for (S32 field = 0; field < FIELD_COUNT; ++field)
+    {
+        mPostings[field].clear();
+    }
+    mPostingCount = 0;
+    mStaleCount = 0;
+
+    for (U32 slot = 0; slot < mObjects.size(); ++slot)
+    {
+        if (mObjects[slot].mLive)
+        {
+            for (S32 field = 0; field < FIELD_COUNT; ++field)
+            {
+                addTrigrams(slot, (EField)field);
+            }
+        }
+    }
+}
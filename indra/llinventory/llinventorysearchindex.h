@@ -0,0 +1,108 @@
+/**
+ * @file llinventorysearchindex.h
+ * @brief Trigram index over inventory names, descriptions and creators.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLINVENTORYSEARCHINDEX_H
+#define LL_LLINVENTORYSEARCHINDEX_H
+
+#include "lluuid.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Class LLInventorySearchIndex
+//
+//   Upper cased copies of a few text fields per inventory object, with an
+//   inverted index from every three byte sequence to the objects containing
+//   it.  A substring query only looks at the objects listed for its rarest
+//   trigram and confirms each one against the stored text, so results are
+//   exact.  Updates are incremental: replaced entries are left in the lists
+//   and skipped on confirmation until enough of them pile up to rebuild.
+//   Not thread safe.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+class LLInventorySearchIndex
+{
+public:
+    enum EField
+    {
+        FIELD_NAME = 0,
+        FIELD_DESCRIPTION,
+        FIELD_CREATOR,
+        FIELD_COUNT
+    };
+    static const U32 FIELD_MASK_ALL = (1 << FIELD_COUNT) - 1;
+
+    LLInventorySearchIndex();
+
+    // Set the text of one field, adding the object if it is new.  The
+    // text is upper cased the way LLInventoryFilter upper cases it.
+    void setField(const LLUUID& id, EField field, const std::string& text);
+    void removeObject(const LLUUID& id);
+    void clear();
+
+    bool hasObject(const LLUUID& id) const;
+    S32 getObjectCount() const { return static_cast<S32>(mSlots.size()); }
+    const std::string& getField(const LLUUID& id, EField field) const;
+
+    // Changes whenever the contents do, to tell when cached query results
+    // are out of date.
+    U32 getGeneration() const { return mGeneration; }
+
+    // True if any field in field_mask of the object contains sub_string,
+    // which must already be upper case.
+    bool matches(const LLUUID& id, U32 field_mask, const std::string& sub_string) const;
+
+    // Append the objects with a field in field_mask containing sub_string,
+    // which must already be upper case.  No particular order.
+    void find(U32 field_mask, const std::string& sub_string, uuid_vec_t& results) const;
+
+private:
+    struct Object
+    {
+        LLUUID mID;
+        std::string mText[FIELD_COUNT];
+        bool mLive;
+    };
+
+    void addTrigrams(U32 slot, EField field);
+    S32 countTrigrams(const std::string& text);
+    void rebuildTrigrams();
+
+    // Object slots per trigram
+    typedef std::unordered_map<U32, std::vector<U32> > postings_t;
+
+    std::vector<Object> mObjects;
+    std::vector<U32> mFreeSlots;
+    std::unordered_map<LLUUID, U32> mSlots;
+    postings_t mPostings[FIELD_COUNT];
+    size_t mPostingCount;
+    size_t mStaleCount;
+    U32 mGeneration;
+    std::vector<U32> mTrigrams;
+};
+
+#endif // LL_LLINVENTORYSEARCHINDEX_H
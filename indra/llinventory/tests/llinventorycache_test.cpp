@@ -0,0 +1,420 @@
+/**
+ * @file llinventorycache_test.cpp
+ * @date 2024-11
+ * @brief Test cases for the binary inventory cache.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llinventorycache.h"
+#include "llfile.h"
+#include "llsdserialize.h"
+#include "lltimer.h"
+#include "stringize.h"
+
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+
+#include "../test/lltut.h"
+
+namespace
+{
+    const S32 CACHE_VERSION = 3;
+
+    // Repeatable ids, generate() is slow enough to dominate building a
+    // large inventory
+    LLUUID make_id(U32 kind, U32 index)
+    {
+        LLUUID id;
+        U32 words[4] = { kind, index, index * 2654435761u, kind ^ 0x5bd1e995 };
+        memcpy(id.mData, words, sizeof(words));
+        return id;
+    }
+
+    LLPointer<LLInventoryItem> make_item(S32 index, const LLUUID& parent_id)
+    {
+        static const LLAssetType::EType types[] =
+            { LLAssetType::AT_OBJECT, LLAssetType::AT_TEXTURE, LLAssetType::AT_NOTECARD, LLAssetType::AT_CLOTHING, LLAssetType::AT_LINK };
+
+        LLAssetType::EType type = types[index % LL_ARRAY_SIZE(types)];
+        LLPermissions perm;
+        perm.init(make_id(1, index % 97), make_id(2, 0), make_id(3, index % 13), index % 5 ? LLUUID::null : make_id(4, 1));
+        if (index % 3)
+        {
+            perm.initMasks(PERM_ALL, PERM_ALL, PERM_NONE, PERM_NONE, PERM_MOVE | PERM_TRANSFER);
+        }
+        else
+        {
+            // Not fully permissive, the asset id is stored shadowed
+            perm.initMasks(PERM_MOVE | PERM_COPY | PERM_MODIFY, PERM_MOVE | PERM_COPY, PERM_NONE, PERM_NONE, PERM_MOVE | PERM_COPY);
+        }
+
+        LLPointer<LLInventoryItem> item = new LLInventoryItem(
+            make_id(5, index),
+            parent_id,
+            perm,
+            make_id(6, index),
+            type,
+            LLInventoryType::defaultForAssetType(type),
+            llformat("Item %d of some synthetic inventory", index),
+            index % 4 ? std::string() : llformat("Description of item %d", index),
+            LLSaleInfo(index % 7 ? LLSaleInfo::FS_NOT : LLSaleInfo::FS_COPY, index % 7 ? 0 : 10 + index % 1000),
+            (U32)index * 7,
+            1700000000 + index);
+        if (index % 11 == 0)
+        {
+            item->setThumbnailUUID(make_id(7, index));
+        }
+        return item;
+    }
+
+    LLPointer<LLInventoryCategory> make_folder(S32 index, const LLUUID& parent_id)
+    {
+        LLPointer<LLInventoryCategory> cat = new LLInventoryCategory(
+            make_id(8, index),
+            parent_id,
+            index % 50 ? LLFolderType::FT_NONE : LLFolderType::FT_OUTFIT,
+            llformat("Folder %d", index));
+        if (index % 9 == 0)
+        {
+            cat->setThumbnailUUID(make_id(9, index));
+        }
+        return cat;
+    }
+
+    void make_inventory(S32 folder_count, S32 item_count,
+                        LLInventoryCategory::cat_array_t& folders, LLInventoryItem::item_array_t& items)
+    {
+        for (S32 i = 0; i < folder_count; ++i)
+        {
+            // A few levels deep, as inventories are
+            folders.push_back(make_folder(i, i ? folders[(i - 1) / 8]->getUUID() : LLUUID::null));
+        }
+        for (S32 i = 0; i < item_count; ++i)
+        {
+            items.push_back(make_item(i, folders[i % folder_count]->getUUID()));
+        }
+    }
+
+    S32 folder_version(S32 index)
+    {
+        return index * 3 + 1;
+    }
+
+    void write_binary(const LLInventoryCategory::cat_array_t& folders, const LLInventoryItem::item_array_t& items,
+                      std::vector<U8>& data)
+    {
+        LLInventoryCacheWriter writer(CACHE_VERSION);
+        for (size_t i = 0; i < folders.size(); ++i)
+        {
+            writer.addCategory(*folders[i], make_id(10, 0), folder_version((S32)i));
+        }
+        for (const auto& item : items)
+        {
+            writer.addItem(*item);
+        }
+        writer.finish(data);
+    }
+
+    // As LLInventoryModel::saveToFile() writes the LLSD notation cache
+    void write_llsd(const LLInventoryCategory::cat_array_t& folders, const LLInventoryItem::item_array_t& items,
+                    std::string& data)
+    {
+        std::ostringstream out;
+        LLSD cache_ver;
+        cache_ver["inv_cache_version"] = CACHE_VERSION;
+        out << LLSDOStreamer<LLSDNotationFormatter>(cache_ver) << std::endl;
+        for (const auto& folder : folders)
+        {
+            out << LLSDOStreamer<LLSDNotationFormatter>(folder->exportLLSD()) << std::endl;
+        }
+        for (const auto& item : items)
+        {
+            out << LLSDOStreamer<LLSDNotationFormatter>(item->asLLSD()) << std::endl;
+        }
+        data = out.str();
+    }
+
+    // As LLInventoryModel::loadFromFile() reads it
+    void read_llsd(const std::string& data, LLInventoryCategory::cat_array_t& folders, LLInventoryItem::item_array_t& items)
+    {
+        std::istringstream file(data);
+        std::string line;
+        LLPointer<LLSDParser> parser = new LLSDNotationParser();
+        while (std::getline(file, line))
+        {
+            LLSD s_item;
+            std::istringstream iss(line);
+            if (parser->parse(iss, s_item, line.length()) == LLSDParser::PARSE_FAILURE)
+            {
+                break;
+            }
+            if (s_item.has("cat_id"))
+            {
+                LLPointer<LLInventoryCategory> inv_cat = new LLInventoryCategory;
+                if (inv_cat->importLLSD(s_item))
+                {
+                    folders.push_back(inv_cat);
+                }
+            }
+            else if (s_item.has("item_id"))
+            {
+                LLPointer<LLInventoryItem> inv_item = new LLInventoryItem;
+                if (inv_item->fromLLSD(s_item))
+                {
+                    items.push_back(inv_item);
+                }
+            }
+        }
+    }
+
+    // As LLInventoryModel::loadFromFile() reads the binary cache
+    void read_binary(const LLInventoryCacheReader& reader, LLInventoryCategory::cat_array_t& folders,
+                     LLInventoryItem::item_array_t& items)
+    {
+        folders.resize(reader.getCategoryCount());
+        for (S32 i = 0; i < reader.getCategoryCount(); ++i)
+        {
+            folders[i] = new LLInventoryCategory;
+            reader.readCategory(i, *folders[i]);
+        }
+        items.resize(reader.getItemCount());
+        LLInventoryCacheReader::forEachChunk(reader.getItemCount(), [&](S32 begin, S32 end)
+        {
+            for (S32 i = begin; i < end; ++i)
+            {
+                items[i] = new LLInventoryItem;
+                reader.readItem(i, *items[i]);
+            }
+        });
+    }
+
+    bool same_item(const LLInventoryItem& a, const LLInventoryItem& b)
+    {
+        return a.getUUID() == b.getUUID()
+            && a.getParentUUID() == b.getParentUUID()
+            && a.getThumbnailUUID() == b.getThumbnailUUID()
+            && a.getAssetUUID() == b.getAssetUUID()
+            && a.getPermissions() == b.getPermissions()
+            && a.getType() == b.getType()
+            && a.getInventoryType() == b.getInventoryType()
+            && a.getFlags() == b.getFlags()
+            && a.getSaleInfo() == b.getSaleInfo()
+            && a.getName() == b.getName()
+            && a.getDescription() == b.getDescription()
+            && a.getCreationDate() == b.getCreationDate();
+    }
+
+    bool same_folder(const LLInventoryCategory& a, const LLInventoryCategory& b)
+    {
+        return a.getUUID() == b.getUUID()
+            && a.getParentUUID() == b.getParentUUID()
+            && a.getThumbnailUUID() == b.getThumbnailUUID()
+            && a.getType() == b.getType()
+            && a.getPreferredType() == b.getPreferredType()
+            && a.getName() == b.getName();
+    }
+}
+
+namespace tut
+{
+    struct inventorycache_data
+    {
+    };
+    typedef test_group<inventorycache_data> inventorycache_test;
+    typedef inventorycache_test::object inventorycache_object;
+    tut::inventorycache_test inventorycache_testcase("LLInventoryCache");
+
+    // Reading the binary cache gives the same folders and items as reading
+    // the LLSD one, corrections included
+    template<> template<>
+    void inventorycache_object::test<1>()
+    {
+        LLInventoryCategory::cat_array_t folders;
+        LLInventoryItem::item_array_t items;
+        make_inventory(40, 500, folders, items);
+
+        // Things fromLLSD() corrects
+        items[1]->setInventoryType(LLInventoryType::IT_LANDMARK);
+        items[2]->setInventoryType(LLInventoryType::IT_NONE);
+
+        std::vector<U8> binary;
+        write_binary(folders, items, binary);
+        LLInventoryCacheReader reader;
+        ensure("opened", reader.open(binary.data(), binary.size()));
+        ensure_equals("cache version", reader.getCacheVersion(), CACHE_VERSION);
+        ensure_equals("folder count", reader.getCategoryCount(), (S32)folders.size());
+        ensure_equals("item count", reader.getItemCount(), (S32)items.size());
+
+        std::string llsd;
+        write_llsd(folders, items, llsd);
+        LLInventoryCategory::cat_array_t llsd_folders;
+        LLInventoryItem::item_array_t llsd_items;
+        read_llsd(llsd, llsd_folders, llsd_items);
+
+        LLInventoryCategory::cat_array_t binary_folders;
+        LLInventoryItem::item_array_t binary_items;
+        read_binary(reader, binary_folders, binary_items);
+
+        ensure_equals("same folder count", binary_folders.size(), llsd_folders.size());
+        for (size_t i = 0; i < binary_folders.size(); ++i)
+        {
+            ensure(STRINGIZE("folder " << i), same_folder(*binary_folders[i], *llsd_folders[i]));
+            ensure_equals("folder version", reader.getCategoryVersion((S32)i), folder_version((S32)i));
+            ensure_equals("folder owner", reader.getCategoryOwnerID((S32)i), make_id(10, 0));
+            ensure_equals("folder id", reader.getCategoryID((S32)i), folders[i]->getUUID());
+        }
+        ensure_equals("same item count", binary_items.size(), llsd_items.size());
+        for (size_t i = 0; i < binary_items.size(); ++i)
+        {
+            ensure(STRINGIZE("item " << i), same_item(*binary_items[i], *llsd_items[i]));
+        }
+
+        ensure_equals("asset id of a restricted item", binary_items[0]->getAssetUUID(), items[0]->getAssetUUID());
+        ensure_equals("inventory type corrected", binary_items[1]->getInventoryType(), LLInventoryType::IT_TEXTURE);
+    }
+
+    // Anything but a complete cache of this format version is refused
+    template<> template<>
+    void inventorycache_object::test<2>()
+    {
+        LLInventoryCategory::cat_array_t folders;
+        LLInventoryItem::item_array_t items;
+        make_inventory(3, 10, folders, items);
+        std::vector<U8> binary;
+        write_binary(folders, items, binary);
+
+        LLInventoryCacheReader reader;
+        ensure("empty", !reader.open(binary.data(), 0));
+        ensure("truncated", !reader.open(binary.data(), binary.size() - 1));
+
+        std::vector<U8> bad(binary);
+        bad[0] ^= 1;
+        ensure("magic", !reader.open(bad.data(), bad.size()));
+        bad = binary;
+        bad[sizeof(U32)] ^= 1;
+        ensure("format version", !reader.open(bad.data(), bad.size()));
+
+        std::string llsd;
+        write_llsd(folders, items, llsd);
+        ensure("LLSD cache", !reader.open((const U8*)llsd.data(), llsd.size()));
+
+        ensure("complete cache", reader.open(binary.data(), binary.size()));
+    }
+
+    // Saving goes through a temporary file, loading maps the file
+    template<> template<>
+    void inventorycache_object::test<3>()
+    {
+        LLInventoryCategory::cat_array_t folders;
+        LLInventoryItem::item_array_t items;
+        make_inventory(5, 100, folders, items);
+        std::vector<U8> binary;
+        write_binary(folders, items, binary);
+
+        LLUUID random;
+        random.generate();
+        const std::string filename = STRINGIZE(LLFile::tmpdir() << "llinventorycache-test-" << random << ".inv.bin");
+        ensure("written", LLInventoryCacheWriter::writeFile(filename, binary));
+        // Replaces the previous cache
+        ensure("rewritten", LLInventoryCacheWriter::writeFile(filename, binary));
+        std::error_code ec;
+        const std::string prefix = std::filesystem::path(filename).filename().string();
+        size_t files = 0;
+        for (const auto& entry : std::filesystem::directory_iterator(LLFile::tmpdir(), ec))
+        {
+            files += entry.path().filename().string().starts_with(prefix) ? 1 : 0;
+        }
+        ensure_equals("no temporary file left", files, (size_t)1);
+
+        LLInventoryCacheReader reader;
+        ensure("mapped", reader.open(filename));
+        LLInventoryCategory::cat_array_t binary_folders;
+        LLInventoryItem::item_array_t binary_items;
+        read_binary(reader, binary_folders, binary_items);
+        reader.close();
+        LLFile::remove(filename);
+
+        ensure_equals("item count", binary_items.size(), items.size());
+        for (size_t i = 0; i < items.size(); ++i)
+        {
+            ensure(STRINGIZE("item " << i), same_item(*binary_items[i], *items[i]));
+        }
+        ensure("missing file", !reader.open(filename));
+    }
+
+    // Loading a 300K item inventory both ways.  Only informative: the
+    // speedup depends on the cores available.  Takes several seconds, so it
+    // only runs when asked for.
+    template<> template<>
+    void inventorycache_object::test<4>()
+    {
+        if (!getenv("LL_TEST_BENCHMARK"))
+        {
+            skip("benchmark, set LL_TEST_BENCHMARK to run it");
+        }
+
+        const S32 ITEMS = 300000;
+        const S32 FOLDERS = 15000;
+
+        LLInventoryCategory::cat_array_t folders;
+        LLInventoryItem::item_array_t items;
+        make_inventory(FOLDERS, ITEMS, folders, items);
+
+        LLTimer timer;
+        std::string llsd;
+        write_llsd(folders, items, llsd);
+        const F64 llsd_save_ms = timer.getElapsedTimeF64() * 1000.0;
+
+        timer.reset();
+        std::vector<U8> binary;
+        write_binary(folders, items, binary);
+        const F64 binary_save_ms = timer.getElapsedTimeF64() * 1000.0;
+
+        timer.reset();
+        LLInventoryCategory::cat_array_t llsd_folders;
+        LLInventoryItem::item_array_t llsd_items;
+        read_llsd(llsd, llsd_folders, llsd_items);
+        const F64 llsd_load_ms = timer.getElapsedTimeF64() * 1000.0;
+
+        timer.reset();
+        LLInventoryCacheReader reader;
+        reader.open(binary.data(), binary.size());
+        LLInventoryCategory::cat_array_t binary_folders;
+        LLInventoryItem::item_array_t binary_items;
+        read_binary(reader, binary_folders, binary_items);
+        const F64 binary_load_ms = timer.getElapsedTimeF64() * 1000.0;
+
+        ensure_equals("LLSD items", llsd_items.size(), (size_t)ITEMS);
+        ensure_equals("binary items", binary_items.size(), (size_t)ITEMS);
+        ensure("last item", same_item(*binary_items.back(), *llsd_items.back()));
+
+        std::cout << "\n" << ITEMS << " items in " << FOLDERS << " folders:\n"
+                  << "LLSD notation: " << llsd.size() / 1024 << " KB, saved in " << llsd_save_ms
+                  << " ms, loaded in " << llsd_load_ms << " ms\n"
+                  << "binary: " << binary.size() / 1024 << " KB, saved in " << binary_save_ms
+                  << " ms, loaded in " << binary_load_ms << " ms" << std::endl;
+    }
+}
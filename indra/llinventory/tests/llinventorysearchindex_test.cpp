@@ -0,0 +1,280 @@
+/**
+ * @file llinventorysearchindex_test.cpp
+ * @date 2024-11
+ * @brief Test cases for the inventory search index.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llinventorysearchindex.h"
+#include "llstring.h"
+#include "lltimer.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include "../test/lltut.h"
+
+namespace
+{
+    const char* WORDS[] =
+    {
+        "Red", "Blue", "Leather", "Jacket", "Boots", "Mesh", "Hair", "Skin",
+        "Shape", "Eyes", "Dress", "Silver", "Ring", "Wooden", "Chair", "Lamp",
+        "Vintage", "Tattoo", "Pose", "Gesture", "Texture", "Script", "Deluxe", "Kit"
+    };
+    const S32 WORD_COUNT = LL_ARRAY_SIZE(WORDS);
+
+    LLUUID make_id(U32 index)
+    {
+        LLUUID id;
+        U32 words[4] = { index, index * 2654435761u, 0x5bd1e995, ~index };
+        memcpy(id.mData, words, sizeof(words));
+        return id;
+    }
+
+    std::string make_text(U32 index, S32 words)
+    {
+        std::string text;
+        U32 state = index * 7919u + 17u;
+        for (S32 i = 0; i < words; ++i)
+        {
+            state = state * 1103515245u + 12345u;
+            if (!text.empty())
+            {
+                text += ' ';
+            }
+            text += WORDS[(state >> 16) % WORD_COUNT];
+        }
+        return text + llformat(" %u", index);
+    }
+
+    struct Entry
+    {
+        LLUUID mID;
+        std::string mText[LLInventorySearchIndex::FIELD_COUNT];
+    };
+
+    void fill(LLInventorySearchIndex& index, std::vector<Entry>& entries, U32 count)
+    {
+        entries.resize(count);
+        for (U32 i = 0; i < count; ++i)
+        {
+            Entry& entry = entries[i];
+            entry.mID = make_id(i);
+            entry.mText[LLInventorySearchIndex::FIELD_NAME] = make_text(i, 3);
+            entry.mText[LLInventorySearchIndex::FIELD_DESCRIPTION] = (i % 3) ? make_text(i + 1000000, 6) : "";
+            entry.mText[LLInventorySearchIndex::FIELD_CREATOR] = llformat("Creator%u Resident", i % 997);
+            for (S32 field = 0; field < LLInventorySearchIndex::FIELD_COUNT; ++field)
+            {
+                index.setField(entry.mID, (LLInventorySearchIndex::EField)field, entry.mText[field]);
+            }
+        }
+    }
+
+    // What LLInventoryFilter did for every item: upper case each field and
+    // look for the string
+    void brute_force(const std::vector<Entry>& entries, U32 field_mask, const std::string& sub_string, uuid_vec_t& results)
+    {
+        for (const Entry& entry : entries)
+        {
+            for (S32 field = 0; field < LLInventorySearchIndex::FIELD_COUNT; ++field)
+            {
+                if (!(field_mask & (1 << field)))
+                {
+                    continue;
+                }
+                std::string text = entry.mText[field];
+                LLStringUtil::toUpper(text);
+                if (text.find(sub_string) != std::string::npos)
+                {
+                    results.push_back(entry.mID);
+                    break;
+                }
+            }
+        }
+    }
+
+    bool same_ids(uuid_vec_t a, uuid_vec_t b)
+    {
+        std::sort(a.begin(), a.end());
+        std::sort(b.begin(), b.end());
+        return a == b;
+    }
+}
+
+namespace tut
+{
+    struct searchindex_data
+    {
+    };
+    typedef test_group<searchindex_data> searchindex_test;
+    typedef searchindex_test::object searchindex_object;
+    tut::searchindex_test searchindex_testcase("LLInventorySearchIndex");
+
+    // Queries find exactly what a scan of every field finds
+    template<> template<>
+    void searchindex_object::test<1>()
+    {
+        LLInventorySearchIndex index;
+        std::vector<Entry> entries;
+        fill(index, entries, 5000);
+        ensure_equals("object count", index.getObjectCount(), 5000);
+
+        const char* queries[] = { "", "E", "KI", "RED", "LEATHER", "ATHER JAC", "CREATOR12 ", "4999", "NOTHING", " " };
+        const U32 masks[] =
+        {
+            1 << LLInventorySearchIndex::FIELD_NAME,
+            1 << LLInventorySearchIndex::FIELD_DESCRIPTION,
+            1 << LLInventorySearchIndex::FIELD_CREATOR,
+            (1 << LLInventorySearchIndex::FIELD_NAME) | (1 << LLInventorySearchIndex::FIELD_DESCRIPTION),
+            LLInventorySearchIndex::FIELD_MASK_ALL
+        };
+        for (const char* query : queries)
+        {
+            for (U32 mask : masks)
+            {
+                uuid_vec_t found;
+                uuid_vec_t expected;
+                index.find(mask, query, found);
+                brute_force(entries, mask, query, expected);
+                ensure(llformat("query '%s' fields %u", query, mask), same_ids(found, expected));
+            }
+        }
+
+        ensure("matches name", index.matches(entries[42].mID, 1 << LLInventorySearchIndex::FIELD_NAME, " 42"));
+        ensure("no match in other field", !index.matches(entries[42].mID, 1 << LLInventorySearchIndex::FIELD_CREATOR, " 42"));
+        ensure("stored upper case", index.getField(entries[42].mID, LLInventorySearchIndex::FIELD_CREATOR) == "CREATOR42 RESIDENT");
+        ensure("unknown object", !index.matches(make_id(999999), LLInventorySearchIndex::FIELD_MASK_ALL, ""));
+    }
+
+    // Renames and removals, enough of them to rebuild the trigram lists
+    template<> template<>
+    void searchindex_object::test<2>()
+    {
+        LLInventorySearchIndex index;
+        std::vector<Entry> entries;
+        fill(index, entries, 20000);
+
+        const U32 generation = index.getGeneration();
+        index.setField(entries[0].mID, LLInventorySearchIndex::FIELD_NAME, entries[0].mText[LLInventorySearchIndex::FIELD_NAME]);
+        ensure_equals("unchanged text keeps the generation", index.getGeneration(), generation);
+
+        for (S32 pass = 0; pass < 4; ++pass)
+        {
+            for (U32 i = 0; i < entries.size(); i += 2)
+            {
+                entries[i].mText[LLInventorySearchIndex::FIELD_NAME] = make_text(i * 31 + pass, 4);
+                index.setField(entries[i].mID, LLInventorySearchIndex::FIELD_NAME, entries[i].mText[LLInventorySearchIndex::FIELD_NAME]);
+            }
+        }
+        ensure("generation moved", index.getGeneration() != generation);
+
+        // Remove every fifth object, then reuse some of the slots
+        std::vector<Entry> kept;
+        for (U32 i = 0; i < entries.size(); ++i)
+        {
+            if (i % 5 == 0)
+            {
+                index.removeObject(entries[i].mID);
+            }
+            else
+            {
+                kept.push_back(entries[i]);
+            }
+        }
+        ensure("removed", !index.hasObject(entries[5].mID));
+        std::vector<Entry> added;
+        for (U32 i = 0; i < 1000; ++i)
+        {
+            Entry entry;
+            entry.mID = make_id(100000 + i);
+            entry.mText[LLInventorySearchIndex::FIELD_NAME] = "Fresh " + make_text(i, 2);
+            index.setField(entry.mID, LLInventorySearchIndex::FIELD_NAME, entry.mText[LLInventorySearchIndex::FIELD_NAME]);
+            kept.push_back(entry);
+        }
+        ensure_equals("object count", index.getObjectCount(), (S32)kept.size());
+
+        const char* queries[] = { "RED", "FRESH", "SILVER RING", "KIT 1", "1999" };
+        for (const char* query : queries)
+        {
+            uuid_vec_t found;
+            uuid_vec_t expected;
+            index.find(LLInventorySearchIndex::FIELD_MASK_ALL, query, found);
+            brute_force(kept, LLInventorySearchIndex::FIELD_MASK_ALL, query, expected);
+            ensure(llformat("query '%s'", query), same_ids(found, expected));
+        }
+
+        index.clear();
+        ensure_equals("cleared", index.getObjectCount(), 0);
+        uuid_vec_t found;
+        index.find(LLInventorySearchIndex::FIELD_MASK_ALL, "RED", found);
+        ensure("nothing after clear", found.empty());
+    }
+
+    // Query latency on a large inventory.  Only informative, and only run
+    // when asked for.
+    template<> template<>
+    void searchindex_object::test<3>()
+    {
+        if (!getenv("LL_TEST_BENCHMARK"))
+        {
+            skip("benchmark, set LL_TEST_BENCHMARK to run it");
+        }
+
+        const U32 ITEMS = 200000;
+
+        LLTimer timer;
+        LLInventorySearchIndex index;
+        std::vector<Entry> entries;
+        fill(index, entries, ITEMS);
+        const F64 build_ms = timer.getElapsedTimeF64() * 1000.0;
+
+        std::cout << "\n" << ITEMS << " items indexed in " << build_ms << " ms\n";
+        const char* queries[] = { "LE", "LEA", "LEATHER", "RED LEATHER", "CREATOR99", "199999" };
+        const U32 mask = LLInventorySearchIndex::FIELD_MASK_ALL;
+        for (const char* query : queries)
+        {
+            const S32 ROUNDS = 5;
+            uuid_vec_t found;
+            timer.reset();
+            for (S32 i = 0; i < ROUNDS; ++i)
+            {
+                found.clear();
+                index.find(mask, query, found);
+            }
+            const F64 index_ms = timer.getElapsedTimeF64() * 1000.0 / ROUNDS;
+
+            uuid_vec_t expected;
+            timer.reset();
+            brute_force(entries, mask, query, expected);
+            const F64 scan_ms = timer.getElapsedTimeF64() * 1000.0;
+
+            ensure(llformat("query '%s'", query), same_ids(found, expected));
+            std::cout << "'" << query << "': " << found.size() << " matches, index "
+                      << index_ms << " ms, scan " << scan_ms << " ms\n";
+        }
+        std::cout << std::flush;
+    }
+}
@@ -47,6 +47,7 @@
 #include "llvolume.h"
 #include "llstl.h"
 #include "llsdserialize.h"
+#include "llmemorystream.h"
 #include "llvector4a.h"
 #include "llmatrix4a.h"
 #include "llmeshoptimizer.h"
@@ -2307,40 +2308,97 @@ bool LLVolumeFace::VertexData::compareNormal(const LLVolumeFace::VertexData& rhs
     return retval;
 }
 
+namespace
+{
+    // Mesh LoD blocks are an array of face maps holding small domain
+    // arrays, anything nested deeper than this is malformed.
+    constexpr S32 MESH_LOD_MAX_DEPTH = 8;
+
+    void view_to_vector3(LLVector3& vec, const LLSDBinaryView& sd)
+    {
+        vec.set((F32)sd[0].asReal(), (F32)sd[1].asReal(), (F32)sd[2].asReal());
+    }
+
+    void view_to_vector2(LLVector2& vec, const LLSDBinaryView& sd)
+    {
+        vec.set((F32)sd[0].asReal(), (F32)sd[1].asReal());
+    }
+
+    // A field read as raw bytes, or an empty view if malformed data put
+    // anything but a binary there, the way LLSD::asBinary() reads it
+    LLSDBinaryView binary_field(const LLSDBinaryView& field)
+    {
+        return field.isBinary() ? field : LLSDBinaryView();
+    }
+
+    // Binary fields sit at arbitrary offsets in the inflated buffer
+    inline U16 load_u16(const U8* p)
+    {
+        U16 v;
+        memcpy(&v, p, sizeof(U16));
+        return v;
+    }
+}
+
 bool LLVolume::unpackVolumeFaces(std::istream& is, S32 size)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_VOLUME;
 
     //input stream is now pointing at a zlib compressed block of LLSD
     //decompress block
-    LLSD mdl;
-    U32 uzip_result = LLUZipHelper::unzip_llsd(mdl, is, size);
+    std::vector<U8> buffer;
+    U32 uzip_result = LLUZipHelper::unzip_buffer(buffer, is, size);
     if (uzip_result != LLUZipHelper::ZR_OK)
     {
         LL_DEBUGS("MeshStreaming") << "Failed to unzip LLSD blob for LoD with code " << uzip_result << " , will probably fetch from sim again." << LL_ENDL;
         return false;
     }
-    return unpackVolumeFacesInternal(mdl);
+    return unpackVolumeFacesInternal(buffer);
 }
 
 bool LLVolume::unpackVolumeFaces(U8* in_data, S32 size)
 {
     //input data is now pointing at a zlib compressed block of LLSD
     //decompress block
-    LLSD mdl;
-    U32 uzip_result = LLUZipHelper::unzip_llsd(mdl, in_data, size);
+    std::vector<U8> buffer;
+    U32 uzip_result = LLUZipHelper::unzip_buffer(buffer, in_data, size);
     if (uzip_result != LLUZipHelper::ZR_OK)
     {
         LL_DEBUGS("MeshStreaming") << "Failed to unzip LLSD blob for LoD with code " << uzip_result << " , will probably fetch from sim again." << LL_ENDL;
         return false;
     }
+    return unpackVolumeFacesInternal(buffer);
+}
+
+bool LLVolume::unpackVolumeFacesInternal(std::vector<U8>& buffer)
+{
+    // Decode straight out of the inflated block instead of building an
+    // LLSD tree and copying every binary field out of it
+    LLSDBinaryView mdl(buffer.data(), buffer.size(), MESH_LOD_MAX_DEPTH);
+    if (!mdl.isValid())
+    {
+        // Not something the view can walk (e.g. quoted map keys), round
+        // trip it through LLSD so it ends up in the canonical encoding.
+        LLSD sd;
+        LLMemoryStream istr(buffer.data(), static_cast<S32>(buffer.size()));
+        if (LLSDSerialize::fromBinary(sd, istr, buffer.size(), MESH_LOD_MAX_DEPTH) <= 0)
+        {
+            LL_DEBUGS("MeshStreaming") << "Failed to parse LLSD blob for LoD, will probably fetch from sim again." << LL_ENDL;
+            return false;
+        }
+        std::ostringstream ostr;
+        LLSDSerialize::toBinary(sd, ostr);
+        const std::string& str = ostr.str();
+        buffer.assign(str.begin(), str.end());
+        mdl = LLSDBinaryView(buffer.data(), buffer.size(), MESH_LOD_MAX_DEPTH);
+    }
     return unpackVolumeFacesInternal(mdl);
 }
 
-bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
+bool LLVolume::unpackVolumeFacesInternal(const LLSDBinaryView& mdl)
 {
     {
-        auto face_count = mdl.size();
+        auto face_count = mdl.isArray() ? mdl.size() : 0;
 
         if (face_count == 0)
         { //no faces unpacked, treat as failed decode
@@ -2353,8 +2411,9 @@ bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
         for (size_t i = 0; i < face_count; ++i)
         {
             LLVolumeFace& face = mVolumeFaces[i];
+            const LLSDBinaryView face_data = mdl[i];
 
-            if (mdl[i].has("NoGeometry"))
+            if (face_data.has("NoGeometry"))
             { //face has no geometry, continue
                 face.resizeIndices(3);
                 face.resizeVertices(1);
@@ -2365,11 +2424,10 @@ bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
                 continue;
             }
 
-            const LLSD::Binary& pos = mdl[i]["Position"].asBinary();
-            const LLSD::Binary& norm = mdl[i]["Normal"].asBinary();
-            const LLSD::Binary& tangent = mdl[i]["Tangent"].asBinary();
-            const LLSD::Binary& tc = mdl[i]["TexCoord0"].asBinary();
-            const LLSD::Binary& idx = mdl[i]["TriangleList"].asBinary();
+            const LLSDBinaryView pos = binary_field(face_data["Position"]);
+            const LLSDBinaryView norm = binary_field(face_data["Normal"]);
+            const LLSDBinaryView tc = binary_field(face_data["TexCoord0"]);
+            const LLSDBinaryView idx = binary_field(face_data["TriangleList"]);
 
             //copy out indices
             auto num_indices = idx.size() / 2;
@@ -2388,17 +2446,13 @@ bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
                 continue;
             }
 
-            if (idx.empty() || face.mNumIndices < 3)
+            if (idx.size() == 0 || face.mNumIndices < 3)
             { //why is there an empty index list?
                 LL_WARNS() << "Empty face present! Face index: " << i << " Total: " << face_count << LL_ENDL;
                 continue;
             }
 
-            U16* indices = (U16*) &(idx[0]);
-            for (U32 j = 0; j < num_indices; ++j)
-            {
-                face.mIndices[j] = indices[j];
-            }
+            memcpy(face.mIndices, idx.data(), num_indices * sizeof(U16));
 
             //copy out vertices
             U32 num_verts = static_cast<U32>(pos.size())/(3*2);
@@ -2416,19 +2470,22 @@ bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
             LLVector2 min_tc;
             LLVector2 max_tc;
 
-            minp.setValue(mdl[i]["PositionDomain"]["Min"]);
-            maxp.setValue(mdl[i]["PositionDomain"]["Max"]);
+            const LLSDBinaryView pos_domain = face_data["PositionDomain"];
+            view_to_vector3(minp, pos_domain["Min"]);
+            view_to_vector3(maxp, pos_domain["Max"]);
             LLVector4a min_pos, max_pos;
             min_pos.load3(minp.mV);
             max_pos.load3(maxp.mV);
 
-            min_tc.setValue(mdl[i]["TexCoord0Domain"]["Min"]);
-            max_tc.setValue(mdl[i]["TexCoord0Domain"]["Max"]);
+            const LLSDBinaryView tc_domain = face_data["TexCoord0Domain"];
+            view_to_vector2(min_tc, tc_domain["Min"]);
+            view_to_vector2(max_tc, tc_domain["Max"]);
 
             //unpack normalized scale/translation
-            if (mdl[i].has("NormalizedScale"))
+            const LLSDBinaryView normalized_scale = face_data["NormalizedScale"];
+            if (!normalized_scale.isUndefined())
             {
-                face.mNormalizedScale.setValue(mdl[i]["NormalizedScale"]);
+                view_to_vector3(face.mNormalizedScale, normalized_scale);
             }
             else
             {
@@ -2448,31 +2505,31 @@ bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
             LLVector4a* tc_out = (LLVector4a*) face.mTexCoords;
 
             {
-                U16* v = (U16*) &(pos[0]);
+                const U8* v = pos.data();
                 for (U32 j = 0; j < num_verts; ++j)
                 {
-                    pos_out->set((F32) v[0], (F32) v[1], (F32) v[2]);
+                    pos_out->set((F32) load_u16(v), (F32) load_u16(v + 2), (F32) load_u16(v + 4));
                     pos_out->div(65535.f);
                     pos_out->mul(pos_range);
                     pos_out->add(min_pos);
                     pos_out++;
-                    v += 3;
+                    v += 6;
                 }
 
             }
 
             {
-                if (!norm.empty())
+                if (norm.size() >= num_verts * 6)
                 {
-                    U16* n = (U16*) &(norm[0]);
+                    const U8* n = norm.data();
                     for (U32 j = 0; j < num_verts; ++j)
                     {
-                        norm_out->set((F32) n[0], (F32) n[1], (F32) n[2]);
+                        norm_out->set((F32) load_u16(n), (F32) load_u16(n + 2), (F32) load_u16(n + 4));
                         norm_out->div(65535.f);
                         norm_out->mul(2.f);
                         norm_out->sub(1.f);
                         norm_out++;
-                        n += 3;
+                        n += 6;
                     }
                 }
                 else
@@ -2487,10 +2544,11 @@ bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
 
 #if 0 // keep this code for now in case we decide to add support for on-the-wire tangents
             {
-                if (!tangent.empty())
+                const LLSDBinaryView tangent = binary_field(face_data["Tangent"]);
+                if (tangent.size() > 0)
                 {
                     face.allocateTangents(face.mNumVertices);
-                    U16* t = (U16*)&(tangent[0]);
+                    U16* t = (U16*)tangent.data();
 
                     // NOTE: tangents coming from the asset may not be mikkt space, but they should always be used by the GLTF shaders to
                     // maintain compliance with the GLTF spec
@@ -2514,21 +2572,21 @@ bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
 #endif
 
             {
-                if (!tc.empty())
+                if (tc.size() >= num_verts * 4)
                 {
-                    U16* t = (U16*) &(tc[0]);
+                    const U8* t = tc.data();
                     for (U32 j = 0; j < num_verts; j+=2)
                     {
                         if (j < num_verts-1)
                         {
-                            tc_out->set((F32) t[0], (F32) t[1], (F32) t[2], (F32) t[3]);
+                            tc_out->set((F32) load_u16(t), (F32) load_u16(t + 2), (F32) load_u16(t + 4), (F32) load_u16(t + 6));
                         }
                         else
                         {
-                            tc_out->set((F32) t[0], (F32) t[1], 0.f, 0.f);
+                            tc_out->set((F32) load_u16(t), (F32) load_u16(t + 2), 0.f, 0.f);
                         }
 
-                        t += 4;
+                        t += 8;
 
                         tc_out->div(65535.f);
                         tc_out->mul(tc_range);
@@ -2547,8 +2605,10 @@ bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
                 }
             }
 
-            if (mdl[i].has("Weights"))
+            const LLSDBinaryView weights_field = face_data["Weights"];
+            if (!weights_field.isUndefined())
             {
+                const LLSDBinaryView weights_data = binary_field(weights_field);
                 face.allocateWeights(num_verts);
                 if (!face.mWeights && num_verts)
                 {
@@ -2558,12 +2618,13 @@ bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
                     continue;
                 }
 
-                const LLSD::Binary& weights = mdl[i]["Weights"].asBinary();
+                const U8* weights = weights_data.data();
+                const size_t weights_size = weights_data.size();
 
                 U32 idx = 0;
 
                 U32 cur_vertex = 0;
-                while (idx < weights.size() && cur_vertex < num_verts)
+                while (idx < weights_size && cur_vertex < num_verts)
                 {
                     const U8 END_INFLUENCES = 0xFF;
                     U8 joint = weights[idx++];
@@ -2573,7 +2634,7 @@ bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
                     U32 joints[4] = {0,0,0,0};
                     LLVector4 joints_with_weights(0,0,0,0);
 
-                    while (joint != END_INFLUENCES && idx < weights.size())
+                    while (joint != END_INFLUENCES && idx < weights_size)
                     {
                         U16 influence = weights[idx++];
                         influence |= ((U16) weights[idx++] << 8);
@@ -2610,7 +2671,7 @@ bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
                     cur_vertex++;
                 }
 
-                if (cur_vertex != num_verts || idx != weights.size())
+                if (cur_vertex != num_verts || idx != weights_size)
                 {
                     LL_WARNS() << "Vertex weight count does not match vertex count!" << LL_ENDL;
                 }
@@ -34,6 +34,7 @@ class LLPathParams;
 class LLVolumeParams;
 class LLProfile;
 class LLPath;
+class LLSDBinaryView;
 
 template<class T> class LLPointer;
 template <class T, typename T_PTR> class LLOctreeNode;
@@ -1121,7 +1122,8 @@ public:
     bool unpackVolumeFaces(std::istream& is, S32 size);
     bool unpackVolumeFaces(U8* in_data, S32 size);
 private:
-    bool unpackVolumeFacesInternal(const LLSD& mdl);
+    bool unpackVolumeFacesInternal(std::vector<U8>& buffer);
+    bool unpackVolumeFacesInternal(const LLSDBinaryView& mdl);
 
 public:
     virtual void setMeshAssetLoaded(bool loaded);
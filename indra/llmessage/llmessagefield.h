@@ -0,0 +1,71 @@
+/**
+ * @file llmessagefield.h
+ * @brief Declaration of LLMessageField, a block/variable pair resolved
+ * against a message template.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLMESSAGEFIELD_H
+#define LL_LLMESSAGEFIELD_H
+
+#include "llmsgvariabletype.h"
+
+class LLMessageTemplate;
+
+// Where a variable lives in a decoded message: the index of its block
+// in the template and its index within the block.  Resolving one costs
+// the same name lookups as a single get*Fast() call, reading through it
+// afterwards costs none, so handlers reading the same variable from many
+// block repeats should resolve once per message and read by field.
+//
+// The canonical block and variable names are kept so that messages which
+// didn't come through the template reader (LLSD) can still be read.
+class LLMessageField
+{
+public:
+    LLMessageField()
+        : mTemplate(NULL),
+          mBlockName(NULL),
+          mVarName(NULL),
+          mBlockIndex(-1),
+          mVarIndex(-1),
+          mSize(-1),
+          mType(MVT_NULL)
+    {
+    }
+
+    // True if the field was found in a template and can be read
+    // without lookups.
+    bool isResolved() const { return mTemplate != NULL; }
+
+public:
+    const LLMessageTemplate*    mTemplate;
+    const char*                 mBlockName;
+    const char*                 mVarName;
+    S32                         mBlockIndex;
+    S32                         mVarIndex;
+    S32                         mSize;      // Template size, data size for MVT_VARIABLE is per block
+    EMsgVariableType            mType;
+};
+
+#endif // LL_LLMESSAGEFIELD_H
@@ -0,0 +1,290 @@
+/**
+ * @file llpacketreceiver.cpp
+ * @brief Network thread which receives and frames incoming packets
+ * ahead of LLMessageSystem::checkMessages().
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llpacketreceiver.h"
+
+#if LL_WINDOWS
+    #include <winsock2.h>
+#else
+    #include <netinet/in.h>
+#endif
+
+#include "llcircuit.h"      // LL_PACKET_ID_SIZE
+#include "llproxy.h"
+#include "lltimer.h"
+#include "message.h"
+
+// How long the thread blocks on an idle socket before checking
+// whether it's been asked to quit.
+static const S32 RECEIVE_WAIT_MS = 50;
+
+// Most datagrams picked up in one go.
+static const S32 RECEIVE_BATCH = 64;
+
+///////////////////////////////////////////////////////////
+
+S32 zero_code_expand(const U8 * in, S32 in_size, U8 * out, S32 out_size)
+{
+    const U8 * in_end = in + in_size;
+    U8 * out_end = out + out_size;
+    U8 * outp = out;
+
+    // skip the packet id field
+    for (U32 ii = 0; ii < LL_PACKET_ID_SIZE && in < in_end; ++ii)
+    {
+        *outp++ = *in++;
+    }
+    out[0] &= ~LL_ZERO_CODE_FLAG;
+
+    // sequential zero bytes are encoded as 0 [U8 count]
+    // with 0 0 [count] representing wrap (>256 zeroes)
+    while (in < in_end)
+    {
+        if (outp >= out_end)
+        {
+            return -1;
+        }
+        if ((*outp++ = *in++))
+        {
+            continue;
+        }
+
+        while (in < in_end && !*in)
+        {
+            ++in;
+            if (outp + 256 > out_end)
+            {
+                return -1;
+            }
+            memset(outp, 0, 256);
+            outp += 256;
+        }
+        if (in == in_end)
+        {
+            break;
+        }
+
+        const S32 count = *in++;
+        if (outp + count - 1 > out_end)
+        {
+            return -1;
+        }
+        memset(outp, 0, count - 1);
+        outp += count - 1;
+    }
+
+    return (S32)(outp - out);
+}
+
+///////////////////////////////////////////////////////////
+
+LLFramedPacket::LLFramedPacket()
+    : mSize(0),
+      mMessage(NULL),
+      mMessageSize(0),
+      mPayloadSize(0),
+      mCompressedSize(0),
+      mAckCount(0),
+      mMalformed(false),
+      mOverflow(false)
+{
+}
+
+void LLFramedPacket::frame()
+{
+    U8 * buffer = (U8 *)mData;
+    S32 size = mSize;
+
+    mMessage = buffer;
+    mMessageSize = size;
+    mPayloadSize = size;
+    mCompressedSize = 0;
+    mAckCount = 0;
+    mMalformed = false;
+    mOverflow = false;
+
+    if (size < LL_MINIMUM_VALID_PACKET_SIZE)
+    {
+        return;
+    }
+
+    // note if packet acks are appended.
+    if (buffer[0] & LL_ACK_FLAG)
+    {
+        mAckCount = buffer[--size];
+        S32 ack_pos = size;
+        if (size >= (S32)(mAckCount * sizeof(TPACKETID) + LL_MINIMUM_VALID_PACKET_SIZE))
+        {
+            size -= mAckCount * sizeof(TPACKETID);
+        }
+        else
+        {
+            mMalformed = true;
+            mPayloadSize = size;
+            mMessageSize = size;
+            return;
+        }
+
+        U32 mem_id = 0;
+        for (S32 i = 0; i < mAckCount; ++i)
+        {
+            ack_pos -= sizeof(TPACKETID);
+            memcpy(&mem_id, &buffer[ack_pos], sizeof(TPACKETID)); /* Flawfinder: ignore*/
+            mAcks[i] = ntohl(mem_id);
+        }
+    }
+
+    mPayloadSize = size;
+    mMessageSize = size;
+
+    if (buffer[0] & LL_ZERO_CODE_FLAG)
+    {
+        mCompressedSize = size;
+        mMessage = mExpanded;
+        mMessageSize = zero_code_expand(buffer, size, mExpanded, sizeof(mExpanded));
+        if (mMessageSize < 0)
+        {
+            mOverflow = true;
+            mMessageSize = 0;
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////
+
+LLPacketReceiver::LLPacketReceiver(S32 socket, S32 ring_size)
+    : LLThread("PacketReceiver"),
+      mSocket(socket),
+      mSlots(ring_size),
+      mDatagrams(RECEIVE_BATCH),
+      mHead(0),
+      mTail(0),
+      mHolding(false),
+      mStalls(0)
+{
+    llassert(ring_size > 0 && !(ring_size & (ring_size - 1)));
+}
+
+LLPacketReceiver::~LLPacketReceiver()
+{
+    shutdown();
+}
+
+LLFramedPacket * LLPacketReceiver::next()
+{
+    U32 tail = mTail.load(std::memory_order_relaxed);
+    if (mHolding)
+    {
+        // Done with the last one, give it back
+        mTail.store(++tail, std::memory_order_release);
+        mHolding = false;
+    }
+
+    if (tail == mHead.load(std::memory_order_acquire))
+    {
+        return NULL;
+    }
+
+    mHolding = true;
+    return &mSlots[tail % mSlots.size()];
+}
+
+void LLPacketReceiver::run()
+{
+    while (!isQuitting())
+    {
+        S32 added = fill();
+        if (added < 0)
+        {
+            // Main thread is behind, let the socket buffer take up
+            // the slack for a bit.
+            ms_sleep(1);
+        }
+        else if (!added)
+        {
+            wait_for_packet(mSocket, RECEIVE_WAIT_MS);
+        }
+    }
+}
+
+S32 LLPacketReceiver::fill()
+{
+    const U32 head = mHead.load(std::memory_order_relaxed);
+    const U32 tail = mTail.load(std::memory_order_acquire);
+    const S32 free_slots = (S32)mSlots.size() - (S32)(head - tail);
+    if (free_slots <= 0)
+    {
+        mStalls.fetch_add(1, std::memory_order_relaxed);
+        return -1;
+    }
+
+    const S32 batch = llmin(free_slots, (S32)mDatagrams.size());
+    for (S32 i = 0; i < batch; ++i)
+    {
+        mDatagrams[i].mBuffer = mSlots[(head + i) % mSlots.size()].mData;
+    }
+
+    const S32 received = receive_packets(mSocket, mDatagrams.data(), batch);
+    const bool socks = LLProxy::isSOCKSProxyEnabled();
+    for (S32 i = 0; i < received; ++i)
+    {
+        const LLNetDatagram & datagram = mDatagrams[i];
+        LLFramedPacket & packet = mSlots[(head + i) % mSlots.size()];
+
+        packet.mSize = datagram.mSize;
+        packet.mHost = LLHost(datagram.mSenderIP, datagram.mSenderPort);
+        packet.mReceivingIF = LLHost(datagram.mReceivingIP, INVALID_PORT);
+
+        if (socks)
+        {
+            if (packet.mSize > SOCKS_HEADER_SIZE)
+            {
+                // *FIX We are assuming ATYP is 0x01 (IPv4), not 0x03 (hostname) or 0x04 (IPv6)
+                proxywrap_t * header = static_cast<proxywrap_t*>(static_cast<void*>(packet.mData));
+                packet.mHost.setAddress(header->addr);
+                packet.mHost.setPort(ntohs(header->port));
+
+                packet.mSize -= SOCKS_HEADER_SIZE;
+                memmove(packet.mData, packet.mData + SOCKS_HEADER_SIZE, packet.mSize);
+            }
+            else
+            {
+                packet.mSize = 0;
+            }
+        }
+
+        packet.frame();
+    }
+
+    if (received > 0)
+    {
+        mHead.store(head + received, std::memory_order_release);
+    }
+    return received;
+}
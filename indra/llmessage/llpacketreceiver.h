@@ -0,0 +1,113 @@
+/**
+ * @file llpacketreceiver.h
+ * @brief Network thread which receives and frames incoming packets
+ * ahead of LLMessageSystem::checkMessages().
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLPACKETRECEIVER_H
+#define LL_LLPACKETRECEIVER_H
+
+#include <atomic>
+#include <vector>
+
+#include "llhost.h"
+#include "llthread.h"
+#include "net.h"
+
+// Expand a zero-coded packet body from in into out.  The packet header
+// is copied as-is except for the zero-code flag being cleared.
+// Returns the expanded size, or -1 if it doesn't fit in out_size.
+S32 zero_code_expand(const U8 * in, S32 in_size, U8 * out, S32 out_size);
+
+// A received datagram with its framing undone: appended acks split off
+// and the body zero-code expanded.  Everything checkMessages() used to do
+// before it needs circuit state, so it can be done off the main thread.
+class LLFramedPacket
+{
+public:
+    LLFramedPacket();
+
+    // Frame the datagram in mData/mSize.  Sizes below the minimum
+    // valid packet are left for the caller to reject.
+    void frame();
+
+public:
+    char        mData[NET_BUFFER_SIZE];     // Datagram as received   /* Flawfinder : ignore */
+    S32         mSize;
+    LLHost      mHost;
+    LLHost      mReceivingIF;
+
+    U8 *        mMessage;                   // Into mData or mExpanded
+    S32         mMessageSize;
+    S32         mPayloadSize;               // Size with acks removed, before expansion
+    S32         mCompressedSize;            // mPayloadSize if zero-coded, else 0
+    S32         mAckCount;
+    TPACKETID   mAcks[255];                 // Host order, last appended first
+    bool        mMalformed;                 // Ack count doesn't fit the datagram
+    bool        mOverflow;                  // Expansion didn't fit, mMessageSize is 0
+
+protected:
+    U8          mExpanded[NET_BUFFER_SIZE]; /* Flawfinder : ignore */
+};
+
+// Thread that drains the message system socket in batches into a
+// fixed ring of framed packets.  One producer (this thread), one
+// consumer (the main thread through LLPacketRing), no locks.
+class LLPacketReceiver : public LLThread
+{
+public:
+    // ring_size must be a power of two
+    LLPacketReceiver(S32 socket, S32 ring_size = 256);
+    ~LLPacketReceiver();
+
+    // Consumer side.  Returns the next framed packet or NULL if none
+    // is waiting.  The packet stays valid until the next call, which
+    // hands its slot back to the thread.
+    LLFramedPacket * next();
+
+    // Number of times the thread found the ring full and left packets
+    // waiting in the socket buffer.
+    U32 getStallCount() const { return mStalls.load(std::memory_order_relaxed); }
+
+protected:
+    void run() override;
+
+private:
+    // Receive and frame what fits in the free slots.
+    // Returns number of packets added.
+    S32 fill();
+
+private:
+    const S32                   mSocket;
+    std::vector<LLFramedPacket> mSlots;
+    std::vector<LLNetDatagram>  mDatagrams;
+
+    // Monotonic counts, slot index is count % size
+    std::atomic<U32>            mHead;      // Written by the thread
+    std::atomic<U32>            mTail;      // Written by the consumer
+    bool                        mHolding;   // Consumer has a slot out
+    std::atomic<U32>            mStalls;
+};
+
+#endif // LL_LLPACKETRECEIVER_H
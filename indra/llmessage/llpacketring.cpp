@@ -55,7 +55,8 @@ LLPacketRing::LLPacketRing () :
     mInBufferLength(0),
     mOutBufferLength(0),
     mDropPercentage(0.0f),
-    mPacketsToDrop(0x0)
+    mPacketsToDrop(0x0),
+    mReceiver(NULL)
 {
 }
 
@@ -68,6 +69,8 @@ LLPacketRing::~LLPacketRing ()
 ///////////////////////////////////////////////////////////
 void LLPacketRing::cleanup ()
 {
+    stopReceiveThread();
+
     LLPacketBuffer *packetp;
 
     while (!mReceiveQueue.empty())
@@ -270,6 +273,72 @@ S32 LLPacketRing::receivePacket (S32 socket, char *datap)
     return packet_size;
 }
 
+///////////////////////////////////////////////////////////
+void LLPacketRing::startReceiveThread(S32 socket)
+{
+    if (mReceiver || mUseInThrottle)
+    {
+        return;
+    }
+
+    LL_INFOS("Messaging") << "Starting packet receive thread" << LL_ENDL;
+    mReceiver = new LLPacketReceiver(socket);
+    mReceiver->start();
+}
+
+void LLPacketRing::stopReceiveThread()
+{
+    if (mReceiver)
+    {
+        LL_INFOS("Messaging") << "Stopping packet receive thread, ring was full "
+                              << mReceiver->getStallCount() << " times" << LL_ENDL;
+        delete mReceiver;
+        mReceiver = NULL;
+    }
+}
+
+///////////////////////////////////////////////////////////
+LLFramedPacket* LLPacketRing::receiveFramedPacket(S32 socket)
+{
+    if (mReceiver)
+    {
+        while (LLFramedPacket* packetp = mReceiver->next())
+        {
+            if (!packetp->mSize)
+            {
+                continue;
+            }
+
+            // Fake packet loss
+            if (mDropPercentage && (ll_frand(100.f) < mDropPercentage))
+            {
+                mPacketsToDrop++;
+            }
+
+            if (mPacketsToDrop)
+            {
+                mPacketsToDrop--;
+                continue;
+            }
+
+            mLastSender = packetp->mHost;
+            mLastReceivingIF = packetp->mReceivingIF;
+            return packetp;
+        }
+        return NULL;
+    }
+
+    mLocalPacket.mSize = receivePacket(socket, mLocalPacket.mData);
+    if (mLocalPacket.mSize <= 0)
+    {
+        return NULL;
+    }
+    mLocalPacket.mHost = mLastSender;
+    mLocalPacket.mReceivingIF = mLastReceivingIF;
+    mLocalPacket.frame();
+    return &mLocalPacket;
+}
+
 bool LLPacketRing::sendPacket(int h_socket, char * send_buffer, S32 buf_size, LLHost host)
 {
     bool status = true;
@@ -32,6 +32,7 @@
 
 #include "llhost.h"
 #include "llpacketbuffer.h"
+#include "llpacketreceiver.h"
 #include "llproxy.h"
 #include "llthrottle.h"
 #include "net.h"
@@ -53,6 +54,17 @@ public:
     S32  receivePacket (S32 socket, char *datap);
     S32  receiveFromRing (S32 socket, char *datap);
 
+    // Move receiving and framing of incoming packets to a network
+    // thread.  Not started while the incoming throttle is simulated.
+    void startReceiveThread(S32 socket);
+    void stopReceiveThread();
+    bool isReceiveThreadRunning() const         { return mReceiver != NULL; }
+
+    // Next incoming packet, already framed, or NULL if there's none.
+    // Comes from the network thread when it's running, otherwise
+    // from receivePacket().  Valid until the next call.
+    LLFramedPacket* receiveFramedPacket(S32 socket);
+
     bool sendPacket(int h_socket, char * send_buffer, S32 buf_size, LLHost host);
 
     inline LLHost getLastSender();
@@ -83,6 +95,9 @@ protected:
     LLHost mLastSender;
     LLHost mLastReceivingIF;
 
+    LLPacketReceiver* mReceiver;
+    LLFramedPacket mLocalPacket;    // For receiving on the calling thread
+
 private:
     bool sendPacketImpl(int h_socket, const char * send_buffer, S32 buf_size, LLHost host);
 };
@@ -39,7 +39,7 @@
 // We want this to be static to avoid excessive indirection on every
 // incoming packet just to do a simple bool test. The getter for this
 // member is also static
-bool LLProxy::sUDPProxyEnabled = false;
+LLAtomicBool LLProxy::sUDPProxyEnabled = false;
 LLProxy* LLProxy::sProxyInstance = NULL;
 
 // Some helpful TCP static functions.
@@ -299,6 +299,10 @@ private:
     ###########################################################################################*/
 
 private:
+    // Is the UDP proxy enabled? Safe to read in any thread, the packet
+    // receive thread unwraps SOCKS headers.
+    static LLAtomicBool sUDPProxyEnabled;
+
     // Is the HTTP proxy enabled? Safe to read in any thread, but do not write directly.
     // Instead use enableHTTPProxy() and disableHTTPProxy() instead.
     mutable LLAtomicBool mHTTPProxyEnabled;
@@ -310,9 +314,6 @@ private:
     MEMBERS READ AND WRITTEN ONLY IN THE MAIN THREAD. DO NOT SHARE!
     ###########################################################################################*/
 
-    // Is the UDP proxy enabled?
-    static bool sUDPProxyEnabled;
-
     // UDP proxy address and port
     LLHost mUDPProxy;
     // TCP proxy control channel address and port
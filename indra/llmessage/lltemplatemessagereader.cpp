@@ -63,6 +63,57 @@ void LLTemplateMessageReader::clearMessage()
     mCurrentRMessageTemplate = NULL;
     delete mCurrentRMessageData;
     mCurrentRMessageData = NULL;
+    mBlockData.clear();
+    mBlockStart.clear();
+}
+
+// Copy out a decoded variable, checking it matches the size asked for
+static void copy_var_data(const LLMsgVarData& vardata, const char *msgname,
+                          const char *varname, void *datap, S32 size, S32 max_size)
+{
+    if (size && size != vardata.getSize())
+    {
+        LL_ERRS() << "Msg " << msgname
+            << " variable " << varname
+            << " is size " << vardata.getSize()
+            << " but copying into buffer of size " << size
+            << LL_ENDL;
+        return;
+    }
+
+    const S32 vardata_size = vardata.getSize();
+    if( max_size >= vardata_size )
+    {
+        switch( vardata_size )
+        {
+        case 1:
+            *((U8*)datap) = *((U8*)vardata.getData());
+            break;
+        case 2:
+            *((U16*)datap) = *((U16*)vardata.getData());
+            break;
+        case 4:
+            *((U32*)datap) = *((U32*)vardata.getData());
+            break;
+        case 8:
+            ((U32*)datap)[0] = ((U32*)vardata.getData())[0];
+            ((U32*)datap)[1] = ((U32*)vardata.getData())[1];
+            break;
+        default:
+            memcpy(datap, vardata.getData(), vardata_size);
+            break;
+        }
+    }
+    else
+    {
+        LL_WARNS() << "Msg " << msgname
+            << " variable " << varname
+            << " is size " << vardata.getSize()
+            << " but truncated to max size of " << max_size
+            << LL_ENDL;
+
+        memcpy(datap, vardata.getData(), max_size);
+    }
 }
 
 void LLTemplateMessageReader::getData(const char *blockname, const char *varname, void *datap, S32 size, S32 blocknum, S32 max_size)
@@ -104,50 +155,98 @@ void LLTemplateMessageReader::getData(const char *blockname, const char *varname
 
     LLMsgVarData& vardata = msg_block_data->mMemberVarData[vnamep];
 
-    if (size && size != vardata.getSize())
+    copy_var_data(vardata, mCurrentRMessageData->mName, vnamep, datap, size, max_size);
+}
+
+//static
+LLMessageField LLTemplateMessageReader::resolveField(const LLMessageTemplate* message_template,
+                                                     const char *blockname, const char *varname)
+{
+    LLMessageField field;
+    field.mBlockName = blockname;
+    field.mVarName = varname;
+    if (!message_template)
     {
-        LL_ERRS() << "Msg " << mCurrentRMessageData->mName
-            << " variable " << vnamep
-            << " is size " << vardata.getSize()
-            << " but copying into buffer of size " << size
-            << LL_ENDL;
-        return;
+        return field;
     }
 
+    const LLMessageTemplate::message_block_map_t& blocks = message_template->mMemberBlocks;
+    LLMessageTemplate::message_block_map_t::const_iterator block_iter = blocks.find((char *)blockname);
+    if (block_iter == blocks.end())
+    {
+        return field;
+    }
 
-    const S32 vardata_size = vardata.getSize();
-    if( max_size >= vardata_size )
+    const LLMessageBlock::message_variable_map_t& variables = (*block_iter)->mMemberVariables;
+    LLMessageBlock::message_variable_map_t::const_iterator var_iter = variables.find(varname);
+    if (var_iter == variables.end())
     {
-        switch( vardata_size )
-        {
-        case 1:
-            *((U8*)datap) = *((U8*)vardata.getData());
-            break;
-        case 2:
-            *((U16*)datap) = *((U16*)vardata.getData());
-            break;
-        case 4:
-            *((U32*)datap) = *((U32*)vardata.getData());
-            break;
-        case 8:
-            ((U32*)datap)[0] = ((U32*)vardata.getData())[0];
-            ((U32*)datap)[1] = ((U32*)vardata.getData())[1];
-            break;
-        default:
-            memcpy(datap, vardata.getData(), vardata_size);
-            break;
-        }
+        return field;
     }
-    else
+
+    field.mTemplate = message_template;
+    field.mBlockIndex = (S32)(block_iter - blocks.begin());
+    field.mVarIndex = (S32)(var_iter - variables.begin());
+    field.mSize = (*var_iter)->getSize();
+    field.mType = (*var_iter)->getType();
+    return field;
+}
+
+LLMessageField LLTemplateMessageReader::resolveField(const char *blockname, const char *varname) const
+{
+    return resolveField(mCurrentRMessageTemplate, blockname, varname);
+}
+
+void LLTemplateMessageReader::resolveField(LLMessageField& field, const char *blockname, const char *varname) const
+{
+    if (!field.isResolved() || field.mTemplate != mCurrentRMessageTemplate)
     {
-        LL_WARNS() << "Msg " << mCurrentRMessageData->mName
-            << " variable " << vnamep
-            << " is size " << vardata.getSize()
-            << " but truncated to max size of " << max_size
-            << LL_ENDL;
+        field = resolveField(mCurrentRMessageTemplate, blockname, varname);
+    }
+}
 
-        memcpy(datap, vardata.getData(), max_size);
+const LLMsgVarData* LLTemplateMessageReader::getFieldVarData(const LLMessageField& field, S32 blocknum) const
+{
+    // is there a message ready to go?
+    if (mReceiveSize == -1 || !mCurrentRMessageData)
+    {
+        LL_ERRS() << "No message waiting for decode in getFieldVarData!" << LL_ENDL;
+        return NULL;
     }
+
+    if (field.mTemplate != mCurrentRMessageTemplate)
+    {
+        LL_ERRS() << "Variable " << field.mVarName << " in block " << field.mBlockName
+            << " not resolved for message " << mCurrentRMessageData->mName << LL_ENDL;
+        return NULL;
+    }
+
+    const S32 index = mBlockStart[field.mBlockIndex] + blocknum;
+    if (blocknum < 0 || index >= mBlockStart[field.mBlockIndex + 1])
+    {
+        LL_ERRS() << "Block " << field.mBlockName << " #" << blocknum
+            << " not in message " << mCurrentRMessageData->mName << LL_ENDL;
+        return NULL;
+    }
+
+    // Variables are decoded in template order
+    return &*(mBlockData[index]->mMemberVarData.begin() + field.mVarIndex);
+}
+
+void LLTemplateMessageReader::getFieldData(const LLMessageField& field, void *datap, S32 size,
+                                           S32 blocknum, S32 max_size)
+{
+    const LLMsgVarData* vardata = getFieldVarData(field, blocknum);
+    if (vardata)
+    {
+        copy_var_data(*vardata, mCurrentRMessageData->mName, field.mVarName, datap, size, max_size);
+    }
+}
+
+S32 LLTemplateMessageReader::getFieldSize(const LLMessageField& field, S32 blocknum)
+{
+    const LLMsgVarData* vardata = getFieldVarData(field, blocknum);
+    return vardata ? vardata->getSize() : LL_MESSAGE_ERROR;
 }
 
 S32 LLTemplateMessageReader::getNumberOfBlocks(const char *blockname)
@@ -554,6 +653,8 @@ bool LLTemplateMessageReader::decodeData(const U8* buffer, const LLHost& sender
 
     // create base working data set
     mCurrentRMessageData = new LLMsgData(mCurrentRMessageTemplate->mName);
+    mBlockData.clear();
+    mBlockStart.clear();
 
     // loop through the template building the data structure as we go
     LLMessageTemplate::message_block_map_t::const_iterator iter;
@@ -566,6 +667,8 @@ bool LLTemplateMessageReader::decodeData(const U8* buffer, const LLHost& sender
         U8  repeat_number;
         S32 i;
 
+        mBlockStart.push_back((S32)mBlockData.size());
+
         // how many of this block?
 
         if (mbci->mType == MBT_SINGLE)
@@ -629,6 +732,7 @@ bool LLTemplateMessageReader::decodeData(const U8* buffer, const LLHost& sender
 
             // add the block to the message
             mCurrentRMessageData->addBlock(cur_data_block);
+            mBlockData.push_back(cur_data_block);
 
             // now read the variables
             for (LLMessageBlock::message_variable_map_t::const_iterator iter =
@@ -710,6 +814,8 @@ bool LLTemplateMessageReader::decodeData(const U8* buffer, const LLHost& sender
         }
     }
 
+    mBlockStart.push_back((S32)mBlockData.size());
+
     if (mCurrentRMessageData->mMemberBlocks.empty()
         && !mCurrentRMessageTemplate->mMemberBlocks.empty())
     {
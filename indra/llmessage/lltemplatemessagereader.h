@@ -27,12 +27,16 @@
 #ifndef LL_LLTEMPLATEMESSAGEREADER_H
 #define LL_LLTEMPLATEMESSAGEREADER_H
 
+#include "llmessagefield.h"
 #include "llmessagereader.h"
 
 #include <map>
+#include <vector>
 
 class LLMessageTemplate;
 class LLMsgData;
+class LLMsgBlkData;
+class LLMsgVarData;
 
 class LLTemplateMessageReader : public LLMessageReader
 {
@@ -91,6 +95,18 @@ public:
     virtual S32 getSize(const char *blockname, S32 blocknum,
                         const char *varname);
 
+    /** Pre-resolved access, see llmessagefield.h. */
+    static LLMessageField resolveField(const LLMessageTemplate* message_template,
+                                       const char *blockname, const char *varname);
+    // Resolve against the template of the message being read
+    LLMessageField resolveField(const char *blockname, const char *varname) const;
+    // Same, unless field is already resolved against that template.
+    // Fields stay good for every message read with the same template.
+    void resolveField(LLMessageField& field, const char *blockname, const char *varname) const;
+    void getFieldData(const LLMessageField& field, void *datap, S32 size,
+                      S32 blocknum = 0, S32 max_size = S32_MAX);
+    S32 getFieldSize(const LLMessageField& field, S32 blocknum = 0);
+
     virtual void clearMessage();
 
     virtual const char* getMessageName() const;
@@ -118,9 +134,16 @@ private:
 
     bool decodeData(const U8* buffer, const LLHost& sender );
 
+    const LLMsgVarData* getFieldVarData(const LLMessageField& field, S32 blocknum) const;
+
     S32 mReceiveSize;
     LLMessageTemplate* mCurrentRMessageTemplate;
     LLMsgData* mCurrentRMessageData;
+
+    // Decoded blocks in template order, repeats of a block are adjacent.
+    // mBlockStart has an entry per template block plus an end marker.
+    std::vector<LLMsgBlkData*> mBlockData;
+    std::vector<S32> mBlockStart;
     message_template_number_map_t& mMessageNumbers;
 };
 
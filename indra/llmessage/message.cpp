@@ -328,6 +328,9 @@ LLMessageSystem::~LLMessageSystem()
     for_each(mMessageNumbers.begin(), mMessageNumbers.end(), DeletePairedPointer());
     mMessageNumbers.clear();
 
+    // Off the socket before it goes away
+    mPacketRing.stopReceiveThread();
+
     if (!mbError)
     {
         end_net(mSocket);
@@ -512,14 +515,14 @@ bool LLMessageSystem::checkMessages(LockMessageChecker&, S64 frame_count )
         bool recv_reliable = false;
         bool recv_resent = false;
         S32 acks = 0;
-        S32 true_rcv_size = 0;
-
-        U8* buffer = mTrueReceiveBuffer;
 
-        mTrueReceiveSize = mPacketRing.receivePacket(mSocket, (char *)mTrueReceiveBuffer);
+        // Acks and zero-coding are already taken apart, on the packet
+        // receive thread when it's running.
+        LLFramedPacket* packetp = mPacketRing.receiveFramedPacket(mSocket);
         // If you want to dump all received packets into SecondLife.log, uncomment this
-        //dumpPacketToLog();
+        //if (packetp) dumpPacketToLog(*packetp);
 
+        mTrueReceiveSize = packetp ? packetp->mSize : 0;
         receive_size = mTrueReceiveSize;
         mLastSender = mPacketRing.getLastSender();
         mLastReceivingIF = mPacketRing.getLastReceivingInterface();
@@ -541,29 +544,34 @@ bool LLMessageSystem::checkMessages(LockMessageChecker&, S64 frame_count )
             LLHost host;
             LLCircuitData* cdp;
 
-            // note if packet acks are appended.
-            if(buffer[0] & LL_ACK_FLAG)
+            acks = packetp->mAckCount;
+            if (packetp->mMalformed)
             {
-                acks += buffer[--receive_size];
-                true_rcv_size = receive_size;
-                if(receive_size >= ((S32)(acks * sizeof(TPACKETID) + LL_MINIMUM_VALID_PACKET_SIZE)))
-                {
-                    receive_size -= acks * sizeof(TPACKETID);
-                }
-                else
-                {
-                    // mal-formed packet. ignore it and continue with
-                    // the next one
-                    LL_WARNS("Messaging") << "Malformed packet received. Packet size "
-                        << receive_size << " with invalid no. of acks " << acks
-                        << LL_ENDL;
-                    valid_packet = false;
-                    continue;
-                }
+                // mal-formed packet. ignore it and continue with
+                // the next one
+                LL_WARNS("Messaging") << "Malformed packet received. Packet size "
+                    << packetp->mPayloadSize << " with invalid no. of acks " << acks
+                    << LL_ENDL;
+                valid_packet = false;
+                continue;
             }
 
             // process the message as normal
-            mIncomingCompressedSize = zeroCodeExpand(&buffer, &receive_size);
+            U8* buffer = packetp->mMessage;
+            receive_size = packetp->mMessageSize;
+            mIncomingCompressedSize = packetp->mCompressedSize;
+            mTotalBytesIn += packetp->mPayloadSize;
+            if (mIncomingCompressedSize)
+            {
+                mCompressedPacketsIn++;
+                mCompressedBytesIn += mIncomingCompressedSize;
+                mUncompressedBytesIn += receive_size;
+            }
+            if (packetp->mOverflow)
+            {
+                LL_WARNS("Messaging") << "attempt to write past reasonable encoded buffer size" << LL_ENDL;
+                callExceptionFunc(MX_WROTE_PAST_BUFFER_SIZE);
+            }
             mCurrentRecvPacketID = ntohl(*((U32*)(&buffer[1])));
             host = getSender();
 
@@ -574,18 +582,12 @@ bool LLMessageSystem::checkMessages(LockMessageChecker&, S64 frame_count )
             // this message came in on if it's valid, and NULL if the
             // circuit was bogus.
 
-            if(cdp && (acks > 0) && ((S32)(acks * sizeof(TPACKETID)) < (true_rcv_size)))
+            if(cdp && (acks > 0))
             {
-                TPACKETID packet_id;
-                U32 mem_id=0;
                 for(S32 i = 0; i < acks; ++i)
                 {
-                    true_rcv_size -= sizeof(TPACKETID);
-                    memcpy(&mem_id, &mTrueReceiveBuffer[true_rcv_size], /* Flawfinder: ignore*/
-                         sizeof(TPACKETID));
-                    packet_id = ntohl(mem_id);
-                    //LL_INFOS("Messaging") << "got ack: " << packet_id << LL_ENDL;
-                    cdp->ackReliablePacket(packet_id);
+                    //LL_INFOS("Messaging") << "got ack: " << packetp->mAcks[i] << LL_ENDL;
+                    cdp->ackReliablePacket(packetp->mAcks[i]);
                 }
                 if (!cdp->getUnackedPacketCount())
                 {
@@ -2830,100 +2832,6 @@ S32 LLMessageSystem::zeroCodeAdjustCurrentSendTotal()
 
 
 
-S32 LLMessageSystem::zeroCodeExpand(U8** data, S32* data_size)
-{
-    if ((*data_size ) < LL_MINIMUM_VALID_PACKET_SIZE)
-    {
-        LL_WARNS("Messaging") << "zeroCodeExpand() called with data_size of " << *data_size
-            << LL_ENDL;
-    }
-
-    mTotalBytesIn += *data_size;
-
-    // if we're not zero-coded, simply return.
-    if (!(*data[0] & LL_ZERO_CODE_FLAG))
-    {
-        return 0;
-    }
-
-    S32 in_size = *data_size;
-    mCompressedPacketsIn++;
-    mCompressedBytesIn += *data_size;
-
-    *data[0] &= (~LL_ZERO_CODE_FLAG);
-
-    S32 count = (*data_size);
-
-    U8 *inptr = (U8 *)*data;
-    U8 *outptr = (U8 *)mEncodedRecvBuffer;
-
-// skip the packet id field
-
-    for (U32 ii = 0; ii < LL_PACKET_ID_SIZE; ++ii)
-    {
-        count--;
-        *outptr++ = *inptr++;
-    }
-
-// reconstruct encoded packet, keeping track of net size gain
-
-// sequential zero bytes are encoded as 0 [U8 count]
-// with 0 0 [count] representing wrap (>256 zeroes)
-
-    while (count--)
-    {
-        if (outptr > (&mEncodedRecvBuffer[MAX_BUFFER_SIZE-1]))
-        {
-            LL_WARNS("Messaging") << "attempt to write past reasonable encoded buffer size 1" << LL_ENDL;
-            callExceptionFunc(MX_WROTE_PAST_BUFFER_SIZE);
-            outptr = mEncodedRecvBuffer;
-            break;
-        }
-        if (!((*outptr++ = *inptr++)))
-        {
-            while (((count--)) && (!(*inptr)))
-            {
-                *outptr++ = *inptr++;
-                if (outptr > (&mEncodedRecvBuffer[MAX_BUFFER_SIZE-256]))
-                {
-                    LL_WARNS("Messaging") << "attempt to write past reasonable encoded buffer size 2" << LL_ENDL;
-                    callExceptionFunc(MX_WROTE_PAST_BUFFER_SIZE);
-                    outptr = mEncodedRecvBuffer;
-                    count = -1;
-                    break;
-                }
-                memset(outptr,0,255);
-                outptr += 255;
-            }
-
-            if (count < 0)
-            {
-                break;
-            }
-
-            else
-            {
-                if (outptr > (&mEncodedRecvBuffer[MAX_BUFFER_SIZE-(*inptr)]))
-                {
-                    LL_WARNS("Messaging") << "attempt to write past reasonable encoded buffer size 3" << LL_ENDL;
-                    callExceptionFunc(MX_WROTE_PAST_BUFFER_SIZE);
-                    outptr = mEncodedRecvBuffer;
-                }
-                memset(outptr,0,(*inptr) - 1);
-                outptr += ((*inptr) - 1);
-                inptr++;
-            }
-        }
-    }
-
-    *data = mEncodedRecvBuffer;
-    *data_size = (S32)(outptr - mEncodedRecvBuffer);
-    mUncompressedBytesIn += *data_size;
-
-    return(in_size);
-}
-
-
 void LLMessageSystem::addTemplate(LLMessageTemplate *templatep)
 {
     if (mMessageTemplates.count(templatep->mName) > 0)
@@ -3338,20 +3246,20 @@ void LLMessageSystem::establishBidirectionalTrust(const LLHost &host, S64 frame_
 }
 
 
-void LLMessageSystem::dumpPacketToLog()
+void LLMessageSystem::dumpPacketToLog(const LLFramedPacket& packet)
 {
-    LL_WARNS("Messaging") << "Packet Dump from:" << mPacketRing.getLastSender() << LL_ENDL;
-    LL_WARNS("Messaging") << "Packet Size:" << mTrueReceiveSize << LL_ENDL;
+    LL_WARNS("Messaging") << "Packet Dump from:" << packet.mHost << LL_ENDL;
+    LL_WARNS("Messaging") << "Packet Size:" << packet.mSize << LL_ENDL;
     char line_buffer[256];      /* Flawfinder: ignore */
     S32 i;
     S32 cur_line_pos = 0;
     S32 cur_line = 0;
 
-    for (i = 0; i < mTrueReceiveSize; i++)
+    for (i = 0; i < packet.mSize; i++)
     {
         S32 offset = cur_line_pos * 3;
         snprintf(line_buffer + offset, sizeof(line_buffer) - offset,
-                 "%02x ", mTrueReceiveBuffer[i]);   /* Flawfinder: ignore */
+                 "%02x ", (U8)packet.mData[i]);   /* Flawfinder: ignore */
         cur_line_pos++;
         if (cur_line_pos >= 16)
         {
@@ -3974,6 +3882,167 @@ S32 LLMessageSystem::getSize(const char *blockname, S32 blocknum,
                        LLMessageStringTable::getInstance()->getString(varname));
 }
 
+LLMessageField LLMessageSystem::getFieldFast(const char *blockname, const char *varname) const
+{
+    if (mMessageReader == mTemplateMessageReader)
+    {
+        return mTemplateMessageReader->resolveField(blockname, varname);
+    }
+
+    // Not a template message, reads will go by name
+    LLMessageField field;
+    field.mBlockName = blockname;
+    field.mVarName = varname;
+    return field;
+}
+
+void LLMessageSystem::getFieldFast(LLMessageField& field, const char *blockname, const char *varname) const
+{
+    if (mMessageReader == mTemplateMessageReader)
+    {
+        mTemplateMessageReader->resolveField(field, blockname, varname);
+    }
+    else
+    {
+        field = LLMessageField();
+        field.mBlockName = blockname;
+        field.mVarName = varname;
+    }
+}
+
+void LLMessageSystem::getBinaryData(const LLMessageField& field, void *datap, S32 size,
+                                    S32 blocknum, S32 max_size)
+{
+    if (field.isResolved())
+    {
+        mTemplateMessageReader->getFieldData(field, datap, size, blocknum, max_size);
+    }
+    else
+    {
+        mMessageReader->getBinaryData(field.mBlockName, field.mVarName, datap, size, blocknum, max_size);
+    }
+}
+
+void LLMessageSystem::getU8(const LLMessageField& field, U8 &u, S32 blocknum)
+{
+    if (field.isResolved())
+    {
+        mTemplateMessageReader->getFieldData(field, &u, sizeof(U8), blocknum);
+    }
+    else
+    {
+        mMessageReader->getU8(field.mBlockName, field.mVarName, u, blocknum);
+    }
+}
+
+void LLMessageSystem::getU16(const LLMessageField& field, U16 &d, S32 blocknum)
+{
+    if (field.isResolved())
+    {
+        mTemplateMessageReader->getFieldData(field, &d, sizeof(U16), blocknum);
+    }
+    else
+    {
+        mMessageReader->getU16(field.mBlockName, field.mVarName, d, blocknum);
+    }
+}
+
+void LLMessageSystem::getU32(const LLMessageField& field, U32 &d, S32 blocknum)
+{
+    if (field.isResolved())
+    {
+        mTemplateMessageReader->getFieldData(field, &d, sizeof(U32), blocknum);
+    }
+    else
+    {
+        mMessageReader->getU32(field.mBlockName, field.mVarName, d, blocknum);
+    }
+}
+
+void LLMessageSystem::getU64(const LLMessageField& field, U64 &d, S32 blocknum)
+{
+    if (field.isResolved())
+    {
+        mTemplateMessageReader->getFieldData(field, &d, sizeof(U64), blocknum);
+    }
+    else
+    {
+        mMessageReader->getU64(field.mBlockName, field.mVarName, d, blocknum);
+    }
+}
+
+void LLMessageSystem::getF32(const LLMessageField& field, F32 &d, S32 blocknum)
+{
+    if (field.isResolved())
+    {
+        mTemplateMessageReader->getFieldData(field, &d, sizeof(F32), blocknum);
+        if (!llfinite(d))
+        {
+            LL_WARNS() << "non-finite in getF32 " << field.mBlockName << " " << field.mVarName
+                    << LL_ENDL;
+            d = 0;
+        }
+    }
+    else
+    {
+        mMessageReader->getF32(field.mBlockName, field.mVarName, d, blocknum);
+    }
+}
+
+void LLMessageSystem::getVector3(const LLMessageField& field, LLVector3 &v, S32 blocknum)
+{
+    if (field.isResolved())
+    {
+        mTemplateMessageReader->getFieldData(field, &v.mV[0], sizeof(v.mV), blocknum);
+        if (!v.isFinite())
+        {
+            LL_WARNS() << "non-finite in getVector3 " << field.mBlockName << " " << field.mVarName
+                    << LL_ENDL;
+            v.zeroVec();
+        }
+    }
+    else
+    {
+        mMessageReader->getVector3(field.mBlockName, field.mVarName, v, blocknum);
+    }
+}
+
+void LLMessageSystem::getUUID(const LLMessageField& field, LLUUID &u, S32 blocknum)
+{
+    if (field.isResolved())
+    {
+        mTemplateMessageReader->getFieldData(field, u.mData, sizeof(u.mData), blocknum);
+    }
+    else
+    {
+        mMessageReader->getUUID(field.mBlockName, field.mVarName, u, blocknum);
+    }
+}
+
+void LLMessageSystem::getString(const LLMessageField& field, std::string& outstr, S32 blocknum)
+{
+    if (field.isResolved())
+    {
+        char s[MTUBYTES + 1] = {0};
+        mTemplateMessageReader->getFieldData(field, s, 0, blocknum, MTUBYTES);
+        s[MTUBYTES] = '\0';
+        outstr = s;
+    }
+    else
+    {
+        mMessageReader->getString(field.mBlockName, field.mVarName, outstr, blocknum);
+    }
+}
+
+S32 LLMessageSystem::getSize(const LLMessageField& field, S32 blocknum) const
+{
+    if (field.isResolved())
+    {
+        return mTemplateMessageReader->getFieldSize(field, blocknum);
+    }
+    return mMessageReader->getSize(field.mBlockName, blocknum, field.mVarName);
+}
+
 S32 LLMessageSystem::getReceiveSize() const
 {
     return mMessageReader->getMessageSize();
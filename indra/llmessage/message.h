@@ -51,6 +51,7 @@
 #include "llsingleton.h"
 #include "message_prehash.h"
 #include "llstl.h"
+#include "llmessagefield.h"
 #include "llmsgvariabletype.h"
 #include "llmessagesenderinterface.h"
 
@@ -423,7 +424,7 @@ public:
         return isMessageFast(LLMessageStringTable::getInstance()->getString(msg));
     }
 
-    void dumpPacketToLog();
+    void dumpPacketToLog(const LLFramedPacket& packet);
 
     char    *getMessageName();
 
@@ -536,7 +537,6 @@ public:
     //void  buildMessage();
 
     S32     zeroCode(U8 **data, S32 *data_size);
-    S32     zeroCodeExpand(U8 **data, S32 *data_size);
     S32     zeroCodeAdjustCurrentSendTotal();
 
     // Uses ping-based retry
@@ -638,6 +638,24 @@ public:
     void getStringFast( const char *block, const char *var, std::string& outstr, S32 blocknum = 0);
     void    getString(  const char *block, const char *var, std::string& outstr, S32 blocknum = 0);
 
+    // Resolve a variable of the message being read once, then read it
+    // from each block without name lookups.  Fields are only good for
+    // the message they were resolved against.
+    LLMessageField getFieldFast(const char *blockname, const char *varname) const;
+    // Handlers called once per block can keep their fields between calls:
+    // this only resolves field again when the message template changed.
+    void    getFieldFast(LLMessageField& field, const char *blockname, const char *varname) const;
+    void    getBinaryData(const LLMessageField& field, void *datap, S32 size, S32 blocknum = 0, S32 max_size = S32_MAX);
+    void    getU8(      const LLMessageField& field, U8 &data, S32 blocknum = 0);
+    void    getU16(     const LLMessageField& field, U16 &data, S32 blocknum = 0);
+    void    getU32(     const LLMessageField& field, U32 &data, S32 blocknum = 0);
+    void    getU64(     const LLMessageField& field, U64 &data, S32 blocknum = 0);
+    void    getF32(     const LLMessageField& field, F32 &data, S32 blocknum = 0);
+    void    getVector3( const LLMessageField& field, LLVector3 &vec, S32 blocknum = 0);
+    void    getUUID(    const LLMessageField& field, LLUUID &uuid, S32 blocknum = 0);
+    void    getString(  const LLMessageField& field, std::string& outstr, S32 blocknum = 0);
+    S32     getSize(    const LLMessageField& field, S32 blocknum = 0) const;
+
 
     // Utility functions to generate a replay-resistant digest check
     // against the shared secret. The window specifies how much of a
@@ -859,8 +877,6 @@ private:
 
     LLMessagePollInfo                       *mPollInfop;
 
-    U8  mEncodedRecvBuffer[MAX_BUFFER_SIZE];
-    U8  mTrueReceiveBuffer[MAX_BUFFER_SIZE];
     S32 mTrueReceiveSize;
 
     // Must be valid during decode
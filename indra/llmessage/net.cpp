@@ -40,6 +40,7 @@
     #include <arpa/inet.h>
     #include <fcntl.h>
     #include <errno.h>
+    #include <poll.h>
 #endif
 
 // linden library includes
@@ -338,6 +339,53 @@ S32 receive_packet(int hSocket, char * receiveBuffer)
     return nRet;
 }
 
+S32 receive_packets(int hSocket, LLNetDatagram * datagrams, S32 count)
+{
+    S32 received = 0;
+    while (received < count)
+    {
+        LLNetDatagram & datagram = datagrams[received];
+        struct sockaddr_in src_addr;
+        int addr_size = sizeof(src_addr);
+
+        int nRet = recvfrom(hSocket, datagram.mBuffer, NET_BUFFER_SIZE, 0, (struct sockaddr*)&src_addr, &addr_size);
+        if (nRet == SOCKET_ERROR)
+        {
+            int last_error = WSAGetLastError();
+            if (WSAECONNRESET == last_error)
+            {
+                // ICMP noise from an earlier send, see send_packet()
+                continue;
+            }
+            if (WSAEWOULDBLOCK != last_error)
+            {
+                LL_INFOS() << "receive_packets() failed, Error: " << last_error << LL_ENDL;
+            }
+            break;
+        }
+
+        datagram.mSize = nRet;
+        datagram.mSenderIP = src_addr.sin_addr.s_addr;
+        datagram.mSenderPort = ntohs(src_addr.sin_port);
+        datagram.mReceivingIP = INVALID_HOST_IP_ADDRESS;
+        ++received;
+    }
+    return received;
+}
+
+bool wait_for_packet(int hSocket, S32 timeout_ms)
+{
+    fd_set read_fds;
+    FD_ZERO(&read_fds);
+    FD_SET((SOCKET)hSocket, &read_fds);
+
+    struct timeval timeout;
+    timeout.tv_sec = timeout_ms / 1000;
+    timeout.tv_usec = (timeout_ms % 1000) * 1000;
+
+    return select(0, &read_fds, NULL, NULL, &timeout) > 0;
+}
+
 // Returns true on success.
 bool send_packet(int hSocket, const char *sendBuffer, int size, U32 recipient, int nPort)
 {
@@ -598,6 +646,104 @@ int receive_packet(int hSocket, char * receiveBuffer)
     return nRet;
 }
 
+#if LL_LINUX
+S32 receive_packets(int hSocket, LLNetDatagram * datagrams, S32 count)
+{
+    const S32 MAX_BATCH = 64;
+    struct mmsghdr msgs[MAX_BATCH];
+    struct iovec iovs[MAX_BATCH];
+    struct sockaddr_in src_addrs[MAX_BATCH];
+    char cmsgs[MAX_BATCH][CMSG_SPACE(sizeof(struct in_pktinfo))];
+
+    S32 received = 0;
+    while (received < count)
+    {
+        const S32 batch = llmin(count - received, MAX_BATCH);
+        memset(msgs, 0, sizeof(msgs[0]) * batch);
+        for (S32 i = 0; i < batch; ++i)
+        {
+            iovs[i].iov_base = datagrams[received + i].mBuffer;
+            iovs[i].iov_len = NET_BUFFER_SIZE;
+            msgs[i].msg_hdr.msg_name = &src_addrs[i];
+            msgs[i].msg_hdr.msg_namelen = sizeof(src_addrs[i]);
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+            msgs[i].msg_hdr.msg_control = cmsgs[i];
+            msgs[i].msg_hdr.msg_controllen = sizeof(cmsgs[i]);
+        }
+
+        int nRet = recvmmsg(hSocket, msgs, batch, MSG_DONTWAIT, NULL);
+        if (nRet <= 0)
+        {
+            break;
+        }
+
+        for (S32 i = 0; i < nRet; ++i)
+        {
+            LLNetDatagram & datagram = datagrams[received + i];
+            datagram.mSize = msgs[i].msg_len;
+            datagram.mSenderIP = src_addrs[i].sin_addr.s_addr;
+            datagram.mSenderPort = ntohs(src_addrs[i].sin_port);
+            datagram.mReceivingIP = INVALID_HOST_IP_ADDRESS;
+
+            // Same as recvfrom_destip()
+            for (struct cmsghdr * cmsgptr = CMSG_FIRSTHDR(&msgs[i].msg_hdr);
+                 cmsgptr != NULL;
+                 cmsgptr = CMSG_NXTHDR(&msgs[i].msg_hdr, cmsgptr))
+            {
+                if (cmsgptr->cmsg_level == SOL_IP && cmsgptr->cmsg_type == IP_PKTINFO)
+                {
+                    in_pktinfo *pktinfo = (in_pktinfo *)CMSG_DATA(cmsgptr);
+                    datagram.mReceivingIP = pktinfo->ipi_spec_dst.s_addr;
+                }
+            }
+        }
+        received += nRet;
+
+        if (nRet < batch)
+        {
+            // Socket drained
+            break;
+        }
+    }
+    return received;
+}
+#else
+S32 receive_packets(int hSocket, LLNetDatagram * datagrams, S32 count)
+{
+    S32 received = 0;
+    while (received < count)
+    {
+        LLNetDatagram & datagram = datagrams[received];
+        struct sockaddr_in src_addr;
+        socklen_t addr_size = sizeof(src_addr);
+
+        int nRet = recvfrom(hSocket, datagram.mBuffer, NET_BUFFER_SIZE, MSG_DONTWAIT, (struct sockaddr*)&src_addr, &addr_size);
+        if (nRet == -1)
+        {
+            break;
+        }
+
+        datagram.mSize = nRet;
+        datagram.mSenderIP = src_addr.sin_addr.s_addr;
+        datagram.mSenderPort = ntohs(src_addr.sin_port);
+        datagram.mReceivingIP = INVALID_HOST_IP_ADDRESS;
+        ++received;
+    }
+    return received;
+}
+#endif
+
+bool wait_for_packet(int hSocket, S32 timeout_ms)
+{
+    struct pollfd pfd;
+    pfd.fd = hSocket;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+
+    return poll(&pfd, 1, timeout_ms) > 0;
+}
+
 bool send_packet(int hSocket, const char * sendBuffer, int size, U32 recipient, int nPort)
 {
     int     ret;
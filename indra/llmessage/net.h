@@ -45,6 +45,27 @@ S32     receive_packet(int hSocket, char * receiveBuffer);
 
 bool    send_packet(int hSocket, const char *sendBuffer, int size, U32 recipient, int nPort);   // Returns true on success.
 
+// One datagram slot for receive_packets().  Unlike receive_packet() the
+// sender and receiving interface are returned per datagram rather than
+// through the globals behind get_sender(), so it may be used off the
+// main thread.
+struct LLNetDatagram
+{
+    char *  mBuffer;            // At least NET_BUFFER_SIZE bytes, caller provided
+    S32     mSize;
+    U32     mSenderIP;
+    U32     mSenderPort;
+    U32     mReceivingIP;       // INVALID_HOST_IP_ADDRESS if not known
+};
+
+// Receives up to count waiting datagrams without blocking, in one system
+// call where the platform has one (recvmmsg).  Returns number received.
+S32     receive_packets(int hSocket, LLNetDatagram * datagrams, S32 count);
+
+// Blocks until a datagram is waiting or timeout_ms passes.
+// Returns true if there is something to receive.
+bool    wait_for_packet(int hSocket, S32 timeout_ms);
+
 //void  get_sender(char * tmp);
 LLHost  get_sender();
 U32     get_sender_port();
@@ -30,6 +30,9 @@
 //#include "vmath.h"
 #include "v3math.h"
 #include "patch_dct.h"
+#include "llmemory.h"
+
+#include <xmmintrin.h>
 
 LLGroupHeader   *gGOPP;
 
@@ -38,25 +41,30 @@ void set_group_of_patch_header(LLGroupHeader *gopp)
     gGOPP = gopp;
 }
 
-F32 gPatchDequantizeTable[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
-void build_patch_dequantize_table(S32 size)
+// Dequantize, inverse cosine and zigzag tables for one patch size.  Built
+// once per size and never changed afterwards, so patches of either size
+// can be decompressed from any thread.
+class LLPatchDecompressTables
+{
+public:
+    LLPatchDecompressTables(S32 size);
+
+    LL_ALIGN_16(F32 mDequantize[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE]);
+    LL_ALIGN_16(F32 mICosines[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE]);
+    S32 mDeCopyMatrix[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
+};
+
+LLPatchDecompressTables::LLPatchDecompressTables(S32 size)
 {
     S32 i, j;
     for (j = 0; j < size; j++)
     {
         for (i = 0; i < size; i++)
         {
-            gPatchDequantizeTable[j*size + i] = (1.f + 2.f*(i+j));
+            mDequantize[j*size + i] = (1.f + 2.f*(i+j));
         }
     }
-}
-
-S32 gCurrentDeSize = 0;
-
-F32 gPatchICosines[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
 
-void setup_patch_icosines(S32 size)
-{
     S32 n, u;
     F32 oosob = F_PI*0.5f/size;
 
@@ -64,16 +72,11 @@ void setup_patch_icosines(S32 size)
     {
         for (n = 0; n < size; n++)
         {
-            gPatchICosines[u*size+n] = cosf((2.f*n+1.f)*u*oosob);
+            mICosines[u*size+n] = cosf((2.f*n+1.f)*u*oosob);
         }
     }
-}
 
-S32 gDeCopyMatrix[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
-
-void build_decopy_matrix(S32 size)
-{
-    S32 i, j, count;
+    S32     count;
     bool    b_diag = false;
     bool    b_right = true;
 
@@ -84,7 +87,7 @@ void build_decopy_matrix(S32 size)
     while (  (i < size)
            &&(j < size))
     {
-        gDeCopyMatrix[j*size + i] = count;
+        mDeCopyMatrix[j*size + i] = count;
 
         count++;
 
@@ -135,494 +138,132 @@ void build_decopy_matrix(S32 size)
     }
 }
 
-void init_patch_decompressor(S32 size)
-{
-    if (size != gCurrentDeSize)
-    {
-        gCurrentDeSize = size;
-        build_patch_dequantize_table(size);
-        setup_patch_icosines(size);
-        build_decopy_matrix(size);
-    }
-}
-
-inline void idct_line(F32 *linein, F32 *lineout, S32 line)
+// Only 16 (land, wind) and 32 (Aurora large land) are ever sent
+static const LLPatchDecompressTables &get_decompress_tables(S32 size)
 {
-    S32 n;
-    F32 total;
-    F32 *pcp = gPatchICosines;
-
-#ifdef _PATCH_SIZE_16_AND_32_ONLY
-    F32 oosob = 2.f/16.f;
-    S32 line_size = line*NORMAL_PATCH_SIZE;
-    F32 *tlinein, *tpcp;
-
-
-    for (n = 0; n < NORMAL_PATCH_SIZE; n++)
-    {
-        tpcp = pcp + n;
-        tlinein = linein + line_size;
-
-        total = OO_SQRT2*(*(tlinein++));
-        total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-
-        total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-
-        total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-
-        total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-        total += *(tlinein)*(*(tpcp += NORMAL_PATCH_SIZE));
-
-        *(lineout + line_size + n) = total*oosob;
-    }
-#else
-    F32 oosob = 2.f/size;
-    S32 size = gGOPP->patch_size;
-    S32 line_size = line*size;
-    S32 u;
-    for (n = 0; n < size; n++)
+    llassert(size == NORMAL_PATCH_SIZE || size == LARGE_PATCH_SIZE);
+    if (size == NORMAL_PATCH_SIZE)
     {
-        total = OO_SQRT2*linein[line_size];
-        for (u = 1; u < size; u++)
-        {
-            total += linein[line_size + u]*pcp[u*size+n];
-        }
-        lineout[line_size + n] = total*oosob;
+        static const LLPatchDecompressTables normal_tables(NORMAL_PATCH_SIZE);
+        return normal_tables;
     }
-#endif
+    static const LLPatchDecompressTables large_tables(LARGE_PATCH_SIZE);
+    return large_tables;
 }
 
-inline void idct_line_large_slow(F32 *linein, F32 *lineout, S32 line)
-{
-    S32 n;
-    F32 total;
-    F32 *pcp = gPatchICosines;
-
-    F32 oosob = 2.f/32.f;
-    S32 line_size = line*LARGE_PATCH_SIZE;
-    F32 *tlinein, *tpcp;
-
-
-    for (n = 0; n < LARGE_PATCH_SIZE; n++)
-    {
-        tpcp = pcp + n;
-        tlinein = linein + line_size;
-
-        total = OO_SQRT2*(*(tlinein++));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein)*(*(tpcp += LARGE_PATCH_SIZE));
-
-        *(lineout + line_size + n) = total*oosob;
-    }
-}
-
-// Nota Bene: assumes that coefficients beyond 128 are 0!
-
-void idct_line_large(F32 *linein, F32 *lineout, S32 line)
+void init_patch_decompressor(S32 size)
 {
-    S32 n;
-    F32 total;
-    F32 *pcp = gPatchICosines;
-
-    F32 oosob = 2.f/32.f;
-    S32 line_size = line*LARGE_PATCH_SIZE;
-    F32 *tlinein, *tpcp;
-    F32 *baselinein = linein + line_size;
-    F32 *baselineout = lineout + line_size;
-
-
-    for (n = 0; n < LARGE_PATCH_SIZE; n++)
-    {
-        tpcp = pcp++;
-        tlinein = baselinein;
-
-        total = OO_SQRT2*(*(tlinein++));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein)*(*(tpcp));
-
-        *baselineout++ = total*oosob;
-    }
+    get_decompress_tables(size);
 }
 
-inline void idct_column(F32 *linein, F32 *lineout, S32 column)
+// Both passes work on whole rows of four floats at a time:
+//
+//  temp[n][c]  = OO_SQRT2*block[0][c] + sum(m = 1..SIZE-1) block[m][c]*cos[m][n]
+//  block[l][n] = (OO_SQRT2*temp[l][0] + sum(u = 1..SIZE-1) temp[l][u]*cos[u][n]) * 2/SIZE
+//
+// Each lane adds its products in the same order as the old one column /
+// one line at a time loops did, with no fused multiply-add, so results are
+// bit for bit those of the scalar code.
+template<S32 SIZE>
+static void idct_patch(F32 *block, const F32 *cosines)
 {
-    S32 n;
-    F32 total;
-    F32 *pcp = gPatchICosines;
+    const S32 LANES = SIZE/4;
+    LL_ALIGN_16(F32 temp[SIZE*SIZE]);
+    __m128 total[LANES];
+    S32 n, m, k;
 
-#ifdef _PATCH_SIZE_16_AND_32_ONLY
-    F32 *tlinein, *tpcp;
-
-    for (n = 0; n < NORMAL_PATCH_SIZE; n++)
+    const __m128 oo_sqrt2 = _mm_set1_ps(OO_SQRT2);
+    for (n = 0; n < SIZE; n++)
     {
-        tpcp = pcp + n;
-        tlinein = linein + column;
-
-        total = OO_SQRT2*(*tlinein);
-        total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-        total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-        total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-
-        total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-        total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-        total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-        total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-
-        total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-        total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-        total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-        total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-
-        total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-        total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-        total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-        total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-
-        *(lineout + (n<<4) + column) = total;
+        for (k = 0; k < LANES; k++)
+        {
+            total[k] = _mm_mul_ps(oo_sqrt2, _mm_load_ps(block + k*4));
+        }
+        for (m = 1; m < SIZE; m++)
+        {
+            const __m128 cosine = _mm_set1_ps(cosines[m*SIZE + n]);
+            const F32 *row = block + m*SIZE;
+            for (k = 0; k < LANES; k++)
+            {
+                total[k] = _mm_add_ps(total[k], _mm_mul_ps(_mm_load_ps(row + k*4), cosine));
+            }
+        }
+        for (k = 0; k < LANES; k++)
+        {
+            _mm_store_ps(temp + n*SIZE + k*4, total[k]);
+        }
     }
 
-#else
-    S32 size = gGOPP->patch_size;
-    S32 u;
-    S32 u_size;
-
-    for (n = 0; n < size; n++)
+    const __m128 oosob = _mm_set1_ps(2.f/SIZE);
+    for (n = 0; n < SIZE; n++)
     {
-        total = OO_SQRT2*linein[column];
-        for (u = 1; u < size; u++)
+        const F32 *line = temp + n*SIZE;
+        const __m128 dc = _mm_set1_ps(OO_SQRT2*line[0]);
+        for (k = 0; k < LANES; k++)
+        {
+            total[k] = dc;
+        }
+        for (m = 1; m < SIZE; m++)
+        {
+            const __m128 coeff = _mm_set1_ps(line[m]);
+            const F32 *row = cosines + m*SIZE;
+            for (k = 0; k < LANES; k++)
+            {
+                total[k] = _mm_add_ps(total[k], _mm_mul_ps(coeff, _mm_load_ps(row + k*4)));
+            }
+        }
+        for (k = 0; k < LANES; k++)
         {
-            u_size = u*size;
-            total += linein[u_size + column]*pcp[u_size+n];
+            _mm_store_ps(block + n*SIZE + k*4, _mm_mul_ps(total[k], oosob));
         }
-        lineout[size*n + column] = total;
     }
-#endif
 }
 
-inline void idct_column_large_slow(F32 *linein, F32 *lineout, S32 column)
+// Dequantize and inverse transform cpatch into block, returns the
+// scale and offset to apply to get heights back.
+static void decompress_block(F32 *block, const S32 *cpatch, const LLPatchHeader *ph, S32 size, F32 &mult, F32 &addval)
 {
-    S32 n;
-    F32 total;
-    F32 *pcp = gPatchICosines;
+    const LLPatchDecompressTables &tables = get_decompress_tables(size);
 
-    F32 *tlinein, *tpcp;
-
-    for (n = 0; n < LARGE_PATCH_SIZE; n++)
-    {
-        tpcp = pcp + n;
-        tlinein = linein + column;
-
-        total = OO_SQRT2*(*tlinein);
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-
-        *(lineout + (n<<5) + column) = total;
-    }
-}
-
-// Nota Bene: assumes that coefficients beyond 128 are 0!
+    F32     range = ph->range;
+    S32     prequant = (ph->quant_wbits >> 4) + 2;
+    S32     quantize = 1<<prequant;
+    F32     hmin = ph->dc_offset;
 
-void idct_column_large(F32 *linein, F32 *lineout, S32 column)
-{
-    S32 n, m;
-    F32 total;
-    F32 *pcp = gPatchICosines;
+    F32     ooq = 1.f/(F32)quantize;
+    const F32   *dq = tables.mDequantize;
+    const S32   *decopy_matrix = tables.mDeCopyMatrix;
 
-    F32 *tlinein, *tpcp;
-    F32 *baselinein = linein + column;
-    F32 *baselineout = lineout + column;
+    mult = ooq*range;
+    addval = mult*(F32)(1<<(prequant - 1))+hmin;
 
-    for (n = 0; n < LARGE_PATCH_SIZE; n++)
+    for (S32 i = 0; i < size*size; i++)
     {
-        tpcp = pcp++;
-        tlinein = baselinein;
-
-        total = OO_SQRT2*(*tlinein);
-        for (m = 1; m < NORMAL_PATCH_SIZE; m++)
-            total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-
-        *(baselineout + (n<<5)) = total;
+        block[i] = cpatch[decopy_matrix[i]]*dq[i];
     }
-}
 
-inline void idct_patch(F32 *block)
-{
-    F32 temp[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
-
-#ifdef _PATCH_SIZE_16_AND_32_ONLY
-    idct_column(block, temp, 0);
-    idct_column(block, temp, 1);
-    idct_column(block, temp, 2);
-    idct_column(block, temp, 3);
-
-    idct_column(block, temp, 4);
-    idct_column(block, temp, 5);
-    idct_column(block, temp, 6);
-    idct_column(block, temp, 7);
-
-    idct_column(block, temp, 8);
-    idct_column(block, temp, 9);
-    idct_column(block, temp, 10);
-    idct_column(block, temp, 11);
-
-    idct_column(block, temp, 12);
-    idct_column(block, temp, 13);
-    idct_column(block, temp, 14);
-    idct_column(block, temp, 15);
-
-    idct_line(temp, block, 0);
-    idct_line(temp, block, 1);
-    idct_line(temp, block, 2);
-    idct_line(temp, block, 3);
-
-    idct_line(temp, block, 4);
-    idct_line(temp, block, 5);
-    idct_line(temp, block, 6);
-    idct_line(temp, block, 7);
-
-    idct_line(temp, block, 8);
-    idct_line(temp, block, 9);
-    idct_line(temp, block, 10);
-    idct_line(temp, block, 11);
-
-    idct_line(temp, block, 12);
-    idct_line(temp, block, 13);
-    idct_line(temp, block, 14);
-    idct_line(temp, block, 15);
-#else
-    S32 i;
-    S32 size = gGOPP->patch_size;
-    for (i = 0; i < size; i++)
+    if (size == NORMAL_PATCH_SIZE)
     {
-        idct_column(block, temp, i);
+        idct_patch<NORMAL_PATCH_SIZE>(block, tables.mICosines);
     }
-    for (i = 0; i < size; i++)
+    else
     {
-        idct_line(temp, block, i);
+        idct_patch<LARGE_PATCH_SIZE>(block, tables.mICosines);
     }
-#endif
-}
-
-inline void idct_patch_large(F32 *block)
-{
-    F32 temp[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
-
-    idct_column_large_slow(block, temp, 0);
-    idct_column_large_slow(block, temp, 1);
-    idct_column_large_slow(block, temp, 2);
-    idct_column_large_slow(block, temp, 3);
-
-    idct_column_large_slow(block, temp, 4);
-    idct_column_large_slow(block, temp, 5);
-    idct_column_large_slow(block, temp, 6);
-    idct_column_large_slow(block, temp, 7);
-
-    idct_column_large_slow(block, temp, 8);
-    idct_column_large_slow(block, temp, 9);
-    idct_column_large_slow(block, temp, 10);
-    idct_column_large_slow(block, temp, 11);
-
-    idct_column_large_slow(block, temp, 12);
-    idct_column_large_slow(block, temp, 13);
-    idct_column_large_slow(block, temp, 14);
-    idct_column_large_slow(block, temp, 15);
-
-    idct_column_large_slow(block, temp, 16);
-    idct_column_large_slow(block, temp, 17);
-    idct_column_large_slow(block, temp, 18);
-    idct_column_large_slow(block, temp, 19);
-
-    idct_column_large_slow(block, temp, 20);
-    idct_column_large_slow(block, temp, 21);
-    idct_column_large_slow(block, temp, 22);
-    idct_column_large_slow(block, temp, 23);
-
-    idct_column_large_slow(block, temp, 24);
-    idct_column_large_slow(block, temp, 25);
-    idct_column_large_slow(block, temp, 26);
-    idct_column_large_slow(block, temp, 27);
-
-    idct_column_large_slow(block, temp, 28);
-    idct_column_large_slow(block, temp, 29);
-    idct_column_large_slow(block, temp, 30);
-    idct_column_large_slow(block, temp, 31);
-
-    idct_line_large_slow(temp, block, 0);
-    idct_line_large_slow(temp, block, 1);
-    idct_line_large_slow(temp, block, 2);
-    idct_line_large_slow(temp, block, 3);
-
-    idct_line_large_slow(temp, block, 4);
-    idct_line_large_slow(temp, block, 5);
-    idct_line_large_slow(temp, block, 6);
-    idct_line_large_slow(temp, block, 7);
-
-    idct_line_large_slow(temp, block, 8);
-    idct_line_large_slow(temp, block, 9);
-    idct_line_large_slow(temp, block, 10);
-    idct_line_large_slow(temp, block, 11);
-
-    idct_line_large_slow(temp, block, 12);
-    idct_line_large_slow(temp, block, 13);
-    idct_line_large_slow(temp, block, 14);
-    idct_line_large_slow(temp, block, 15);
-
-    idct_line_large_slow(temp, block, 16);
-    idct_line_large_slow(temp, block, 17);
-    idct_line_large_slow(temp, block, 18);
-    idct_line_large_slow(temp, block, 19);
-
-    idct_line_large_slow(temp, block, 20);
-    idct_line_large_slow(temp, block, 21);
-    idct_line_large_slow(temp, block, 22);
-    idct_line_large_slow(temp, block, 23);
-
-    idct_line_large_slow(temp, block, 24);
-    idct_line_large_slow(temp, block, 25);
-    idct_line_large_slow(temp, block, 26);
-    idct_line_large_slow(temp, block, 27);
-
-    idct_line_large_slow(temp, block, 28);
-    idct_line_large_slow(temp, block, 29);
-    idct_line_large_slow(temp, block, 30);
-    idct_line_large_slow(temp, block, 31);
 }
 
 S32 gDitherNoise = 128;
 
-void decompress_patch(F32 *patch, S32 *cpatch, LLPatchHeader *ph)
+void decompress_patch(F32 *patch, const S32 *cpatch, const LLPatchHeader *ph, S32 size, S32 stride)
 {
     S32     i, j;
 
-    F32     block[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE], *tblock = block;
+    LL_ALIGN_16(F32 block[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE]);
+    F32     *tblock;
     F32     *tpatch;
+    F32     mult, addval;
 
-    LLGroupHeader   *gopp = gGOPP;
-    S32     size = gopp->patch_size;
-    F32     range = ph->range;
-    S32     prequant = (ph->quant_wbits >> 4) + 2;
-    S32     quantize = 1<<prequant;
-    F32     hmin = ph->dc_offset;
-    S32     stride = gopp->stride;
-
-    F32     ooq = 1.f/(F32)quantize;
-    F32     *dq = gPatchDequantizeTable;
-    S32     *decopy_matrix = gDeCopyMatrix;
-
-    F32     mult = ooq*range;
-    F32     addval = mult*(F32)(1<<(prequant - 1))+hmin;
-
-    for (i = 0; i < size*size; i++)
-    {
-        *(tblock++) = *(cpatch + *(decopy_matrix++))*(*dq++);
-    }
-
-    if (size == 16)
-    {
-        idct_patch(block);
-    }
-    else
-    {
-        idct_patch_large(block);
-    }
+    decompress_block(block, cpatch, ph, size, mult, addval);
 
     for (j = 0; j < size; j++)
     {
@@ -635,41 +276,25 @@ void decompress_patch(F32 *patch, S32 *cpatch, LLPatchHeader *ph)
     }
 }
 
+void decompress_patch(F32 *patch, S32 *cpatch, LLPatchHeader *ph)
+{
+    decompress_patch(patch, cpatch, ph, gGOPP->patch_size, gGOPP->stride);
+}
 
 void decompress_patchv(LLVector3 *v, S32 *cpatch, LLPatchHeader *ph)
 {
     S32     i, j;
 
-    F32         block[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE], *tblock = block;
+    LL_ALIGN_16(F32 block[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE]);
+    F32         *tblock;
     LLVector3   *tvec;
+    F32         mult, addval;
 
     LLGroupHeader   *gopp = gGOPP;
     S32     size = gopp->patch_size;
-    F32     range = ph->range;
-    S32     prequant = (ph->quant_wbits >> 4) + 2;
-    S32     quantize = 1<<prequant;
-    F32     hmin = ph->dc_offset;
     S32     stride = gopp->stride;
 
-    F32     ooq = 1.f/(F32)quantize;
-    F32     *dq = gPatchDequantizeTable;
-    S32     *decopy_matrix = gDeCopyMatrix;
-
-    F32     mult = ooq*range;
-    F32     addval = mult*(F32)(1<<(prequant - 1))+hmin;
-
-//  bool    b_diag = false;
-//  bool    b_right = true;
-
-    for (i = 0; i < size*size; i++)
-    {
-        *(tblock++) = *(cpatch + *(decopy_matrix++))*(*dq++);
-    }
-
-    if (size == 16)
-        idct_patch(block);
-    else
-        idct_patch_large(block);
+    decompress_block(block, cpatch, ph, size, mult, addval);
 
     for (j = 0; j < size; j++)
     {
@@ -681,4 +306,3 @@ void decompress_patchv(LLVector3 *v, S32 *cpatch, LLPatchHeader *ph)
         }
     }
 }
-
@@ -0,0 +1,279 @@
+/**
+ * @file llpacketreceiver_test.cpp
+ * @date 2024-11
+ * @brief LLFramedPacket and LLPacketReceiver test cases.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llpacketreceiver.h"
+
+#include <iostream>
+
+#if LL_WINDOWS
+    #include <winsock2.h>
+#else
+    #include <netinet/in.h>
+#endif
+
+#include "../message.h"
+#include "lltimer.h"
+
+#include "../test/lltut.h"
+
+namespace
+{
+    // Write a packet header, returns bytes written
+    S32 put_header(U8 * buffer, U8 flags, U32 packet_id)
+    {
+        buffer[0] = flags;
+        U32 net_id = htonl(packet_id);
+        memcpy(&buffer[1], &net_id, sizeof(net_id));
+        buffer[5] = 0;      // no extra header
+        return LL_PACKET_ID_SIZE;
+    }
+
+    S32 put_ack(U8 * buffer, TPACKETID id)
+    {
+        U32 net_id = htonl(id);
+        memcpy(buffer, &net_id, sizeof(net_id));
+        return sizeof(net_id);
+    }
+}
+
+namespace tut
+{
+    struct packetreceiver_data
+    {
+    };
+    typedef test_group<packetreceiver_data> packetreceiver_test;
+    typedef packetreceiver_test::object packetreceiver_object;
+    tut::packetreceiver_test packetreceiver_testcase("LLPacketReceiver");
+
+    template<> template<>
+    void packetreceiver_object::test<1>()
+    {
+        set_test_name("frame() splits acks and expands zero-coding");
+
+        LLFramedPacket packet;
+        U8 * buffer = (U8 *)packet.mData;
+        S32 size = put_header(buffer, LL_ZERO_CODE_FLAG | LL_ACK_FLAG | LL_RELIABLE_FLAG, 1234);
+        buffer[size++] = 0x01;      // message number
+        buffer[size++] = 0x00;      // five zeroes
+        buffer[size++] = 0x05;
+        buffer[size++] = 0xab;
+        const S32 payload = size;
+        size += put_ack(&buffer[size], 7);
+        size += put_ack(&buffer[size], 9);
+        buffer[size++] = 2;         // ack count
+        packet.mSize = size;
+
+        packet.frame();
+
+        ensure("not malformed", !packet.mMalformed);
+        ensure("no overflow", !packet.mOverflow);
+        ensure_equals("ack count", packet.mAckCount, 2);
+        ensure_equals("last ack first", packet.mAcks[0], (TPACKETID)9);
+        ensure_equals("first ack last", packet.mAcks[1], (TPACKETID)7);
+        ensure_equals("payload size", packet.mPayloadSize, payload);
+        ensure_equals("compressed size", packet.mCompressedSize, payload);
+        ensure_equals("expanded size", packet.mMessageSize, LL_PACKET_ID_SIZE + 1 + 5 + 1);
+        ensure("zero-code flag cleared", !(packet.mMessage[0] & LL_ZERO_CODE_FLAG));
+        ensure("other flags kept", (packet.mMessage[0] & LL_RELIABLE_FLAG) != 0);
+        U32 net_id = 0;
+        memcpy(&net_id, &packet.mMessage[1], sizeof(net_id));
+        ensure_equals("packet id", ntohl(net_id), (U32)1234);
+        ensure_equals("message number", packet.mMessage[6], (U8)0x01);
+        for (S32 i = 7; i < 12; ++i)
+        {
+            ensure_equals("expanded zero", packet.mMessage[i], (U8)0);
+        }
+        ensure_equals("trailing byte", packet.mMessage[12], (U8)0xab);
+    }
+
+    template<> template<>
+    void packetreceiver_object::test<2>()
+    {
+        set_test_name("frame() leaves plain packets in place and flags bad ack counts");
+
+        LLFramedPacket packet;
+        U8 * buffer = (U8 *)packet.mData;
+        S32 size = put_header(buffer, 0, 42);
+        buffer[size++] = 0x01;
+        buffer[size++] = 0x00;
+        buffer[size++] = 0x05;
+        packet.mSize = size;
+
+        packet.frame();
+        ensure("plain packet not copied", packet.mMessage == buffer);
+        ensure_equals("plain size", packet.mMessageSize, size);
+        ensure_equals("not compressed", packet.mCompressedSize, 0);
+        ensure_equals("no acks", packet.mAckCount, 0);
+
+        buffer[0] = LL_ACK_FLAG;
+        buffer[size++] = 200;       // far more acks than bytes
+        packet.mSize = size;
+
+        packet.frame();
+        ensure("malformed", packet.mMalformed);
+    }
+
+    template<> template<>
+    void packetreceiver_object::test<3>()
+    {
+        set_test_name("zero_code_expand() refuses to overflow");
+
+        U8 in[64];
+        S32 size = put_header(in, LL_ZERO_CODE_FLAG, 1);
+        while (size < (S32)sizeof(in))
+        {
+            in[size++] = 0;         // each pair of zeroes is 256 bytes out
+        }
+
+        U8 out[NET_BUFFER_SIZE];
+        ensure_equals("overflow detected", zero_code_expand(in, size, out, sizeof(out)), -1);
+
+        // A trailing lone zero is just a zero
+        size = put_header(in, LL_ZERO_CODE_FLAG, 1);
+        in[size++] = 0x03;
+        in[size++] = 0x00;
+        ensure_equals("trailing zero", zero_code_expand(in, size, out, sizeof(out)), LL_PACKET_ID_SIZE + 2);
+    }
+
+    template<> template<>
+    void packetreceiver_object::test<4>()
+    {
+        set_test_name("Replay bursts, main thread drain time with and without the receive thread");
+        if (!getenv("LL_TEST_BENCHMARK"))
+        {
+            skip("benchmark, set LL_TEST_BENCHMARK to run it");
+        }
+
+        S32 socket = -1;
+        int port = NET_USE_OS_ASSIGNED_PORT;
+        if (start_net(socket, port))
+        {
+            skip("no network available");
+        }
+        const U32 loopback = ip_string_to_u32(LOOPBACK_ADDRESS_STRING);
+
+        // Roughly an ObjectUpdate burst on region crossing
+        const S32 BURSTS = 20;
+        const S32 PACKETS_PER_BURST = 200;
+        const S32 PACKET_SIZE = 600;
+        char packet[PACKET_SIZE];
+        for (S32 i = 0; i < PACKET_SIZE; ++i)
+        {
+            packet[i] = (char)(i * 7);
+        }
+        packet[0] = LL_ZERO_CODE_FLAG;
+
+        // Each packet carries its own id so that the order can be checked
+        U32 next_id = 0;
+        auto send_burst = [&]()
+        {
+            for (S32 i = 0; i < PACKETS_PER_BURST; ++i)
+            {
+                put_header((U8 *)packet, LL_ZERO_CODE_FLAG, ++next_id);
+                send_packet(socket, packet, PACKET_SIZE, loopback, port);
+            }
+            // Let them land in the socket buffer
+            ms_sleep(20);
+        };
+
+        // UDP may drop packets even on loopback, so only what did arrive is
+        // checked: intact, and in the order it was sent
+        auto check_packet = [&](const char * path, const LLFramedPacket & framed, U32 & last_id)
+        {
+            ensure_equals(std::string(path) + " packet size", framed.mSize, PACKET_SIZE);
+            ensure(std::string(path) + " packet framed", !framed.mMalformed && !framed.mOverflow);
+            U32 net_id = 0;
+            memcpy(&net_id, &framed.mMessage[1], sizeof(net_id));
+            const U32 id = ntohl(net_id);
+            ensure(std::string(path) + " packet order", id > last_id);
+            last_id = id;
+        };
+
+        // Inline: receive and frame on the "main" thread like before
+        LLFramedPacket inline_packet;
+        S32 inline_count = 0;
+        U32 inline_last_id = 0;
+        F64 inline_secs = 0.0;
+        for (S32 burst = 0; burst < BURSTS; ++burst)
+        {
+            send_burst();
+            LLTimer timer;
+            while ((inline_packet.mSize = receive_packet(socket, inline_packet.mData)) > 0)
+            {
+                inline_packet.frame();
+                check_packet("inline", inline_packet, inline_last_id);
+                ++inline_count;
+            }
+            inline_secs += timer.getElapsedTimeF64();
+        }
+
+        // Threaded: the main thread only picks up framed packets
+        S32 thread_count = 0;
+        U32 thread_last_id = next_id;
+        F64 thread_secs = 0.0;
+        {
+            LLPacketReceiver receiver(socket);
+            receiver.start();
+            for (S32 burst = 0; burst < BURSTS; ++burst)
+            {
+                send_burst();
+                LLTimer timer;
+                while (LLFramedPacket * packetp = receiver.next())
+                {
+                    check_packet("threaded", *packetp, thread_last_id);
+                    ++thread_count;
+                }
+                thread_secs += timer.getElapsedTimeF64();
+            }
+            // Stragglers don't count towards the drain time
+            for (S32 i = 0; i < 50 && thread_count < BURSTS * PACKETS_PER_BURST; ++i)
+            {
+                ms_sleep(10);
+                while (LLFramedPacket * packetp = receiver.next())
+                {
+                    check_packet("threaded", *packetp, thread_last_id);
+                    ++thread_count;
+                }
+            }
+        }
+
+        end_net(socket);
+
+        std::cout << "\n"
+                  << "Inline receive: " << inline_count << " packets, "
+                  << (inline_secs * 1000.0 / BURSTS) << " ms per burst on the main thread\n"
+                  << "Receive thread: " << thread_count << " packets, "
+                  << (thread_secs * 1000.0 / BURSTS) << " ms per burst on the main thread"
+                  << std::endl;
+
+        // Not everything has to arrive, but most of it should
+        ensure("inline received most packets", inline_count >= BURSTS * PACKETS_PER_BURST / 2);
+        ensure("thread received most packets", thread_count >= BURSTS * PACKETS_PER_BURST / 2);
+    }
+}
@@ -0,0 +1,391 @@
+/**
+ * @file patch_idct_test.cpp
+ * @date 2024-11
+ * @brief Terrain patch decompression test cases.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llmath.h"
+#include "../patch_dct.h"
+#include "../patch_code.h"
+
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "llbitpack.h"
+#include "lltimer.h"
+
+#include "../test/lltut.h"
+
+namespace
+{
+    const S32 REGION_WIDTH = 256;
+    const S32 GRIDS_PER_EDGE = REGION_WIDTH + 1;  // with the north and east buffers
+    const S32 PREQUANT = 10;
+
+    // The decoder's tables, built the straightforward way
+    class Tables
+    {
+    public:
+        Tables(S32 size)
+            : mSize(size),
+              mDequantize(size*size),
+              mICosines(size*size),
+              mDeCopy(size*size)
+        {
+            F32 oosob = F_PI*0.5f/size;
+            for (S32 j = 0; j < size; j++)
+            {
+                for (S32 i = 0; i < size; i++)
+                {
+                    mDequantize[j*size + i] = 1.f + 2.f*(i + j);
+                    mICosines[j*size + i] = cosf((2.f*i + 1.f)*j*oosob);
+                }
+            }
+
+            // Zigzag: i rises along even diagonals, falls along odd ones
+            S32 count = 0;
+            for (S32 d = 0; d < 2*size - 1; d++)
+            {
+                S32 lo = llmax(0, d - size + 1);
+                S32 hi = llmin(d, size - 1);
+                for (S32 k = lo; k <= hi; k++)
+                {
+                    S32 i = (d & 1) ? hi - (k - lo) : k;
+                    mDeCopy[(d - i)*size + i] = count++;
+                }
+            }
+        }
+
+        void dequantize(F32 *block, const S32 *cpatch) const
+        {
+            for (S32 i = 0; i < mSize*mSize; i++)
+            {
+                block[i] = cpatch[mDeCopy[i]]*mDequantize[i];
+            }
+        }
+
+        S32 mSize;
+        std::vector<F32> mDequantize;
+        std::vector<F32> mICosines;
+        std::vector<S32> mDeCopy;
+    };
+
+    void get_scale(const LLPatchHeader &ph, F32 &mult, F32 &addval)
+    {
+        S32 prequant = (ph.quant_wbits >> 4) + 2;
+        mult = (1.f/(F32)(1<<prequant))*ph.range;
+        addval = mult*(F32)(1<<(prequant - 1)) + ph.dc_offset;
+    }
+
+    // The scalar decoder as it was, one column and one line at a time
+    void scalar_decompress(const Tables &tables, F32 *patch, const S32 *cpatch, const LLPatchHeader &ph, S32 stride)
+    {
+        const S32 size = tables.mSize;
+        const F32 *cosines = tables.mICosines.data();
+        F32 block[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
+        F32 temp[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
+        tables.dequantize(block, cpatch);
+
+        for (S32 c = 0; c < size; c++)
+        {
+            for (S32 n = 0; n < size; n++)
+            {
+                F32 total = OO_SQRT2*block[c];
+                for (S32 m = 1; m < size; m++)
+                {
+                    total += block[m*size + c]*cosines[m*size + n];
+                }
+                temp[n*size + c] = total;
+            }
+        }
+        for (S32 l = 0; l < size; l++)
+        {
+            for (S32 n = 0; n < size; n++)
+            {
+                F32 total = OO_SQRT2*temp[l*size];
+                for (S32 u = 1; u < size; u++)
+                {
+                    total += temp[l*size + u]*cosines[u*size + n];
+                }
+                block[l*size + n] = total*(2.f/size);
+            }
+        }
+
+        F32 mult, addval;
+        get_scale(ph, mult, addval);
+        for (S32 j = 0; j < size; j++)
+        {
+            for (S32 i = 0; i < size; i++)
+            {
+                patch[j*stride + i] = block[j*size + i]*mult + addval;
+            }
+        }
+    }
+
+    // Textbook 2D inverse DCT in double precision, with the decoder's
+    // scaling (2/size once, not per pass).  Returns the largest height any
+    // one coefficient can add, which float rounding errors scale with.
+    F64 exact_decompress(const Tables &tables, F64 *patch, const S32 *cpatch, const LLPatchHeader &ph)
+    {
+        const S32 size = tables.mSize;
+        F32 block[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
+        tables.dequantize(block, cpatch);
+
+        F32 mult, addval;
+        get_scale(ph, mult, addval);
+        F64 magnitude = 0.0;
+        for (S32 k = 0; k < size*size; k++)
+        {
+            magnitude += fabs(block[k]);
+        }
+        for (S32 y = 0; y < size; y++)
+        {
+            for (S32 x = 0; x < size; x++)
+            {
+                F64 total = 0.0;
+                for (S32 v = 0; v < size; v++)
+                {
+                    F64 cv = (v ? 1.0 : 1.0/sqrt(2.0))*cos((2*y + 1)*v*F_PI/(2.0*size));
+                    for (S32 u = 0; u < size; u++)
+                    {
+                        F64 cu = (u ? 1.0 : 1.0/sqrt(2.0))*cos((2*x + 1)*u*F_PI/(2.0*size));
+                        total += block[v*size + u]*cu*cv;
+                    }
+                }
+                patch[y*size + x] = total*(2.0/size)*mult + addval;
+            }
+        }
+        return magnitude*(2.0/size)*mult;
+    }
+
+    // Rolling hills with some bumps, in meters
+    F32 terrain_height(S32 x, S32 y)
+    {
+        return 30.f + 12.f*sinf(x*0.045f)*cosf(y*0.06f) + 2.5f*sinf(x*0.31f + y*0.17f);
+    }
+
+    // A LayerData land block for a whole region, the way the simulator
+    // packs it.  Returns the packed size.
+    S32 encode_land(std::vector<U8> &buffer, const std::vector<F32> &heights, S32 size)
+    {
+        buffer.assign(64*1024, 0);
+        LLBitPack bitpack(buffer.data(), (U32)buffer.size());
+
+        init_patch_compressor(size, GRIDS_PER_EDGE, 'L');
+        LLGroupHeader goph;
+        get_patch_group_header(&goph);
+        init_patch_coding(bitpack);
+        code_patch_group_header(bitpack, &goph);
+
+        S32 cpatch[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
+        const S32 patches_per_edge = REGION_WIDTH/size;
+        for (S32 j = 0; j < patches_per_edge; j++)
+        {
+            for (S32 i = 0; i < patches_per_edge; i++)
+            {
+                F32 *patch = const_cast<F32 *>(&heights[j*size*GRIDS_PER_EDGE + i*size]);
+                LLPatchHeader ph;
+                F32 zmax, zmin;
+                prescan_patch(patch, &ph, zmax, zmin);
+                compress_patch(patch, cpatch, &ph, PREQUANT);
+                ph.patchids = (i << 5) | j;
+                code_patch_header(bitpack, &ph, cpatch);
+                code_patch(bitpack, cpatch, 0);
+            }
+        }
+        code_end_of_data(bitpack);
+        return (S32)bitpack.flushBitPack();
+    }
+
+    // Decode a land block into heights the way LLSurface does, with either
+    // decoder.  Returns the number of patches.
+    S32 decode_land(const std::vector<U8> &buffer, S32 packed_size, std::vector<F32> &heights, const Tables *scalar)
+    {
+        LLBitPack bitpack(const_cast<U8 *>(buffer.data()), packed_size);
+        LLGroupHeader goph;
+        decode_patch_group_header(bitpack, &goph);
+        const S32 size = goph.patch_size;
+
+        S32 count = 0;
+        S32 cpatch[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
+        LLPatchHeader ph;
+        while (1)
+        {
+            decode_patch_header(bitpack, &ph, false);
+            if (ph.quant_wbits == END_OF_PATCHES)
+            {
+                break;
+            }
+            S32 i = ph.patchids >> 5;
+            S32 j = ph.patchids & 0x1F;
+            decode_patch(bitpack, cpatch);
+
+            F32 *patch = &heights[j*size*GRIDS_PER_EDGE + i*size];
+            if (scalar)
+            {
+                scalar_decompress(*scalar, patch, cpatch, ph, GRIDS_PER_EDGE);
+            }
+            else
+            {
+                decompress_patch(patch, cpatch, &ph, size, GRIDS_PER_EDGE);
+            }
+            count++;
+        }
+        return count;
+    }
+}
+
+namespace tut
+{
+    struct patch_idct_data
+    {
+        patch_idct_data()
+            : mHeights(GRIDS_PER_EDGE*GRIDS_PER_EDGE)
+        {
+            for (S32 y = 0; y < GRIDS_PER_EDGE; y++)
+            {
+                for (S32 x = 0; x < GRIDS_PER_EDGE; x++)
+                {
+                    mHeights[y*GRIDS_PER_EDGE + x] = terrain_height(x, y);
+                }
+            }
+        }
+
+        std::vector<F32> mHeights;
+    };
+    typedef test_group<patch_idct_data> patch_idct_test;
+    typedef patch_idct_test::object patch_idct_object;
+    tut::patch_idct_test patch_idct_testcase("patch_idct");
+
+    template<> template<>
+    void patch_idct_object::test<1>()
+    {
+        set_test_name("decompress_patch() matches the scalar decoder bit for bit");
+
+        for (S32 size : { (S32)NORMAL_PATCH_SIZE, (S32)LARGE_PATCH_SIZE })
+        {
+            Tables tables(size);
+            U32 seed = 1;
+            for (S32 iter = 0; iter < 200; iter++)
+            {
+                // Mostly low frequency, like terrain
+                S32 cpatch[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
+                for (S32 k = 0; k < size*size; k++)
+                {
+                    seed = seed*1664525 + 1013904223;
+                    cpatch[k] = (k < 24 || !(seed >> 29)) ? (S32)(seed >> 16) % 2001 - 1000 : 0;
+                }
+                LLPatchHeader ph;
+                ph.dc_offset = 20.f + iter;
+                ph.range = 1 + iter;
+                ph.quant_wbits = (U8)(((iter % 8) << 4) | 6);
+
+                F32 expected[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
+                F32 actual[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
+                F64 exact[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
+                scalar_decompress(tables, expected, cpatch, ph, size);
+                decompress_patch(actual, cpatch, &ph, size, size);
+                F32 tolerance = (F32)exact_decompress(tables, exact, cpatch, ph)*1e-5f + 1e-4f;
+
+                for (S32 k = 0; k < size*size; k++)
+                {
+                    ensure_equals("same as scalar", actual[k], expected[k]);
+                    ensure_approximately_equals_range("close to exact", actual[k], (F32)exact[k], tolerance);
+                }
+            }
+        }
+    }
+
+    template<> template<>
+    void patch_idct_object::test<2>()
+    {
+        set_test_name("Land layer data round trip");
+
+        for (S32 size : { (S32)NORMAL_PATCH_SIZE, (S32)LARGE_PATCH_SIZE })
+        {
+            std::vector<U8> buffer;
+            S32 packed_size = encode_land(buffer, mHeights, size);
+
+            std::vector<F32> decoded(GRIDS_PER_EDGE*GRIDS_PER_EDGE, 0.f);
+            S32 patches = decode_land(buffer, packed_size, decoded, NULL);
+            ensure_equals("every patch", patches, (REGION_WIDTH/size)*(REGION_WIDTH/size));
+
+            F32 max_error = 0.f;
+            for (S32 y = 0; y < REGION_WIDTH; y++)
+            {
+                for (S32 x = 0; x < REGION_WIDTH; x++)
+                {
+                    max_error = llmax(max_error, fabsf(decoded[y*GRIDS_PER_EDGE + x] - mHeights[y*GRIDS_PER_EDGE + x]));
+                }
+            }
+            ensure("heights survive compression (" + std::to_string(max_error) + " m off)", max_error < 1.f);
+        }
+    }
+
+    template<> template<>
+    void patch_idct_object::test<3>()
+    {
+        set_test_name("Decode time of a region of land, scalar and vectorized");
+        if (!getenv("LL_TEST_BENCHMARK"))
+        {
+            skip("benchmark, set LL_TEST_BENCHMARK to run it");
+        }
+
+        const S32 ROUNDS = 50;
+        for (S32 size : { (S32)NORMAL_PATCH_SIZE, (S32)LARGE_PATCH_SIZE })
+        {
+            std::vector<U8> buffer;
+            S32 packed_size = encode_land(buffer, mHeights, size);
+            Tables tables(size);
+
+            std::vector<F32> scalar(GRIDS_PER_EDGE*GRIDS_PER_EDGE, 0.f);
+            std::vector<F32> vectorized(GRIDS_PER_EDGE*GRIDS_PER_EDGE, 0.f);
+
+            LLTimer timer;
+            for (S32 round = 0; round < ROUNDS; round++)
+            {
+                decode_land(buffer, packed_size, scalar, &tables);
+            }
+            F64 scalar_secs = timer.getElapsedTimeF64();
+
+            timer.reset();
+            for (S32 round = 0; round < ROUNDS; round++)
+            {
+                decode_land(buffer, packed_size, vectorized, NULL);
+            }
+            F64 vectorized_secs = timer.getElapsedTimeF64();
+
+            std::cout << "\n"
+                      << size << "x" << size << " patches, " << packed_size << " bytes per region: "
+                      << (scalar_secs * 1000.0 / ROUNDS) << " ms scalar, "
+                      << (vectorized_secs * 1000.0 / ROUNDS) << " ms vectorized"
+                      << std::endl;
+
+            ensure("same heights", scalar == vectorized);
+        }
+    }
+}
@@ -63,64 +63,65 @@ static const struct
     U32                         mMax;
     U32                         mRate;
     bool                        mPipelined;
+    bool                        mMultiplexed;       // Pipelined over HTTP/2 where the server offers it
     std::string                 mKey;
     const char *                mUsage;
 } init_data[LLAppCoreHttp::AP_COUNT] =
 {
     { // AP_DEFAULT
-        8,      8,      8,      0,      false,
+        8,      8,      8,      0,      false,  false,
         "",
         "other"
     },
     // <FS:Beq> Avoid stall in texture fetch due to asset fetching. [Drake]
     { // AP_ASSET
-        12,     1,      16,     0,      true,
+        12,     1,      16,     0,      true,   false,
         "AssetFetchConcurrency",
         "asset fetch"
     },
     // </FS:Beq>
     { // AP_TEXTURE
-        8,      1,      12,     0,      true,
+        8,      1,      12,     0,      true,   false,
         "TextureFetchConcurrency",
         "texture fetch"
     },
     { // AP_MESH1
-        32,     1,      128,    0,      false,
+        32,     1,      128,    0,      false,  false,
         "MeshMaxConcurrentRequests",
         "mesh fetch"
     },
     { // AP_MESH2
-        8,      1,      32,     0,      true,
+        8,      1,      32,     0,      true,   true,
         "Mesh2MaxConcurrentRequests",
         "mesh2 fetch"
     },
     { // AP_LARGE_MESH
-        2,      1,      8,      0,      false,
+        2,      1,      8,      0,      false,  false,
         "",
         "large mesh fetch"
     },
     { // AP_UPLOADS
-        2,      1,      8,      0,      false,
+        2,      1,      8,      0,      false,  false,
         "",
         "asset upload"
     },
     { // AP_LONG_POLL
-        32,     32,     32,     0,      false,
+        32,     32,     32,     0,      false,  false,
         "",
         "long poll"
     },
     { // AP_INVENTORY
-        4,      1,      4,      0,      false,
+        4,      1,      4,      0,      false,  false,
         "",
         "inventory"
     },
     { // AP_MATERIALS
-        2,      1,      8,      0,      false,
+        2,      1,      8,      0,      false,  false,
         "RenderMaterials",
         "material manager requests"
     },
     { // AP_AGENT
-        2,      1,      32,     0,      false,
+        2,      1,      32,     0,      false,  false,
         "Agent",
         "Agent requests"
     }
@@ -133,7 +134,8 @@ static void ssl_verification_changed();
 LLAppCoreHttp::HttpClass::HttpClass()
     : mPolicy(LLCore::HttpRequest::DEFAULT_POLICY_ID),
       mConnLimit(0U),
-      mPipelined(false)
+      mPipelined(false),
+      mMultiplexed(false)
 {}
 
 
@@ -426,6 +428,25 @@ void LLAppCoreHttp::refreshSettings(bool initial)
                 }
             }
 
+            if (init_data[i].mMultiplexed)
+            {
+                // Only takes effect while the class is pipelined
+                status = LLCore::HttpRequest::setStaticPolicyOption(LLCore::HttpRequest::PO_HTTP2_MULTIPLEX,
+                                                                    mHttpClasses[app_policy].mPolicy,
+                                                                    1L,
+                                                                    NULL);
+                if (! status)
+                {
+                    LL_WARNS("Init") << "Unable to set " << init_data[i].mUsage
+                                     << " HTTP/2 multiplexing.  Reason:  " << status.toString()
+                                     << LL_ENDL;
+                }
+                else
+                {
+                    mHttpClasses[app_policy].mMultiplexed = true;
+                }
+            }
+
         }
 
         // Init- or run-time settings.  Must use the queued request API.
@@ -244,6 +244,12 @@ public:
             return mHttpClasses[policy].mPipelined;
         }
 
+    // Return whether a pipelined policy multiplexes over HTTP/2.
+    bool isMultiplexed(EAppPolicy policy) const
+        {
+            return mHttpClasses[policy].mPipelined && mHttpClasses[policy].mMultiplexed;
+        }
+
     // Apply initial or new settings from the environment.
     void refreshSettings(bool initial);
 
@@ -262,6 +268,7 @@ private:
         policy_t                    mPolicy;            // Policy class id for the class
         U32                         mConnLimit;
         bool                        mPipelined;
+        bool                        mMultiplexed;
         boost::signals2::connection mSettingsSignal;    // Signal to global setting that affect this class (if any)
     };
 
@@ -5010,6 +5010,7 @@ bool LLAppViewer::initCache()
     const uintmax_t disk_cache_size = llclamp(disk_cache_b, MIN_CACHE_SIZE, MAX_CACHE_SIZE);
     // </FS:Ansariel>
     const bool enable_cache_debug_info = gSavedSettings.getBOOL("EnableDiskCacheDebugInfo");
+    const bool use_pack_store = gSavedSettings.getBOOL("FSDiskCachePackStore");
 
     bool texture_cache_mismatch = false;
     bool remove_vfs_files = false;
@@ -5089,7 +5090,7 @@ bool LLAppViewer::initCache()
     const std::string cache_dir = gDirUtilp->getExpandedFilename(LL_PATH_CACHE, cache_dir_name);
     // <FS:Beq> Improve cache purge triggering
     // LLDiskCache::initParamSingleton(cache_dir, disk_cache_size, enable_cache_debug_info);
-    LLDiskCache::initParamSingleton(cache_dir, disk_cache_size, enable_cache_debug_info, gSavedSettings.getF32("FSDiskCacheHighWaterPercent"), gSavedSettings.getF32("FSDiskCacheLowWaterPercent"));
+    LLDiskCache::initParamSingleton(cache_dir, disk_cache_size, enable_cache_debug_info, gSavedSettings.getF32("FSDiskCacheHighWaterPercent"), gSavedSettings.getF32("FSDiskCacheLowWaterPercent"), use_pack_store, read_only);
     // </FS:Beq>
 
     if (!read_only)
@@ -5101,6 +5102,13 @@ bool LLAppViewer::initCache()
             gSavedSettings.setS32("DiskCacheVersion", LLAppViewer::getDiskCacheVersion());
         }
 
+        // Assets stored in the other layout would never be found or purged
+        if (gSavedSettings.getBOOL("FSDiskCachePackStoreInUse") != use_pack_store)
+        {
+            LLDiskCache::getInstance()->clearCache();
+            gSavedSettings.setBOOL("FSDiskCachePackStoreInUse", use_pack_store);
+        }
+
         if (remove_vfs_files)
         {
             LLDiskCache::getInstance()->removeOldVFSFiles();
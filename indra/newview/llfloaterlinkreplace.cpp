@@ -126,14 +126,7 @@ void LLFloaterLinkReplace::onDeleteOnlyToggle()
 
 void LLFloaterLinkReplace::updateFoundLinks()
 {
-    LLInventoryModel::item_array_t items;
-    LLInventoryModel::cat_array_t cat_array;
-    LLLinkedItemIDMatches is_linked_item_match(mSourceUUID);
-    gInventory.collectDescendentsIf(gInventory.getRootFolderID(),
-                                    cat_array,
-                                    items,
-                                    LLInventoryModel::INCLUDE_TRASH,
-                                    is_linked_item_match);
+    LLInventoryModel::item_array_t items = gInventory.collectLinkedItems(mSourceUUID);
     mRemainingItems = (U32)items.size();
 
     LLStringUtil::format_map_t args;
@@ -221,13 +214,8 @@ void LLFloaterLinkReplace::onStartClickedResponse(const LLSD& notification, cons
     if (LLNotificationsUtil::getSelectedOption(notification, response) == 0)
     {
 
-        LLInventoryModel::cat_array_t cat_array;
-        LLLinkedItemIDMatches is_linked_item_match(mSourceUUID);
-        gInventory.collectDescendentsIf(gInventory.getRootFolderID(),
-            cat_array,
-            mRemainingInventoryItems,
-            LLInventoryModel::INCLUDE_TRASH,
-            is_linked_item_match);
+        LLInventoryModel::item_array_t links = gInventory.collectLinkedItems(mSourceUUID);
+        mRemainingInventoryItems.insert(mRemainingInventoryItems.end(), links.begin(), links.end());
         LL_INFOS() << "Found " << mRemainingInventoryItems.size() << " inventory links that need to be replaced." << LL_ENDL;
 
         if (mRemainingInventoryItems.size() > 0)
@@ -278,14 +266,7 @@ void LLFloaterLinkReplace::linkCreatedCallback(LLHandle<LLFloaterLinkReplace> fl
     // link is worn. So we have to correct this.
     if (needs_description_update && outfit_folder_id.notNull())
     {
-        LLInventoryModel::item_array_t items;
-        LLInventoryModel::cat_array_t cats;
-        LLLinkedItemIDMatches is_target_link(target_item_id);
-        gInventory.collectDescendentsIf(outfit_folder_id,
-                                        cats,
-                                        items,
-                                        LLInventoryModel::EXCLUDE_TRASH,
-                                        is_target_link);
+        LLInventoryModel::item_array_t items = gInventory.collectLinkedItems(target_item_id, outfit_folder_id);
 
         for (LLInventoryModel::item_array_t::iterator it = items.begin(); it != items.end(); ++it)
         {
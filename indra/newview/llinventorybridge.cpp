@@ -2620,9 +2620,9 @@ std::string LLFolderBridge::getLabelSuffix() const
     }
     else if(mShowDescendantsCount)
     {
-        LLInventoryModel::cat_array_t cat_array;
-        LLInventoryModel::item_array_t item_array;
-        gInventory.collectDescendents(getUUID(), cat_array, item_array, true);
+        S32 cat_count = 0;
+        S32 item_count = 0;
+        gInventory.countDescendents(getUUID(), cat_count, item_count);
         // <FS:Ansariel> Fix item count formatting
         //auto count = item_array.size();
         //if (count > 0)
@@ -2633,14 +2633,14 @@ std::string LLFolderBridge::getLabelSuffix() const
         //    args["[ITEMS_COUNT]"] = oss.str();
         //    suffix = " " + LLTrans::getString("InventoryItemsCount", args);
         //}
-        if (cat_array.size() > 0 || item_array.size() > 0)
+        if (cat_count > 0 || item_count > 0)
         {
             LLLocale locale("");
             LLStringUtil::format_map_t args;
             std::string count_str;
-            LLResMgr::getInstance()->getIntegerString(count_str, static_cast<S32>(item_array.size()));
+            LLResMgr::getInstance()->getIntegerString(count_str, item_count);
             args["ITEMS"] = count_str;
-            LLResMgr::getInstance()->getIntegerString(count_str, static_cast<S32>(cat_array.size()));
+            LLResMgr::getInstance()->getIntegerString(count_str, cat_count);
             args["CATEGORIES"] = count_str;
             suffix = " " + LLTrans::getString("InventoryItemsCount", args);
         }
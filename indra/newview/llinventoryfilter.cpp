@@ -35,6 +35,7 @@
 #include "llinventorymodel.h"
 #include "llinventorymodelbackgroundfetch.h"
 #include "llinventoryfunctions.h"
+#include "llinventorysearchobserver.h"
 #include "llmarketplacefunctions.h"
 #include "llregex.h"
 #include "llviewercontrol.h"
@@ -111,7 +112,21 @@ bool LLInventoryFilter::check(const LLFolderViewModelItem* item)
         return true;
     }
 
-    std::string desc = listener->getSearchableCreatorName();
+    bool passed = true;
+    if (checkAgainstSearchIndex(listener, passed))
+    {
+        passed = passed && checkAgainstFilterType(listener);
+        passed = passed && checkAgainstPermissions(listener);
+        passed = passed && checkAgainstFilterLinks(listener);
+        passed = passed && checkAgainstCreator(listener);
+        passed = passed && checkAgainstSearchVisibility(listener);
+
+        passed = passed && checkAgainstFilterThumbnails(listener->getUUID());
+
+        return passed;
+    }
+
+    std::string desc;
     switch(mSearchType)
     {
         case SEARCHTYPE_CREATOR:
@@ -134,7 +149,6 @@ bool LLInventoryFilter::check(const LLFolderViewModelItem* item)
             break;
     }
 
-    bool passed = true;
     // <FS:Ansariel> Allow searching by all
     //if (!mExactToken.empty() && (mSearchType == SEARCHTYPE_NAME))
     if (!mExactToken.empty() && ((mSearchType == SEARCHTYPE_NAME) || (mSearchType == SEARCHTYPE_ALL)))
@@ -183,6 +197,94 @@ bool LLInventoryFilter::check(const LLFolderViewModelItem* item)
     return passed;
 }
 
+bool LLInventoryFilter::checkAgainstSearchIndex(const LLFolderViewModelItemInventory* listener, bool& passed) const
+{
+    U32 field_mask = 0;
+    switch (mSearchType)
+    {
+        case SEARCHTYPE_CREATOR:
+            field_mask = 1 << LLInventorySearchIndex::FIELD_CREATOR;
+            break;
+        case SEARCHTYPE_DESCRIPTION:
+            field_mask = 1 << LLInventorySearchIndex::FIELD_DESCRIPTION;
+            break;
+        case SEARCHTYPE_ALL:
+            // A '+' on its own matches the separators of getSearchableAll()
+            if (!mExactToken.empty()
+                || (mFilterTokens.empty() && mFilterSubString.find('+') != std::string::npos))
+            {
+                return false;
+            }
+            field_mask = (1 << LLInventorySearchIndex::FIELD_CREATOR) | (1 << LLInventorySearchIndex::FIELD_DESCRIPTION);
+            break;
+        default:
+            return false;
+    }
+
+    if (mFilterSubString.empty())
+    {
+        passed = true;
+        return true;
+    }
+
+    if (!gInventory.isInventoryUsable())
+    {
+        return false;
+    }
+    LLInventorySearchObserver& search = LLInventorySearchObserver::instance();
+    const LLUUID& item_id = listener->getUUID();
+    if (!search.isIndexed(item_id))
+    {
+        return false;
+    }
+
+    if (mSearchType != SEARCHTYPE_ALL)
+    {
+        passed = search.matches(item_id, field_mask, mFilterSubString);
+        return true;
+    }
+
+    // The name comes from the listener, it may carry a label suffix the
+    // index does not know about.  Asset ids are only looked at for strings
+    // that could be part of one.
+    const std::string& name = listener->getSearchableName();
+    std::string uuid_string;
+    bool have_uuid_string = false;
+    auto contains = [&](const std::string& sub_string)
+    {
+        if (name.find(sub_string) != std::string::npos || search.matches(item_id, field_mask, sub_string))
+        {
+            return true;
+        }
+        if (sub_string.find_first_not_of("0123456789ABCDEF-") != std::string::npos)
+        {
+            return false;
+        }
+        if (!have_uuid_string)
+        {
+            uuid_string = listener->getSearchableUUIDString();
+            have_uuid_string = true;
+        }
+        return uuid_string.find(sub_string) != std::string::npos;
+    };
+
+    if (mFilterTokens.empty())
+    {
+        passed = contains(mFilterSubString);
+        return true;
+    }
+    for (const std::string& token : mFilterTokens)
+    {
+        if (!contains(token))
+        {
+            passed = false;
+            return true;
+        }
+    }
+    passed = true;
+    return true;
+}
+
 bool LLInventoryFilter::check(const LLInventoryItem* item)
 {
     const bool passed_string = (mFilterSubString.size() ? item->getName().find(mFilterSubString) != std::string::npos : true);
@@ -369,6 +369,9 @@ private:
     bool                checkAgainstPermissions(const LLInventoryItem* item) const;
     bool                checkAgainstFilterLinks(const class LLFolderViewModelItemInventory* listener) const;
     bool                checkAgainstCreator(const class LLFolderViewModelItemInventory* listener) const;
+    // Sets passed from the search index and returns true, or returns false
+    // if the index cannot answer for this item and search type.
+    bool                checkAgainstSearchIndex(const class LLFolderViewModelItemInventory* listener, bool& passed) const;
     bool                checkAgainstSearchVisibility(const class LLFolderViewModelItemInventory* listener) const;
     bool                checkAgainstClipboard(const LLUUID& object_id) const;
 
@@ -3452,10 +3452,10 @@ void LLInventoryAction::doToSelected(LLInventoryModel* model, LLFolderView* root
                     auto cat = model->getCategory(view_model->getUUID());
                     if (cat)
                     {
-                        LLInventoryModel::cat_array_t cats;
-                        LLInventoryModel::item_array_t items;
-                        model->collectDescendents(cat->getUUID(), cats, items, true);
-                        total_count += (S32)(cats.size() + items.size());
+                        S32 cat_count = 0;
+                        S32 item_count = 0;
+                        model->countDescendents(cat->getUUID(), cat_count, item_count);
+                        total_count += cat_count + item_count;
                     }
                 }
             }
@@ -40,6 +40,7 @@
 #include "lldispatcher.h"
 #include "llinventorypanel.h"
 #include "llinventorybridge.h"
+#include "llinventorycache.h"
 #include "llinventoryfunctions.h"
 #include "llinventorymodelbackgroundfetch.h"
 #include "llinventoryobserver.h"
@@ -456,6 +457,7 @@ LLInventoryModel::LLInventoryModel()
     mItemMap(),
     mParentChildCategoryTree(),
     mParentChildItemTree(),
+    mDescendentCounts(),
     mLastItem(NULL),
     mIsNotifyObservers(false),
     mModifyMask(LLInventoryObserver::ALL),
@@ -1363,14 +1365,22 @@ void LLInventoryModel::collectDescendentsIf(const LLUUID& id,
                                             LLInventoryCollectFunctor& add,
                                             bool follow_folder_links)
 // [/RLVa:KB]
+{
+    // Look the trash up once, not at every level of the walk
+    const LLUUID trash_id = include_trash ? LLUUID::null : findCategoryUUIDForType(LLFolderType::FT_TRASH);
+    collectDescendentsIfNotIn(id, cats, items, trash_id, add, follow_folder_links);
+}
+
+void LLInventoryModel::collectDescendentsIfNotIn(const LLUUID& id,
+                                                 cat_array_t& cats,
+                                                 item_array_t& items,
+                                                 const LLUUID& excluded_id,
+                                                 LLInventoryCollectFunctor& add,
+                                                 bool follow_folder_links)
 {
     // Start with categories
-    if(!include_trash)
-    {
-        const LLUUID trash_id = findCategoryUUIDForType(LLFolderType::FT_TRASH);
-        if(trash_id.notNull() && (trash_id == id))
-            return;
-    }
+    if(excluded_id.notNull() && (excluded_id == id))
+        return;
     cat_array_t* cat_array = get_ptr_in_map(mParentChildCategoryTree, id);
     if(cat_array)
     {
@@ -1381,7 +1391,7 @@ void LLInventoryModel::collectDescendentsIf(const LLUUID& id,
                 cats.push_back(cat);
             }
 // [RLVa:KB] - Checked: 2013-04-15 (RLVa-1.4.8)
-            collectDescendentsIf(cat->getUUID(), cats, items, include_trash, add, follow_folder_links);
+            collectDescendentsIfNotIn(cat->getUUID(), cats, items, excluded_id, add, follow_folder_links);
 // [/RLVa:KB]
 //          collectDescendentsIf(cat->getUUID(), cats, items, include_trash, add);
         }
@@ -1430,7 +1440,7 @@ void LLInventoryModel::collectDescendentsIf(const LLUUID& id,
                         // outfit traversal.
                         cats.push_back(LLPointer<LLViewerInventoryCategory>(linked_cat));
                     }
-                    collectDescendentsIf(linked_cat->getUUID(), cats, items, include_trash, add, false);
+                    collectDescendentsIfNotIn(linked_cat->getUUID(), cats, items, excluded_id, add, false);
                 }
             }
         }
@@ -1500,18 +1510,69 @@ LLInventoryModel::item_array_t LLInventoryModel::collectLinksTo(const LLUUID& id
 LLInventoryModel::item_array_t LLInventoryModel::collectLinkedItems(const LLUUID& id,
                                                                     const LLUUID& start_folder_id)
 {
+    // Start from the backlinks and check where each link lives instead of
+    // walking the whole folder tree looking for them.
     item_array_t items;
-    LLInventoryModel::cat_array_t cat_array;
-    LLLinkedItemIDMatches is_linked_item_match(id);
-    collectDescendentsIf((start_folder_id == LLUUID::null ? gInventory.getRootFolderID() : start_folder_id),
-                         cat_array,
-                         items,
-                         LLInventoryModel::INCLUDE_TRASH,
-                         is_linked_item_match);
+    const LLUUID& root_id = (start_folder_id == LLUUID::null ? gInventory.getRootFolderID() : start_folder_id);
+    std::pair<backlink_mmap_t::iterator, backlink_mmap_t::iterator> range = mBacklinkMMap.equal_range(id);
+    for (backlink_mmap_t::iterator it = range.first; it != range.second; ++it)
+    {
+        LLViewerInventoryItem* item = getItem(it->second);
+        if (item && item->getIsLinkType() && item->getLinkedUUID() == id
+            && isObjectDescendentOf(item->getUUID(), root_id))
+        {
+            items.push_back(item);
+        }
+    }
     return items;
 }
 // </FS:Ansariel>
 
+void LLInventoryModel::countDescendents(const LLUUID& id, S32& cat_count, S32& item_count) const
+{
+    descendent_counts_t counts = getDescendentCounts(id);
+    cat_count = counts.first;
+    item_count = counts.second;
+}
+
+LLInventoryModel::descendent_counts_t LLInventoryModel::getDescendentCounts(const LLUUID& cat_id) const
+{
+    descendent_counts_map_t::const_iterator found = mDescendentCounts.find(cat_id);
+    if (found != mDescendentCounts.end())
+    {
+        return found->second;
+    }
+
+    // Enter the folder before its children, so a loop in a broken
+    // inventory ends here instead of recursing forever.
+    mDescendentCounts[cat_id] = descendent_counts_t(0, 0);
+
+    descendent_counts_t counts(0, 0);
+    if (cat_array_t* cat_array = get_ptr_in_map(mParentChildCategoryTree, cat_id))
+    {
+        for (auto& cat : *cat_array)
+        {
+            descendent_counts_t child_counts = getDescendentCounts(cat->getUUID());
+            counts.first += 1 + child_counts.first;
+            counts.second += child_counts.second;
+        }
+    }
+    if (item_array_t* item_array = get_ptr_in_map(mParentChildItemTree, cat_id))
+    {
+        counts.second += static_cast<S32>(item_array->size());
+    }
+    mDescendentCounts[cat_id] = counts;
+    return counts;
+}
+
+void LLInventoryModel::dirtyDescendentCounts()
+{
+    if (!mDescendentCounts.empty())
+    {
+        mDescendentCounts.clear();
+    }
+}
+
 bool LLInventoryModel::isInventoryUsable() const
 {
     bool result = false;
@@ -1599,6 +1660,7 @@ U32 LLInventoryModel::updateItem(const LLViewerInventoryItem* item, U32 mask)
                 }
                 item_array->push_back(old_item);
             }
+            dirtyDescendentCounts();
             mask |= LLInventoryObserver::STRUCTURE;
         }
         if(old_item->getName() != item->getName())
@@ -1689,6 +1751,7 @@ U32 LLInventoryModel::updateItem(const LLViewerInventoryItem* item, U32 mask)
                 }
             }
         }
+        dirtyDescendentCounts();
         mask |= LLInventoryObserver::ADD;
     }
     if(new_item->getType() == LLAssetType::AT_CALLINGCARD)
@@ -1784,6 +1847,7 @@ void LLInventoryModel::updateCategory(const LLViewerInventoryCategory* cat, U32
             {
                 cat_array->push_back(old_cat);
             }
+            dirtyDescendentCounts();
             mask |= LLInventoryObserver::STRUCTURE;
             mask |= LLInventoryObserver::INTERNAL;
         }
@@ -1822,6 +1886,7 @@ void LLInventoryModel::updateCategory(const LLViewerInventoryCategory* cat, U32
         item_array_t* itemsp = new item_array_t;
         mParentChildCategoryTree[new_cat->getUUID()] = catsp;
         mParentChildItemTree[new_cat->getUUID()] = itemsp;
+        dirtyDescendentCounts();
         mask |= LLInventoryObserver::ADD;
         addChangedMask(mask, cat->getUUID());
     }
@@ -1836,7 +1901,7 @@ void LLInventoryModel::moveObject(const LLUUID& object_id, const LLUUID& cat_id)
         return;
     }
 
-    if((object_id == cat_id) || !is_in_map(mCategoryMap, cat_id))
+    if((object_id == cat_id) || !mCategoryMap.contains(cat_id))
     {
         LL_WARNS(LOG_INV) << "Could not move inventory object " << object_id << " to "
                           << cat_id << LL_ENDL;
@@ -1852,6 +1917,7 @@ void LLInventoryModel::moveObject(const LLUUID& object_id, const LLUUID& cat_id)
         cat_array = getUnlockedCatArray(cat_id);
         cat->setParent(cat_id);
         if(cat_array) cat_array->push_back(cat);
+        dirtyDescendentCounts();
         addChangedMask(LLInventoryObserver::STRUCTURE, object_id);
         return;
     }
@@ -1865,6 +1931,7 @@ void LLInventoryModel::moveObject(const LLUUID& object_id, const LLUUID& cat_id)
         item_array = getUnlockedItemArray(cat_id);
         item->setParent(cat_id);
         if(item_array) item_array->push_back(item);
+        dirtyDescendentCounts();
         addChangedMask(LLInventoryObserver::STRUCTURE, object_id);
         return;
     }
@@ -2191,6 +2258,7 @@ void LLInventoryModel::deleteObject(const LLUUID& id, bool fix_broken_links, boo
         LLPointer<LLViewerInventoryCategory> cat = (LLViewerInventoryCategory*)((LLInventoryObject*)obj);
         vector_replace_with_last(*cat_list, cat);
     }
+    dirtyDescendentCounts();
 
     // Note : We need to tell the inventory observers that those things are going to be deleted *before* the tree is cleared or they won't know what to delete (in views and view models)
     addChangedMask(LLInventoryObserver::REMOVE, id);
@@ -2216,6 +2284,7 @@ void LLInventoryModel::deleteObject(const LLUUID& id, bool fix_broken_links, boo
         delete cat_list;
         mParentChildCategoryTree.erase(id);
     }
+    dirtyDescendentCounts();
     addChangedMask(LLInventoryObserver::REMOVE, id);
 
     bool is_link_type = obj->getIsLinkType();
@@ -2515,20 +2584,16 @@ void LLInventoryModel::cache(
         items,
         INCLUDE_TRASH,
         can_cache);
-    // Use temporary file to avoid potential conflicts with other
-    // instances (even a 'read only' instance unzips into a file)
-    std::string temp_file = gDirUtilp->getTempFilename();
-    saveToFile(temp_file, categories, items);
-    std::string gzip_filename = getInvCacheAddres(agent_id);
-    gzip_filename.append(".gz");
-    if(gzip_file(temp_file, gzip_filename))
-    {
-        LL_DEBUGS(LOG_INV) << "Successfully compressed " << temp_file << " to " << gzip_filename << LL_ENDL;
-        LLFile::remove(temp_file);
-    }
-    else
+    // Written through a temporary file and renamed, so other instances
+    // never map half a cache
+    std::string inventory_filename = getInvCacheAddres(agent_id);
+    saveToFile(inventory_filename + ".bin", categories, items);
+
+    // The gzipped LLSD cache is only read when there is no binary one
+    std::string gzip_filename = inventory_filename + ".gz";
+    if (LLFile::isfile(gzip_filename))
     {
-        LL_WARNS(LOG_INV) << "Unable to compress " << temp_file << " into " << gzip_filename << LL_ENDL;
+        LLFile::remove(gzip_filename);
     }
 }
 
@@ -2699,6 +2764,7 @@ void LLInventoryModel::empty()
         mParentChildItemTree.end(),
         DeletePairedPointer());
     mParentChildItemTree.clear();
+    mDescendentCounts.clear();
     mBacklinkMMap.clear(); // forget all backlink information.
     mCategoryMap.clear(); // remove all references (should delete entries)
     mItemMap.clear(); // remove all references (should delete entries)
@@ -2845,6 +2911,13 @@ bool LLInventoryModel::loadSkeleton(
             LLFile::remove(inventory_filename);
         }
 
+        std::string binary_filename = inventory_filename + ".bin";
+        if (LLFile::isfile(binary_filename))
+        {
+            LL_INFOS("LLInventoryModel") << "Purging inventory cache file: " << binary_filename << LL_ENDL;
+            LLFile::remove(binary_filename);
+        }
+
         inventory_filename.append(".gz");
         if (LLFile::isfile(inventory_filename))
         {
@@ -2864,6 +2937,13 @@ bool LLInventoryModel::loadSkeleton(
             LLFile::remove(inventory_filename);
         }
 
+        binary_filename = inventory_filename + ".bin";
+        if (LLFile::isfile(binary_filename))
+        {
+            LL_INFOS("LLInventoryModel") << "Purging library cache file: " << binary_filename << LL_ENDL;
+            LLFile::remove(binary_filename);
+        }
+
         inventory_filename.append(".gz");
         if (LLFile::isfile(inventory_filename))
         {
@@ -2930,39 +3010,52 @@ bool LLInventoryModel::loadSkeleton(
         cat_set_t invalid_categories; // Used to mark categories that weren't successfully loaded.
         std::string inventory_filename = getInvCacheAddres(owner_id);
         const S32 NO_VERSION = LLViewerInventoryCategory::VERSION_UNKNOWN;
+        std::string binary_filename(inventory_filename);
+        binary_filename.append(".bin");
         std::string gzip_filename(inventory_filename);
         gzip_filename.append(".gz");
-        LLFILE* fp = LLFile::fopen(gzip_filename, "rb");
         bool remove_inventory_file = false;
-        if (LLAppViewer::instance()->isSecondInstance())
+        bool is_cache_obsolete = false;
+        bool cache_loaded = false;
+        if (LLFile::isfile(binary_filename))
         {
-            // Safeguard viewer against trying to unpack file twice
-            // ex: user logs into two accounts simultaneously, so two
-            // viewers are trying to unpack library into same file
-            //
-            // Would be better to do it in gunzip_file, but it doesn't
-            // have access to llfilesystem
-            inventory_filename = gDirUtilp->getTempFilename();
-            remove_inventory_file = true;
+            // Mapped read only, so instances can share it
+            cache_loaded = loadFromBinaryFile(binary_filename, categories, items, categories_to_update, is_cache_obsolete);
         }
-        if(fp)
+        else
         {
-            fclose(fp);
-            fp = NULL;
-            if(gunzip_file(gzip_filename, inventory_filename))
+            // Legacy cache, the next save replaces it with a binary one
+            LLFILE* fp = LLFile::fopen(gzip_filename, "rb");
+            if (LLAppViewer::instance()->isSecondInstance())
             {
-                // we only want to remove the inventory file if it was
-                // gzipped before we loaded, and we successfully
-                // gunziped it.
+                // Safeguard viewer against trying to unpack file twice
+                // ex: user logs into two accounts simultaneously, so two
+                // viewers are trying to unpack library into same file
+                //
+                // Would be better to do it in gunzip_file, but it doesn't
+                // have access to llfilesystem
+                inventory_filename = gDirUtilp->getTempFilename();
                 remove_inventory_file = true;
             }
-            else
+            if(fp)
             {
-                LL_INFOS(LOG_INV) << "Unable to gunzip " << gzip_filename << LL_ENDL;
+                fclose(fp);
+                fp = NULL;
+                if(gunzip_file(gzip_filename, inventory_filename))
+                {
+                    // we only want to remove the inventory file if it was
+                    // gzipped before we loaded, and we successfully
+                    // gunziped it.
+                    remove_inventory_file = true;
+                }
+                else
+                {
+                    LL_INFOS(LOG_INV) << "Unable to gunzip " << gzip_filename << LL_ENDL;
+                }
             }
+            cache_loaded = loadFromFile(inventory_filename, categories, items, categories_to_update, is_cache_obsolete);
         }
-        bool is_cache_obsolete = false;
-        if (loadFromFile(inventory_filename, categories, items, categories_to_update, is_cache_obsolete))
+        if (cache_loaded)
         {
             // We were able to find a cache of files. So, use what we
             // found to generate a set of categories we should add. We
@@ -3155,7 +3248,8 @@ bool LLInventoryModel::loadSkeleton(
         {
             // If out of date, remove the gzipped file too.
             LL_WARNS(LOG_INV) << "Inv cache out of date, removing" << LL_ENDL;
-            LLFile::remove(gzip_filename);
+            LLFile::remove(gzip_filename, ENOENT);
+            LLFile::remove(binary_filename, ENOENT);
         }
         categories.clear(); // will unref and delete entries
     }
@@ -3179,6 +3273,8 @@ void LLInventoryModel::buildParentChildMap()
     // might actually want to invalidate it at that point - not
     // attempt to cache. More time & thought is necessary.
 
+    dirtyDescendentCounts();
+
     // First the categories. We'll copy all of the categories into a
     // temporary container to iterate over (oh for real iterators.)
     // While we're at it, we'll allocate the arrays in the trees.
@@ -3701,78 +3797,119 @@ bool LLInventoryModel::loadFromFile(const std::string& filename,
 }
 
 // static
-bool LLInventoryModel::saveToFile(const std::string& filename,
-    const cat_array_t& categories,
-    const item_array_t& items)
+bool LLInventoryModel::loadFromBinaryFile(const std::string& filename,
+                                          LLInventoryModel::cat_array_t& categories,
+                                          LLInventoryModel::item_array_t& items,
+                                          LLInventoryModel::changed_items_t& cats_to_update,
+                                          bool& is_cache_obsolete)
 {
-    if (filename.empty())
+    LL_PROFILE_ZONE_NAMED("inventory load from binary file");
+    LL_INFOS(LOG_INV) << "loading inventory from: (" << filename << ")" << LL_ENDL;
+
+    is_cache_obsolete = true; // Obsolete until proven current
+
+    LLInventoryCacheReader reader;
+    if (!reader.open(filename))
     {
-        LL_ERRS(LOG_INV) << "Filename is Null!" << LL_ENDL;
+        LL_INFOS(LOG_INV) << "unable to load inventory from: " << filename << LL_ENDL;
         return false;
     }
+    if (reader.getCacheVersion() != sCurrentInvCacheVersion)
+    {
+        LL_WARNS(LOG_INV) << "Inventory cache is out of date" << LL_ENDL;
+        return false;
+    }
+    is_cache_obsolete = false;
 
-    LL_INFOS(LOG_INV) << "saving inventory to: (" << filename << ")" << LL_ENDL;
-
-    try
+    // Records are independent, decode them in parallel then keep them in
+    // file order the way loadFromFile() does.
+    const S32 cat_count = reader.getCategoryCount();
+    cat_array_t loaded_categories(cat_count);
+    LLInventoryCacheReader::forEachChunk(cat_count, [&](S32 begin, S32 end)
     {
-        llofstream fileXML(filename.c_str());
-        if (!fileXML.is_open())
+        for (S32 i = begin; i < end; ++i)
         {
-            LL_WARNS(LOG_INV) << "Failed to open file. Unable to save inventory to: " << filename << LL_ENDL;
-            return false;
+            LLViewerInventoryCategory* inv_cat = new LLViewerInventoryCategory(reader.getCategoryOwnerID(i));
+            reader.readCategory(i, *inv_cat);
+            inv_cat->setVersion(reader.getCategoryVersion(i));
+            loaded_categories[i] = inv_cat;
         }
+    });
 
-        LLSD cache_ver;
-        cache_ver["inv_cache_version"] = sCurrentInvCacheVersion;
-
-        if (fileXML.fail())
+    const S32 item_count = reader.getItemCount();
+    item_array_t loaded_items(item_count);
+    LLInventoryCacheReader::forEachChunk(item_count, [&](S32 begin, S32 end)
+    {
+        for (S32 i = begin; i < end; ++i)
         {
-            LL_WARNS(LOG_INV) << "Failed to write cache version to file. Unable to save inventory to: " << filename << LL_ENDL;
-            return false;
+            LLViewerInventoryItem* inv_item = new LLViewerInventoryItem;
+            reader.readItem(i, *inv_item);
+            loaded_items[i] = inv_item;
         }
+    });
 
-        fileXML << LLSDOStreamer<LLSDNotationFormatter>(cache_ver) << std::endl;
-
-        S32 cat_count = 0;
-        for (auto& cat : categories)
+    categories.insert(categories.end(), loaded_categories.begin(), loaded_categories.end());
+    items.reserve(items.size() + loaded_items.size());
+    for (auto& inv_item : loaded_items)
+    {
+        if (inv_item->getUUID().isNull())
         {
-            if (cat->getVersion() != LLViewerInventoryCategory::VERSION_UNKNOWN)
-            {
-                fileXML << LLSDOStreamer<LLSDNotationFormatter>(cat->exportLLSD()) << std::endl;
-                cat_count++;
-            }
-
-            if (fileXML.fail())
-            {
-                LL_WARNS(LOG_INV) << "Failed to write a folder to file. Unable to save inventory to: " << filename << LL_ENDL;
-                return false;
-            }
+            LL_DEBUGS(LOG_INV) << "Ignoring inventory with null item id: "
+                << inv_item->getName() << LL_ENDL;
         }
-
-        auto it_count = items.size();
-        for (auto& item : items)
+        else if (inv_item->getType() == LLAssetType::AT_UNKNOWN)
         {
-            fileXML << LLSDOStreamer<LLSDNotationFormatter>(item->asLLSD()) << std::endl;
-
-            if (fileXML.fail())
-            {
-                LL_WARNS(LOG_INV) << "Failed to write an item to file. Unable to save inventory to: " << filename << LL_ENDL;
-                return false;
-            }
+            cats_to_update.insert(inv_item->getParentUUID());
+        }
+        else
+        {
+            items.push_back(inv_item);
         }
-        fileXML.flush();
+    }
 
-        fileXML.close();
+    LL_INFOS(LOG_INV) << "Inventory loaded: " << cat_count << " categories, " << item_count << " items." << LL_ENDL;
+    return true;
+}
 
-        LL_INFOS(LOG_INV) << "Inventory saved: " << cat_count << " categories, " << it_count << " items." << LL_ENDL;
+// static
+bool LLInventoryModel::saveToFile(const std::string& filename,
+    const cat_array_t& categories,
+    const item_array_t& items)
+{
+    LL_PROFILE_ZONE_SCOPED;
+    if (filename.empty())
+    {
+        LL_ERRS(LOG_INV) << "Filename is Null!" << LL_ENDL;
+        return false;
+    }
+
+    LL_INFOS(LOG_INV) << "saving inventory to: (" << filename << ")" << LL_ENDL;
+
+    LLInventoryCacheWriter writer(sCurrentInvCacheVersion);
+    for (auto& cat : categories)
+    {
+        if (cat->getVersion() != LLViewerInventoryCategory::VERSION_UNKNOWN)
+        {
+            writer.addCategory(*cat, cat->getOwnerID(), cat->getVersion());
+        }
     }
-    catch (...)
+    for (auto& item : items)
+    {
+        writer.addItem(*item);
+    }
+
+    // Written right away: this runs on the disconnect path, and the cache
+    // directory may be purged on exit as soon as it returns.
+    const S32 cat_count = writer.getCategoryCount();
+    const S32 item_count = writer.getItemCount();
+    std::vector<U8> data;
+    writer.finish(data);
+    if (!LLInventoryCacheWriter::writeFile(filename, data))
     {
-        LOG_UNHANDLED_EXCEPTION("");
-        LL_INFOS(LOG_INV) << "Failed to save inventory to: (" << filename << ")" << LL_ENDL;
         return false;
     }
 
+    LL_INFOS(LOG_INV) << "Inventory saved: " << cat_count << " categories, " << item_count << " items." << LL_ENDL;
     return true;
 }
 
@@ -32,6 +32,8 @@
 #include <string>
 #include <vector>
 
+#include <boost/unordered/unordered_flat_map.hpp>
+
 #include "llassettype.h"
 #include "llfoldertype.h"
 #include "llframetimer.h"
@@ -213,16 +215,35 @@ private:
     // the inventory using several different identifiers.
     // mInventory member data is the 'master' list of inventory, and
     // mCategoryMap and mItemMap store uuid->object mappings.
-    typedef std::map<LLUUID, LLPointer<LLViewerInventoryCategory> > cat_map_t;
-    typedef std::map<LLUUID, LLPointer<LLViewerInventoryItem> > item_map_t;
+    // These are open addressed hash tables, iteration order is arbitrary.
+    typedef boost::unordered_flat_map<LLUUID, LLPointer<LLViewerInventoryCategory> > cat_map_t;
+    typedef boost::unordered_flat_map<LLUUID, LLPointer<LLViewerInventoryItem> > item_map_t;
     cat_map_t mCategoryMap;
     item_map_t mItemMap;
     // This last set of indices is used to map parents to children.
-    typedef std::map<LLUUID, cat_array_t*> parent_cat_map_t;
-    typedef std::map<LLUUID, item_array_t*> parent_item_map_t;
+    // The child arrays are allocated separately so pointers handed out
+    // by getDirectDescendentsOf() survive the tables growing.
+    typedef boost::unordered_flat_map<LLUUID, cat_array_t*> parent_cat_map_t;
+    typedef boost::unordered_flat_map<LLUUID, item_array_t*> parent_item_map_t;
     parent_cat_map_t mParentChildCategoryTree;
     parent_item_map_t mParentChildItemTree;
 
+    // Number of categories and items below each folder, filled in as
+    // countDescendents() asks for them and dropped whenever the
+    // parent-child structure changes.
+    typedef std::pair<S32, S32> descendent_counts_t; // categories, items
+    typedef boost::unordered_flat_map<LLUUID, descendent_counts_t> descendent_counts_map_t;
+    mutable descendent_counts_map_t mDescendentCounts;
+    descendent_counts_t getDescendentCounts(const LLUUID& cat_id) const;
+    void dirtyDescendentCounts();
+    // collectDescendentsIf() skipping the folder excluded_id, if not null
+    void collectDescendentsIfNotIn(const LLUUID& id,
+                                   cat_array_t& categories,
+                                   item_array_t& items,
+                                   const LLUUID& excluded_id,
+                                   LLInventoryCollectFunctor& add,
+                                   bool follow_folder_links);
+
     // Track links to items and categories. We do not store item or
     // category pointers here, because broken links are also supported.
     typedef std::multimap<LLUUID, LLUUID> backlink_mmap_t;
@@ -307,6 +328,12 @@ public:
 //                            bool include_trash,
 //                            LLInventoryCollectFunctor& add);
 
+    // Count the categories and items below the object specified, the
+    // same objects collectDescendents() with trash included collects.
+    // Counts are cached until the structure changes, so this is cheap
+    // enough for folder labels.
+    void countDescendents(const LLUUID& id, S32& cat_count, S32& item_count) const;
+
     // Collect all items in inventory that are linked to item_id.
     // Assumes item_id is itself not a linked item.
     item_array_t collectLinksTo(const LLUUID& item_id);
@@ -726,6 +753,12 @@ protected:
                              item_array_t& items,
                              changed_items_t& cats_to_update,
                              bool& is_cache_obsolete);
+    static bool loadFromBinaryFile(const std::string& filename,
+                                   cat_array_t& categories,
+                                   item_array_t& items,
+                                   changed_items_t& cats_to_update,
+                                   bool& is_cache_obsolete);
+    // Writes the binary cache, the file is written on the general thread pool
     static bool saveToFile(const std::string& filename,
                            const cat_array_t& categories,
                            const item_array_t& items);
@@ -762,8 +795,8 @@ protected:
     cat_array_t* getUnlockedCatArray(const LLUUID& id);
     item_array_t* getUnlockedItemArray(const LLUUID& id);
 private:
-    std::map<LLUUID, bool> mCategoryLock;
-    std::map<LLUUID, bool> mItemLock;
+    boost::unordered_flat_map<LLUUID, bool> mCategoryLock;
+    boost::unordered_flat_map<LLUUID, bool> mItemLock;
 
     //--------------------------------------------------------------------
     // Debugging
@@ -0,0 +1,286 @@
+/**
+ * @file llinventorysearchobserver.cpp
+ * @brief Keeps the inventory search index in step with the inventory model.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llinventorysearchobserver.h"
+
+#include "llcallbacklist.h"
+#include "llinventorymodel.h"
+#include "lltimer.h"
+#include "llviewerinventory.h"
+
+// Time spent indexing queued items per frame
+const F32 INDEX_TIME_SLICE_SECONDS = 0.002f;
+
+// getMatches() results kept, enough for the tokens of a search
+const size_t MAX_CACHED_QUERIES = 8;
+
+LLInventorySearchObserver::LLInventorySearchObserver() :
+    mQueuedAll(false),
+    mIndexingOnIdle(false)
+{
+    gInventory.addObserver(this);
+    queueAll();
+}
+
+LLInventorySearchObserver::~LLInventorySearchObserver()
+{
+    for (name_connections_t::value_type& connection : mNameConnections)
+    {
+        connection.second.disconnect();
+    }
+
+    if (gInventory.containsObserver(this))
+    {
+        gInventory.removeObserver(this);
+    }
+}
+
+void LLInventorySearchObserver::changed(U32 mask)
+{
+    if (!gInventory.isInventoryUsable())
+    {
+        return;
+    }
+
+    if (!mQueuedAll)
+    {
+        // Everything there is gets queued once, which covers these changes
+        queueAll();
+        return;
+    }
+
+    if (!(mask & (LLInventoryObserver::LABEL | LLInventoryObserver::INTERNAL
+                  | LLInventoryObserver::ADD | LLInventoryObserver::REMOVE
+                  | LLInventoryObserver::REBUILD)))
+    {
+        return;
+    }
+
+    for (const LLUUID& id : gInventory.getChangedIDs())
+    {
+        // Drop the old text right away so the filter does not match against
+        // it, the item is checked the old way until it is indexed again.
+        mIndex.removeObject(id);
+
+        LLViewerInventoryItem* item = gInventory.getItem(id);
+        if (!item)
+        {
+            continue;
+        }
+        queueItem(id);
+
+        // Links show the description and creator of what they link to
+        if (!item->getIsLinkType())
+        {
+            LLInventoryModel::item_array_t links = gInventory.collectLinksTo(id);
+            for (LLViewerInventoryItem* link : links)
+            {
+                mIndex.removeObject(link->getUUID());
+                queueItem(link->getUUID());
+            }
+        }
+    }
+}
+
+bool LLInventorySearchObserver::matches(const LLUUID& item_id, U32 field_mask, const std::string& upper_sub_string)
+{
+    if (mIndexingOnIdle)
+    {
+        // Every frame of indexing changes the index, a set of matches would
+        // be out of date by the next one
+        return mIndex.matches(item_id, field_mask, upper_sub_string);
+    }
+    return getMatches(field_mask, upper_sub_string).count(item_id) > 0;
+}
+
+const LLInventorySearchObserver::match_set_t& LLInventorySearchObserver::getMatches(U32 field_mask, const std::string& upper_sub_string)
+{
+    Query* query = NULL;
+    for (Query& cached : mQueries)
+    {
+        if (cached.mFieldMask == field_mask && cached.mSubString == upper_sub_string)
+        {
+            query = &cached;
+            break;
+        }
+    }
+
+    if (!query)
+    {
+        if (mQueries.size() >= MAX_CACHED_QUERIES)
+        {
+            mQueries.pop_front();
+        }
+        mQueries.emplace_back();
+        query = &mQueries.back();
+        query->mFieldMask = field_mask;
+        query->mSubString = upper_sub_string;
+        query->mGeneration = mIndex.getGeneration() - 1;
+    }
+
+    if (query->mGeneration != mIndex.getGeneration())
+    {
+        LL_PROFILE_ZONE_SCOPED;
+        uuid_vec_t found;
+        mIndex.find(field_mask, upper_sub_string, found);
+        query->mMatches.clear();
+        query->mMatches.insert(found.begin(), found.end());
+        query->mGeneration = mIndex.getGeneration();
+    }
+    return query->mMatches;
+}
+
+void LLInventorySearchObserver::queueAll()
+{
+    if (mQueuedAll || !gInventory.isInventoryUsable())
+    {
+        return;
+    }
+    mQueuedAll = true;
+
+    const LLUUID roots[] = { gInventory.getRootFolderID(), gInventory.getLibraryRootFolderID() };
+    for (const LLUUID& root_id : roots)
+    {
+        if (root_id.isNull())
+        {
+            continue;
+        }
+        LLInventoryModel::cat_array_t cats;
+        LLInventoryModel::item_array_t items;
+        gInventory.collectDescendents(root_id, cats, items, LLInventoryModel::INCLUDE_TRASH);
+        for (LLViewerInventoryItem* item : items)
+        {
+            queueItem(item->getUUID());
+        }
+    }
+    LL_INFOS("Inventory") << "Queued " << mQueue.size() << " items for the search index" << LL_ENDL;
+}
+
+void LLInventorySearchObserver::queueItem(const LLUUID& item_id)
+{
+    mQueue.push_back(item_id);
+    if (!mIndexingOnIdle)
+    {
+        mIndexingOnIdle = true;
+        doOnIdleRepeating([]()
+            {
+                return !LLInventorySearchObserver::instanceExists()
+                    || LLInventorySearchObserver::instance().indexQueued();
+            });
+    }
+}
+
+bool LLInventorySearchObserver::indexQueued()
+{
+    LLTimer timer;
+    while (!mQueue.empty())
+    {
+        indexItem(mQueue.front());
+        mQueue.pop_front();
+        if (timer.getElapsedTimeF32() > INDEX_TIME_SLICE_SECONDS)
+        {
+            return false;
+        }
+    }
+    mIndexingOnIdle = false;
+    return true;
+}
+
+void LLInventorySearchObserver::indexItem(const LLUUID& item_id)
+{
+    const LLViewerInventoryItem* item = gInventory.getItem(item_id);
+    if (!item)
+    {
+        mIndex.removeObject(item_id);
+        return;
+    }
+
+    // The same text get_searchable_description() and
+    // get_searchable_creator_name() produce.  Names are left out, the
+    // filter matches the bridge's name, label suffix and all.
+    mIndex.setField(item_id, LLInventorySearchIndex::FIELD_DESCRIPTION, item->getDescription());
+
+    std::string creator_name;
+    bool lookup_creator = false;
+    const LLUUID& creator_id = item->getCreatorUUID();
+    if (creator_id.notNull())
+    {
+        LLAvatarName av_name;
+        if (LLAvatarNameCache::get(creator_id, &av_name))
+        {
+            creator_name = av_name.getUserName();
+        }
+        else
+        {
+            mPendingCreators[creator_id].push_back(item_id);
+            lookup_creator = (mNameConnections.find(creator_id) == mNameConnections.end());
+        }
+    }
+    mIndex.setField(item_id, LLInventorySearchIndex::FIELD_CREATOR, creator_name);
+
+    if (lookup_creator)
+    {
+        LLAvatarNameCache::callback_connection_t connection = LLAvatarNameCache::get(creator_id,
+            boost::bind(&LLInventorySearchObserver::onCreatorName, this, _1, _2));
+        if (connection.connected())
+        {
+            mNameConnections[creator_id] = connection;
+        }
+    }
+}
+
+void LLInventorySearchObserver::onCreatorName(const LLUUID& creator_id, const LLAvatarName& av_name)
+{
+    name_connections_t::iterator connection = mNameConnections.find(creator_id);
+    if (connection != mNameConnections.end())
+    {
+        connection->second.disconnect();
+        mNameConnections.erase(connection);
+    }
+
+    pending_creators_t::iterator pending = mPendingCreators.find(creator_id);
+    if (pending == mPendingCreators.end())
+    {
+        return;
+    }
+    uuid_vec_t item_ids;
+    item_ids.swap(pending->second);
+    mPendingCreators.erase(pending);
+
+    const std::string creator_name = av_name.getUserName();
+    for (const LLUUID& item_id : item_ids)
+    {
+        // Only items still indexed under this creator
+        const LLViewerInventoryItem* item = gInventory.getItem(item_id);
+        if (item && item->getCreatorUUID() == creator_id && mIndex.hasObject(item_id))
+        {
+            mIndex.setField(item_id, LLInventorySearchIndex::FIELD_CREATOR, creator_name);
+        }
+    }
+}
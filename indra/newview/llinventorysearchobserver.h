@@ -0,0 +1,104 @@
+/**
+ * @file llinventorysearchobserver.h
+ * @brief Keeps the inventory search index in step with the inventory model.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+
+#ifndef LL_LLINVENTORYSEARCHOBSERVER_H
+#define LL_LLINVENTORYSEARCHOBSERVER_H
+
+#include "llinventoryobserver.h"
+#include "llinventorysearchindex.h"
+#include "llavatarnamecache.h"
+#include "llsingleton.h"
+
+#include <deque>
+#include <unordered_set>
+
+/**
+ * Search index over the descriptions and creator names of the items in
+ * agent inventory and the library, so the inventory filter does not build
+ * and upper case those strings for every item on every keystroke.
+ * Items are indexed a few at a time on idle and reindexed when the model
+ * reports them changed; anything not indexed (yet) is checked the old way.
+ * A search string is looked up in the index once, and the filter then
+ * only has to see whether each item is among the matches.
+ */
+class LLInventorySearchObserver : public LLInventoryObserver, public LLSingleton<LLInventorySearchObserver>
+{
+    LLSINGLETON(LLInventorySearchObserver);
+    virtual ~LLInventorySearchObserver();
+
+public:
+    virtual void changed(U32 mask) override;
+
+    // True if the index has current text for the item
+    bool isIndexed(const LLUUID& item_id) const { return mIndex.hasObject(item_id); }
+
+    // True if a field in field_mask of the item contains upper_sub_string.
+    // Answered from the set of matches getMatches() keeps for the string,
+    // unless the index is still changing every frame.
+    bool matches(const LLUUID& item_id, U32 field_mask, const std::string& upper_sub_string);
+
+    // The indexed items with a field in field_mask containing
+    // upper_sub_string, see LLInventorySearchIndex::find().  Kept until the
+    // index changes, so a filter pass only queries the index once.
+    typedef std::unordered_set<LLUUID> match_set_t;
+    const match_set_t& getMatches(U32 field_mask, const std::string& upper_sub_string);
+
+    const LLInventorySearchIndex& getIndex() const { return mIndex; }
+
+private:
+    void queueAll();
+    void queueItem(const LLUUID& item_id);
+    // Returns true once the queue is empty, for doOnIdleRepeating()
+    bool indexQueued();
+    void indexItem(const LLUUID& item_id);
+    void onCreatorName(const LLUUID& creator_id, const LLAvatarName& av_name);
+
+    LLInventorySearchIndex mIndex;
+
+    // Most recent getMatches() results, oldest first
+    struct Query
+    {
+        U32 mFieldMask;
+        std::string mSubString;
+        U32 mGeneration;
+        match_set_t mMatches;
+    };
+    std::deque<Query> mQueries;
+
+    std::deque<LLUUID> mQueue;
+    bool mQueuedAll;
+    bool mIndexingOnIdle;
+
+    // Items indexed without a creator name, by the creator whose name
+    // the name cache is still looking up
+    typedef std::map<LLUUID, uuid_vec_t> pending_creators_t;
+    pending_creators_t mPendingCreators;
+    typedef std::map<LLUUID, LLAvatarNameCache::callback_connection_t> name_connections_t;
+    name_connections_t mNameConnections;
+};
+
+#endif // LL_LLINVENTORYSEARCHOBSERVER_H
@@ -359,6 +359,8 @@ const S32 REQUEST2_HIGH_WATER_MIN = 32;                 // Limits for GetMesh2 r
 const S32 REQUEST2_HIGH_WATER_MAX = 100;
 const S32 REQUEST2_LOW_WATER_MIN = 16;
 const S32 REQUEST2_LOW_WATER_MAX = 50;
+const S32 HEADER2_HIGH_WATER_MAX = 200;                 // Header fetches are 4KB, pipelined classes can take more
+const size_t CACHED_FILES_MAX = 16;                     // Mesh cache files the repo thread keeps mapped
 
 const U32 LARGE_MESH_FETCH_THRESHOLD = 1U << 21;        // Size at which requests goes to narrow/slow queue
 const long SMALL_MESH_XFER_TIMEOUT = 120L;              // Seconds to complete xfer, small mesh downloads
@@ -567,6 +569,7 @@ volatile S32 LLMeshRepoThread::sActiveLODRequests = 0;
 U32 LLMeshRepoThread::sMaxConcurrentRequests = 1;
 S32 LLMeshRepoThread::sRequestLowWater = REQUEST2_LOW_WATER_MIN;
 S32 LLMeshRepoThread::sRequestHighWater = REQUEST2_HIGH_WATER_MIN;
+S32 LLMeshRepoThread::sHeaderHighWater = REQUEST2_HIGH_WATER_MIN;
 S32 LLMeshRepoThread::sRequestWaterLevel = 0;
 
 // Base handler class for all mesh users of llcorehttp.
@@ -888,6 +891,7 @@ LLMeshRepoThread::~LLMeshRepoThread()
 
     mHttpRequestSet.clear();
     mHttpHeaders.reset();
+    mCachedFiles.clear();
 
     while (!mSkinInfoQ.empty())
     {
@@ -1002,48 +1006,9 @@ void LLMeshRepoThread::run()
             }
         }
 
-        if (!mHeaderReqQ.empty() && mHttpRequestSet.size() < sRequestHighWater)
+        if (!mHeaderReqQ.empty() && mHttpRequestSet.size() < sHeaderHighWater)
         {
-            std::list<HeaderRequest> incomplete;
-            while (!mHeaderReqQ.empty() && mHttpRequestSet.size() < sRequestHighWater)
-            {
-                if (!mMutex)
-                {
-                    break;
-                }
-
-                mMutex->lock();
-                HeaderRequest req = mHeaderReqQ.front();
-                mHeaderReqQ.pop();
-                mMutex->unlock();
-                if (req.isDelayed())
-                {
-                    // failed to load before, wait a bit
-                    incomplete.push_front(req);
-                }
-                else if (!fetchMeshHeader(req.mMeshParams, req.canRetry()))
-                {
-                    if (req.canRetry())
-                    {
-                        //failed, resubmit
-                        req.updateTime();
-                        incomplete.push_front(req);
-                    }
-                    else
-                    {
-                        LL_DEBUGS() << "mHeaderReqQ failed: " << req.mMeshParams << LL_ENDL;
-                    }
-                }
-            }
-
-            if (!incomplete.empty())
-            {
-                LLMutexLock locker(mMutex);
-                for (std::list<HeaderRequest>::iterator iter = incomplete.begin(); iter != incomplete.end(); iter++)
-                {
-                    mHeaderReqQ.push(*iter);
-                }
-            }
+            fetchMeshHeaders();
         }
 
         // For the final three request lists, similar goal to above but
@@ -1424,7 +1389,7 @@ bool LLMeshRepoThread::fetchMeshSkinInfo(const LLUUID& mesh_id, bool can_retry)
         if (version <= MAX_MESH_VERSION && offset >= 0 && size > 0)
         {
             //check cache for mesh skin info
-            LLFileSystem file(mesh_id, LLAssetType::AT_MESH);
+            LLFileSystem& file = getCachedFile(mesh_id);
             if (file.getSize() >= offset + size)
             {
                 U8* buffer = new(std::nothrow) U8[size];
@@ -1554,7 +1519,7 @@ bool LLMeshRepoThread::fetchMeshDecomposition(const LLUUID& mesh_id)
         if (version <= MAX_MESH_VERSION && offset >= 0 && size > 0)
         {
             //check cache for mesh skin info
-            LLFileSystem file(mesh_id, LLAssetType::AT_MESH);
+            LLFileSystem& file = getCachedFile(mesh_id);
             if (file.getSize() >= offset+size)
             {
                 U8* buffer = new(std::nothrow) U8[size];
@@ -1668,7 +1633,7 @@ bool LLMeshRepoThread::fetchMeshPhysicsShape(const LLUUID& mesh_id)
         if (version <= MAX_MESH_VERSION && offset >= 0 && size > 0)
         {
             //check cache for mesh physics shape info
-            LLFileSystem file(mesh_id, LLAssetType::AT_MESH);
+            LLFileSystem& file = getCachedFile(mesh_id);
             if (file.getSize() >= offset+size)
             {
                 LLMeshRepository::sCacheBytesRead += size;
@@ -1781,44 +1746,153 @@ void LLMeshRepoThread::decActiveHeaderRequests()
     --LLMeshRepoThread::sActiveHeaderRequests;
 }
 
-//return false if failed to get header
-bool LLMeshRepoThread::fetchMeshHeader(const LLVolumeParams& mesh_params, bool can_retry)
+// Drain mHeaderReqQ in batches.  Each batch is taken off the queue
+// under a single lock rather than one lock per request.  Headers found
+// in the cache are processed right away, the others are requested in
+// queue order.
+//
+// Thread:  repo
+void LLMeshRepoThread::fetchMeshHeaders()
 {
-    ++LLMeshRepository::sMeshRequestCount;
-
+    std::list<HeaderRequest> incomplete;
+    while (mMutex && mHttpRequestSet.size() < sHeaderHighWater && !LLApp::isExiting())
     {
-        //look for mesh in asset in cache
-        LLFileSystem file(mesh_params.getSculptID(), LLAssetType::AT_MESH);
-
-        S32 size = file.getSize();
+        std::vector<HeaderRequest> batch;
+        {
+            LLMutexLock lock(mMutex);
+            if (mHeaderReqQ.empty())
+            {
+                break;
+            }
+            size_t budget = sHeaderHighWater - mHttpRequestSet.size();
+            batch.reserve(llmin(budget, mHeaderReqQ.size()));
+            while (!mHeaderReqQ.empty() && batch.size() < budget)
+            {
+                batch.push_back(mHeaderReqQ.front());
+                mHeaderReqQ.pop();
+            }
+        }
 
-        if (size > 0)
+        for (HeaderRequest& req : batch)
         {
-            // *NOTE:  if the header size is ever more than 4KB, this will break
-            U8 buffer[MESH_HEADER_SIZE];
-            S32 bytes = llmin(size, MESH_HEADER_SIZE);
-            LLMeshRepository::sCacheBytesRead += bytes;
-            ++LLMeshRepository::sCacheReads;
-            file.read(buffer, bytes);
-            if (headerReceived(mesh_params, buffer, bytes) == MESH_OK)
+            if (LLApp::isExiting())
             {
-                LL_DEBUGS(LOG_MESH) << "Mesh/Cache: Mesh header for ID " << mesh_params.getSculptID() << " - was retrieved from the cache." << LL_ENDL;
+                // shutting down, the rest of the batch no longer matters
+                return;
+            }
 
-                // Found mesh in cache
-                return true;
+            if (req.isDelayed())
+            {
+                // failed to load before, wait a bit
+                incomplete.push_front(req);
+                continue;
+            }
+
+            ++LLMeshRepository::sMeshRequestCount;
+            if (loadMeshHeaderFromCache(req.mMeshParams))
+            {
+                continue;
+            }
+
+            //either cache entry doesn't exist or is corrupt, request header from simulator
+            std::string http_url;
+            // <FS:Ansariel> [UDP Assets]
+            //constructUrl(req.mMeshParams.getSculptID(), &http_url);
+            int legacy_cap_version(0);
+            constructUrl(req.mMeshParams.getSculptID(), &http_url, &legacy_cap_version);
+            // </FS:Ansariel> [UDP Assets]
+            if (!requestMeshHeader(req.mMeshParams, http_url, legacy_cap_version, req.canRetry()))
+            {
+                if (req.canRetry())
+                {
+                    //failed, resubmit
+                    req.updateTime();
+                    incomplete.push_front(req);
+                }
+                else
+                {
+                    LL_DEBUGS() << "mHeaderReqQ failed: " << req.mMeshParams << LL_ENDL;
+                }
             }
         }
     }
 
-    //either cache entry doesn't exist or is corrupt, request header from simulator
-    bool retval = true;
-    std::string http_url;
-    // <FS:Ansariel> [UDP Assets]
-    //constructUrl(mesh_params.getSculptID(), &http_url);
-    int legacy_cap_version(0);
-    constructUrl(mesh_params.getSculptID(), &http_url, &legacy_cap_version);
-    // </FS:Ansariel> [UDP Assets]
+    if (!incomplete.empty() && mMutex)
+    {
+        LLMutexLock locker(mMutex);
+        for (std::list<HeaderRequest>::iterator iter = incomplete.begin(); iter != incomplete.end(); iter++)
+        {
+            mHeaderReqQ.push(*iter);
+        }
+    }
+}
+
+LLFileSystem& LLMeshRepoThread::getCachedFile(const LLUUID& mesh_id)
+{
+    for (cached_file_list_t::iterator iter = mCachedFiles.begin(); iter != mCachedFiles.end(); ++iter)
+    {
+        if (iter->first == mesh_id)
+        {
+            mCachedFiles.splice(mCachedFiles.begin(), mCachedFiles, iter);
+            return *mCachedFiles.front().second;
+        }
+    }
+
+    if (mCachedFiles.size() >= CACHED_FILES_MAX)
+    {
+        mCachedFiles.pop_back();
+    }
+    mCachedFiles.emplace_front(mesh_id, std::make_unique<LLFileSystem>(mesh_id, LLAssetType::AT_MESH, LLFileSystem::READ | LLFileSystem::MAPPED));
+    return *mCachedFiles.front().second;
+}
+
+void LLMeshRepoThread::forgetCachedFile(const LLUUID& mesh_id)
+{
+    // The mapping is a snapshot of the file, and Windows won't resize a
+    // mapped file, so drop it before the file is written
+    for (cached_file_list_t::iterator iter = mCachedFiles.begin(); iter != mCachedFiles.end(); ++iter)
+    {
+        if (iter->first == mesh_id)
+        {
+            mCachedFiles.erase(iter);
+            return;
+        }
+    }
+}
+
+//return true if the header was found in the cache and processed
+bool LLMeshRepoThread::loadMeshHeaderFromCache(const LLVolumeParams& mesh_params)
+{
+    //look for mesh in asset in cache
+    // Only the first 4KB are read, not worth mapping the file
+    LLFileSystem file(mesh_params.getSculptID(), LLAssetType::AT_MESH);
+
+    S32 size = file.getSize();
+
+    if (size > 0)
+    {
+        // *NOTE:  if the header size is ever more than 4KB, this will break
+        U8 buffer[MESH_HEADER_SIZE];
+        S32 bytes = llmin(size, MESH_HEADER_SIZE);
+        LLMeshRepository::sCacheBytesRead += bytes;
+        ++LLMeshRepository::sCacheReads;
+        file.read(buffer, bytes);
+        if (headerReceived(mesh_params, buffer, bytes) == MESH_OK)
+        {
+            LL_DEBUGS(LOG_MESH) << "Mesh/Cache: Mesh header for ID " << mesh_params.getSculptID() << " - was retrieved from the cache." << LL_ENDL;
+
+            // Found mesh in cache
+            return true;
+        }
+    }
+    return false;
+}
 
+//return false if failed to get header
+bool LLMeshRepoThread::requestMeshHeader(const LLVolumeParams& mesh_params, const std::string& http_url,
+                                         int legacy_cap_version, bool can_retry)
+{
+    bool retval = true;
 
     if (!http_url.empty())
     {
@@ -1884,7 +1958,7 @@ bool LLMeshRepoThread::fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod,
         {
 
             //check cache for mesh asset
-            LLFileSystem file(mesh_id, LLAssetType::AT_MESH);
+            LLFileSystem& file = getCachedFile(mesh_id);
             if (file.getSize() >= offset+size)
             {
                 U8* buffer = new(std::nothrow) U8[size];
@@ -3214,6 +3288,7 @@ void LLMeshHandlerBase::onCompleted(LLCore::HttpHandle handle, LLCore::HttpRespo
         LLCore::BufferArray * body(response->getBody());
         S32 body_offset(0);
         U8 * data(NULL);
+        bool data_allocated(false);
         auto data_size(body ? body->size() : 0);
 
         if (data_size > 0)
@@ -3266,27 +3341,39 @@ void LLMeshHandlerBase::onCompleted(LLCore::HttpHandle handle, LLCore::HttpRespo
                 goto common_exit;
             }
 
-            // *TODO: Try to get rid of data copying and add interfaces
-            // that support BufferArray directly.  Introduce a two-phase
-            // handler, optional first that takes a body, fallback second
-            // that requires a temporary allocation and data copy.
+            // Bodies sized from a Content-Length header arrive in one
+            // block and the handlers only read the data, so use it in
+            // place.  Otherwise fall back to a temporary allocation and
+            // data copy.
             body_offset = mOffset - offset;
-            data = new(std::nothrow) U8[data_size - body_offset];
-            if (data)
+            if (char * contiguous = body->contiguousData())
             {
-                body->read(body_offset, (char *) data, data_size - body_offset);
+                data = reinterpret_cast<U8 *>(contiguous) + body_offset;
                 LLMeshRepository::sBytesReceived += static_cast<U32>(data_size);
             }
             else
             {
-                LL_WARNS(LOG_MESH) << "Failed to allocate " << data_size - body_offset << " memory for mesh response" << LL_ENDL;
-                processFailure(LLCore::HttpStatus(LLCore::HttpStatus::LLCORE, LLCore::HE_BAD_ALLOC));
+                data = new(std::nothrow) U8[data_size - body_offset];
+                if (data)
+                {
+                    data_allocated = true;
+                    body->read(body_offset, (char *) data, data_size - body_offset);
+                    LLMeshRepository::sBytesReceived += static_cast<U32>(data_size);
+                }
+                else
+                {
+                    LL_WARNS(LOG_MESH) << "Failed to allocate " << data_size - body_offset << " memory for mesh response" << LL_ENDL;
+                    processFailure(LLCore::HttpStatus(LLCore::HttpStatus::LLCORE, LLCore::HE_BAD_ALLOC));
+                }
             }
         }
 
         processData(body, body_offset, data, static_cast<S32>(data_size) - body_offset);
 
-        delete [] data;
+        if (data_allocated)
+        {
+            delete [] data;
+        }
     }
 
     // Release handler
@@ -3397,6 +3484,7 @@ void LLMeshHeaderHandler::processData(LLCore::BufferArray * /* body */, S32 /* b
             // only allocate as much space in the cache as is needed for the local cache
             data_size = llmin(data_size, bytes);
 
+            gMeshRepo.mThread->forgetCachedFile(mesh_id);
             LLFileSystem file(mesh_id, LLAssetType::AT_MESH, LLFileSystem::READ_WRITE);
             if (file.getMaxSize() >= bytes)
             {
@@ -3468,6 +3556,7 @@ void LLMeshLODHandler::processData(LLCore::BufferArray * /* body */, S32 /* body
         if (result == MESH_OK)
         {
             // good fetch from sim, write to cache
+            gMeshRepo.mThread->forgetCachedFile(mMeshParams.getSculptID());
             LLFileSystem file(mMeshParams.getSculptID(), LLAssetType::AT_MESH, LLFileSystem::READ_WRITE);
 
             S32 offset = mOffset;
@@ -3531,6 +3620,7 @@ void LLMeshSkinInfoHandler::processData(LLCore::BufferArray * /* body */, S32 /*
         && gMeshRepo.mThread->skinInfoReceived(mMeshID, data, data_size))
     {
         // good fetch from sim, write to cache
+        gMeshRepo.mThread->forgetCachedFile(mMeshID);
         LLFileSystem file(mMeshID, LLAssetType::AT_MESH, LLFileSystem::READ_WRITE);
 
         S32 offset = mOffset;
@@ -3580,6 +3670,7 @@ void LLMeshDecompositionHandler::processData(LLCore::BufferArray * /* body */, S
         && gMeshRepo.mThread->decompositionReceived(mMeshID, data, data_size))
     {
         // good fetch from sim, write to cache
+        gMeshRepo.mThread->forgetCachedFile(mMeshID);
         LLFileSystem file(mMeshID, LLAssetType::AT_MESH, LLFileSystem::READ_WRITE);
 
         S32 offset = mOffset;
@@ -3627,6 +3718,7 @@ void LLMeshPhysicsShapeHandler::processData(LLCore::BufferArray * /* body */, S3
         && gMeshRepo.mThread->physicsShapeReceived(mMeshID, data, data_size) == MESH_OK)
     {
         // good fetch from sim, write to cache for caching
+        gMeshRepo.mThread->forgetCachedFile(mMeshID);
         LLFileSystem file(mMeshID, LLAssetType::AT_MESH, LLFileSystem::READ_WRITE);
 
         S32 offset = mOffset;
@@ -3904,6 +3996,7 @@ void LLMeshRepository::notifyLoadedMeshes()
         LLMeshRepoThread::sRequestLowWater = llclamp(LLMeshRepoThread::sRequestHighWater / 2,
                                                      REQUEST_LOW_WATER_MIN,
                                                      REQUEST_LOW_WATER_MAX);
+        LLMeshRepoThread::sHeaderHighWater = LLMeshRepoThread::sRequestHighWater;
     }
     else
     {
@@ -3934,6 +4027,13 @@ void LLMeshRepository::notifyLoadedMeshes()
         LLMeshRepoThread::sRequestLowWater = llclamp(LLMeshRepoThread::sRequestHighWater / 2,
                                                      REQUEST2_LOW_WATER_MIN,
                                                      REQUEST2_LOW_WATER_MAX);
+        // Header GETs are tiny.  When the class multiplexes over HTTP/2,
+        // let more of them share the open connections.
+        LLMeshRepoThread::sHeaderHighWater = (app_core_http.isMultiplexed(LLAppCoreHttp::AP_MESH2)
+                                              ? llclamp(2 * LLMeshRepoThread::sRequestHighWater,
+                                                        REQUEST2_HIGH_WATER_MIN,
+                                                        HEADER2_HIGH_WATER_MAX)
+                                              : LLMeshRepoThread::sRequestHighWater);
     }
     // </FS:Ansariel> [UDP Assets]
 
@@ -4100,7 +4200,10 @@ void LLMeshRepository::notifyLoadedMeshes()
             mUploadErrorQ.pop();
         }
 
-        S32 active_count = LLMeshRepoThread::sActiveHeaderRequests + LLMeshRepoThread::sActiveLODRequests;
+        // Header requests are weighted by how much cheaper they are
+        // allowed to be, see sHeaderHighWater
+        S32 active_count = LLMeshRepoThread::sActiveHeaderRequests * LLMeshRepoThread::sRequestHighWater / LLMeshRepoThread::sHeaderHighWater
+                           + LLMeshRepoThread::sActiveLODRequests;
         if (active_count < LLMeshRepoThread::sRequestLowWater)
         {
             S32 push_count = LLMeshRepoThread::sRequestHighWater - active_count;
@@ -27,6 +27,8 @@
 #ifndef LL_MESH_REPOSITORY_H
 #define LL_MESH_REPOSITORY_H
 
+#include <list>
+#include <memory>
 #include <unordered_map>
 #include "llassettype.h"
 #include "llmodel.h"
@@ -47,6 +49,7 @@
 #include "lluploadfloaterobservers.h"
 
 class LLVOVolume;
+class LLFileSystem;
 class LLMutex;
 class LLCondition;
 class LLMeshRepository;
@@ -270,6 +273,7 @@ public:
     static U32 sMaxConcurrentRequests;
     static S32 sRequestLowWater;
     static S32 sRequestHighWater;
+    static S32 sHeaderHighWater;            // Headers are small, allow more of them in flight
     static S32 sRequestWaterLevel;          // Stats-use only, may read outside of thread
 
     LLMutex*    mMutex;
@@ -409,7 +413,9 @@ public:
     void lockAndLoadMeshLOD(const LLVolumeParams& mesh_params, S32 lod);
     void loadMeshLOD(const LLVolumeParams& mesh_params, S32 lod);
 
-    bool fetchMeshHeader(const LLVolumeParams& mesh_params, bool can_retry = true);
+    void fetchMeshHeaders();
+    bool loadMeshHeaderFromCache(const LLVolumeParams& mesh_params);
+    bool requestMeshHeader(const LLVolumeParams& mesh_params, const std::string& http_url, int legacy_cap_version, bool can_retry);
     bool fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod, bool can_retry = true);
     EMeshProcessingResult headerReceived(const LLVolumeParams& mesh_params, U8* data, S32 data_size);
     EMeshProcessingResult lodReceived(const LLVolumeParams& mesh_params, S32 lod, U8* data, S32 data_size);
@@ -462,7 +468,22 @@ public:
     // <FS:Ansariel> DAE export
     LLUUID getCreatorFromHeader(const LLUUID& mesh_id);
 
+    // Close the cache file kept for a mesh, before writing to it.
+    //
+    // Threads:  Repo thread only
+    void forgetCachedFile(const LLUUID& mesh_id);
+
 private:
+    // The LOD, skin, decomposition and physics shape of a mesh are read
+    // from its cache file by separate fetches.  Keep the most recently
+    // read files open (mapped) so each one is only mapped once.
+    //
+    // Threads:  Repo thread only
+    LLFileSystem& getCachedFile(const LLUUID& mesh_id);
+
+    typedef std::list<std::pair<LLUUID, std::unique_ptr<LLFileSystem>>> cached_file_list_t;
+    cached_file_list_t mCachedFiles;    // most recently used first
+
     // Issue a GET request to a URL with 'Range' header using
     // the correct policy class and other attributes.  If an invalid
     // handle is returned, the request failed and caller must retry
@@ -914,6 +914,11 @@ bool idle_startup()
                 msg->mPacketRing.setUseOutThrottle(true);
                 msg->mPacketRing.setOutBandwidth(outBandwidth);
             }
+
+            if (gSavedSettings.getBOOL("FSMessageReceiveThread"))
+            {
+                msg->mPacketRing.startReceiveThread(msg->mSocket);
+            }
         }
 
         LL_INFOS("AppInit") << "Message System Initialized." << LL_ENDL;
@@ -55,6 +55,9 @@
 #include "lldrawpoolterrain.h"
 #include "lldrawable.h"
 #include "llworldmipmap.h"
+#include "workexecutor.h"
+
+#include <unordered_set>
 
 extern LLPipeline gPipeline;
 extern bool gShiftFrame;
@@ -794,14 +797,38 @@ bool LLSurface::idleUpdate(F32 max_update_time)
     }
 
     // Always call updateNormals() / updateVerticalStats()
-    //  every frame to avoid artifacts
+    //  every frame to avoid artifacts.
+    // Edge normals read and patch up neighbors so go one patch at a time,
+    // the middles and the height stats only touch their own patch so are
+    // spread across threads.
+    if (!mDirtyPatchList.empty())
+    {
+        LL_PROFILE_ZONE_NAMED("surface normals");
+        std::vector<std::pair<LLSurfacePatch *, bool>> dirty_patches;
+        dirty_patches.reserve(mDirtyPatchList.size());
+        for (LLSurfacePatch *patchp : mDirtyPatchList)
+        {
+            dirty_patches.emplace_back(patchp, patchp->updateEdgeNormals<PBR>());
+        }
+
+        LL::WorkExecutor::getShared().forEach(dirty_patches.size(),
+            [&dirty_patches](size_t i)
+            {
+                const std::pair<LLSurfacePatch *, bool> &dirty = dirty_patches[i];
+                if (dirty.second)
+                {
+                    dirty.first->updateMiddleNormals<PBR>();
+                }
+                dirty.first->calcVerticalStats();
+            });
+    }
+
     for(std::set<LLSurfacePatch *>::iterator iter = mDirtyPatchList.begin();
         iter != mDirtyPatchList.end(); )
     {
         std::set<LLSurfacePatch *>::iterator curiter = iter++;
         LLSurfacePatch *patchp = *curiter;
-        patchp->updateNormals<PBR>();
-        patchp->updateVerticalStats();
+        patchp->applyVerticalStats();
         if (max_update_time == 0.f || update_timer.getElapsedTimeF32() < max_update_time)
         {
             if (patchp->updateTexture())
@@ -823,12 +850,17 @@ template bool LLSurface::idleUpdate</*PBR=*/false>(F32 max_update_time);
 template bool LLSurface::idleUpdate</*PBR=*/true>(F32 max_update_time);
 
 void LLSurface::decompressDCTPatch(LLBitPack &bitpack, LLGroupHeader *gopp, bool b_large_patch)
+{
+    std::vector<DecodedPatch> patches;
+    decodeDCTPatches(bitpack, gopp, b_large_patch, patches);
+    decompressDCTPatches(patches);
+}
+
+void LLSurface::decodeDCTPatches(LLBitPack &bitpack, LLGroupHeader *gopp, bool b_large_patch, std::vector<DecodedPatch> &patches)
 {
 
     LLPatchHeader  ph;
     S32 j, i;
-    S32 patch[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
-    LLSurfacePatch *patchp;
 
     init_patch_decompressor(gopp->patch_size);
     gopp->stride = mGridsPerEdge;
@@ -874,11 +906,51 @@ void LLSurface::decompressDCTPatch(LLBitPack &bitpack, LLGroupHeader *gopp, bool
             return;
         }
 
-        patchp = &mPatchList[j*mPatchesPerEdge + i];
+        patches.emplace_back();
+        DecodedPatch &decoded = patches.back();
+        decoded.mPatchp = &mPatchList[j*mPatchesPerEdge + i];
+        decoded.mHeader = ph;
+        decoded.mSize = gopp->patch_size;
+        decoded.mStride = gopp->stride;
+
+        decode_patch(bitpack, decoded.mCoefficients);
+    }
+}
+
+// static
+void LLSurface::decompressDCTPatches(std::vector<DecodedPatch> &patches)
+{
+    LL_PROFILE_ZONE_SCOPED;
+
+    // Only the last copy of a patch sent more than once counts, and two
+    // threads mustn't write the same heights.
+    std::unordered_set<LLSurfacePatch *> seen;
+    for (auto iter = patches.rbegin(); iter != patches.rend(); ++iter)
+    {
+        if (!seen.insert(iter->mPatchp).second)
+        {
+            iter->mPatchp = NULL;
+        }
+    }
 
+    // Each patch writes only its own heights, not the shared edge buffers
+    LL::WorkExecutor::getShared().forEach(patches.size(),
+        [&patches](size_t i)
+        {
+            DecodedPatch &decoded = patches[i];
+            if (decoded.mPatchp)
+            {
+                decompress_patch(decoded.mPatchp->getDataZ(), decoded.mCoefficients, &decoded.mHeader, decoded.mSize, decoded.mStride);
+            }
+        });
 
-        decode_patch(bitpack, patch);
-        decompress_patch(patchp->getDataZ(), patch, &ph);
+    for (DecodedPatch &decoded : patches)
+    {
+        LLSurfacePatch *patchp = decoded.mPatchp;
+        if (!patchp)
+        {
+            continue;
+        }
 
         // Update edges for neighbors.  Need to guarantee that this gets done before we generate vertical stats.
         patchp->updateNorthEdge();
@@ -901,6 +973,7 @@ void LLSurface::decompressDCTPatch(LLBitPack &bitpack, LLGroupHeader *gopp, bool
         patchp->dirtyZ();
         patchp->setHasReceivedData();
     }
+    patches.clear();
 }
 
 
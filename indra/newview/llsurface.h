@@ -41,6 +41,7 @@
 #include "llvowater.h"
 #include "llpatchvertexarray.h"
 #include "llviewertexture.h"
+#include "patch_dct.h"
 
 class LLTimer;
 class LLUUID;
@@ -66,6 +67,17 @@ class LLGroupHeader;
 class LLSurface
 {
 public:
+    // A land patch unpacked from a layer packet, waiting on its inverse DCT
+    class DecodedPatch
+    {
+    public:
+        LLSurfacePatch *mPatchp;
+        LLPatchHeader   mHeader;
+        S32             mSize;
+        S32             mStride;
+        S32             mCoefficients[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
+    };
+
     LLSurface(U32 type, LLViewerRegion *regionp = NULL);
     virtual ~LLSurface();
 
@@ -88,6 +100,13 @@ public:
     void rebuildWater();
 // </FS:CR> Aurora Sim
     virtual void decompressDCTPatch(LLBitPack &bitpack, LLGroupHeader *gopp, bool b_large_patch);
+    // Unpack the patches of one land layer packet onto patches, leaving the
+    // inverse DCT to decompressDCTPatches() so that it can be done for every
+    // packet of a frame at once.
+    void decodeDCTPatches(LLBitPack &bitpack, LLGroupHeader *gopp, bool b_large_patch, std::vector<DecodedPatch> &patches);
+    // Inverse DCT of decoded patches, spread across threads, then edge
+    // and dirty updates in packet order on this thread.  Empties patches.
+    static void decompressDCTPatches(std::vector<DecodedPatch> &patches);
     virtual void updatePatchVisibilities(LLAgent &agent);
 
     inline F32 getZ(const U32 k) const              { return mSurfaceZ[k]; }
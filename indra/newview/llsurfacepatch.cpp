@@ -610,6 +610,12 @@ F32 LLSurfacePatch::getDistance() const
 // Called when a patch has changed its height field
 // data.
 void LLSurfacePatch::updateVerticalStats()
+{
+    calcVerticalStats();
+    applyVerticalStats();
+}
+
+void LLSurfacePatch::calcVerticalStats()
 {
     if (!mDirtyZStats)
     {
@@ -658,6 +664,14 @@ void LLSurfacePatch::updateVerticalStats()
                         meters_per_grid*grids_per_patch_edge,
                         mMaxZ - mMinZ);
     mRadius = diam_vec.magVec() * 0.5f;
+}
+
+void LLSurfacePatch::applyVerticalStats()
+{
+    if (!mDirtyZStats)
+    {
+        return;
+    }
 
     mSurfacep->mMaxZ = llmax(mMaxZ, mSurfacep->mMaxZ);
     mSurfacep->mMinZ = llmin(mMinZ, mSurfacep->mMinZ);
@@ -674,10 +688,22 @@ void LLSurfacePatch::updateVerticalStats()
 
 template<bool PBR>
 void LLSurfacePatch::updateNormals()
+{
+    if (updateEdgeNormals<PBR>())
+    {
+        updateMiddleNormals<PBR>();
+    }
+}
+
+template void LLSurfacePatch::updateNormals</*PBR=*/false>();
+template void LLSurfacePatch::updateNormals</*PBR=*/true>();
+
+template<bool PBR>
+bool LLSurfacePatch::updateEdgeNormals()
 {
     if (mSurfacep->mType == 'w')
     {
-        return;
+        return false;
     }
     U32 grids_per_patch_edge = mSurfacep->getGridsPerPatchEdge();
     U32 grids_per_edge = mSurfacep->getGridsPerEdge();
@@ -867,16 +893,10 @@ void LLSurfacePatch::updateNormals()
         dirty_patch = true;
     }
 
-    // update the middle normals
-    if (mNormalsInvalid[MIDDLE])
+    // the middle normals are left to updateMiddleNormals()
+    const bool middle_invalid = mNormalsInvalid[MIDDLE];
+    if (middle_invalid)
     {
-        for (j=2; j < grids_per_patch_edge - 2; j++)
-        {
-            for (i=2; i < grids_per_patch_edge - 2; i++)
-            {
-                calcNormal<PBR>(i, j, 2);
-            }
-        }
         dirty_patch = true;
     }
 
@@ -889,10 +909,32 @@ void LLSurfacePatch::updateNormals()
     {
         mNormalsInvalid[i] = false;
     }
+
+    return middle_invalid;
 }
 
-template void LLSurfacePatch::updateNormals</*PBR=*/false>();
-template void LLSurfacePatch::updateNormals</*PBR=*/true>();
+template bool LLSurfacePatch::updateEdgeNormals</*PBR=*/false>();
+template bool LLSurfacePatch::updateEdgeNormals</*PBR=*/true>();
+
+// Only reads heights inside this patch, never the edge buffers that
+// updateEdgeNormals() patches up, and only writes normals in its middle.
+template<bool PBR>
+void LLSurfacePatch::updateMiddleNormals()
+{
+    U32 grids_per_patch_edge = mSurfacep->getGridsPerPatchEdge();
+
+    U32 i, j;
+    for (j=2; j < grids_per_patch_edge - 2; j++)
+    {
+        for (i=2; i < grids_per_patch_edge - 2; i++)
+        {
+            calcNormal<PBR>(i, j, 2);
+        }
+    }
+}
+
+template void LLSurfacePatch::updateMiddleNormals</*PBR=*/false>();
+template void LLSurfacePatch::updateMiddleNormals</*PBR=*/true>();
 
 void LLSurfacePatch::updateEastEdge()
 {
@@ -75,10 +75,24 @@ public:
 
     bool updateTexture();
 
+    // Height stats after the height field changed, in two halves:
+    // calcVerticalStats() only touches this patch and is safe to run for
+    // several patches at once, applyVerticalStats() folds them into the
+    // surface and region and dirties the drawable.
     void updateVerticalStats();
+    void calcVerticalStats();
+    void applyVerticalStats();
     void updateCompositionStats();
     template<bool PBR>
     void updateNormals();
+    // updateNormals() in two halves.  The edges and corners read and patch
+    // up neighbors, so are done one patch at a time; returns true if the
+    // middle is out of date too.  The middle only reads and writes this
+    // patch, so middles of different patches can be done at once.
+    template<bool PBR>
+    bool updateEdgeNormals();
+    template<bool PBR>
+    void updateMiddleNormals();
 
     void updateEastEdge();
     void updateNorthEdge();
@@ -195,6 +209,10 @@ protected:
 
 extern template void LLSurfacePatch::updateNormals</*PBR=*/false>();
 extern template void LLSurfacePatch::updateNormals</*PBR=*/true>();
+extern template bool LLSurfacePatch::updateEdgeNormals</*PBR=*/false>();
+extern template bool LLSurfacePatch::updateEdgeNormals</*PBR=*/true>();
+extern template void LLSurfacePatch::updateMiddleNormals</*PBR=*/false>();
+extern template void LLSurfacePatch::updateMiddleNormals</*PBR=*/true>();
 
 
 #endif // LL_LLSURFACEPATCH_H
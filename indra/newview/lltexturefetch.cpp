@@ -1829,7 +1829,27 @@ bool LLTextureFetchWorker::doWork(S32 param)
                 mRequestedOffset += src_offset;
             }
 
-            U8 * buffer = (U8 *)ll_aligned_malloc_16(total_size);
+            // A fresh fetch whose body arrived in one block can hand
+            // that block straight to the formatted image.
+            U8 * buffer(NULL);
+            bool buffer_filled(false);
+            if (0 == cur_size && 0 == src_offset && mHttpBufferArray->isLastRef())
+            {
+                size_t detached_size(0);
+                buffer = (U8 *)mHttpBufferArray->detachContiguousData(&detached_size);
+                if (buffer && detached_size != (size_t)total_size)
+                {
+                    // Shouldn't happen, put it back the slow way
+                    mHttpBufferArray->append(buffer, detached_size);
+                    ll_aligned_free_16(buffer);
+                    buffer = NULL;
+                }
+                buffer_filled = (buffer != NULL);
+            }
+            if (!buffer)
+            {
+                buffer = (U8 *)ll_aligned_malloc_16(total_size);
+            }
             if (!buffer)
             {
                 // abort. If we have no space for packet, we have not enough space to decode image
@@ -1866,7 +1886,10 @@ bool LLTextureFetchWorker::doWork(S32 param)
                 // Copy previously collected data into buffer
                 memcpy(buffer, mFormattedImage->getData(), cur_size);
             }
-            mHttpBufferArray->read(src_offset, (char *) buffer + cur_size, append_size);
+            if (!buffer_filled)
+            {
+                mHttpBufferArray->read(src_offset, (char *) buffer + cur_size, append_size);
+            }
 
             // NOTE: setData releases current data and owns new data (buffer)
             mFormattedImage->setData(buffer, total_size);
@@ -2412,9 +2435,8 @@ S32 LLTextureFetchWorker::callbackHttpGet(LLCore::HttpResponse * response,
         LL_DEBUGS(LOG_TXT) << "HTTP RECEIVED: " << mID.asString() << " Bytes: " << data_size << LL_ENDL;
         if (data_size > 0)
         {
-            // *TODO: set the formatted image data here directly to avoid the copy
-
-            // Hold on to body for later copy
+            // Hold on to body, doWork() takes its data over when it
+            // arrived in one block and copies it otherwise
             llassert_always(NULL == mHttpBufferArray);
             body->addRef();
             mHttpBufferArray = body;
@@ -2482,8 +2504,6 @@ S32 LLTextureFetchWorker::callbackHttpGet(LLCore::HttpResponse * response,
         {
             LLViewerStatsRecorder::instance().textureFetch();
         }
-
-        // *TODO: set the formatted image data here directly to avoid the copy
     }
     else
     {
@@ -158,6 +158,76 @@ const S32 MAX_OBJECT_BINARY_DATA_SIZE = 60 + 16;
 const F64 INVENTORY_UPDATE_WAIT_TIME_DESYNC = 5; // seconds
 const F64 INVENTORY_UPDATE_WAIT_TIME_OUTDATED = 1;
 
+namespace
+{
+    // Message fields processUpdateMessage() reads.  It is called once per
+    // object block, so the fields are kept between calls: they get resolved
+    // for the first object of a message and read without name lookups for
+    // the rest.  Main thread only.
+    struct UpdateMessageFields
+    {
+        LLMessageField mRegionHandle;
+        LLMessageField mTimeDilation;
+        LLMessageField mCRC;
+        LLMessageField mParentID;
+        LLMessageField mSound;
+        LLMessageField mOwnerID;
+        LLMessageField mGain;
+        LLMessageField mRadius;
+        LLMessageField mFlags;
+        LLMessageField mMaterial;
+        LLMessageField mClickAction;
+        LLMessageField mScale;
+        LLMessageField mObjectData;
+        LLMessageField mUpdateFlags;
+        LLMessageField mState;
+        LLMessageField mNameValue;
+        LLMessageField mData;
+        LLMessageField mText;
+        LLMessageField mTextColor;
+        LLMessageField mMediaURL;
+        LLMessageField mExtraParams;
+
+        void resolveRegion(LLMessageSystem* msg)
+        {
+            msg->getFieldFast(mRegionHandle, _PREHASH_RegionData, _PREHASH_RegionHandle);
+            msg->getFieldFast(mTimeDilation, _PREHASH_RegionData, _PREHASH_TimeDilation);
+        }
+
+        // ObjectUpdate
+        void resolveFull(LLMessageSystem* msg)
+        {
+            msg->getFieldFast(mCRC, _PREHASH_ObjectData, _PREHASH_CRC);
+            msg->getFieldFast(mParentID, _PREHASH_ObjectData, _PREHASH_ParentID);
+            msg->getFieldFast(mSound, _PREHASH_ObjectData, _PREHASH_Sound);
+            msg->getFieldFast(mOwnerID, _PREHASH_ObjectData, _PREHASH_OwnerID);
+            msg->getFieldFast(mGain, _PREHASH_ObjectData, _PREHASH_Gain);
+            msg->getFieldFast(mRadius, _PREHASH_ObjectData, _PREHASH_Radius);
+            msg->getFieldFast(mFlags, _PREHASH_ObjectData, _PREHASH_Flags);
+            msg->getFieldFast(mMaterial, _PREHASH_ObjectData, _PREHASH_Material);
+            msg->getFieldFast(mClickAction, _PREHASH_ObjectData, _PREHASH_ClickAction);
+            msg->getFieldFast(mScale, _PREHASH_ObjectData, _PREHASH_Scale);
+            msg->getFieldFast(mObjectData, _PREHASH_ObjectData, _PREHASH_ObjectData);
+            msg->getFieldFast(mUpdateFlags, _PREHASH_ObjectData, _PREHASH_UpdateFlags);
+            msg->getFieldFast(mState, _PREHASH_ObjectData, _PREHASH_State);
+            msg->getFieldFast(mNameValue, _PREHASH_ObjectData, _PREHASH_NameValue);
+            msg->getFieldFast(mData, _PREHASH_ObjectData, _PREHASH_Data);
+            msg->getFieldFast(mText, _PREHASH_ObjectData, _PREHASH_Text);
+            msg->getFieldFast(mTextColor, _PREHASH_ObjectData, _PREHASH_TextColor);
+            msg->getFieldFast(mMediaURL, _PREHASH_ObjectData, _PREHASH_MediaURL);
+            msg->getFieldFast(mExtraParams, _PREHASH_ObjectData, _PREHASH_ExtraParams);
+        }
+
+        // ImprovedTerseObjectUpdate
+        void resolveTerse(LLMessageSystem* msg)
+        {
+            msg->getFieldFast(mObjectData, _PREHASH_ObjectData, _PREHASH_ObjectData);
+            msg->getFieldFast(mState, _PREHASH_ObjectData, _PREHASH_State);
+        }
+    };
+    UpdateMessageFields sUpdateMessageFields;
+}
+
 // static
 LLViewerObject *LLViewerObject::createObject(const LLUUID &id, const LLPCode pcode, LLViewerRegion *regionp, S32 flags)
 {
@@ -1246,7 +1316,8 @@ U32 LLViewerObject::processUpdateMessage(LLMessageSystem *mesgsys,
 
     if(mesgsys != NULL)
     {
-        mesgsys->getU64Fast(_PREHASH_RegionData, _PREHASH_RegionHandle, region_handle);
+        sUpdateMessageFields.resolveRegion(mesgsys);
+        mesgsys->getU64(sUpdateMessageFields.mRegionHandle, region_handle);
         LLViewerRegion* regionp = LLWorld::getInstance()->getRegionFromHandle(region_handle);
         if(regionp != mRegionp && regionp && mRegionp)//region cross
         {
@@ -1287,7 +1358,7 @@ U32 LLViewerObject::processUpdateMessage(LLMessageSystem *mesgsys,
     if(mesgsys != NULL)
     {
         U16 time_dilation16;
-        mesgsys->getU16Fast(_PREHASH_RegionData, _PREHASH_TimeDilation, time_dilation16);
+        mesgsys->getU16(sUpdateMessageFields.mTimeDilation, time_dilation16);
         time_dilation = ((F32) time_dilation16) / 65535.f;
         mRegionp->setTimeDilation(time_dilation);
     }
@@ -1358,20 +1429,23 @@ U32 LLViewerObject::processUpdateMessage(LLMessageSystem *mesgsys,
                 F32    cutoff;
                 U8     sound_flags;
 
-                mesgsys->getU32Fast( _PREHASH_ObjectData, _PREHASH_CRC, crc, block_num);
-                mesgsys->getU32Fast( _PREHASH_ObjectData, _PREHASH_ParentID, parent_id, block_num);
-                mesgsys->getUUIDFast(_PREHASH_ObjectData, _PREHASH_Sound, audio_uuid, block_num );
+                UpdateMessageFields& fields = sUpdateMessageFields;
+                fields.resolveFull(mesgsys);
+
+                mesgsys->getU32(    fields.mCRC, crc, block_num);
+                mesgsys->getU32(    fields.mParentID, parent_id, block_num);
+                mesgsys->getUUID(   fields.mSound, audio_uuid, block_num );
                 // HACK: Owner id only valid if non-null sound id or particle system
-                mesgsys->getUUIDFast(_PREHASH_ObjectData, _PREHASH_OwnerID, owner_id, block_num );
-                mesgsys->getF32Fast( _PREHASH_ObjectData, _PREHASH_Gain, gain, block_num );
-                mesgsys->getF32Fast(  _PREHASH_ObjectData, _PREHASH_Radius, cutoff, block_num );
-                mesgsys->getU8Fast(  _PREHASH_ObjectData, _PREHASH_Flags, sound_flags, block_num );
-                mesgsys->getU8Fast(  _PREHASH_ObjectData, _PREHASH_Material, material, block_num );
-                mesgsys->getU8Fast(  _PREHASH_ObjectData, _PREHASH_ClickAction, click_action, block_num);
-                mesgsys->getVector3Fast(_PREHASH_ObjectData, _PREHASH_Scale, new_scale, block_num );
-                length = mesgsys->getSizeFast(_PREHASH_ObjectData, block_num, _PREHASH_ObjectData);
-                mesgsys->getBinaryDataFast(_PREHASH_ObjectData, _PREHASH_ObjectData, data, length, block_num, MAX_OBJECT_BINARY_DATA_SIZE);
-                length = llmin(length, MAX_OBJECT_BINARY_DATA_SIZE);  // getBinaryDataFast() safely fills the buffer to max_size
+                mesgsys->getUUID(   fields.mOwnerID, owner_id, block_num );
+                mesgsys->getF32(    fields.mGain, gain, block_num );
+                mesgsys->getF32(    fields.mRadius, cutoff, block_num );
+                mesgsys->getU8(     fields.mFlags, sound_flags, block_num );
+                mesgsys->getU8(     fields.mMaterial, material, block_num );
+                mesgsys->getU8(     fields.mClickAction, click_action, block_num);
+                mesgsys->getVector3(fields.mScale, new_scale, block_num );
+                length = mesgsys->getSize(fields.mObjectData, block_num);
+                mesgsys->getBinaryData(fields.mObjectData, data, length, block_num, MAX_OBJECT_BINARY_DATA_SIZE);
+                length = llmin(length, MAX_OBJECT_BINARY_DATA_SIZE);  // getBinaryData() safely fills the buffer to max_size
 
                 mTotalCRC = crc;
                 // Might need to update mSourceMuted here to properly pick up new radius
@@ -1454,24 +1528,24 @@ U32 LLViewerObject::processUpdateMessage(LLMessageSystem *mesgsys,
                 //
 
                 U32 flags;
-                mesgsys->getU32Fast(_PREHASH_ObjectData, _PREHASH_UpdateFlags, flags, block_num);
+                mesgsys->getU32(fields.mUpdateFlags, flags, block_num);
                 // clear all but local flags
                 mFlags &= FLAGS_LOCAL;
                 mFlags |= flags;
 
                 U8 state;
-                mesgsys->getU8Fast(_PREHASH_ObjectData, _PREHASH_State, state, block_num );
+                mesgsys->getU8(fields.mState, state, block_num );
                 mAttachmentState = state;
 
                 // ...new objects that should come in selected need to be added to the selected list
                 mCreateSelected = ((flags & FLAGS_CREATE_SELECTED) != 0);
 
                 // Set all name value pairs
-                S32 nv_size = mesgsys->getSizeFast(_PREHASH_ObjectData, block_num, _PREHASH_NameValue);
+                S32 nv_size = mesgsys->getSize(fields.mNameValue, block_num);
                 if (nv_size > 0)
                 {
                     std::string name_value_list;
-                    mesgsys->getStringFast(_PREHASH_ObjectData, _PREHASH_NameValue, name_value_list, block_num);
+                    mesgsys->getString(fields.mNameValue, name_value_list, block_num);
                     setNameValueList(name_value_list);
                 }
 
@@ -1493,20 +1567,20 @@ U32 LLViewerObject::processUpdateMessage(LLMessageSystem *mesgsys,
 
                 // Check for appended generic data
                 const S32 GENERIC_DATA_BUFFER_SIZE = 16;
-                S32 data_size = mesgsys->getSizeFast(_PREHASH_ObjectData, block_num, _PREHASH_Data);
+                S32 data_size = mesgsys->getSize(fields.mData, block_num);
                 if (data_size > 0)
                 {    // has generic data
                     if (getPCode() == LL_PCODE_LEGACY_TREE || getPCode() == LL_PCODE_TREE_NEW)
                     {
                         mData = new U8[data_size];
-                        mesgsys->getBinaryDataFast(_PREHASH_ObjectData, _PREHASH_Data, mData, data_size, block_num);
+                        mesgsys->getBinaryData(fields.mData, mData, data_size, block_num);
                         LL_DEBUGS("NewObjectData") << "Read " << data_size << " bytes tree genome data for " << getID() << ", pcode "
                                              << getPCodeString() << ", value " << (S32) mData[0] << LL_ENDL;
                     }
                     else
                     {   // Extract number of prims
                         U8 generic_data[GENERIC_DATA_BUFFER_SIZE];
-                        mesgsys->getBinaryDataFast(_PREHASH_ObjectData, _PREHASH_Data,
+                        mesgsys->getBinaryData(fields.mData,
                             &generic_data[0], llmin(data_size, GENERIC_DATA_BUFFER_SIZE), block_num);
                         // This is sample code to extract the number of prims
                         //    Future viewers should use it for their own purposes
@@ -1519,7 +1593,7 @@ U32 LLViewerObject::processUpdateMessage(LLMessageSystem *mesgsys,
                     }
                 }
 
-                S32 text_size = mesgsys->getSizeFast(_PREHASH_ObjectData, block_num, _PREHASH_Text);
+                S32 text_size = mesgsys->getSize(fields.mText, block_num);
                 if (text_size > 1)
                 {
                     // Setup object text
@@ -1529,10 +1603,10 @@ U32 LLViewerObject::processUpdateMessage(LLMessageSystem *mesgsys,
                     }
 
                     std::string temp_string;
-                    mesgsys->getStringFast(_PREHASH_ObjectData, _PREHASH_Text, temp_string, block_num );
+                    mesgsys->getString(fields.mText, temp_string, block_num );
 
                     LLColor4U coloru;
-                    mesgsys->getBinaryDataFast(_PREHASH_ObjectData, _PREHASH_TextColor, coloru.mV, 4, block_num);
+                    mesgsys->getBinaryData(fields.mTextColor, coloru.mV, 4, block_num);
 
                     // alpha was flipped so that it zero encoded better
                     coloru.mV[3] = 255 - coloru.mV[3];
@@ -1562,7 +1636,7 @@ U32 LLViewerObject::processUpdateMessage(LLMessageSystem *mesgsys,
                 }
 
                 std::string media_url;
-                mesgsys->getStringFast(_PREHASH_ObjectData, _PREHASH_MediaURL, media_url, block_num);
+                mesgsys->getString(fields.mMediaURL, media_url, block_num);
                 retval |= checkMediaURL(media_url);
 
                 //
@@ -1578,7 +1652,7 @@ U32 LLViewerObject::processUpdateMessage(LLMessageSystem *mesgsys,
                 }
 
                 // Unpack extra parameters
-                S32 size = mesgsys->getSizeFast(_PREHASH_ObjectData, block_num, _PREHASH_ExtraParams);
+                S32 size = mesgsys->getSize(fields.mExtraParams, block_num);
                 if (size > 0)
                 {
                     U8 *buffer = new(std::nothrow) U8[size];
@@ -1587,7 +1661,7 @@ U32 LLViewerObject::processUpdateMessage(LLMessageSystem *mesgsys,
                         LLError::LLUserWarningMsg::showOutOfMemory();
                         LL_ERRS() << "Bad memory allocation for buffer, size: " << size << LL_ENDL;
                     }
-                    mesgsys->getBinaryDataFast(_PREHASH_ObjectData, _PREHASH_ExtraParams, buffer, size, block_num);
+                    mesgsys->getBinaryData(fields.mExtraParams, buffer, size, block_num);
                     LLDataPackerBinaryBuffer dp(buffer, size);
 
                     U8 num_parameters;
@@ -1623,9 +1697,12 @@ U32 LLViewerObject::processUpdateMessage(LLMessageSystem *mesgsys,
 #ifdef DEBUG_UPDATE_TYPE
                 LL_INFOS() << "TI:" << getID() << LL_ENDL;
 #endif
-                length = mesgsys->getSizeFast(_PREHASH_ObjectData, block_num, _PREHASH_ObjectData);
-                mesgsys->getBinaryDataFast(_PREHASH_ObjectData, _PREHASH_ObjectData, data, length, block_num, MAX_OBJECT_BINARY_DATA_SIZE);
-                length = llmin(length, MAX_OBJECT_BINARY_DATA_SIZE);    // getBinaryDataFast() safely fills the buffer to max_size
+                UpdateMessageFields& fields = sUpdateMessageFields;
+                fields.resolveTerse(mesgsys);
+
+                length = mesgsys->getSize(fields.mObjectData, block_num);
+                mesgsys->getBinaryData(fields.mObjectData, data, length, block_num, MAX_OBJECT_BINARY_DATA_SIZE);
+                length = llmin(length, MAX_OBJECT_BINARY_DATA_SIZE);    // getBinaryData() safely fills the buffer to max_size
                 count  = 0;
                 LLVector4 collision_plane;
 
@@ -1711,7 +1788,7 @@ U32 LLViewerObject::processUpdateMessage(LLMessageSystem *mesgsys,
                 }
 
                 U8 state;
-                mesgsys->getU8Fast(_PREHASH_ObjectData, _PREHASH_State, state, block_num );
+                mesgsys->getU8(fields.mState, state, block_num );
                 mAttachmentState = state;
                 break;
             }
@@ -1977,7 +2054,8 @@ U32 LLViewerObject::processUpdateMessage(LLMessageSystem *mesgsys,
                 if(mesgsys != NULL)
                 {
                 U32 flags;
-                mesgsys->getU32Fast(_PREHASH_ObjectData, _PREHASH_UpdateFlags, flags, block_num);
+                mesgsys->getFieldFast(sUpdateMessageFields.mUpdateFlags, _PREHASH_ObjectData, _PREHASH_UpdateFlags);
+                mesgsys->getU32(sUpdateMessageFields.mUpdateFlags, flags, block_num);
                 loadFlags(flags);
                 }
             }
@@ -512,6 +512,30 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
     LLDataPackerBinaryBuffer compressed_dp(compressed_dpbuffer, 2048);
     LLViewerStatsRecorder& recorder = LLViewerStatsRecorder::instance();
 
+    // Resolve the per-object fields once for the whole message
+    LLMessageField data_field;
+    LLMessageField update_flags_field;
+    LLMessageField id_field;
+    LLMessageField full_id_field;
+    LLMessageField pcode_field;
+    if (compressed)
+    {
+        data_field = mesgsys->getFieldFast(_PREHASH_ObjectData, _PREHASH_Data);
+        if (update_type != OUT_TERSE_IMPROVED)
+        {
+            update_flags_field = mesgsys->getFieldFast(_PREHASH_ObjectData, _PREHASH_UpdateFlags);
+        }
+    }
+    else
+    {
+        id_field = mesgsys->getFieldFast(_PREHASH_ObjectData, _PREHASH_ID);
+        if (update_type == OUT_FULL)
+        {
+            full_id_field = mesgsys->getFieldFast(_PREHASH_ObjectData, _PREHASH_FullID);
+            pcode_field = mesgsys->getFieldFast(_PREHASH_ObjectData, _PREHASH_PCode);
+        }
+    }
+
     for (i = 0; i < num_objects; i++)
     {
         bool justCreated = false;
@@ -521,15 +545,15 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
         {
             compressed_dp.reset();
 
-            S32 uncompressed_length = mesgsys->getSizeFast(_PREHASH_ObjectData, i, _PREHASH_Data);
+            S32 uncompressed_length = mesgsys->getSize(data_field, i);
             LL_DEBUGS("ObjectUpdate") << "got binary data from message to compressed_dpbuffer" << LL_ENDL;
-            mesgsys->getBinaryDataFast(_PREHASH_ObjectData, _PREHASH_Data, compressed_dpbuffer, 0, i, 2048);
+            mesgsys->getBinaryData(data_field, compressed_dpbuffer, 0, i, 2048);
             compressed_dp.assignBuffer(compressed_dpbuffer, uncompressed_length);
 
             if (update_type != OUT_TERSE_IMPROVED) // OUT_FULL_COMPRESSED only?
             {
                 U32 flags = 0;
-                mesgsys->getU32Fast(_PREHASH_ObjectData, _PREHASH_UpdateFlags, flags, i);
+                mesgsys->getU32(update_flags_field, flags, i);
 
                 compressed_dp.unpackUUID(fullid, "ID");
                 compressed_dp.unpackU32(local_id, "LocalID");
@@ -570,7 +594,7 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
         }
         else if (update_type != OUT_FULL) // !compressed, !OUT_FULL ==> OUT_FULL_CACHED only?
         {
-            mesgsys->getU32Fast(_PREHASH_ObjectData, _PREHASH_ID, local_id, i);
+            mesgsys->getU32(id_field, local_id, i);
 
             getUUIDFromLocal(fullid,
                             local_id,
@@ -589,8 +613,8 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
         else // OUT_FULL only?
         {
             update_cache = true;
-            mesgsys->getUUIDFast(_PREHASH_ObjectData, _PREHASH_FullID, fullid, i);
-            mesgsys->getU32Fast(_PREHASH_ObjectData, _PREHASH_ID, local_id, i);
+            mesgsys->getUUID(full_id_field, fullid, i);
+            mesgsys->getU32(id_field, local_id, i);
             LL_DEBUGS("ObjectUpdate") << "Full Update, obj " << local_id << ", global ID " << fullid << " from " << mesgsys->getSender() << LL_ENDL;
         }
         objectp = findObject(fullid);
@@ -663,7 +687,7 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
                     continue;
                 }
 
-                mesgsys->getU8Fast(_PREHASH_ObjectData, _PREHASH_PCode, pcode, i);
+                mesgsys->getU8(pcode_field, pcode, i);
 
             }
 #ifdef IGNORE_DEAD
@@ -1025,6 +1049,9 @@ void LLViewerObjectList::update(LLAgent &agent)
 
     std::vector<LLViewerObject*>::iterator idle_end = idle_list.begin()+idle_count;
 
+    // Avatar motions are evaluated together after the idle loop below
+    LLVOAvatar::beginDeferredMotions();
+
     // <FS:Ansariel> Speed up debug settings
     //if (gSavedSettings.getBOOL("FreezeTime"))
     if (freezeTime)
@@ -1040,6 +1067,7 @@ void LLViewerObjectList::update(LLAgent &agent)
                 objectp->idleUpdate(agent, frame_time);
             }
         }
+        LLVOAvatar::updateDeferredMotions();
     }
     else
     {
@@ -1050,6 +1078,7 @@ void LLViewerObjectList::update(LLAgent &agent)
             llassert(objectp->isActive());
                 objectp->idleUpdate(agent, frame_time);
         }
+        LLVOAvatar::updateDeferredMotions();
 
         //update flexible objects
         LLVolumeImplFlexible::updateClass();
@@ -0,0 +1,287 @@
+/**
+ * @file llviewerpartarrays.cpp
+ * @brief Structure-of-arrays particle state for an LLViewerPartGroup
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llviewerpartarrays.h"
+
+#include "llmath.h"
+
+namespace
+{
+    template <typename T>
+    void remove_at(std::vector<T>& array, S32 idx)
+    {
+        array[idx] = array.back();
+        array.pop_back();
+    }
+
+    LLVector4a load_vec(const LLVector3& v)
+    {
+        LLVector4a ret;
+        ret.load3(v.mV);
+        return ret;
+    }
+}
+
+S32 LLViewerPartArrays::add(const LLPartData& data, F32 age, F32 skip_offset,
+                            const LLVector3& pos, const LLVector3& velocity, const LLVector3& accel,
+                            const LLColor4& color, const LLVector2& scale)
+{
+    LLVector4a v;
+
+    mPosition.push_back(load_vec(pos));
+    mVelocity.push_back(load_vec(velocity));
+    mAccel.push_back(load_vec(accel));
+    v.loadua(color.mV);
+    mColor.push_back(v);
+    v.set(scale.mV[VX], scale.mV[VY], 0.f, 0.f);
+    mScale.push_back(v);
+    mPosOffset.push_back(load_vec(data.mPosOffset));
+    mAge.push_back(age);
+    mSkipOffset.push_back(skip_offset);
+    mFlags.push_back(data.mFlags);
+    mGlow.push_back((U8) ll_round(lerp(data.mStartGlow, data.mEndGlow, age / data.mMaxAge)*255.f));
+    mState.push_back(PART_ALIVE);
+
+    v.loadua(data.mStartColor.mV);
+    mStartColor.push_back(v);
+    v.loadua(data.mEndColor.mV);
+    mEndColor.push_back(v);
+    v.set(data.mStartScale.mV[VX], data.mStartScale.mV[VY], 0.f, 0.f);
+    mStartScale.push_back(v);
+    v.set(data.mEndScale.mV[VX], data.mEndScale.mV[VY], 0.f, 0.f);
+    mEndScale.push_back(v);
+    mMaxAge.push_back(data.mMaxAge);
+    mStartGlow.push_back(data.mStartGlow);
+    mEndGlow.push_back(data.mEndGlow);
+
+    v.clear();
+    mSourcePos.push_back(v);
+    mTargetPos.push_back(v);
+    mWind.push_back(v);
+
+    return size() - 1;
+}
+
+void LLViewerPartArrays::remove(S32 idx)
+{
+    llassert(idx >= 0 && idx < size());
+
+    remove_at(mPosition, idx);
+    remove_at(mVelocity, idx);
+    remove_at(mAccel, idx);
+    remove_at(mColor, idx);
+    remove_at(mScale, idx);
+    remove_at(mPosOffset, idx);
+    remove_at(mAge, idx);
+    remove_at(mSkipOffset, idx);
+    remove_at(mFlags, idx);
+    remove_at(mGlow, idx);
+    remove_at(mState, idx);
+
+    remove_at(mStartColor, idx);
+    remove_at(mEndColor, idx);
+    remove_at(mStartScale, idx);
+    remove_at(mEndScale, idx);
+    remove_at(mMaxAge, idx);
+    remove_at(mStartGlow, idx);
+    remove_at(mEndGlow, idx);
+
+    remove_at(mSourcePos, idx);
+    remove_at(mTargetPos, idx);
+    remove_at(mWind, idx);
+}
+
+void LLViewerPartArrays::clear()
+{
+    mPosition.clear();
+    mVelocity.clear();
+    mAccel.clear();
+    mColor.clear();
+    mScale.clear();
+    mPosOffset.clear();
+    mAge.clear();
+    mSkipOffset.clear();
+    mFlags.clear();
+    mGlow.clear();
+    mState.clear();
+
+    mStartColor.clear();
+    mEndColor.clear();
+    mStartScale.clear();
+    mEndScale.clear();
+    mMaxAge.clear();
+    mStartGlow.clear();
+    mEndGlow.clear();
+
+    mSourcePos.clear();
+    mTargetPos.clear();
+    mWind.clear();
+}
+
+// The arithmetic here follows the scalar LLVector3/LLColor4 code it
+// replaced operation for operation, so results are the same to the bit.
+void LLViewerPartArrays::simulate(F32 lastdt, F32 skipped_time, const LLVector3& camera_origin,
+                                  const LLVector3& min_pos, const LLVector3& max_pos, F32 box_radius)
+{
+    LL_PROFILE_ZONE_SCOPED;
+
+    const LLVector4a camera = load_vec(camera_origin);
+    const LLVector4a box_min = load_vec(min_pos);
+    const LLVector4a box_max = load_vec(max_pos);
+
+    const S32 count = size();
+    LLVector4a* __restrict posp = mPosition.data();
+    LLVector4a* __restrict velp = mVelocity.data();
+    LLVector4a* __restrict colorp = mColor.data();
+    LLVector4a* __restrict scalep = mScale.data();
+
+    for (S32 i = 0; i < count; ++i)
+    {
+        const U32 flags = mFlags[i];
+        const F32 dt = getTimeStep(i, lastdt, skipped_time);
+        mSkipOffset[i] = 0.f;
+
+        const F32 age = mAge[i];
+        const F32 max_age = mMaxAge[i];
+        const F32 cur_time = age + dt;
+        const F32 frac = cur_time / max_age;
+
+        LLVector4a& pos = posp[i];
+        LLVector4a& vel = velp[i];
+        LLVector4a t;
+
+        if (flags & LLPartData::LL_PART_WIND_MASK)
+        {
+            vel.mul(1.f - 0.1f*dt);
+            t.setMul(mWind[i], 0.1f*dt);
+            vel.add(t);
+        }
+
+        // Now do interpolation towards a target
+        if (flags & LLPartData::LL_PART_TARGET_POS_MASK)
+        {
+            F32 remaining = max_age - age;
+            F32 step = dt / remaining;
+
+            step = llclamp(step, 0.f, 0.1f);
+            step *= 5.f;
+
+            LLVector4a delta_pos;
+            delta_pos.setSub(mTargetPos[i], pos);
+            delta_pos.mul(1.f / remaining);
+
+            vel.mul(1.f - step);
+            delta_pos.mul(step);
+            vel.add(delta_pos);
+        }
+
+        if (flags & LLPartData::LL_PART_TARGET_LINEAR_MASK)
+        {
+            const LLVector4a& source = mSourcePos[i];
+            LLVector4a delta_pos;
+            delta_pos.setSub(mTargetPos[i], source);
+            t.setMul(delta_pos, frac);
+            pos.setAdd(source, t);
+            vel = delta_pos;
+        }
+        else
+        {
+            // Do velocity interpolation
+            const LLVector4a& accel = mAccel[i];
+            t.setMul(vel, dt);
+            pos.add(t);
+            t.setMul(accel, 0.5f*dt*dt);
+            pos.add(t);
+            t.setMul(accel, dt);
+            vel.add(t);
+        }
+
+        // Do a bounce test
+        if (flags & LLPartData::LL_PART_BOUNCE_MASK)
+        {
+            // For now, just check relative to object height...
+            F32* pos_f = pos.getF32ptr();
+            F32 dz = pos_f[VZ] - mSourcePos[i].getF32ptr()[VZ];
+            if (dz < 0)
+            {
+                pos_f[VZ] += -2.f*dz;
+                vel.getF32ptr()[VZ] *= -0.75f;
+            }
+        }
+
+        // Reset the offset from the source position
+        if (flags & LLPartData::LL_PART_FOLLOW_SRC_MASK)
+        {
+            mPosOffset[i].setSub(pos, mSourcePos[i]);
+        }
+
+        if (flags & LLPartData::LL_PART_INTERP_COLOR_MASK)
+        {
+            colorp[i].setMul(mStartColor[i], 1.f - frac);
+            t.setMul(mEndColor[i], frac);
+            colorp[i].add(t);
+        }
+
+        if (flags & LLPartData::LL_PART_INTERP_SCALE_MASK)
+        {
+            scalep[i].setMul(mStartScale[i], 1.f - frac);
+            t.setMul(mEndScale[i], frac);
+            scalep[i].add(t);
+        }
+
+        mGlow[i] = (U8) ll_round(lerp(mStartGlow[i], mEndGlow[i], frac)*255.f);
+
+        mAge[i] = cur_time;
+
+        // Kill dead particles (either flagged dead, or too old)
+        if ((cur_time > max_age) || (LLPartData::LL_PART_DEAD_MASK == flags))
+        {
+            mState[i] = PART_DEAD;
+            continue;
+        }
+
+        // Same test as LLViewerPartGroup::posInGroup() with the size
+        // from calc_desired_size()
+        U32 outside = pos.lessThan(box_min).getGatheredBits() | pos.greaterThan(box_max).getGatheredBits();
+        if (!(outside & 0x7))
+        {
+            t.setSub(pos, camera);
+            const F32* d = t.getF32ptr();
+            const F32* s = scalep[i].getF32ptr();
+            F32 desired_size = (F32) sqrt(d[VX]*d[VX] + d[VY]*d[VY] + d[VZ]*d[VZ]);
+            desired_size /= 4;
+            desired_size = llclamp(desired_size, (F32) sqrt(s[VX]*s[VX] + s[VY]*s[VY])*0.5f, PART_SIM_BOX_SIDE*2);
+
+            outside = desired_size > 0 &&
+                      (desired_size < box_radius*0.5f ||
+                       desired_size > box_radius*2.f);
+        }
+
+        mState[i] = outside ? PART_OUTSIDE : PART_ALIVE;
+    }
+}
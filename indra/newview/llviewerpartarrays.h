@@ -0,0 +1,129 @@
+/**
+ * @file llviewerpartarrays.h
+ * @brief Structure-of-arrays particle state for an LLViewerPartGroup
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLVIEWERPARTARRAYS_H
+#define LL_LLVIEWERPARTARRAYS_H
+
+#include <vector>
+
+#include "llpartdata.h"
+#include "llvector4a.h"
+#include "v2math.h"
+#include "v3math.h"
+#include "v4color.h"
+
+// Side of the boxes particles are sorted into
+const F32 PART_SIM_BOX_SIDE = 16.f;
+
+// The simulated state of the particles in one LLViewerPartGroup, one array
+// per field, index-aligned with the group's particle list.
+//
+// Stepping a group is split in three so that the expensive part can run on
+// any thread:
+//  - the owner gathers what lives outside the group (source and target
+//    positions, wind) and runs particle callbacks on the main thread,
+//  - simulate() does the integration and interpolation with LLVector4a math,
+//    touching nothing but these arrays, so groups can be stepped in parallel,
+//  - the owner removes particles simulate() marked dead or outside the box.
+class LLViewerPartArrays
+{
+public:
+    enum
+    {
+        PART_ALIVE = 0,
+        PART_DEAD,          // Too old or flagged dead, to be deleted
+        PART_OUTSIDE        // Left the group's box or size range, to be moved
+    };
+
+    // Flags that need mSourcePos or mTargetPos gathered before simulate()
+    static const U32 SOURCE_FLAGS = LLPartData::LL_PART_FOLLOW_SRC_MASK |
+                                    LLPartData::LL_PART_TARGET_POS_MASK |
+                                    LLPartData::LL_PART_TARGET_LINEAR_MASK |
+                                    LLPartData::LL_PART_BOUNCE_MASK;
+
+    S32 size() const { return (S32)mFlags.size(); }
+
+    // Append a particle with the constant parts taken from data, returns
+    // its index.
+    S32 add(const LLPartData& data, F32 age, F32 skip_offset,
+            const LLVector3& pos, const LLVector3& velocity, const LLVector3& accel,
+            const LLColor4& color, const LLVector2& scale);
+
+    // Remove particle idx by moving the last one into its place, the way
+    // LLViewerPartGroup removes from its particle list.
+    void remove(S32 idx);
+
+    void clear();
+
+    // Time step of particle idx, it may have joined the group part way
+    // through a skipped update.
+    F32 getTimeStep(S32 idx, F32 lastdt, F32 skipped_time) const
+    {
+        return lastdt + skipped_time - mSkipOffset[idx];
+    }
+
+    // Advance every particle and set its mState.  Particles are checked
+    // against the group's box and size range like
+    // LLViewerPartGroup::posInGroup().
+    void simulate(F32 lastdt, F32 skipped_time, const LLVector3& camera_origin,
+                  const LLVector3& min_pos, const LLVector3& max_pos, F32 box_radius);
+
+    LLVector3 getPosition(S32 idx) const    { return LLVector3(mPosition[idx].getF32ptr()); }
+    LLVector3 getVelocity(S32 idx) const    { return LLVector3(mVelocity[idx].getF32ptr()); }
+    LLColor4 getColor(S32 idx) const        { return LLColor4(mColor[idx].getF32ptr()); }
+    LLVector2 getScale(S32 idx) const       { return LLVector2(mScale[idx].getF32ptr()); }
+
+public:
+    // Simulated state
+    std::vector<LLVector4a> mPosition;
+    std::vector<LLVector4a> mVelocity;
+    std::vector<LLVector4a> mAccel;
+    std::vector<LLVector4a> mColor;
+    std::vector<LLVector4a> mScale;         // x, y, 0, 0
+    std::vector<LLVector4a> mPosOffset;     // From source when following it
+    std::vector<F32>        mAge;
+    std::vector<F32>        mSkipOffset;
+    std::vector<U32>        mFlags;
+    std::vector<U8>         mGlow;
+    std::vector<U8>         mState;
+
+    // Constant for the life of the particle
+    std::vector<LLVector4a> mStartColor;
+    std::vector<LLVector4a> mEndColor;
+    std::vector<LLVector4a> mStartScale;
+    std::vector<LLVector4a> mEndScale;
+    std::vector<F32>        mMaxAge;
+    std::vector<F32>        mStartGlow;
+    std::vector<F32>        mEndGlow;
+
+    // Gathered by the owner before simulate(), only for particles whose
+    // flags need them
+    std::vector<LLVector4a> mSourcePos;
+    std::vector<LLVector4a> mTargetPos;
+    std::vector<LLVector4a> mWind;
+};
+
+#endif // LL_LLVIEWERPARTARRAYS_H
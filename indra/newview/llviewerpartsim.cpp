@@ -42,8 +42,7 @@
 #include "llspatialpartition.h"
 #include "llvoavatarself.h"
 #include "llvovolume.h"
-
-const F32 PART_SIM_BOX_SIDE = 16.f;
+#include "workexecutor.h"
 
 //static
 S32 LLViewerPartSim::sMaxParticleCount = 0;
@@ -204,6 +203,7 @@ LLViewerPartGroup::~LLViewerPartGroup()
         delete mParticles[i] ;
     }
     mParticles.clear();
+    mArrays.clear();
 
     LLViewerPartSim::decPartCount(count);
 }
@@ -268,159 +268,131 @@ bool LLViewerPartGroup::addPart(LLViewerPart* part, F32 desired_size)
 
     mParticles.push_back(part);
     part->mSkipOffset=mSkippedTime;
+    mArrays.add(*part, part->mLastUpdateTime, part->mSkipOffset,
+                part->mPosAgent, part->mVelocity, part->mAccel, part->mColor, part->mScale);
     LLViewerPartSim::incPartCount(1);
     return true;
 }
 
 
-void LLViewerPartGroup::updateParticles(const F32 lastdt)
+void LLViewerPartGroup::storePart(S32 idx)
 {
-    F32 dt;
+    LLViewerPart* part = mParticles[idx];
+
+    part->mPosAgent = mArrays.getPosition(idx);
+    part->mVelocity = mArrays.getVelocity(idx);
+    part->mAccel.set(mArrays.mAccel[idx].getF32ptr());
+    part->mColor = mArrays.getColor(idx);
+    part->mScale = mArrays.getScale(idx);
+    part->mPosOffset.set(mArrays.mPosOffset[idx].getF32ptr());
+    part->mGlow.mV[3] = mArrays.mGlow[idx];
+    part->mLastUpdateTime = mArrays.mAge[idx];
+    part->mSkipOffset = mArrays.mSkipOffset[idx];
+    part->mFlags = mArrays.mFlags[idx];
+}
 
-    LLVector3 gravity(0.f, 0.f, GRAVITY);
+void LLViewerPartGroup::loadPart(S32 idx)
+{
+    const LLViewerPart* part = mParticles[idx];
+
+    mArrays.mPosition[idx].load3(part->mPosAgent.mV);
+    mArrays.mVelocity[idx].load3(part->mVelocity.mV);
+    mArrays.mAccel[idx].load3(part->mAccel.mV);
+    mArrays.mColor[idx].loadua(part->mColor.mV);
+    mArrays.mScale[idx].set(part->mScale.mV[VX], part->mScale.mV[VY], 0.f, 0.f);
+    mArrays.mPosOffset[idx].load3(part->mPosOffset.mV);
+    mArrays.mGlow[idx] = part->mGlow.mV[3];
+    mArrays.mAge[idx] = part->mLastUpdateTime;
+    mArrays.mSkipOffset[idx] = part->mSkipOffset;
+    mArrays.mFlags[idx] = part->mFlags;
+}
+
+void LLViewerPartGroup::prepareParticles(const F32 lastdt)
+{
+    LL_PROFILE_ZONE_SCOPED;
 
     // <FS:Beq> FIRE-34600 off by one particle count triggering bugsplat (LL_ERR)
-    S32 end = (S32) mParticles.size();
     LLViewerPartSim::checkParticleCount(static_cast<U32>(mParticles.size()));
     std::atomic_signal_fence(std::memory_order_seq_cst);
     // </FS:Beq>
 
-    LLViewerCamera* camera = LLViewerCamera::getInstance();
+    llassert(mArrays.size() == (S32)mParticles.size());
+
     LLViewerRegion *regionp = getRegion();
-    //S32 end = (S32) mParticles.size();// <FS:Beq> FIRE-34600 off by one particle count triggering bugsplat (LL_ERR)
-    for (S32 i = 0 ; i < (S32)mParticles.size();)
+    for (S32 i = 0 ; i < (S32)mParticles.size(); i++)
     {
-        LLVector3 a(0.f, 0.f, 0.f);
-        LLViewerPart* part = mParticles[i] ;
-
-        dt = lastdt + mSkippedTime - part->mSkipOffset;
-        part->mSkipOffset = 0.f;
+        LLViewerPart* part = mParticles[i];
+        const U32 flags = mArrays.mFlags[i];
 
-        // Update current time
-        const F32 cur_time = part->mLastUpdateTime + dt;
-        const F32 frac = cur_time / part->mMaxAge;
+        if (flags & LLViewerPartArrays::SOURCE_FLAGS)
+        {
+            mArrays.mSourcePos[i].load3(part->mPartSourcep->mPosAgent.mV);
+            mArrays.mTargetPos[i].load3(part->mPartSourcep->mTargetPosAgent.mV);
+        }
 
         // "Drift" the object based on the source object
-        if (part->mFlags & LLPartData::LL_PART_FOLLOW_SRC_MASK)
+        if (flags & LLPartData::LL_PART_FOLLOW_SRC_MASK)
         {
-            part->mPosAgent = part->mPartSourcep->mPosAgent;
-            part->mPosAgent += part->mPosOffset;
+            mArrays.mPosition[i].setAdd(mArrays.mSourcePos[i], mArrays.mPosOffset[i]);
         }
 
         // Do a custom callback if we have one...
         if (part->mVPCallback)
         {
+            const F32 dt = mArrays.getTimeStep(i, lastdt, mSkippedTime);
+            storePart(i);
             (*part->mVPCallback)(*part, dt);
+            loadPart(i);
         }
 
-        if (part->mFlags & LLPartData::LL_PART_WIND_MASK)
-        {
-            part->mVelocity *= 1.f - 0.1f*dt;
-            part->mVelocity += 0.1f*dt*regionp->mWind.getVelocity(regionp->getPosRegionFromAgent(part->mPosAgent));
-        }
-
-        // Now do interpolation towards a target
-        if (part->mFlags & LLPartData::LL_PART_TARGET_POS_MASK)
-        {
-            F32 remaining = part->mMaxAge - part->mLastUpdateTime;
-            F32 step = dt / remaining;
-
-            step = llclamp(step, 0.f, 0.1f);
-            step *= 5.f;
-            // we want a velocity that will result in reaching the target in the
-            // Interpolate towards the target.
-            LLVector3 delta_pos = part->mPartSourcep->mTargetPosAgent - part->mPosAgent;
-
-            delta_pos /= remaining;
-
-            part->mVelocity *= (1.f - step);
-            part->mVelocity += step*delta_pos;
-        }
-
-
-        if (part->mFlags & LLPartData::LL_PART_TARGET_LINEAR_MASK)
-        {
-            LLVector3 delta_pos = part->mPartSourcep->mTargetPosAgent - part->mPartSourcep->mPosAgent;
-            part->mPosAgent = part->mPartSourcep->mPosAgent;
-            part->mPosAgent += frac*delta_pos;
-            part->mVelocity = delta_pos;
-        }
-        else
-        {
-            // Do velocity interpolation
-            part->mPosAgent += dt*part->mVelocity;
-            part->mPosAgent += 0.5f*dt*dt*part->mAccel;
-            part->mVelocity += part->mAccel*dt;
-        }
-
-        // Do a bounce test
-        if (part->mFlags & LLPartData::LL_PART_BOUNCE_MASK)
+        if (mArrays.mFlags[i] & LLPartData::LL_PART_WIND_MASK)
         {
-            // Need to do point vs. plane check...
-            // For now, just check relative to object height...
-            F32 dz = part->mPosAgent.mV[VZ] - part->mPartSourcep->mPosAgent.mV[VZ];
-            if (dz < 0)
-            {
-                part->mPosAgent.mV[VZ] += -2.f*dz;
-                part->mVelocity.mV[VZ] *= -0.75f;
-            }
+            LLVector3 pos_agent = mArrays.getPosition(i);
+            mArrays.mWind[i].load3(regionp->mWind.getVelocity(regionp->getPosRegionFromAgent(pos_agent)).mV);
         }
+    }
+}
 
+void LLViewerPartGroup::simulateParticles(const F32 lastdt, const LLVector3& camera_origin)
+{
+    mArrays.simulate(lastdt, mSkippedTime, camera_origin, mMinObjPos, mMaxObjPos, mBoxRadius);
+}
 
-        // Reset the offset from the source position
-        if (part->mFlags & LLPartData::LL_PART_FOLLOW_SRC_MASK)
-        {
-            part->mPosOffset = part->mPosAgent;
-            part->mPosOffset -= part->mPartSourcep->mPosAgent;
-        }
+void LLViewerPartGroup::finishParticles()
+{
+    LL_PROFILE_ZONE_SCOPED;
 
-        // Do color interpolation
-        if (part->mFlags & LLPartData::LL_PART_INTERP_COLOR_MASK)
-        {
-            part->mColor.setVec(part->mStartColor);
-            // note: LLColor4's v%k means multiply-alpha-only,
-            //       LLColor4's v*k means multiply-rgb-only
-            part->mColor *= 1.f - frac; // rgb*k
-            part->mColor %= 1.f - frac; // alpha*k
-            part->mColor += frac%(frac*part->mEndColor); // rgb,alpha
-        }
+    S32 end = (S32) mParticles.size();
+    for (S32 i = 0 ; i < (S32)mParticles.size();)
+    {
+        LLViewerPart* part = mParticles[i];
 
-        // Do scale interpolation
-        if (part->mFlags & LLPartData::LL_PART_INTERP_SCALE_MASK)
+        switch (mArrays.mState[i])
         {
-            part->mScale.setVec(part->mStartScale);
-            part->mScale *= 1.f - frac;
-            part->mScale += frac*part->mEndScale;
-        }
-
-        // Do glow interpolation
-        part->mGlow.mV[3] = (U8) ll_round(lerp(part->mStartGlow, part->mEndGlow, frac)*255.f);
-
-        // Set the last update time to now.
-        part->mLastUpdateTime = cur_time;
+        case LLViewerPartArrays::PART_DEAD:
+            mParticles[i] = mParticles.back();
+            mParticles.pop_back();
+            mArrays.remove(i);
+            delete part;
+            break;
 
+        case LLViewerPartArrays::PART_OUTSIDE:
+            // Transfer particles between groups
+            storePart(i);
+            mParticles[i] = mParticles.back();
+            mParticles.pop_back();
+            mArrays.remove(i);
+            LLViewerPartSim::getInstance()->put(part);
+            break;
 
-        // Kill dead particles (either flagged dead, or too old)
-        if ((part->mLastUpdateTime > part->mMaxAge) || (LLViewerPart::LL_PART_DEAD_MASK == part->mFlags))
-        {
-            mParticles[i] = mParticles.back() ;
-            mParticles.pop_back() ;
-            delete part ;
-        }
-        else
-        {
-            F32 desired_size = calc_desired_size(camera, part->mPosAgent, part->mScale);
-            if (!posInGroup(part->mPosAgent, desired_size))
-            {
-                // Transfer particles between groups
-                LLViewerPartSim::getInstance()->put(part) ;
-                mParticles[i] = mParticles.back() ;
-                mParticles.pop_back() ;
-            }
-            else
+        default:
+            if (mArrays.mFlags[i] & LLPartData::LL_PART_RIBBON_MASK)
             {
-                i++ ;
+                // Ribbon neighbours read each other through the particle
+                storePart(i);
             }
+            i++;
+            break;
         }
     }
 
@@ -435,13 +407,6 @@ void LLViewerPartGroup::updateParticles(const F32 lastdt)
         LLViewerPartSim::decPartCount(removed);
     }
 
-    // Kill the viewer object if this particle group is empty
-    if (mParticles.empty())
-    {
-        gObjectList.killObject(mVOPartGroupp);
-        mVOPartGroupp = NULL;
-    }
-
     LLViewerPartSim::checkParticleCount() ;
 }
 
@@ -452,9 +417,12 @@ void LLViewerPartGroup::shift(const LLVector3 &offset)
     mMinObjPos += offset;
     mMaxObjPos += offset;
 
+    LLVector4a offset_a;
+    offset_a.load3(offset.mV);
     for (S32 i = 0 ; i < (S32)mParticles.size(); i++)
     {
         mParticles[i]->mPosAgent += offset;
+        mArrays.mPosition[i].add(offset_a);
     }
 }
 
@@ -465,6 +433,7 @@ void LLViewerPartGroup::removeParticlesByID(const U32 source_id)
         if(mParticles[i]->mPartSourcep->getID() == source_id)
         {
             mParticles[i]->mFlags = LLViewerPart::LL_PART_DEAD_MASK;
+            mArrays.mFlags[i] = LLViewerPart::LL_PART_DEAD_MASK;
         }
     }
 }
@@ -753,10 +722,16 @@ void LLViewerPartSim::updateSimulation()
         num_updates++;
     }
 
+    // Groups are stepped in three passes: gathering and callbacks on the
+    // main thread, the simulation itself on all cores, then removing and
+    // moving particles on the main thread again.  Particles moved into
+    // another group wait for that group's next update.
+    std::vector<std::pair<LLViewerPartGroup*, F32> > update_groups;
     count = (S32) mViewerPartGroups.size();
     for (i = 0; i < count; i++)
     {
-        LLViewerObject* vobj = mViewerPartGroups[i]->mVOPartGroupp;
+        LLViewerPartGroup* groupp = mViewerPartGroups[i];
+        LLViewerObject* vobj = groupp->mVOPartGroupp;
 
         S32 visirate = 1;
         if (vobj && !vobj->isDead() && vobj->mDrawable && !vobj->mDrawable->isDead())
@@ -768,7 +743,7 @@ void LLViewerPartSim::updateSimulation()
             }
         }
 
-        if ((LLDrawable::getCurrentFrame()+mViewerPartGroups[i]->mID)%visirate == 0)
+        if ((LLDrawable::getCurrentFrame()+groupp->mID)%visirate == 0)
         {
             // <FS:CR> FIRE-11593: Opensim "4096 Bug" Fix by Latif Khalifa
             // <vobj && !vobj->isDead())
@@ -776,22 +751,38 @@ void LLViewerPartSim::updateSimulation()
             {
                 gPipeline.markRebuild(vobj->mDrawable, LLDrawable::REBUILD_ALL);
             }
-            mViewerPartGroups[i]->updateParticles(dt * visirate);
-            mViewerPartGroups[i]->mSkippedTime=0.0f;
-            if (!mViewerPartGroups[i]->getCount())
-            {
-                delete mViewerPartGroups[i];
-                mViewerPartGroups.erase(mViewerPartGroups.begin() + i);
-                i--;
-                count--;
-            }
+            groupp->prepareParticles(dt * visirate);
+            update_groups.emplace_back(groupp, dt * visirate);
         }
         else
         {
-            mViewerPartGroups[i]->mSkippedTime+=dt;
+            groupp->mSkippedTime+=dt;
         }
+    }
 
+    const LLVector3 camera_origin = LLViewerCamera::getInstance()->getOrigin();
+    LL::WorkExecutor::getShared().forEach(update_groups.size(),
+        [&update_groups, &camera_origin](size_t i)
+        {
+            update_groups[i].first->simulateParticles(update_groups[i].second, camera_origin);
+        });
+
+    for (auto& update : update_groups)
+    {
+        update.first->finishParticles();
+        update.first->mSkippedTime=0.0f;
     }
+
+    for (auto& update : update_groups)
+    {
+        LLViewerPartGroup* groupp = update.first;
+        if (!groupp->getCount())
+        {
+            mViewerPartGroups.erase(std::find(mViewerPartGroups.begin(), mViewerPartGroups.end(), groupp));
+            delete groupp;
+        }
+    }
+
     if (LLDrawable::getCurrentFrame()%16==0)
     {
         if (sParticleCount > sMaxParticleCount * 0.875f
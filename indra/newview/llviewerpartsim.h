@@ -30,6 +30,7 @@
 #include "llframetimer.h"
 #include "llpointer.h"
 #include "llpartdata.h"
+#include "llviewerpartarrays.h"
 #include "llviewerpartsource.h"
 
 class LLViewerTexture;
@@ -45,7 +46,12 @@ typedef void (*LLVPCallback)(LLViewerPart &part, const F32 dt);
 //
 // An individual particle
 //
-
+// While a particle is in a group its simulated state (position, velocity,
+// color, scale, glow, age and flags) lives in the group's LLViewerPartArrays.
+// The copy here is brought up to date around callbacks, when the particle
+// moves between groups, and every update for ribbon particles, whose
+// neighbours may be in another group.
+//
 
 class LLViewerPart : public LLPartData
 {
@@ -97,7 +103,12 @@ public:
 
     bool addPart(LLViewerPart* part, const F32 desired_size = -1.f);
 
-    void updateParticles(const F32 lastdt);
+    // Stepping the particles, see LLViewerPartArrays.  Only
+    // simulateParticles() may be called off the main thread, and on
+    // different groups at the same time.
+    void prepareParticles(const F32 lastdt);
+    void simulateParticles(const F32 lastdt, const LLVector3& camera_origin);
+    void finishParticles();
 
     bool posInGroup(const LLVector3 &pos, const F32 desired_size = -1.f);
 
@@ -108,6 +119,12 @@ public:
 
     typedef std::vector<LLViewerPart*>  part_list_t;
     part_list_t mParticles;
+    LLViewerPartArrays mArrays;             // Index-aligned with mParticles
+
+    // Copy the simulated state of particle idx between the arrays and
+    // its LLViewerPart
+    void storePart(S32 idx);
+    void loadPart(S32 idx);
 
     const LLVector3 &getCenterAgent() const     { return mCenterAgent; }
     S32 getCount() const                    { return (S32) mParticles.size(); }
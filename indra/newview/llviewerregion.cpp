@@ -651,6 +651,8 @@ LLViewerRegion::LLViewerRegion(const U64 &handle,
     mViewerAssetUrl(""),
     mCacheLoaded(false),
     mCacheDirty(false),
+    mCacheLoadPending(false),
+    mHandshakeReplyPending(false),
     mReleaseNotesRequested(false),
     mCapabilitiesState(CAPABILITIES_STATE_INIT),
     mSimulatorFeaturesReceived(false),
@@ -843,22 +845,48 @@ void LLViewerRegion::loadObjectCache()
 
     if(LLVOCache::instanceExists())
     {
-        LLVOCache & vocache = LLVOCache::instance();
-        // Without this a "corrupted" vocache persists until a cache clear or other rewrite. Mark as dirty hereif read fails to force a rewrite.
-        mCacheDirty = !vocache.readFromCache(mHandle, mImpl->mCacheID, mImpl->mCacheMap);
-        vocache.readGenericExtrasFromCache(mHandle, mImpl->mCacheID, mImpl->mGLTFOverridesLLSD, mImpl->mCacheMap);
+        // The file is read on the cache thread, the region may be gone by the time it is done.
+        mCacheLoadPending = true;
+        U64 handle = mHandle;
+        LLUUID cache_id = mImpl->mCacheID;
+        LLVOCache::instance().readFromCacheAsync(mHandle, mImpl->mCacheID,
+            [handle, cache_id](bool success, LLVOCacheEntry::vocache_entry_map_t& cache_entry_map)
+            {
+                LLViewerRegion* region = LLWorld::instanceExists() ? LLWorld::getInstance()->getRegionFromHandle(handle) : NULL;
+                if (region && region->mCacheLoadPending && region->mImpl->mCacheID == cache_id)
+                {
+                    region->onObjectCacheLoaded(success, cache_entry_map);
+                }
+            });
+    }
+}
 
-        if (mImpl->mCacheMap.empty())
-        {
-            mCacheDirty = true;
-        }
+void LLViewerRegion::onObjectCacheLoaded(bool success, vocache_entry_map_t& cache_entry_map)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_NETWORK;
+    mCacheLoadPending = false;
+
+    // Anything that arrived while loading is newer than the cache, keep it.
+    mImpl->mCacheMap.insert(cache_entry_map.begin(), cache_entry_map.end());
+
+    if (LLVOCache::instanceExists())
+    {
+        LLVOCache::instance().readGenericExtrasFromCache(mHandle, mImpl->mCacheID, mImpl->mGLTFOverridesLLSD, mImpl->mCacheMap);
+    }
+
+    // Without this a "corrupted" vocache persists until a cache clear or other rewrite. Mark as dirty here if read fails to force a rewrite.
+    mCacheDirty = !success || mImpl->mCacheMap.empty();
+
+    if (mHandshakeReplyPending)
+    {
+        sendRegionHandshakeReply();
     }
 }
 
 
 void LLViewerRegion::saveObjectCache()
 {
-    if (!mCacheLoaded)
+    if (!mCacheLoaded || mCacheLoadPending)
     {
         return;
     }
@@ -2801,8 +2829,12 @@ void LLViewerRegion::decodeBoundingInfo(LLVOCacheEntry* entry)
     LLVector3 scale;
     LLQuaternion rot;
 
-    //decode spatial info and parent info
-    U32 parent_id = entry->getDP() ? LLViewerObject::extractSpatialExtents(entry->getDP(), pos, scale, rot) : entry->getParentID();
+    //decode spatial info and parent info, the cache index has them without inflating the object data
+    U32 parent_id = 0;
+    if (!entry->getIndexedBoundingInfo(pos, scale, parent_id))
+    {
+        parent_id = entry->getDP() ? LLViewerObject::extractSpatialExtents(entry->getDP(), pos, scale, rot) : entry->getParentID();
+    }
 
     U32 old_parent_id = entry->getParentID();
     bool same_old_parent = false;
@@ -3413,9 +3445,24 @@ void LLViewerRegion::unpackRegionHandshake()
     loadObjectCache();
 
     // After loading cache, signal that simulator can start
-    // sending data.
+    // sending data. If the cache is still being read, the reply goes
+    // out once it is done so the sim knows whether to send probes.
+    if (mCacheLoadPending)
+    {
+        mHandshakeReplyPending = true;
+    }
+    else
+    {
+        sendRegionHandshakeReply();
+    }
+}
+
+void LLViewerRegion::sendRegionHandshakeReply()
+{
+    mHandshakeReplyPending = false;
+
     // TODO: Send all upstream viewer->sim handshake info here.
-    LLHost host = msg->getSender();
+    LLMessageSystem* msg = gMessageSystem;
     msg->newMessage("RegionHandshakeReply");
     msg->nextBlock("AgentData");
     msg->addUUID("AgentID", gAgent.getID());
@@ -3434,7 +3481,7 @@ void LLViewerRegion::unpackRegionHandshake()
         flags |= 0x00000002; //set the bit 1 to be 1 to tell sim the cache file is empty, no need to send cache probes.
     }
     msg->addU32("Flags", flags );
-    msg->sendReliable(host);
+    msg->sendReliable(getHost());
 
     mRegionTimer.reset(); //reset region timer.
 }
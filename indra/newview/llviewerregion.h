@@ -601,6 +601,8 @@ public:
     // a structure of size 2^14 = 16,000
     bool                                    mCacheLoaded;
     bool                                    mCacheDirty;
+    bool                                    mCacheLoadPending;       // object cache is being read on the cache thread
+    bool                                    mHandshakeReplyPending;  // RegionHandshakeReply waits for the object cache
     bool    mAlive;                 // can become false if circuit disconnects
     bool    mSimulatorFeaturesReceived;
     bool    mReleaseNotesRequested;
@@ -651,6 +653,9 @@ public:
     typedef std::map<U32, LLPointer<LLVOCacheEntry> >      vocache_entry_map_t;
     static vocache_entry_map_t sRegionCacheCleanup;
 
+    void onObjectCacheLoaded(bool success, vocache_entry_map_t& cache_entry_map);
+    void sendRegionHandshakeReply();
+
     // the materials capability throttle
     LLFrameTimer mMaterialsCapThrottleTimer;
     LLFrameTimer mRenderInfoRequestTimer;
@@ -790,6 +790,9 @@ void LLViewerTexture::addFace(U32 ch, LLFace* facep)
     facep->setIndexInTex(ch, mNumFaces[ch]);
     mNumFaces[ch]++;
     mLastFaceListUpdateTimer.reset();
+
+    // The new face may need more of the texture than it has
+    gTextureList.queueImageUpdate(LLViewerTextureManager::staticCastToFetchedTexture(this), facep->getVirtualSize());
 }
 
 //virtual
@@ -385,6 +385,7 @@ void LLViewerTextureList::shutdown()
 
     mUUIDMap.clear();
 
+    mUpdateQueue.clear();
     mImageList.clear();
 
     mInitialized = false ; //prevent loading textures again.
@@ -749,6 +750,8 @@ void LLViewerTextureList::removeImageFromList(LLViewerFetchedTexture *image)
     llassert_always(mInitialized) ;
     llassert(image);
 
+    mUpdateQueue.erase(image);
+
     size_t count = 0;
     if (image->isInImageList())
     {
@@ -1078,6 +1081,22 @@ bool LLViewerTextureList::updateImageDecodePriority(LLViewerFetchedTexture *imag
     return needs_fetch;
 }
 
+void LLViewerTextureList::queueImageUpdate(LLViewerFetchedTexture *imagep, F32 virtual_size)
+{
+    if (imagep && mInitialized && imagep->isInImageList() && !gCubeSnapshot)
+    {
+        mUpdateQueue.pushMax(imagep, virtual_size);
+    }
+}
+
+void LLViewerTextureList::queueFaceImageUpdates(const LLFace* facep, F32 virtual_size)
+{
+    for (U32 ch = 0; ch < LLRender::NUM_TEXTURE_CHANNELS; ++ch)
+    {
+        queueImageUpdate(LLViewerTextureManager::staticCastToFetchedTexture(facep->getTexture(ch)), virtual_size);
+    }
+}
+
 //void LLViewerTextureList::setDebugFetching(LLViewerFetchedTexture* tex, S32 debug_level)
 //{
 //    LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
@@ -1275,10 +1294,42 @@ F32 LLViewerTextureList::updateBoostImagesFetchTextures(F32 max_time)
     return timer.getElapsedTimeF32();
 }
 
+F32 LLViewerTextureList::updateQueuedImagesFetchTextures(F32 max_time)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
+
+    LLTimer timer;
+    while (!mUpdateQueue.empty())
+    {
+        LLPointer<LLViewerFetchedTexture> imagep = mUpdateQueue.top();
+        mUpdateQueue.pop();
+
+        // Boosted textures are updated by updateBoostImagesFetchTextures()
+        if (imagep->getGLTexture() && imagep->getBoostLevel() <= 0)
+        {
+            if (updateImageDecodePriority(imagep))
+                imagep->updateFetch();
+        }
+
+        if (timer.getElapsedTimeF32() > max_time)
+        {
+            break;
+        }
+    }
+
+    return timer.getElapsedTimeF32();
+}
+
 F32 LLViewerTextureList::updateImagesFetchTextures(F32 max_time)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
 
+    // Queued textures first, with up to half of the time, so that they start
+    // fetching in the frame they are queued.  The sweep below keeps the
+    // priorities and lazy flushing of all the others going.
+    const F32 queued_time = updateQueuedImagesFetchTextures(max_time * 0.5f);
+    max_time -= queued_time;
+
     typedef std::vector<LLPointer<LLViewerFetchedTexture> > entries_list_t;
     entries_list_t entries;
 
@@ -1340,7 +1391,7 @@ F32 LLViewerTextureList::updateImagesFetchTextures(F32 max_time)
         }
     }
 
-    return timer.getElapsedTimeF32();
+    return queued_time + timer.getElapsedTimeF32();
 }
 
 void LLViewerTextureList::updateImagesUpdateStats()
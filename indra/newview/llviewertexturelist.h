@@ -30,6 +30,7 @@
 #include "lluuid.h"
 //#include "message.h"
 #include "llgl.h"
+#include "llindexedheap.h"
 #include "llviewertexture.h"
 #include "llui.h"
 #include <list>
@@ -47,6 +48,7 @@ const bool GL_TEXTURE_NO = false;
 const bool IMMEDIATE_YES = true;
 const bool IMMEDIATE_NO = false;
 
+class LLFace;
 class LLImageJ2C;
 class LLMessageSystem;
 class LLTextureView;
@@ -148,10 +150,17 @@ public:
 
     bool updateImageDecodePriority(LLViewerFetchedTexture *imagep);
 
+    // Update the texture in the next updateImages(), ahead of queued textures
+    // with a smaller virtual size, instead of whenever the sweep over all
+    // textures gets to it.  For textures coming into view or changing size.
+    void queueImageUpdate(LLViewerFetchedTexture *imagep, F32 virtual_size);
+    void queueFaceImageUpdates(const LLFace* facep, F32 virtual_size);
+
 
   private:
     F32  updateImagesCreateTextures(F32 max_time);
     F32  updateBoostImagesFetchTextures(F32 max_time);
+    F32  updateQueuedImagesFetchTextures(F32 max_time);
     F32  updateImagesFetchTextures(F32 max_time);
     void updateImagesUpdateStats();
     F32  updateImagesLoadingFastCache(F32 max_time);
@@ -243,6 +252,10 @@ private:
 
     image_list_t mImageList;
 
+    // Textures waiting for an update, largest virtual size first.  Only
+    // textures in mImageList, which keeps them alive.
+    LLIndexedHeap<LLViewerFetchedTexture*, F32> mUpdateQueue;
+
     // simply holds on to LLViewerFetchedTexture references to stop them from being purged too soon
     std::unordered_set<LLPointer<LLViewerFetchedTexture> > mImagePreloads;
 
@@ -102,6 +102,10 @@ void LLVLManager::unpackData(const S32 num_packets)
 {
     static LLFrameTimer decode_timer;
 
+    // Land from every packet is inverse transformed together, so that a
+    // region's worth of patches arriving at once is spread across threads.
+    std::vector<LLSurface::DecodedPatch> land_patches;
+
     S32 i;
     for (i = 0; i < mPacketData.size(); i++)
     {
@@ -113,12 +117,12 @@ void LLVLManager::unpackData(const S32 num_packets)
         decode_patch_group_header(bit_pack, &goph);
         if (LAND_LAYER_CODE == datap->mType)
         {
-            datap->mRegionp->getLand().decompressDCTPatch(bit_pack, &goph, false);
+            datap->mRegionp->getLand().decodeDCTPatches(bit_pack, &goph, false, land_patches);
         }
 // <FS:CR> Aurora Sim
         else if (AURORA_LAND_LAYER_CODE == datap->mType)
         {
-            datap->mRegionp->getLand().decompressDCTPatch(bit_pack, &goph, true);
+            datap->mRegionp->getLand().decodeDCTPatches(bit_pack, &goph, true, land_patches);
         }
         //else if (WIND_LAYER_CODE == datap->mType)
         else if (WIND_LAYER_CODE == datap->mType || AURORA_WIND_LAYER_CODE == datap->mType)
@@ -140,6 +144,8 @@ void LLVLManager::unpackData(const S32 num_packets)
         }
     }
 
+    LLSurface::decompressDCTPatches(land_patches);
+
     for (i = 0; i < mPacketData.size(); i++)
     {
         delete mPacketData[i];
@@ -650,6 +650,8 @@ F32 LLVOAvatar::sGreyUpdateTime = 0.f;
 LLPointer<LLViewerTexture> LLVOAvatar::sCloudTexture = NULL;
 std::vector<LLUUID> LLVOAvatar::sAVsIgnoringARTLimit;
 S32 LLVOAvatar::sAvatarsNearby = 0;
+std::vector<LLPointer<LLVOAvatar> > LLVOAvatar::sDeferredMotionAvatars;
+bool LLVOAvatar::sDeferMotions = false;
 
 //-----------------------------------------------------------------------------
 // Helper functions
@@ -2909,7 +2911,17 @@ void LLVOAvatar::idleUpdate(LLAgent &agent, const F64 &time)
     // store off last frame's root position to be consistent with camera position
     mLastRootPos = mRoot->getWorldPosition();
     bool detailed_update = updateCharacter(agent);
+    if (mMotionsDeferred)
+    {
+        // updateDeferredMotions() finishes up
+        return;
+    }
+
+    idleUpdateAfterCharacter(detailed_update);
+}
 
+void LLVOAvatar::idleUpdateAfterCharacter(bool detailed_update)
+{
     static LLUICachedControl<bool> visualizers_in_calls("ShowVoiceVisualizersInCalls", false);
     bool voice_enabled = (visualizers_in_calls || LLVoiceClient::getInstance()->inProximalChannel()) &&
                          LLVoiceClient::getInstance()->getVoiceEnabled(mID);
@@ -5480,20 +5492,43 @@ bool LLVOAvatar::updateCharacter(LLAgent &agent)
     mSpeed = speed;
 
     // update animations
+    LLCharacter::e_update_t update_type = LLCharacter::NORMAL_UPDATE; // Might be better to do HIDDEN_UPDATE if cloud
     if (!visible && !isSelf()) // NOTE: never do a "hidden update" for self avatar as it interrupts controller processing
     {
-        updateMotions(LLCharacter::HIDDEN_UPDATE);
+        update_type = LLCharacter::HIDDEN_UPDATE;
     }
     else if (mSpecialRenderMode == 1) // Animation Preview
     {
-        updateMotions(LLCharacter::FORCE_UPDATE);
+        update_type = LLCharacter::FORCE_UPDATE;
+    }
+
+    // Self drives the camera and agent, and attached animesh follows its
+    // avatar, so those stay in step with the rest of the frame
+    if (sDeferMotions && !isSelf() && !isUIAvatar() && !is_attachment)
+    {
+        if (beginUpdateMotions(update_type))
+        {
+            sDeferredMotionAvatars.push_back(this);
+            mMotionsDeferred = true;
+            mDeferredVisible = visible;
+            mDeferredSitGroundConstrained = was_sit_ground_constrained;
+            return visible;
+        }
     }
     else
     {
-        // Might be better to do HIDDEN_UPDATE if cloud
-        updateMotions(LLCharacter::NORMAL_UPDATE);
+        updateMotions(update_type);
     }
 
+    finishUpdateCharacter(visible, was_sit_ground_constrained);
+    return visible;
+}
+
+//-----------------------------------------------------------------------------
+// finishUpdateCharacter()
+//-----------------------------------------------------------------------------
+void LLVOAvatar::finishUpdateCharacter(bool visible, bool was_sit_ground_constrained)
+{
     // Special handling for sitting on ground.
     if (!getParent() && (isSitting() || was_sit_ground_constrained))
     {
@@ -5523,8 +5558,57 @@ bool LLVOAvatar::updateCharacter(LLAgent &agent)
         // System avatar mesh vertices need to be reskinned.
         mNeedsSkin = true;
     }
+}
 
-    return visible;
+//-----------------------------------------------------------------------------
+// beginDeferredMotions()
+//-----------------------------------------------------------------------------
+// static
+void LLVOAvatar::beginDeferredMotions()
+{
+    static LLCachedControl<bool> parallel_animation(gSavedSettings, "AvatarParallelAnimation", true);
+    llassert(sDeferredMotionAvatars.empty());
+    sDeferMotions = parallel_animation;
+}
+
+//-----------------------------------------------------------------------------
+// updateDeferredMotions()
+//-----------------------------------------------------------------------------
+// static
+void LLVOAvatar::updateDeferredMotions()
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
+    sDeferMotions = false;
+    if (sDeferredMotionAvatars.empty())
+    {
+        return;
+    }
+
+    static std::vector<LLCharacter*> characters;
+    characters.clear();
+    for (LLVOAvatar* avatarp : sDeferredMotionAvatars)
+    {
+        characters.push_back(avatarp);
+    }
+    LLCharacter::evaluateMotionsInParallel(characters);
+
+    // Back on the main thread, in the order the avatars were idled
+    for (LLVOAvatar* avatarp : sDeferredMotionAvatars)
+    {
+        avatarp->mMotionsDeferred = false;
+        if (avatarp->isDead())
+        {
+            continue;
+        }
+        if (avatarp->mSexUpdatePending)
+        {
+            // Reapplies the visual params for the new sex too
+            avatarp->updateVisualParams();
+        }
+        avatarp->finishUpdateCharacter(avatarp->mDeferredVisible, avatarp->mDeferredSitGroundConstrained);
+        avatarp->idleUpdateAfterCharacter(avatarp->mDeferredVisible);
+    }
+    sDeferredMotionAvatars.clear();
 }
 
 //-----------------------------------------------------------------------------
@@ -7957,26 +8041,7 @@ void LLVOAvatar::initAttachmentPoints(bool ignore_hud_joints)
 //-----------------------------------------------------------------------------
 void LLVOAvatar::updateVisualParams()
 {
-    ESex avatar_sex = (getVisualParamWeight("male") > 0.5f) ? SEX_MALE : SEX_FEMALE;
-    if (getSex() != avatar_sex)
-    {
-        if (mIsSitting && findMotion(avatar_sex == SEX_MALE ? ANIM_AGENT_SIT_FEMALE : ANIM_AGENT_SIT) != NULL)
-        {
-            // In some cases of gender change server changes sit motion with motion message,
-            // but in case of some avatars (legacy?) there is no update from server side,
-            // likely because server doesn't know about difference between motions
-            // (female and male sit ids are same server side, so it is likely unaware that it
-            // need to send update)
-            // Make sure motion is up to date
-            stopMotion(ANIM_AGENT_SIT);
-            setSex(avatar_sex);
-            startMotion(ANIM_AGENT_SIT);
-        }
-        else
-        {
-            setSex(avatar_sex);
-        }
-    }
+    updateSex();
 
     LLCharacter::updateVisualParams();
 
@@ -7996,6 +8061,46 @@ void LLVOAvatar::updateVisualParams()
     dirtyMesh();
     updateHeadOffset();
 }
+
+//-----------------------------------------------------------------------------
+// updateSex()
+//-----------------------------------------------------------------------------
+void LLVOAvatar::updateSex()
+{
+    mSexUpdatePending = false;
+
+    ESex avatar_sex = (getVisualParamWeight("male") > 0.5f) ? SEX_MALE : SEX_FEMALE;
+    if (getSex() == avatar_sex)
+    {
+        return;
+    }
+
+    if (mMotionsDeferred)
+    {
+        // Called by a motion being evaluated off the main thread, switching
+        // sit motions must wait for updateDeferredMotions()
+        mSexUpdatePending = true;
+        return;
+    }
+
+    if (mIsSitting && findMotion(avatar_sex == SEX_MALE ? ANIM_AGENT_SIT_FEMALE : ANIM_AGENT_SIT) != NULL)
+    {
+        // In some cases of gender change server changes sit motion with motion message,
+        // but in case of some avatars (legacy?) there is no update from server side,
+        // likely because server doesn't know about difference between motions
+        // (female and male sit ids are same server side, so it is likely unaware that it
+        // need to send update)
+        // Make sure motion is up to date
+        stopMotion(ANIM_AGENT_SIT);
+        setSex(avatar_sex);
+        startMotion(ANIM_AGENT_SIT);
+    }
+    else
+    {
+        setSex(avatar_sex);
+    }
+}
+
 //-----------------------------------------------------------------------------
 // isActive()
 //-----------------------------------------------------------------------------
@@ -249,6 +249,7 @@ public:
     /*virtual*/ LLVector3d      getPosGlobalFromAgent(const LLVector3 &position);
     /*virtual*/ LLVector3       getPosAgentFromGlobal(const LLVector3d &position);
     virtual void                updateVisualParams();
+    void                        updateSex();
 
 /**                    Inherited
  **                                                                            **
@@ -283,6 +284,7 @@ public:
     virtual void    updateDebugText();
     virtual bool    computeNeedsUpdate();
     virtual bool    updateCharacter(LLAgent &agent);
+    void            finishUpdateCharacter(bool visible, bool was_sit_ground_constrained);
     void            updateFootstepSounds();
     void            computeUpdatePeriod();
     void            updateOrientation(LLAgent &agent, F32 speed, F32 delta_time);
@@ -314,6 +316,21 @@ public:
     // </FS:Ansariel>
     void            idleUpdateRenderComplexity();
     void            idleUpdateDebugInfo();
+    void            idleUpdateAfterCharacter(bool detailed_update);
+
+    // Between these, updateCharacter() leaves the motions of other avatars
+    // to be evaluated together, in parallel, by updateDeferredMotions(),
+    // which then finishes their updateCharacter() and idleUpdate().
+    static void     beginDeferredMotions();
+    static void     updateDeferredMotions();
+private:
+    static std::vector<LLPointer<LLVOAvatar> > sDeferredMotionAvatars;
+    static bool     sDeferMotions;
+    bool            mMotionsDeferred = false;
+    bool            mDeferredVisible = false;
+    bool            mDeferredSitGroundConstrained = false;
+    bool            mSexUpdatePending = false; // updateSex() waiting for the deferred motions
+public:
     void            accountRenderComplexityForObject(LLViewerObject *attached_object,
                                                      const F32 max_attachment_complexity,
                                                      LLVOVolume::texture_cost_t& textures,
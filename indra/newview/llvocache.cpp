@@ -35,6 +35,13 @@
 #include "llsdserialize.h"
 #include "llagent.h" // <FS:Beq/> For gAgent
 #include "llworld.h" // For LLWorld::getInstance()
+#include "threadpool.h"
+#include "lltimer.h"
+#ifdef LL_USESYSTEMLIBS
+#include <zlib.h>
+#else
+#include "zlib-ng/zlib.h"
+#endif
 
 //static variables
 U32 LLVOCacheEntry::sMinFrameRange = 0;
@@ -47,6 +54,52 @@ bool LLVOCachePartition::sNeedsOcclusionCheck = false;
 const S32 ENTRY_HEADER_SIZE = 6 * sizeof(S32);
 const S32 MAX_ENTRY_BODY_SIZE = 10000;
 
+// Indexed region object cache file layout, all values in host byte order:
+//   U32 magic, U32 format version, LLUUID region cache id,
+//   S32 number of entries, S32 number of payload blocks,
+//   index section: one fixed-size LLVOCacheIndexRecord per entry,
+//   block table: S32 compressed size, S32 inflated size per block,
+//   the zlib compressed payload blocks.
+// Files without the magic are from the legacy entry-by-entry format and get
+// rewritten in this format the next time the region is saved.
+const U32 OBJECT_CACHE_MAGIC = 0x32434f56; // "VOC2"
+const U32 OBJECT_CACHE_FORMAT_VERSION = 1;
+const S32 OBJECT_CACHE_HEADER_SIZE = 2 * sizeof(U32) + UUID_BYTES + 2 * sizeof(S32);
+const S32 INDEX_RECORD_SIZE = 9 * sizeof(U32) + UUID_BYTES + 6 * sizeof(F32);
+const S32 BLOCK_TABLE_ENTRY_SIZE = 2 * sizeof(S32);
+const S32 PAYLOAD_BLOCK_SIZE = 64 * 1024; // inflated size a block is closed at
+const S32 MAX_PAYLOAD_BLOCK_SIZE = PAYLOAD_BLOCK_SIZE + MAX_ENTRY_BODY_SIZE;
+
+// Object data of a run of entries, compressed as one block.  Shared by the
+// entries until each of them inflates its own copy, main thread only after load.
+struct LLVOCachePayloadBlock
+{
+    std::vector<U8> mCompressed;
+    S32             mInflatedSize = 0;
+    std::vector<U8> mInflated;
+    bool            mFailed = false;
+
+    const U8* inflate()
+    {
+        if (mInflated.empty() && !mFailed)
+        {
+            LL_PROFILE_ZONE_NAMED_CATEGORY_NETWORK("VOCache:inflatePayload");
+            mInflated.resize(mInflatedSize);
+            uLongf dest_len = mInflatedSize;
+            if (uncompress(mInflated.data(), &dest_len, mCompressed.data(), static_cast<uLong>(mCompressed.size())) != Z_OK
+                || dest_len != (uLongf)mInflatedSize)
+            {
+                LL_WARNS("VOCache") << "Failed to inflate object cache payload block" << LL_ENDL;
+                mInflated.clear();
+                mFailed = true;
+            }
+            // Nothing needs the compressed data past this point.
+            std::vector<U8>().swap(mCompressed);
+        }
+        return mInflated.empty() ? NULL : mInflated.data();
+    }
+};
+
 bool check_read(LLAPRFile* apr_file, void* src, S32 n_bytes)
 {
     return apr_file->read(src, n_bytes) == n_bytes ;
@@ -169,7 +222,11 @@ LLVOCacheEntry::LLVOCacheEntry(U32 local_id, U32 crc, LLDataPackerBinaryBuffer &
     mSceneContrib(0.f),
     mValid(true),
     mParentID(0),
-    mBSphereRadius(-1.0f)
+    mBSphereRadius(-1.0f),
+    mPayloadOffset(0),
+    mPayloadSize(0),
+    mIndexed(false),
+    mIndexParentID(0)
 {
     mBuffer = new U8[dp.getBufferSize()];
     mDP.assignBuffer(mBuffer, dp.getBufferSize());
@@ -189,12 +246,16 @@ LLVOCacheEntry::LLVOCacheEntry()
     mSceneContrib(0.f),
     mValid(true),
     mParentID(0),
-    mBSphereRadius(-1.0f)
+    mBSphereRadius(-1.0f),
+    mPayloadOffset(0),
+    mPayloadSize(0),
+    mIndexed(false),
+    mIndexParentID(0)
 {
     mDP.assignBuffer(mBuffer, 0);
 }
 
-LLVOCacheEntry::LLVOCacheEntry(LLAPRFile* apr_file)
+LLVOCacheEntry::LLVOCacheEntry(const U8* data, S32 data_size, S32& bytes_read)
 :   LLViewerOctreeEntryData(LLViewerOctreeEntry::LLVOCACHEENTRY),
     mBuffer(NULL),
     mUpdateFlags(-1),
@@ -202,49 +263,51 @@ LLVOCacheEntry::LLVOCacheEntry(LLAPRFile* apr_file)
     mSceneContrib(0.f),
     mValid(false),
     mParentID(0),
-    mBSphereRadius(-1.0f)
+    mBSphereRadius(-1.0f),
+    mPayloadOffset(0),
+    mPayloadSize(0),
+    mIndexed(false),
+    mIndexParentID(0)
 {
     S32 size = -1;
-    bool success;
-    static U8 data_buffer[ENTRY_HEADER_SIZE];
+    bool success = data_size >= ENTRY_HEADER_SIZE;
+    bytes_read = 0;
 
     mDP.assignBuffer(mBuffer, 0);
 
-    success = check_read(apr_file, (void *)data_buffer, ENTRY_HEADER_SIZE);
     if (success)
     {
-        memcpy(&mLocalID, data_buffer, sizeof(U32));
-        memcpy(&mCRC, data_buffer + sizeof(U32), sizeof(U32));
-        memcpy(&mHitCount, data_buffer + (2 * sizeof(U32)), sizeof(S32));
-        memcpy(&mDupeCount, data_buffer + (3 * sizeof(U32)), sizeof(S32));
-        memcpy(&mCRCChangeCount, data_buffer + (4 * sizeof(U32)), sizeof(S32));
-        memcpy(&size, data_buffer + (5 * sizeof(U32)), sizeof(S32));
+        memcpy(&mLocalID, data, sizeof(U32));
+        memcpy(&mCRC, data + sizeof(U32), sizeof(U32));
+        memcpy(&mHitCount, data + (2 * sizeof(U32)), sizeof(S32));
+        memcpy(&mDupeCount, data + (3 * sizeof(U32)), sizeof(S32));
+        memcpy(&mCRCChangeCount, data + (4 * sizeof(U32)), sizeof(S32));
+        memcpy(&size, data + (5 * sizeof(U32)), sizeof(S32));
 
         // Corruption in the cache entries
         if ((size > MAX_ENTRY_BODY_SIZE) || (size < 1))
         {
             // We've got a bogus size, skip reading it.
-            // We won't bother seeking, because the rest of this file
-            // is likely bogus, and will be tossed anyway.
+            // The rest of this file is likely bogus, and will be
+            // tossed anyway.
             LL_WARNS() << "Bogus cache entry, size " << size << ", aborting!" << LL_ENDL;
             success = false;
         }
     }
     if(success && size > 0)
     {
-        mBuffer = new U8[size];
-        success = check_read(apr_file, mBuffer, size);
-
-        if(success)
+        if (size <= data_size - ENTRY_HEADER_SIZE)
         {
+            mBuffer = new U8[size];
+            memcpy(mBuffer, data + ENTRY_HEADER_SIZE, size);
             mDP.assignBuffer(mBuffer, size);
+            bytes_read = ENTRY_HEADER_SIZE + size;
         }
         else
         {
             // Improve logging around vocache
             LL_WARNS() << "Error loading cache entry for " << mLocalID << ", size " << size << " aborting!" << LL_ENDL;
-            delete[] mBuffer ;
-            mBuffer = NULL ;
+            success = false;
         }
     }
 
@@ -261,6 +324,32 @@ LLVOCacheEntry::LLVOCacheEntry(LLAPRFile* apr_file)
     }
 }
 
+LLVOCacheEntry::LLVOCacheEntry(const LLVOCacheIndexRecord& record, const std::shared_ptr<LLVOCachePayloadBlock>& payload)
+:   LLViewerOctreeEntryData(LLViewerOctreeEntry::LLVOCACHEENTRY),
+    mLocalID(record.mLocalID),
+    mCRC(record.mCRC),
+    mUpdateFlags(-1),
+    mHitCount(record.mHitCount),
+    mDupeCount(record.mDupeCount),
+    mCRCChangeCount(record.mCRCChangeCount),
+    mBuffer(NULL),
+    mState(INACTIVE),
+    mSceneContrib(0.f),
+    mValid(false),
+    mParentID(0),
+    mBSphereRadius(-1.0f),
+    mPayload(payload),
+    mPayloadOffset(record.mOffset),
+    mPayloadSize(record.mSize),
+    mIndexed(true),
+    mIndexParentID(record.mParentID),
+    mFullID(record.mFullID),
+    mIndexPos(record.mPos),
+    mIndexScale(record.mScale)
+{
+    mDP.assignBuffer(mBuffer, 0);
+}
+
 LLVOCacheEntry::~LLVOCacheEntry()
 {
     mDP.freeBuffer();
@@ -275,6 +364,8 @@ void LLVOCacheEntry::updateEntry(U32 crc, LLDataPackerBinaryBuffer &dp)
     }
 
     mDP.freeBuffer();
+    mPayload.reset();
+    mIndexed = false;
 
     llassert_always(dp.getBufferSize() > 0);
     mBuffer = new U8[dp.getBufferSize()];
@@ -310,10 +401,13 @@ void LLVOCacheEntry::removeAllChildren()
 //virtual
 void LLVOCacheEntry::setOctreeEntry(LLViewerOctreeEntry* entry)
 {
-    if(!entry && mDP.getBufferSize() > 0)
+    if(!entry && (mIndexed || mDP.getBufferSize() > 0))
     {
-        LLUUID fullid;
-        LLViewerObject::unpackUUID(&mDP, fullid, "ID");
+        LLUUID fullid = mFullID;
+        if (!mIndexed)
+        {
+            LLViewerObject::unpackUUID(&mDP, fullid, "ID");
+        }
 
         LLViewerObject* obj = gObjectList.findObject(fullid);
         if(obj && obj->mDrawable)
@@ -407,6 +501,19 @@ LLVOCacheEntry* LLVOCacheEntry::getChild()
 
 LLDataPackerBinaryBuffer *LLVOCacheEntry::getDP()
 {
+    if (mDP.getBufferSize() == 0 && mPayload)
+    {
+        // First use since the cache was loaded, take a copy of the object data.
+        const U8* data = mPayload->inflate();
+        if (data)
+        {
+            mBuffer = new U8[mPayloadSize];
+            memcpy(mBuffer, data + mPayloadOffset, mPayloadSize);
+            mDP.assignBuffer(mBuffer, mPayloadSize);
+        }
+        mPayload.reset();
+    }
+
     if (mDP.getBufferSize() == 0)
     {
         //LL_INFOS() << "Not getting cache entry, invalid!" << LL_ENDL;
@@ -432,25 +539,64 @@ void LLVOCacheEntry::dump() const
         << LL_ENDL;
 }
 
-S32 LLVOCacheEntry::writeToBuffer(U8 *data_buffer) const
+bool LLVOCacheEntry::getIndexRecord(LLVOCacheIndexRecord& record, const U8*& data)
 {
-    S32 size = mDP.getBufferSize();
+    S32 size = 0;
+    data = NULL;
+    if (mDP.getBufferSize() > 0)
+    {
+        size = mDP.getBufferSize();
+        data = mBuffer;
+    }
+    else if (mPayload)
+    {
+        // Don't bother materializing an entry that was never used.
+        const U8* payload = mPayload->inflate();
+        if (payload)
+        {
+            size = mPayloadSize;
+            data = payload + mPayloadOffset;
+        }
+    }
 
-    if (size > MAX_ENTRY_BODY_SIZE)
+    if (!data || size < 1 || size > MAX_ENTRY_BODY_SIZE)
     {
-        LL_WARNS() << "Failed to write entry with size above allowed limit: " << size << LL_ENDL;
-        return 0;
+        LL_WARNS() << "Failed to write entry with size outside allowed limit: " << size << LL_ENDL;
+        return false;
     }
 
-    memcpy(data_buffer, &mLocalID, sizeof(U32));
-    memcpy(data_buffer + sizeof(U32), &mCRC, sizeof(U32));
-    memcpy(data_buffer + (2 * sizeof(U32)), &mHitCount, sizeof(S32));
-    memcpy(data_buffer + (3 * sizeof(U32)), &mDupeCount, sizeof(S32));
-    memcpy(data_buffer + (4 * sizeof(U32)), &mCRCChangeCount, sizeof(S32));
-    memcpy(data_buffer + (5 * sizeof(U32)), &size, sizeof(S32));
-    memcpy(data_buffer + ENTRY_HEADER_SIZE, (void*)mBuffer, size);
+    if (!mIndexed)
+    {
+        // Object data came from the sim or a legacy cache, decode the bits the index needs.
+        LLQuaternion rot;
+        mIndexParentID = LLViewerObject::extractSpatialExtents(&mDP, mIndexPos, mIndexScale, rot);
+        LLViewerObject::unpackUUID(&mDP, mFullID, "ID");
+        mIndexed = true;
+    }
+
+    record.mLocalID = mLocalID;
+    record.mCRC = mCRC;
+    record.mParentID = mIndexParentID;
+    record.mHitCount = mHitCount;
+    record.mDupeCount = mDupeCount;
+    record.mCRCChangeCount = mCRCChangeCount;
+    record.mSize = size;
+    record.mFullID = mFullID;
+    record.mPos = mIndexPos;
+    record.mScale = mIndexScale;
+    return true;
+}
 
-    return ENTRY_HEADER_SIZE + size;
+bool LLVOCacheEntry::getIndexedBoundingInfo(LLVector3& pos, LLVector3& scale, U32& parent_id) const
+{
+    if (!mIndexed)
+    {
+        return false;
+    }
+    pos = mIndexPos;
+    scale = mIndexScale;
+    parent_id = mIndexParentID;
+    return true;
 }
 
 #ifndef LL_TEST
@@ -1187,6 +1333,12 @@ LLVOCache::LLVOCache(bool read_only) :
 
 LLVOCache::~LLVOCache()
 {
+    if (mThreadPool)
+    {
+        // Finish pending reads and writes before the header goes out.
+        mThreadPool->close();
+        mThreadPool.reset();
+    }
     if(mEnabled)
     {
         writeCacheHeader();
@@ -1195,6 +1347,20 @@ LLVOCache::~LLVOCache()
     delete mLocalAPRFilePoolp;
 }
 
+void LLVOCache::waitForCacheThread()
+{
+    if (mThreadPool)
+    {
+        // Closing runs what is already queued, then the pool is started
+        // again for whatever comes next.  The old one has to go first, the
+        // two can't share the queue name.
+        mThreadPool->close();
+        mThreadPool.reset();
+        mThreadPool.reset(new LL::ThreadPool("VOCache", 1));
+        mThreadPool->start();
+    }
+}
+
 void LLVOCache::setDirNames(ELLPath location)
 {
     mHeaderFileName = gDirUtilp->getExpandedFilename(location, object_cache_dirname, header_filename);
@@ -1233,6 +1399,10 @@ void LLVOCache::initCache(ELLPath location, U32 size, U32 cache_version)
 
     readCacheHeader();
 
+    // A single thread, region object files are read and written in the order they were requested.
+    mThreadPool.reset(new LL::ThreadPool("VOCache", 1));
+    mThreadPool->start();
+
     LL_INFOS() << "Viewer Object Cache Versions - expected: " << cache_version << " found: " << mMetaInfo.mVersion <<  LL_ENDL;
 
     if( mMetaInfo.mVersion != cache_version
@@ -1268,6 +1438,8 @@ void LLVOCache::removeCache(ELLPath location, bool started)
 
     LL_INFOS() << "about to remove the object cache due to settings." << LL_ENDL ;
 
+    waitForCacheThread();
+
     std::string mask = "*";
     std::string cache_dir = gDirUtilp->getExpandedFilename(location, object_cache_dirname);
     LL_INFOS() << "Removing cache at " << cache_dir << LL_ENDL;
@@ -1292,6 +1464,8 @@ void LLVOCache::removeCache()
         return ;
     }
 
+    waitForCacheThread();
+
     std::string mask = "*";
     LL_INFOS() << "Removing object cache at " << mObjectCacheDirName << LL_ENDL;
     gDirUtilp->deleteFilesInDir(mObjectCacheDirName, mask);
@@ -1392,7 +1566,13 @@ void LLVOCache::removeFromCache(HeaderEntryInfo* entry)
     std::string filename;
     getObjectCacheFilename(entry->mHandle, filename);
     LL_WARNS("GLTF", "VOCache") << "Removing object cache for handle " << entry->mHandle << "Filename: " << filename << LL_ENDL;
-    LLAPRFile::remove(filename, mLocalAPRFilePoolp);
+    // A write of the file may still be queued on the cache thread, remove it
+    // there so that the write can't bring it back afterwards.
+    LL::WorkQueue::ptr_t cache_queue = LL::WorkQueue::getInstance("VOCache");
+    if (!cache_queue || !cache_queue->post([filename]() { LLFile::remove(filename, ENOENT); }))
+    {
+        LLAPRFile::remove(filename, mLocalAPRFilePoolp);
+    }
 
     // Note: `removeFromCache` should take responsibility for cleaning up all cache artefacts specfic to the handle/entry.
     // as such this now includes the generic extras
@@ -1549,6 +1729,207 @@ bool LLVOCache::updateEntry(const HeaderEntryInfo* entry)
     return check_write(&apr_file, (void*)entry, sizeof(HeaderEntryInfo)) ;
 }
 
+namespace
+{
+    template <typename T>
+    T read_value(const U8*& pos)
+    {
+        T value;
+        memcpy(&value, pos, sizeof(T));
+        pos += sizeof(T);
+        return value;
+    }
+
+    template <typename T>
+    void append_value(std::vector<U8>& out, const T& value)
+    {
+        const U8* bytes = reinterpret_cast<const U8*>(&value);
+        out.insert(out.end(), bytes, bytes + sizeof(T));
+    }
+
+    void append_index_record(std::vector<U8>& out, const LLVOCacheIndexRecord& record)
+    {
+        append_value(out, record.mLocalID);
+        append_value(out, record.mCRC);
+        append_value(out, record.mParentID);
+        append_value(out, record.mHitCount);
+        append_value(out, record.mDupeCount);
+        append_value(out, record.mCRCChangeCount);
+        append_value(out, record.mBlock);
+        append_value(out, record.mOffset);
+        append_value(out, record.mSize);
+        out.insert(out.end(), record.mFullID.mData, record.mFullID.mData + UUID_BYTES);
+        append_value(out, record.mPos.mV);
+        append_value(out, record.mScale.mV);
+    }
+
+    void read_index_record(const U8* pos, LLVOCacheIndexRecord& record)
+    {
+        record.mLocalID = read_value<U32>(pos);
+        record.mCRC = read_value<U32>(pos);
+        record.mParentID = read_value<U32>(pos);
+        record.mHitCount = read_value<S32>(pos);
+        record.mDupeCount = read_value<S32>(pos);
+        record.mCRCChangeCount = read_value<S32>(pos);
+        record.mBlock = read_value<U32>(pos);
+        record.mOffset = read_value<S32>(pos);
+        record.mSize = read_value<S32>(pos);
+        memcpy(record.mFullID.mData, pos, UUID_BYTES);
+        pos += UUID_BYTES;
+        memcpy(record.mPos.mV, pos, sizeof(record.mPos.mV));
+        pos += sizeof(record.mPos.mV);
+        memcpy(record.mScale.mV, pos, sizeof(record.mScale.mV));
+    }
+
+    bool parse_legacy_object_cache(const std::vector<U8>& data, const std::string& filename, const LLUUID& id,
+                                   LLVOCacheEntry::vocache_entry_map_t& cache_entry_map, S32& num_entries)
+    {
+        const S32 file_size = static_cast<S32>(data.size());
+        LLUUID cache_id;
+        memcpy(cache_id.mData, data.data(), UUID_BYTES);
+        if (cache_id != id)
+        {
+            LL_INFOS() << "Cache ID doesn't match for this region, discarding"<< LL_ENDL;
+            return false;
+        }
+
+        memcpy(&num_entries, data.data() + UUID_BYTES, sizeof(S32));
+        S32 offset = UUID_BYTES + sizeof(S32);
+        for (S32 i = 0; i < num_entries && offset < file_size; i++)
+        {
+            S32 bytes_read = 0;
+            LLPointer<LLVOCacheEntry> entry = new LLVOCacheEntry(data.data() + offset, file_size - offset, bytes_read);
+            if (!entry->getLocalID())
+            {
+                LL_WARNS() << "Aborting cache file load for " << filename << ", cache file corruption!" << LL_ENDL;
+                return false;
+            }
+            cache_entry_map[entry->getLocalID()] = entry;
+            offset += bytes_read;
+        }
+        return true;
+    }
+
+    // Only the index is decoded, the payload blocks are kept compressed and
+    // inflated on the main thread once an entry's object data is needed.
+    bool parse_indexed_object_cache(const std::vector<U8>& data, const std::string& filename, const LLUUID& id,
+                                    LLVOCacheEntry::vocache_entry_map_t& cache_entry_map, S32& num_entries)
+    {
+        const U8* pos = data.data() + 2 * sizeof(U32);
+        const U8* end = data.data() + data.size();
+
+        LLUUID cache_id;
+        memcpy(cache_id.mData, pos, UUID_BYTES);
+        pos += UUID_BYTES;
+        if (cache_id != id)
+        {
+            LL_INFOS() << "Cache ID doesn't match for this region, discarding"<< LL_ENDL;
+            return false;
+        }
+
+        num_entries = read_value<S32>(pos);
+        S32 num_blocks = read_value<S32>(pos);
+        if (num_entries < 0 || num_blocks < 0
+            || (S64)num_entries * INDEX_RECORD_SIZE + (S64)num_blocks * BLOCK_TABLE_ENTRY_SIZE > (S64)(end - pos))
+        {
+            LL_WARNS() << "Aborting cache file load for " << filename << ", bad index size, cache file corruption!" << LL_ENDL;
+            return false;
+        }
+
+        const U8* index = pos;
+        const U8* block_table = index + (size_t)num_entries * INDEX_RECORD_SIZE;
+        const U8* block_data = block_table + (size_t)num_blocks * BLOCK_TABLE_ENTRY_SIZE;
+
+        std::vector<std::shared_ptr<LLVOCachePayloadBlock> > blocks(num_blocks);
+        for (S32 i = 0; i < num_blocks; i++)
+        {
+            S32 compressed_size = read_value<S32>(block_table);
+            S32 inflated_size = read_value<S32>(block_table);
+            if (compressed_size < 1 || inflated_size < 1 || inflated_size > MAX_PAYLOAD_BLOCK_SIZE
+                || compressed_size > end - block_data)
+            {
+                LL_WARNS() << "Aborting cache file load for " << filename << ", bad payload block " << i << ", cache file corruption!" << LL_ENDL;
+                return false;
+            }
+            blocks[i] = std::make_shared<LLVOCachePayloadBlock>();
+            blocks[i]->mCompressed.assign(block_data, block_data + compressed_size);
+            blocks[i]->mInflatedSize = inflated_size;
+            block_data += compressed_size;
+        }
+
+        for (S32 i = 0; i < num_entries; i++)
+        {
+            LLVOCacheIndexRecord record;
+            read_index_record(index + (size_t)i * INDEX_RECORD_SIZE, record);
+            if (!record.mLocalID || record.mBlock >= (U32)num_blocks
+                || record.mSize < 1 || record.mSize > MAX_ENTRY_BODY_SIZE
+                || record.mOffset < 0 || record.mOffset > blocks[record.mBlock]->mInflatedSize - record.mSize)
+            {
+                LL_WARNS() << "Aborting cache file load for " << filename << ", cache file corruption!" << LL_ENDL;
+                return false;
+            }
+            cache_entry_map[record.mLocalID] = new LLVOCacheEntry(record, blocks[record.mBlock]);
+        }
+        return true;
+    }
+
+    // Read a region object cache file in one go and parse it from memory.
+    // Runs on the cache thread, must not touch any LLVOCache state.
+    // Returns false for a legacy file so it gets rewritten in the indexed format.
+    bool load_object_cache(const std::string& filename, const LLUUID& id,
+                           LLVOCacheEntry::vocache_entry_map_t& cache_entry_map, S32& num_entries)
+    {
+        LL_PROFILE_ZONE_NAMED_CATEGORY_NETWORK("VOCache:loadRegionObjectCache");
+        LLTimer load_timer;
+        num_entries = 0;
+
+        const S32 file_size = LLAPRFile::size(filename);
+        if (file_size < (S32)(UUID_BYTES + sizeof(S32)))
+        {
+            return false;
+        }
+        std::vector<U8> data(file_size);
+        if (LLAPRFile::readEx(filename, data.data(), 0, file_size) != file_size)
+        {
+            return false;
+        }
+
+        LL_PROFILE_ZONE_NAMED_CATEGORY_NETWORK("VOCache:loadCacheForRegion");
+        const U8* pos = data.data();
+        bool indexed = file_size >= OBJECT_CACHE_HEADER_SIZE && read_value<U32>(pos) == OBJECT_CACHE_MAGIC;
+        bool success = false;
+        if (!indexed)
+        {
+            success = parse_legacy_object_cache(data, filename, id, cache_entry_map, num_entries);
+            if (success)
+            {
+                LL_INFOS("VOCache") << "Legacy object cache format in " << filename << ", it will be rewritten" << LL_ENDL;
+                success = false;
+            }
+        }
+        else if (read_value<U32>(pos) != OBJECT_CACHE_FORMAT_VERSION)
+        {
+            LL_INFOS("VOCache") << "Unknown object cache format version in " << filename << ", discarding" << LL_ENDL;
+        }
+        else
+        {
+            success = parse_indexed_object_cache(data, filename, id, cache_entry_map, num_entries);
+        }
+
+        LL_DEBUGS("VOCache") << "Loaded " << cache_entry_map.size() << " entries from " << (indexed ? "indexed" : "legacy")
+                             << " object cache " << filename << " (" << file_size << " bytes) in "
+                             << load_timer.getElapsedTimeF32() * 1000.f << " ms" << LL_ENDL;
+        return success;
+    }
+
+    struct CacheReadResult
+    {
+        bool mSuccess = false;
+        S32 mNumEntries = 0;
+        LLVOCacheEntry::vocache_entry_map_t mEntries;
+    };
+}
+
 // we now return bool to trigger dirty cache
 // this in turn forces a rewrite after a partial read due to corruption.
 bool LLVOCache::readFromCache(U64 handle, const LLUUID& id, LLVOCacheEntry::vocache_entry_map_t& cache_entry_map)
@@ -1568,58 +1949,68 @@ bool LLVOCache::readFromCache(U64 handle, const LLUUID& id, LLVOCacheEntry::voca
         return false; // arguably no a problem, but we'll mark this as dirty anyway.
     }
 
-    bool success = true ;
-    S32 num_entries = 0 ; // lifted out of inner loop.
-    std::string filename; // lifted out of loop
-    {
-		LL_PROFILE_ZONE_NAMED_CATEGORY_NETWORK("VOCache:loadRegionObjectCache");        
-        LLUUID cache_id;
-        getObjectCacheFilename(handle, filename);
-        LLAPRFile apr_file(filename, APR_READ|APR_BINARY, mLocalAPRFilePoolp);
+    S32 num_entries = 0 ;
+    std::string filename;
+    getObjectCacheFilename(handle, filename);
+    bool success = load_object_cache(filename, id, cache_entry_map, num_entries);
 
-        success = check_read(&apr_file, cache_id.mData, UUID_BYTES);
+    finishRead(handle, filename, success, num_entries, cache_entry_map);
+    return success;
+}
 
-        if(success)
-        {
-            LL_PROFILE_ZONE_NAMED_CATEGORY_NETWORK("VOCache:loadCacheForRegion");
-            if(cache_id != id)
+void LLVOCache::readFromCacheAsync(U64 handle, const LLUUID& id, read_callback_t callback)
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_NETWORK;
+    LL::WorkQueue::ptr_t main_queue = LL::WorkQueue::getInstance("mainloop");
+    LL::WorkQueue::ptr_t cache_queue = LL::WorkQueue::getInstance("VOCache");
+    bool posted = false;
+    if (mEnabled && main_queue && cache_queue && mHandleEntryMap.find(handle) != mHandleEntryMap.end())
+    {
+        std::string filename;
+        getObjectCacheFilename(handle, filename);
+        posted = main_queue->postTo(
+            cache_queue,
+            [filename, id]() // Work done on the cache thread
             {
-                LL_INFOS() << "Cache ID doesn't match for this region, discarding"<< LL_ENDL;
-                success = false ;
-            }
-
-            if(success)
+                CacheReadResult result;
+                result.mSuccess = load_object_cache(filename, id, result.mEntries, result.mNumEntries);
+                return result;
+            },
+            [handle, filename, callback](CacheReadResult result) // Callback on the main thread
             {
-                success = check_read(&apr_file, &num_entries, sizeof(S32)) ;
-
-                if(success)
+                if (LLVOCache::instanceExists())
                 {
-                    for (S32 i = 0; i < num_entries && apr_file.eof() != APR_EOF; i++)
-                    {
-                        LLPointer<LLVOCacheEntry> entry = new LLVOCacheEntry(&apr_file);
-                        if (!entry->getLocalID())
-                        {
-                            LL_WARNS() << "Aborting cache file load for " << filename << ", cache file corruption!" << LL_ENDL;
-                            success = false ;
-                            break ;
-                        }
-                        cache_entry_map[entry->getLocalID()] = entry;
-                    }
+                    LLVOCache::instance().finishRead(handle, filename, result.mSuccess, result.mNumEntries, result.mEntries);
                 }
-            }
-        }
+                callback(result.mSuccess, result.mEntries);
+            });
     }
 
+    if (!posted)
+    {
+        // Disabled, unknown region or no cache thread, do it the slow way
+        LLVOCacheEntry::vocache_entry_map_t cache_entry_map;
+        bool success = readFromCache(handle, id, cache_entry_map);
+        callback(success, cache_entry_map);
+    }
+}
+
+void LLVOCache::finishRead(U64 handle, const std::string& filename, bool success, S32 num_entries,
+                           const LLVOCacheEntry::vocache_entry_map_t& cache_entry_map)
+{
     if(!success)
     {
         if(cache_entry_map.empty())
         {
-            removeEntry(iter->second) ;
+            handle_entry_map_t::iterator iter = mHandleEntryMap.find(handle);
+            if (iter != mHandleEntryMap.end())
+            {
+                removeEntry(iter->second) ;
+            }
         }
     }
 
     LL_DEBUGS("GLTF", "VOCache") << "Read " << cache_entry_map.size() << " entries from object cache " << filename << ", expected " << num_entries << ", success=" << (success?"True":"False") << LL_ENDL;
-    return success;
 }
 
 // We now pass in the cache entry map, so that we can remove entries from extras that are no longer in the primary cache.
@@ -1838,78 +2229,123 @@ void LLVOCache::writeToCache(U64 handle, const LLUUID& id, const LLVOCacheEntry:
         return ; //nothing changed, no need to update.
     }
 
-    //write to cache file
+    // Gather the index and the raw payload blocks on the main thread, the
+    // entries are not safe to touch from the cache thread.
+    struct PendingWrite
+    {
+        std::vector<U8> mIndex;
+        std::vector<std::vector<U8> > mBlocks;
+        S32 mNumEntries = 0;
+    };
+    auto pending = std::make_shared<PendingWrite>();
+    pending->mIndex.reserve(cache_entry_map.size() * INDEX_RECORD_SIZE);
+    pending->mBlocks.emplace_back();
+
     bool success = true ;
+    for (LLVOCacheEntry::vocache_entry_map_t::const_iterator iter = cache_entry_map.begin(); iter != cache_entry_map.end(); ++iter)
     {
-        std::string filename;
-        getObjectCacheFilename(handle, filename);
-        LLAPRFile apr_file(filename, APR_CREATE|APR_WRITE|APR_BINARY|APR_TRUNCATE, mLocalAPRFilePoolp);
+        if (!removal_enabled || iter->second->isValid())
+        {
+            LLVOCacheIndexRecord record;
+            const U8* payload = NULL;
+            if (!iter->second->getIndexRecord(record, payload))
+            {
+                LL_WARNS() << "Failed to write cache entry to buffer for " << filename << ", entry number " << iter->second->getLocalID() << LL_ENDL;
+                success = false;
+                break;
+            }
+
+            if (pending->mBlocks.back().size() >= PAYLOAD_BLOCK_SIZE)
+            {
+                pending->mBlocks.emplace_back();
+            }
+            std::vector<U8>& block = pending->mBlocks.back();
+            record.mBlock = static_cast<U32>(pending->mBlocks.size() - 1);
+            record.mOffset = static_cast<S32>(block.size());
+            block.insert(block.end(), payload, payload + record.mSize);
 
-        success = check_write(&apr_file, (void*)id.mData, UUID_BYTES);
+            append_index_record(pending->mIndex, record);
+            pending->mNumEntries++;
+        }
+    }
 
-        if(success)
+    if(!success)
+    {
+        removeEntry(entry) ;
+        return ;
+    }
+
+    if (pending->mBlocks.back().empty())
+    {
+        pending->mBlocks.pop_back();
+    }
+
+    // Compress and write on the cache thread, it is the only one touching region
+    // object files while it runs so reads and writes for a region stay in order.
+    auto write_file = [filename, id, pending]()
+    {
+        LL_PROFILE_ZONE_NAMED_CATEGORY_NETWORK("VOCache:writeRegionObjectCache");
+        const S32 num_blocks = static_cast<S32>(pending->mBlocks.size());
+
+        std::vector<U8> data;
+        data.reserve(OBJECT_CACHE_HEADER_SIZE + pending->mIndex.size() + num_blocks * (BLOCK_TABLE_ENTRY_SIZE + PAYLOAD_BLOCK_SIZE / 2));
+        append_value(data, OBJECT_CACHE_MAGIC);
+        append_value(data, OBJECT_CACHE_FORMAT_VERSION);
+        data.insert(data.end(), id.mData, id.mData + UUID_BYTES);
+        append_value(data, pending->mNumEntries);
+        append_value(data, num_blocks);
+        data.insert(data.end(), pending->mIndex.begin(), pending->mIndex.end());
+
+        // Block table is filled in as the blocks are compressed.
+        size_t block_table = data.size();
+        data.resize(block_table + (size_t)num_blocks * BLOCK_TABLE_ENTRY_SIZE);
+
+        for (S32 i = 0; i < num_blocks; i++)
         {
-            S32 num_entries = static_cast<S32>(cache_entry_map.size()); // if removal is enabled num_entries might be wrong
-            success = check_write(&apr_file, &num_entries, sizeof(S32));
-            if (success)
+            const std::vector<U8>& block = pending->mBlocks[i];
+            size_t offset = data.size();
+            uLongf compressed_size = compressBound(static_cast<uLong>(block.size()));
+            data.resize(offset + compressed_size);
+            if (compress2(data.data() + offset, &compressed_size, block.data(), static_cast<uLong>(block.size()), Z_DEFAULT_COMPRESSION) != Z_OK)
             {
-                const S32 buffer_size = 32768; //should be large enough for couple MAX_ENTRY_BODY_SIZE
-                U8 data_buffer[buffer_size]; // generaly entries are fairly small, so collect them and drop onto disk in one go
-                S32 size_in_buffer = 0;
+                LL_WARNS() << "Failed to compress object cache payload for " << filename << LL_ENDL;
+                return false;
+            }
+            data.resize(offset + compressed_size);
 
-                // This can have a lot of entries, so might be better to dump them into buffer first and write in one go.
-                for (LLVOCacheEntry::vocache_entry_map_t::const_iterator iter = cache_entry_map.begin(); success && iter != cache_entry_map.end(); ++iter)
-                {
-                    if (!removal_enabled || iter->second->isValid())
-                    {
-                        S32 size = iter->second->writeToBuffer(data_buffer + size_in_buffer);
-
-                        if (size > ENTRY_HEADER_SIZE) // body is minimum of 1
-                        {
-                            size_in_buffer += size;
-                        }
-                        else
-                        {
-                            LL_WARNS() << "Failed to write cache entry to buffer for " << filename << ", entry number " << iter->second->getLocalID() << LL_ENDL;
-                            success = false;
-                            break;
-                        }
-
-                        // Make sure we have space in buffer for next element
-                        if (buffer_size - size_in_buffer < MAX_ENTRY_BODY_SIZE + ENTRY_HEADER_SIZE)
-                        {
-                            success = check_write(&apr_file, (void*)data_buffer, size_in_buffer);
-                            size_in_buffer = 0;
-                            if (!success)
-                            {
-                                LL_WARNS() << "Failed to write cache to disk " << filename << LL_ENDL;
-                                break;
-                            }
-                        }
-                    }
-                }
+            S32 sizes[2] = { static_cast<S32>(compressed_size), static_cast<S32>(block.size()) };
+            memcpy(data.data() + block_table + (size_t)i * BLOCK_TABLE_ENTRY_SIZE, sizes, sizeof(sizes));
+        }
 
-                if (success && size_in_buffer > 0)
+        LLAPRFile apr_file(filename, APR_CREATE|APR_WRITE|APR_BINARY|APR_TRUNCATE);
+        bool success = check_write(&apr_file, (void*)data.data(), static_cast<S32>(data.size()));
+        apr_file.close();
+        LL_DEBUGS("VOCache") << "Wrote " << pending->mNumEntries << " entries in " << num_blocks << " blocks (" << data.size() << " bytes) to the primary VOCache file " << filename << ". success = " << (success ? "True":"False") << LL_ENDL;
+        return success;
+    };
+
+    LL::WorkQueue::ptr_t main_queue = LL::WorkQueue::getInstance("mainloop");
+    LL::WorkQueue::ptr_t cache_queue = LL::WorkQueue::getInstance("VOCache");
+    bool posted = false;
+    if (main_queue && cache_queue)
+    {
+        posted = main_queue->postTo(
+            cache_queue,
+            write_file,
+            [handle](bool success) // Callback on the main thread
+            {
+                if (!success && LLVOCache::instanceExists())
                 {
-                    // final write
-                    success = check_write(&apr_file, (void*)data_buffer, size_in_buffer);
-                    if(!success)
-                    {
-                        LL_WARNS() << "Failed to write cache entry to disk " << filename << LL_ENDL;
-                    }
-                    size_in_buffer = 0;
+                    LL_WARNS() << "Failed to write cache to disk for handle " << handle << LL_ENDL;
+                    LLVOCache::instance().removeEntry(handle);
                 }
-                LL_DEBUGS("VOCache") << "Wrote " << num_entries << " entries to the primary VOCache file " << filename << ". success = " << (success ? "True":"False") << LL_ENDL;
-            }
-        }
+            });
     }
 
-    if(!success)
+    if (!posted && !write_file())
     {
         removeEntry(entry) ;
     }
-
-    return ;
 }
 
 void LLVOCache::removeGenericExtrasForHandle(U64 handle)
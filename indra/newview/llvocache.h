@@ -33,12 +33,35 @@
 #include "llvieweroctree.h"
 #include "llapr.h"
 #include "llgltfmaterial.h"
+#include "threadpool_fwd.h"
+#include "v3math.h"
 
+#include <functional>
+#include <memory>
 #include <unordered_map>
 
 //---------------------------------------------------------------------------
 // Cache entries
 class LLCamera;
+struct LLVOCachePayloadBlock;
+
+// Fixed-size record in the index section of a region object cache file.
+// Holds enough to place and cull the object without its payload.
+struct LLVOCacheIndexRecord
+{
+    U32         mLocalID = 0;
+    U32         mCRC = 0;
+    U32         mParentID = 0;
+    S32         mHitCount = 0;
+    S32         mDupeCount = 0;
+    S32         mCRCChangeCount = 0;
+    U32         mBlock = 0;     // payload block holding the object data
+    S32         mOffset = 0;    // offset of the object data in the inflated block
+    S32         mSize = 0;      // size of the object data
+    LLUUID      mFullID;
+    LLVector3   mPos;           // bounding info, as extracted from the object data
+    LLVector3   mScale;
+};
 
 class LLGLTFOverrideCacheEntry
 {
@@ -109,7 +132,12 @@ protected:
     ~LLVOCacheEntry();
 public:
     LLVOCacheEntry(U32 local_id, U32 crc, LLDataPackerBinaryBuffer &dp);
-    LLVOCacheEntry(LLAPRFile* apr_file);
+    // Parse an entry out of a legacy cache file read into memory.  bytes_read
+    // is set to the size of the entry, the local id is 0 if it is corrupt.
+    LLVOCacheEntry(const U8* data, S32 data_size, S32& bytes_read);
+    // Entry from an indexed cache file, the object data stays compressed in
+    // payload until getDP() is first called.
+    LLVOCacheEntry(const LLVOCacheIndexRecord& record, const std::shared_ptr<LLVOCachePayloadBlock>& payload);
     LLVOCacheEntry();
 
     void updateEntry(U32 crc, LLDataPackerBinaryBuffer &dp);
@@ -132,8 +160,13 @@ public:
     F32 getSceneContribution() const             { return mSceneContrib;}
 
     void dump() const;
-    S32 writeToBuffer(U8 *data_buffer) const;
+    // Fill in an index record and point data at the object data to save,
+    // without inflating the payload into the entry.  False if there is none.
+    bool getIndexRecord(LLVOCacheIndexRecord& record, const U8*& data);
     LLDataPackerBinaryBuffer *getDP();
+    // Bounding info from the cache index, false if the entry has none and
+    // the object data needs to be decoded.
+    bool getIndexedBoundingInfo(LLVector3& pos, LLVector3& scale, U32& parent_id) const;
     void recordHit();
     void recordDupe() { mDupeCount++; }
 
@@ -193,6 +226,15 @@ protected:
     LLVector4a                  mBSphereCenter; //bounding sphere center
     F32                         mBSphereRadius; //bounding sphere radius
 
+    std::shared_ptr<LLVOCachePayloadBlock> mPayload; //compressed object data, until first used.
+    S32                         mPayloadOffset;
+    S32                         mPayloadSize;
+    bool                        mIndexed; //index data below is valid for the current object data.
+    U32                         mIndexParentID;
+    LLUUID                      mFullID;
+    LLVector3                   mIndexPos;
+    LLVector3                   mIndexScale;
+
 public:
     static U32                  sMinFrameRange;
     static F32                  sNearRadius;
@@ -248,7 +290,9 @@ private:
 };
 
 //
-//Note: LLVOCache is not thread-safe
+//Note: LLVOCache is not thread-safe.  Region cache files are read and
+//written on its own single worker thread, but all bookkeeping stays on
+//the main thread.
 //
 class LLVOCache : public LLParamSingleton<LLVOCache>
 {
@@ -293,6 +337,11 @@ public:
     void removeCache(ELLPath location, bool started = false) ;
 
     bool readFromCache(U64 handle, const LLUUID& id, LLVOCacheEntry::vocache_entry_map_t& cache_entry_map) ;
+    // Read and parse the region's cache file on the cache thread, callback
+    // is fired on the main thread with the entries (or inline if the cache
+    // thread isn't running).
+    typedef std::function<void(bool success, LLVOCacheEntry::vocache_entry_map_t& cache_entry_map)> read_callback_t;
+    void readFromCacheAsync(U64 handle, const LLUUID& id, read_callback_t callback);
     void readGenericExtrasFromCache(U64 handle, const LLUUID& id, LLVOCacheEntry::vocache_gltf_overrides_map_t& cache_extras_entry_map, const LLVOCacheEntry::vocache_entry_map_t& cache_entry_map);
 
     void writeToCache(U64 handle, const LLUUID& id, const LLVOCacheEntry::vocache_entry_map_t& cache_entry_map, bool dirty_cache, bool removal_enabled);
@@ -316,6 +365,10 @@ private:
     void removeEntry(HeaderEntryInfo* entry) ;
     void purgeEntries(U32 size);
     bool updateEntry(const HeaderEntryInfo* entry);
+    // Let the cache thread finish the reads and writes queued so far, before
+    // removing the files they use.
+    void waitForCacheThread();
+    void finishRead(U64 handle, const std::string& filename, bool success, S32 num_entries, const LLVOCacheEntry::vocache_entry_map_t& cache_entry_map);
 
 private:
     bool                 mEnabled;
@@ -329,6 +382,7 @@ private:
     LLVolatileAPRPool*   mLocalAPRFilePoolp ;
     header_entry_queue_t mHeaderEntryQueue;
     handle_entry_map_t   mHandleEntryMap;
+    std::unique_ptr<LL::ThreadPool> mThreadPool;
 };
 
 #endif
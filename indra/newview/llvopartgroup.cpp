@@ -263,7 +263,7 @@ F32 LLVOPartGroup::getPartSize(S32 idx)
 {
     if (idx < (S32) mViewerPartGroupp->mParticles.size())
     {
-        return mViewerPartGroupp->mParticles[idx]->mScale.mV[0];
+        return mViewerPartGroupp->mArrays.mScale[idx].getF32ptr()[VX];
     }
 
     return 0.f;
@@ -341,15 +341,18 @@ bool LLVOPartGroup::updateGeometry(LLDrawable *drawable)
     F32 max_scale = 0.f;
 
 
+    const LLViewerPartArrays& arrays = mViewerPartGroupp->mArrays;
     for (i = 0 ; i < (S32)mViewerPartGroupp->mParticles.size(); i++)
     {
         const LLViewerPart *part = mViewerPartGroupp->mParticles[i];
-
+        const U32 flags = arrays.mFlags[i];
+        const F32* scale = arrays.mScale[i].getF32ptr();
+        const LLVector3 part_pos_agent = arrays.getPosition(i);
 
         //remember the largest particle
-        max_scale = llmax(max_scale, part->mScale.mV[0], part->mScale.mV[1]);
+        max_scale = llmax(max_scale, scale[VX], scale[VY]);
 
-        if (part->mFlags & LLPartData::LL_PART_RIBBON_MASK)
+        if (flags & LLPartData::LL_PART_RIBBON_MASK)
         { //include ribbon segment length in scale
             const LLVector3* pos_agent = NULL;
             if (part->mParent)
@@ -363,13 +366,12 @@ bool LLVOPartGroup::updateGeometry(LLDrawable *drawable)
 
             if (pos_agent)
             {
-                F32 dist = (*pos_agent-part->mPosAgent).length();
+                F32 dist = (*pos_agent-part_pos_agent).length();
 
                 max_scale = llmax(max_scale, dist);
             }
         }
 
-        LLVector3 part_pos_agent(part->mPosAgent);
         LLVector3 at(part_pos_agent - camera_agent);
 
 
@@ -383,7 +385,7 @@ bool LLVOPartGroup::updateGeometry(LLDrawable *drawable)
         llassert(llfinite(inv_camera_dist_squared));
         llassert(!llisnan(inv_camera_dist_squared));
 
-        F32 area = part->mScale.mV[0] * part->mScale.mV[1] * inv_camera_dist_squared;
+        F32 area = scale[VX] * scale[VY] * inv_camera_dist_squared;
         tot_area = llmax(tot_area, area);
 
         if (tot_area > max_area)
@@ -414,7 +416,7 @@ bool LLVOPartGroup::updateGeometry(LLDrawable *drawable)
 
         facep->setViewerObject(this);
 
-        if (part->mFlags & LLPartData::LL_PART_EMISSIVE_MASK)
+        if (flags & LLPartData::LL_PART_EMISSIVE_MASK)
         {
             facep->setState(LLFace::FULLBRIGHT);
         }
@@ -423,8 +425,8 @@ bool LLVOPartGroup::updateGeometry(LLDrawable *drawable)
             facep->clearState(LLFace::FULLBRIGHT);
         }
 
-        facep->mCenterLocal = part->mPosAgent;
-        facep->setFaceColor(part->mColor);
+        facep->mCenterLocal = part_pos_agent;
+        facep->setFaceColor(arrays.getColor(i));
         facep->setTexture(part->mImagep);
 
         //check if this particle texture is replaced by a parcel media texture.
@@ -478,13 +480,11 @@ bool LLVOPartGroup::lineSegmentIntersect(const LLVector4a& start, const LLVector
 
     for (U32 idx = 0; idx < mViewerPartGroupp->mParticles.size(); ++idx)
     {
-        const LLViewerPart &part = *((LLViewerPart*) (mViewerPartGroupp->mParticles[idx]));
-
         LLVector4a v[4];
         LLStrider<LLVector4a> verticesp;
         verticesp = v;
 
-        getGeometry(part, verticesp);
+        getGeometry(idx, verticesp);
 
         F32 a,b,t;
         if (LLTriangleRayIntersect(v[0], v[1], v[2], start, dir, a,b,t) ||
@@ -514,17 +514,22 @@ bool LLVOPartGroup::lineSegmentIntersect(const LLVector4a& start, const LLVector
     return ret;
 }
 
-void LLVOPartGroup::getGeometry(const LLViewerPart& part,
+void LLVOPartGroup::getGeometry(S32 idx,
                                 LLStrider<LLVector4a>& verticesp)
 {
-    if (part.mFlags & LLPartData::LL_PART_RIBBON_MASK)
+    const LLViewerPart& part = *mViewerPartGroupp->mParticles[idx];
+    const LLViewerPartArrays& arrays = mViewerPartGroupp->mArrays;
+    const U32 flags = arrays.mFlags[idx];
+    const F32* part_scale = arrays.mScale[idx].getF32ptr();
+
+    if (flags & LLPartData::LL_PART_RIBBON_MASK)
     {
         LLVector4a axis, pos, paxis, ppos;
         F32 scale, pscale;
 
-        pos.load3(part.mPosAgent.mV);
+        pos = arrays.mPosition[idx];
         axis.load3(part.mAxis.mV);
-        scale = part.mScale.mV[0];
+        scale = part_scale[VX];
 
         if (part.mParent)
         {
@@ -571,8 +576,7 @@ void LLVOPartGroup::getGeometry(const LLViewerPart& part,
     }
     else
     {
-        LLVector4a part_pos_agent;
-        part_pos_agent.load3(part.mPosAgent.mV);
+        const LLVector4a& part_pos_agent = arrays.mPosition[idx];
         LLVector4a camera_agent;
         camera_agent.load3(getCameraPosition().mV);
         LLVector4a at;
@@ -586,10 +590,9 @@ void LLVOPartGroup::getGeometry(const LLViewerPart& part,
         up.setCross3(right, at);
         up.normalize3fast();
 
-        if (part.mFlags & LLPartData::LL_PART_FOLLOW_VELOCITY_MASK && !part.mVelocity.isExactlyZero())
+        if (flags & LLPartData::LL_PART_FOLLOW_VELOCITY_MASK && !arrays.getVelocity(idx).isExactlyZero())
         {
-            LLVector4a normvel;
-            normvel.load3(part.mVelocity.mV);
+            LLVector4a normvel = arrays.mVelocity[idx];
             normvel.normalize3fast();
             LLVector2 up_fracs;
             up_fracs.mV[0] = normvel.dot3(right).getF32();
@@ -618,8 +621,8 @@ void LLVOPartGroup::getGeometry(const LLViewerPart& part,
             right.normalize3fast();
         }
 
-        right.mul(0.5f*part.mScale.mV[0]);
-        up.mul(0.5f*part.mScale.mV[1]);
+        right.mul(0.5f*part_scale[VX]);
+        up.mul(0.5f*part_scale[VY]);
 
 
         //HACK -- the verticesp->mV[3] = 0.f here are to set the texture index to 0 (particles don't use texture batching, maybe they should)
@@ -659,15 +662,18 @@ void LLVOPartGroup::getGeometry(S32 idx,
     }
 
     const LLViewerPart &part = *((LLViewerPart*) (mViewerPartGroupp->mParticles[idx]));
+    const LLViewerPartArrays& arrays = mViewerPartGroupp->mArrays;
+    const U32 flags = arrays.mFlags[idx];
 
-    getGeometry(part, verticesp);
+    getGeometry(idx, verticesp);
 
     LLColor4U pcolor;
-    LLColor4U color = part.mColor;
+    LLColor4U color = arrays.getColor(idx);
 
+    LLColor4U glow(0, 0, 0, arrays.mGlow[idx]);
     LLColor4U pglow;
 
-    if (part.mFlags & LLPartData::LL_PART_RIBBON_MASK)
+    if (flags & LLPartData::LL_PART_RIBBON_MASK)
     { //make sure color blends properly
         if (part.mParent)
         {
@@ -682,7 +688,7 @@ void LLVOPartGroup::getGeometry(S32 idx,
     }
     else
     {
-        pglow = part.mGlow;
+        pglow = glow;
         pcolor = color;
     }
 
@@ -691,16 +697,16 @@ void LLVOPartGroup::getGeometry(S32 idx,
     *colorsp++ = color;
     *colorsp++ = color;
 
-    //if (pglow.mV[3] || part.mGlow.mV[3])
+    //if (pglow.mV[3] || glow.mV[3])
     { //only write glow if it is not zero
         *emissivep++ = pglow;
         *emissivep++ = pglow;
-        *emissivep++ = part.mGlow;
-        *emissivep++ = part.mGlow;
+        *emissivep++ = glow;
+        *emissivep++ = glow;
     }
 
 
-    if (!(part.mFlags & LLPartData::LL_PART_EMISSIVE_MASK))
+    if (!(flags & LLPartData::LL_PART_EMISSIVE_MASK))
     { //not fullbright, needs normal
         LLVector3 normal = -LLViewerCamera::getInstance()->getXAxis();
         *normalsp++   = normal;
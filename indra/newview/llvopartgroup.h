@@ -79,7 +79,7 @@ public:
 
     /*virtual*/ LLDrawable* createDrawable(LLPipeline *pipeline);
     /*virtual*/ bool        updateGeometry(LLDrawable *drawable);
-    void        getGeometry(const LLViewerPart& part,
+    void        getGeometry(S32 idx,
                                 LLStrider<LLVector4a>& verticesp);
 
                 void        getGeometry(S32 idx,
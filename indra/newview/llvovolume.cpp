@@ -938,6 +938,13 @@ void LLVOVolume::updateTextureVirtualSize(bool forced)
             vsize = face->getTextureVirtualSize();
         }
 
+        // Textures of faces that doubled or halved in size are updated
+        // ahead of the sweep over all textures
+        if (vsize > old_size * 2.f || vsize < old_size * 0.5f)
+        {
+            gTextureList.queueFaceImageUpdates(face, vsize);
+        }
+
         mPixelArea = llmax(mPixelArea, face->getPixelArea());
 
         // if the face has gotten small enough to turn off texture animation and texture
@@ -2498,11 +2498,38 @@ void LLPipeline::markNotCulled(LLSpatialGroup* group, LLCamera& camera)
         return;
     }
 
+    // Not visible in this frame or the last one
+    const bool newly_visible = group->getVisible(LLViewerCamera::sCurCameraID) < LLDrawable::getCurrentFrame() - 1;
+
     group->setVisible();
 
     if (LLViewerCamera::sCurCameraID == LLViewerCamera::CAMERA_WORLD && !gCubeSnapshot)
     {
         group->updateDistance(camera);
+
+        if (newly_visible)
+        {
+            // Fetch the textures coming into view in this frame rather than
+            // when the texture sweep gets to them.  The pixel area is the one
+            // from when the face was last updated; updateImageDecodePriority()
+            // works out the current one once the texture is taken off the queue.
+            for (LLSpatialGroup::element_iter i = group->getDataBegin(); i != group->getDataEnd(); ++i)
+            {
+                LLDrawable* drawablep = (LLDrawable*)(*i)->getDrawable();
+                if (!drawablep || drawablep->isDead())
+                {
+                    continue;
+                }
+                for (S32 f = 0; f < drawablep->getNumFaces(); ++f)
+                {
+                    LLFace* facep = drawablep->getFace(f);
+                    if (facep)
+                    {
+                        gTextureList.queueFaceImageUpdates(facep, facep->getPixelArea());
+                    }
+                }
+            }
+        }
     }
 
     assertInitialized();
@@ -0,0 +1,439 @@
+/**
+ * @file llviewerpartarrays_test.cpp
+ * @date 2024-11
+ * @brief LLViewerPartArrays test cases.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llviewerpartarrays.h"
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <random>
+
+#include "llmath.h"
+#include "lltimer.h"
+#include "workexecutor.h"
+
+#include "../test/lltut.h"
+
+namespace
+{
+    // A particle the way LLViewerPart holds one, stepped with the scalar
+    // code LLViewerPartGroup::updateParticles() used before the arrays.
+    struct ScalarPart : public LLPartData
+    {
+        LLVector3   mPosAgent;
+        LLVector3   mVelocity;
+        LLVector3   mAccel;
+        LLColor4    mColor;
+        LLVector2   mScale;
+        U8          mGlow;
+        F32         mLastUpdateTime;
+
+        LLVector3   mSourcePos;
+        LLVector3   mTargetPos;
+        LLVector3   mWind;
+        U8          mState;
+    };
+
+    struct ScalarGroup
+    {
+        std::vector<ScalarPart*> mParticles;
+        LLVector3   mMinObjPos;
+        LLVector3   mMaxObjPos;
+        F32         mBoxRadius;
+
+        ~ScalarGroup()
+        {
+            for (ScalarPart* part : mParticles)
+            {
+                delete part;
+            }
+        }
+
+        void update(F32 dt, const LLVector3& camera_origin)
+        {
+            for (ScalarPart* part : mParticles)
+            {
+                const F32 cur_time = part->mLastUpdateTime + dt;
+                const F32 frac = cur_time / part->mMaxAge;
+
+                if (part->mFlags & LLPartData::LL_PART_FOLLOW_SRC_MASK)
+                {
+                    part->mPosAgent = part->mSourcePos;
+                    part->mPosAgent += part->mPosOffset;
+                }
+
+                if (part->mFlags & LLPartData::LL_PART_WIND_MASK)
+                {
+                    part->mVelocity *= 1.f - 0.1f*dt;
+                    part->mVelocity += 0.1f*dt*part->mWind;
+                }
+
+                if (part->mFlags & LLPartData::LL_PART_TARGET_POS_MASK)
+                {
+                    F32 remaining = part->mMaxAge - part->mLastUpdateTime;
+                    F32 step = dt / remaining;
+
+                    step = llclamp(step, 0.f, 0.1f);
+                    step *= 5.f;
+                    LLVector3 delta_pos = part->mTargetPos - part->mPosAgent;
+
+                    delta_pos /= remaining;
+
+                    part->mVelocity *= (1.f - step);
+                    part->mVelocity += step*delta_pos;
+                }
+
+                if (part->mFlags & LLPartData::LL_PART_TARGET_LINEAR_MASK)
+                {
+                    LLVector3 delta_pos = part->mTargetPos - part->mSourcePos;
+                    part->mPosAgent = part->mSourcePos;
+                    part->mPosAgent += frac*delta_pos;
+                    part->mVelocity = delta_pos;
+                }
+                else
+                {
+                    part->mPosAgent += dt*part->mVelocity;
+                    part->mPosAgent += 0.5f*dt*dt*part->mAccel;
+                    part->mVelocity += part->mAccel*dt;
+                }
+
+                if (part->mFlags & LLPartData::LL_PART_BOUNCE_MASK)
+                {
+                    F32 dz = part->mPosAgent.mV[VZ] - part->mSourcePos.mV[VZ];
+                    if (dz < 0)
+                    {
+                        part->mPosAgent.mV[VZ] += -2.f*dz;
+                        part->mVelocity.mV[VZ] *= -0.75f;
+                    }
+                }
+
+                if (part->mFlags & LLPartData::LL_PART_FOLLOW_SRC_MASK)
+                {
+                    part->mPosOffset = part->mPosAgent;
+                    part->mPosOffset -= part->mSourcePos;
+                }
+
+                if (part->mFlags & LLPartData::LL_PART_INTERP_COLOR_MASK)
+                {
+                    part->mColor.setVec(part->mStartColor);
+                    part->mColor *= 1.f - frac;
+                    part->mColor %= 1.f - frac;
+                    part->mColor += frac%(frac*part->mEndColor);
+                }
+
+                if (part->mFlags & LLPartData::LL_PART_INTERP_SCALE_MASK)
+                {
+                    part->mScale.setVec(part->mStartScale);
+                    part->mScale *= 1.f - frac;
+                    part->mScale += frac*part->mEndScale;
+                }
+
+                part->mGlow = (U8) ll_round(lerp(part->mStartGlow, part->mEndGlow, frac)*255.f);
+
+                part->mLastUpdateTime = cur_time;
+
+                if ((part->mLastUpdateTime > part->mMaxAge) || (LLPartData::LL_PART_DEAD_MASK == part->mFlags))
+                {
+                    part->mState = LLViewerPartArrays::PART_DEAD;
+                }
+                else
+                {
+                    F32 desired_size = (part->mPosAgent - camera_origin).magVec();
+                    desired_size /= 4;
+                    desired_size = llclamp(desired_size, part->mScale.magVec()*0.5f, PART_SIM_BOX_SIDE*2);
+                    part->mState = posInGroup(part->mPosAgent, desired_size) ?
+                        LLViewerPartArrays::PART_ALIVE : LLViewerPartArrays::PART_OUTSIDE;
+                }
+            }
+        }
+
+        bool posInGroup(const LLVector3 &pos, const F32 desired_size) const
+        {
+            if ((pos.mV[VX] < mMinObjPos.mV[VX])
+                || (pos.mV[VY] < mMinObjPos.mV[VY])
+                || (pos.mV[VZ] < mMinObjPos.mV[VZ]))
+            {
+                return false;
+            }
+
+            if ((pos.mV[VX] > mMaxObjPos.mV[VX])
+                || (pos.mV[VY] > mMaxObjPos.mV[VY])
+                || (pos.mV[VZ] > mMaxObjPos.mV[VZ]))
+            {
+                return false;
+            }
+
+            if (desired_size > 0 &&
+                (desired_size < mBoxRadius*0.5f ||
+                desired_size > mBoxRadius*2.f))
+            {
+                return false;
+            }
+
+            return true;
+        }
+    };
+
+    struct TestGroup
+    {
+        ScalarGroup         mScalar;
+        LLViewerPartArrays  mArrays;
+    };
+
+    const U32 FLAG_CHOICES[] =
+    {
+        0,
+        LLPartData::LL_PART_INTERP_COLOR_MASK | LLPartData::LL_PART_INTERP_SCALE_MASK,
+        LLPartData::LL_PART_INTERP_COLOR_MASK | LLPartData::LL_PART_WIND_MASK,
+        LLPartData::LL_PART_INTERP_SCALE_MASK | LLPartData::LL_PART_BOUNCE_MASK,
+        LLPartData::LL_PART_FOLLOW_SRC_MASK | LLPartData::LL_PART_INTERP_COLOR_MASK,
+        LLPartData::LL_PART_TARGET_POS_MASK | LLPartData::LL_PART_INTERP_COLOR_MASK,
+        LLPartData::LL_PART_TARGET_LINEAR_MASK,
+        LLPartData::LL_PART_EMISSIVE_MASK | LLPartData::LL_PART_INTERP_COLOR_MASK |
+            LLPartData::LL_PART_INTERP_SCALE_MASK | LLPartData::LL_PART_BOUNCE_MASK,
+    };
+
+    // Fill a group with the same random particles on both sides
+    void fill_group(TestGroup& group, const LLVector3& center, S32 count, std::mt19937& rand)
+    {
+        std::uniform_real_distribution<F32> unit(0.f, 1.f);
+        std::uniform_real_distribution<F32> spread(-1.f, 1.f);
+        std::uniform_int_distribution<S32> flag_choice(0, LL_ARRAY_SIZE(FLAG_CHOICES) - 1);
+
+        const F32 side = PART_SIM_BOX_SIDE;
+        group.mScalar.mMinObjPos = center - LLVector3(side, side, side);
+        group.mScalar.mMaxObjPos = center + LLVector3(side, side, side);
+        group.mScalar.mBoxRadius = F_SQRT3*side*0.5f;
+
+        for (S32 i = 0; i < count; ++i)
+        {
+            ScalarPart* part = new ScalarPart;
+            part->mFlags = FLAG_CHOICES[flag_choice(rand)];
+            part->mMaxAge = 1.f + 10.f*unit(rand);
+            part->mStartColor.setVec(unit(rand), unit(rand), unit(rand), 1.f);
+            part->mEndColor.setVec(unit(rand), unit(rand), unit(rand), unit(rand));
+            part->mStartScale.setVec(0.1f + unit(rand), 0.1f + unit(rand));
+            part->mEndScale.setVec(0.1f + unit(rand), 0.1f + unit(rand));
+            part->mStartGlow = unit(rand);
+            part->mEndGlow = unit(rand);
+            part->mSourcePos = center + LLVector3(spread(rand), spread(rand), spread(rand));
+            part->mTargetPos = center + 4.f*LLVector3(spread(rand), spread(rand), spread(rand));
+            part->mWind.setVec(3.f*spread(rand), 3.f*spread(rand), 0.f);
+            part->mPosOffset.setVec(0.1f*spread(rand), 0.1f*spread(rand), 0.1f*spread(rand));
+
+            part->mPosAgent = part->mSourcePos;
+            part->mVelocity.setVec(spread(rand), spread(rand), 2.f*unit(rand));
+            part->mAccel.setVec(0.f, 0.f, -0.5f*unit(rand));
+            part->mColor = part->mStartColor;
+            part->mScale = part->mStartScale;
+            part->mLastUpdateTime = 0.f;
+            part->mState = LLViewerPartArrays::PART_ALIVE;
+            group.mScalar.mParticles.push_back(part);
+
+            S32 idx = group.mArrays.add(*part, 0.f, 0.f, part->mPosAgent, part->mVelocity,
+                                        part->mAccel, part->mColor, part->mScale);
+            group.mArrays.mSourcePos[idx].load3(part->mSourcePos.mV);
+            group.mArrays.mTargetPos[idx].load3(part->mTargetPos.mV);
+            group.mArrays.mWind[idx].load3(part->mWind.mV);
+        }
+    }
+
+    // What LLViewerPartGroup::prepareParticles() does for followers
+    void follow_sources(LLViewerPartArrays& arrays)
+    {
+        for (S32 i = 0; i < arrays.size(); ++i)
+        {
+            if (arrays.mFlags[i] & LLPartData::LL_PART_FOLLOW_SRC_MASK)
+            {
+                arrays.mPosition[i].setAdd(arrays.mSourcePos[i], arrays.mPosOffset[i]);
+            }
+        }
+    }
+
+    bool close(const LLVector3& a, const LLVector3& b)
+    {
+        return dist_vec(a, b) <= 1e-5f * (1.f + a.magVec());
+    }
+}
+
+namespace tut
+{
+    struct viewerpartarrays_data
+    {
+        std::mt19937 mRand;
+        LLVector3 mCamera;
+
+        viewerpartarrays_data()
+            : mRand(1234),
+              mCamera(128.f, 170.f, 24.f)
+        {
+        }
+    };
+    typedef test_group<viewerpartarrays_data> viewerpartarrays_test;
+    typedef viewerpartarrays_test::object viewerpartarrays_object;
+    tut::viewerpartarrays_test viewerpartarrays_testcase("LLViewerPartArrays");
+
+    template<> template<>
+    void viewerpartarrays_object::test<1>()
+    {
+        set_test_name("simulate() matches the scalar particle update");
+
+        TestGroup group;
+        const LLVector3 center(128.f, 128.f, 24.f);
+        fill_group(group, center, 2000, mRand);
+        ScalarGroup& scalar = group.mScalar;
+        LLViewerPartArrays& arrays = group.mArrays;
+
+        const F32 dt = 1.f / 30.f;
+        S32 dead = 0;
+        S32 outside = 0;
+        for (S32 frame = 0; frame < 400; ++frame)
+        {
+            scalar.update(dt, mCamera);
+            follow_sources(arrays);
+            arrays.simulate(dt, 0.f, mCamera, scalar.mMinObjPos, scalar.mMaxObjPos, scalar.mBoxRadius);
+
+            for (S32 i = 0; i < arrays.size(); ++i)
+            {
+                const ScalarPart* part = scalar.mParticles[i];
+                ensure("position", close(part->mPosAgent, arrays.getPosition(i)));
+                ensure("velocity", close(part->mVelocity, arrays.getVelocity(i)));
+                ensure("color", close(LLVector3(part->mColor.mV), LLVector3(arrays.getColor(i).mV)));
+                ensure_approximately_equals_range("alpha", arrays.getColor(i).mV[VW], part->mColor.mV[VW], 1e-5f);
+                ensure_approximately_equals_range("scale x", arrays.getScale(i).mV[VX], part->mScale.mV[VX], 1e-5f);
+                ensure_approximately_equals_range("scale y", arrays.getScale(i).mV[VY], part->mScale.mV[VY], 1e-5f);
+                ensure("glow", llabs((S32)part->mGlow - (S32)arrays.mGlow[i]) <= 1);
+                ensure_equals("age", arrays.mAge[i], part->mLastUpdateTime);
+                ensure_equals("state", (S32)arrays.mState[i], (S32)part->mState);
+            }
+
+            // Remove the same way LLViewerPartGroup::finishParticles() does
+            for (S32 i = 0; i < arrays.size();)
+            {
+                if (arrays.mState[i] != LLViewerPartArrays::PART_ALIVE)
+                {
+                    if (arrays.mState[i] == LLViewerPartArrays::PART_DEAD)
+                    {
+                        ++dead;
+                    }
+                    else
+                    {
+                        ++outside;
+                    }
+                    delete scalar.mParticles[i];
+                    scalar.mParticles[i] = scalar.mParticles.back();
+                    scalar.mParticles.pop_back();
+                    arrays.remove(i);
+                }
+                else
+                {
+                    ++i;
+                }
+            }
+            ensure_equals("same count", arrays.size(), (S32)scalar.mParticles.size());
+        }
+
+        ensure("some particles died", dead > 0);
+        ensure("some particles left the box", outside > 0);
+    }
+
+    template<> template<>
+    void viewerpartarrays_object::test<2>()
+    {
+        set_test_name("Benchmark 100K particles, scalar vs arrays vs arrays on all cores");
+        if (!getenv("LL_TEST_BENCHMARK"))
+        {
+            skip("benchmark, set LL_TEST_BENCHMARK to run it");
+        }
+
+        const S32 GROUPS = 64;
+        const S32 PARTS_PER_GROUP = 100000 / GROUPS;
+        const S32 FRAMES = 30;
+        // Long-lived so nothing dies during the run
+        const F32 dt = 1.f / 1000.f;
+
+        std::vector<std::unique_ptr<TestGroup> > groups;
+        for (S32 g = 0; g < GROUPS; ++g)
+        {
+            groups.emplace_back(new TestGroup);
+            LLVector3 center(8.f + 16.f*(g % 8), 8.f + 16.f*(g / 8), 24.f);
+            fill_group(*groups.back(), center, PARTS_PER_GROUP, mRand);
+        }
+
+        LLTimer timer;
+        for (S32 frame = 0; frame < FRAMES; ++frame)
+        {
+            for (auto& group : groups)
+            {
+                group->mScalar.update(dt, mCamera);
+            }
+        }
+        const F64 scalar_ms = timer.getElapsedTimeF64() * 1000.0 / FRAMES;
+
+        auto simulate = [this, dt](const std::unique_ptr<TestGroup>& group)
+        {
+            const ScalarGroup& scalar = group->mScalar;
+            follow_sources(group->mArrays);
+            group->mArrays.simulate(dt, 0.f, mCamera, scalar.mMinObjPos, scalar.mMaxObjPos, scalar.mBoxRadius);
+        };
+
+        timer.reset();
+        for (S32 frame = 0; frame < FRAMES; ++frame)
+        {
+            std::for_each(groups.begin(), groups.end(), simulate);
+        }
+        const F64 arrays_ms = timer.getElapsedTimeF64() * 1000.0 / FRAMES;
+
+        timer.reset();
+        for (S32 frame = 0; frame < FRAMES; ++frame)
+        {
+            LL::WorkExecutor::getShared().forEach(groups.size(),
+                [&groups, &simulate](size_t i) { simulate(groups[i]); });
+        }
+        const F64 parallel_ms = timer.getElapsedTimeF64() * 1000.0 / FRAMES;
+
+        std::cout << "\n"
+                  << "Scalar particles:   " << scalar_ms << " ms per frame\n"
+                  << "Particle arrays:    " << arrays_ms << " ms per frame\n"
+                  << "Arrays, all cores:  " << parallel_ms << " ms per frame"
+                  << std::endl;
+
+        // The arrays were stepped twice as often as the scalar particles
+        for (auto& group : groups)
+        {
+            const ScalarGroup& scalar = group->mScalar;
+            const LLViewerPartArrays& arrays = group->mArrays;
+            ensure_equals("count", arrays.size(), (S32)scalar.mParticles.size());
+            for (S32 i = 0; i < arrays.size(); ++i)
+            {
+                ensure_approximately_equals_range("age", arrays.mAge[i], scalar.mParticles[i]->mLastUpdateTime * 2.f, 1e-4f);
+            }
+        }
+    }
+}
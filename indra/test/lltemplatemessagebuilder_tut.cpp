@@ -967,5 +967,156 @@ namespace tut
         ensure_equals("Ensure unchanged buffer ", strlen(outBuffer), 0);
         delete reader;
     }
-}
 
+    // Template shaped like ObjectUpdateCompressed: a repeated block of a
+    // few fixed fields and a variable length blob, plus a single block.
+    static LLMessageTemplate objectUpdateTemplate()
+    {
+        LLMessageTemplate messageTemplate = LLTemplateMessageBuilderTestData::defaultTemplate();
+        LLMessageBlock* objects = new LLMessageBlock(_PREHASH_Test0, MBT_VARIABLE);
+        objects->addVariable(const_cast<char*>(_PREHASH_Test0), MVT_U32, 4);
+        objects->addVariable(const_cast<char*>(_PREHASH_Test1), MVT_LLUUID, 16);
+        objects->addVariable(const_cast<char*>(_PREHASH_Test2), MVT_VARIABLE, 2);
+        messageTemplate.addBlock(objects);
+        LLMessageBlock* region = new LLMessageBlock(_PREHASH_Test1, MBT_SINGLE);
+        region->addVariable(const_cast<char*>(_PREHASH_Test0), MVT_U64, 8);
+        messageTemplate.addBlock(region);
+        return messageTemplate;
+    }
+
+    static LLTemplateMessageReader* objectUpdateReader(LLMessageTemplate& messageTemplate, S32 count)
+    {
+        LLTemplateMessageBuilder* builder = LLTemplateMessageBuilderTestData::defaultBuilder(messageTemplate);
+        U8 data[32];
+        for (S32 i = 0; i < count; ++i)
+        {
+            if (i)
+            {
+                builder->nextBlock(_PREHASH_Test0);
+            }
+            LLUUID id;
+            id.mData[0] = (U8)i;
+            memset(data, i, sizeof(data));
+            builder->addU32(_PREHASH_Test0, 1000 + i);
+            builder->addUUID(_PREHASH_Test1, id);
+            builder->addBinaryData(_PREHASH_Test2, data, 8 + i);
+        }
+        builder->nextBlock(_PREHASH_Test1);
+        builder->addU64(_PREHASH_Test0, 0x123456789abcdefULL);
+        return LLTemplateMessageBuilderTestData::setReader(messageTemplate, builder);
+    }
+
+    template<> template<>
+    void LLTemplateMessageBuilderTestObject::test<46>()
+        // resolved fields read the same data as names
+    {
+        LLMessageTemplate messageTemplate = objectUpdateTemplate();
+        LLTemplateMessageReader* reader = objectUpdateReader(messageTemplate, 3);
+
+        LLMessageField id_field = reader->resolveField(_PREHASH_Test0, _PREHASH_Test0);
+        LLMessageField uuid_field = reader->resolveField(_PREHASH_Test0, _PREHASH_Test1);
+        LLMessageField data_field = reader->resolveField(_PREHASH_Test0, _PREHASH_Test2);
+        LLMessageField handle_field = reader->resolveField(_PREHASH_Test1, _PREHASH_Test0);
+        ensure("Ensure resolved", id_field.isResolved() && uuid_field.isResolved()
+               && data_field.isResolved() && handle_field.isResolved());
+        ensure("Ensure missing variable unresolved",
+               !reader->resolveField(_PREHASH_Test1, _PREHASH_Test1).isResolved());
+        ensure("Ensure missing block unresolved",
+               !reader->resolveField(_PREHASH_Test2, _PREHASH_Test0).isResolved());
+        ensure_equals("Ensure variable type", data_field.mType, MVT_VARIABLE);
+
+        for (S32 i = 0; i < 3; ++i)
+        {
+            U32 by_name = 0, by_field = 0;
+            reader->getU32(_PREHASH_Test0, _PREHASH_Test0, by_name, i);
+            reader->getFieldData(id_field, &by_field, sizeof(U32), i);
+            ensure_equals("Ensure U32", by_field, by_name);
+            ensure_equals("Ensure U32 value", by_field, (U32)(1000 + i));
+
+            LLUUID uuid;
+            reader->getFieldData(uuid_field, uuid.mData, sizeof(uuid.mData), i);
+            ensure_equals("Ensure UUID", (S32)uuid.mData[0], i);
+
+            S32 size = reader->getFieldSize(data_field, i);
+            ensure_equals("Ensure size", size, reader->getSize(_PREHASH_Test0, i, _PREHASH_Test2));
+            ensure_equals("Ensure size value", size, 8 + i);
+            U8 data[32];
+            memset(data, 0xff, sizeof(data));
+            reader->getFieldData(data_field, data, 0, i, sizeof(data));
+            ensure_equals("Ensure data", (S32)data[size - 1], i);
+        }
+
+        U64 handle = 0;
+        reader->getFieldData(handle_field, &handle, sizeof(U64));
+        ensure("Ensure single block", handle == 0x123456789abcdefULL);
+        delete reader;
+    }
+
+    template<> template<>
+    void LLTemplateMessageBuilderTestObject::test<47>()
+        // kept fields are only resolved again for another template
+    {
+        LLMessageTemplate messageTemplate = objectUpdateTemplate();
+        LLTemplateMessageReader* reader = objectUpdateReader(messageTemplate, 3);
+        LLMessageField id_field;
+        LLMessageField uuid_field;
+        reader->resolveField(id_field, _PREHASH_Test0, _PREHASH_Test0);
+        reader->resolveField(uuid_field, _PREHASH_Test0, _PREHASH_Test1);
+        ensure("Ensure resolved", id_field.isResolved() && uuid_field.isResolved());
+        delete reader;
+
+        // another message with the same template reads through the same fields
+        reader = objectUpdateReader(messageTemplate, 5);
+        reader->resolveField(id_field, _PREHASH_Test0, _PREHASH_Test0);
+        reader->resolveField(uuid_field, _PREHASH_Test0, _PREHASH_Test1);
+        ensure("Ensure same template", id_field.mTemplate == &messageTemplate);
+        for (S32 i = 0; i < 5; ++i)
+        {
+            U32 id = 0;
+            LLUUID uuid;
+            reader->getFieldData(id_field, &id, sizeof(U32), i);
+            reader->getFieldData(uuid_field, uuid.mData, sizeof(uuid.mData), i);
+            ensure_equals("Ensure U32 value", id, (U32)(1000 + i));
+            ensure_equals("Ensure UUID", (S32)uuid.mData[0], i);
+        }
+        delete reader;
+
+        // a template with the blocks and variables in another order, and
+        // without the UUID
+        LLMessageTemplate otherTemplate = LLTemplateMessageBuilderTestData::defaultTemplate();
+        LLMessageBlock* region = new LLMessageBlock(_PREHASH_Test1, MBT_SINGLE);
+        region->addVariable(const_cast<char*>(_PREHASH_Test0), MVT_U64, 8);
+        otherTemplate.addBlock(region);
+        LLMessageBlock* objects = new LLMessageBlock(_PREHASH_Test0, MBT_VARIABLE);
+        objects->addVariable(const_cast<char*>(_PREHASH_Test2), MVT_VARIABLE, 2);
+        objects->addVariable(const_cast<char*>(_PREHASH_Test0), MVT_U32, 4);
+        otherTemplate.addBlock(objects);
+
+        LLTemplateMessageBuilder* builder = LLTemplateMessageBuilderTestData::defaultBuilder(otherTemplate, const_cast<char*>(_PREHASH_Test1));
+        builder->addU64(_PREHASH_Test0, 1);
+        U8 data[4] = { 0 };
+        for (S32 i = 0; i < 2; ++i)
+        {
+            builder->nextBlock(_PREHASH_Test0);
+            builder->addBinaryData(_PREHASH_Test2, data, sizeof(data));
+            builder->addU32(_PREHASH_Test0, 2000 + i);
+        }
+        reader = LLTemplateMessageBuilderTestData::setReader(otherTemplate, builder);
+
+        reader->resolveField(id_field, _PREHASH_Test0, _PREHASH_Test0);
+        reader->resolveField(uuid_field, _PREHASH_Test0, _PREHASH_Test1);
+        ensure("Ensure resolved again", id_field.mTemplate == &otherTemplate);
+        ensure_equals("Ensure new block index", id_field.mBlockIndex, 1);
+        ensure_equals("Ensure new variable index", id_field.mVarIndex, 1);
+        ensure("Ensure missing variable unresolved", !uuid_field.isResolved());
+        for (S32 i = 0; i < 2; ++i)
+        {
+            U32 by_name = 0, by_field = 0;
+            reader->getU32(_PREHASH_Test0, _PREHASH_Test0, by_name, i);
+            reader->getFieldData(id_field, &by_field, sizeof(U32), i);
+            ensure_equals("Ensure U32", by_field, by_name);
+            ensure_equals("Ensure other U32 value", by_field, (U32)(2000 + i));
+        }
+        delete reader;
+    }
+}